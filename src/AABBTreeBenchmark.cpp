@@ -0,0 +1,190 @@
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <iomanip>
+#include "domain/AABBTree.hpp"
+
+// Moves N boxes around every frame and compares the dynamic tree against a
+// linear scan for frustum, ray and overlap queries. Results must match exactly.
+
+struct Mover {
+    glm::vec3 position;
+    glm::vec3 velocity;
+    glm::vec3 halfSize;
+    int proxy;
+};
+
+struct Timer {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    double ms() const {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+};
+
+AABB boundsOf(const Mover& m) {
+    AABB box;
+    box.min = m.position - m.halfSize;
+    box.max = m.position + m.halfSize;
+    return box;
+}
+
+bool runBenchmark(int count, int frames, std::mt19937& rng) {
+    // Keep density constant so query selectivity is comparable across sizes
+    float worldSize = 4.0f * std::cbrt(static_cast<float>(count));
+    std::uniform_real_distribution<float> coord(-worldSize * 0.5f, worldSize * 0.5f);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    std::uniform_real_distribution<float> size(0.2f, 1.0f);
+
+    std::vector<Mover> movers(count);
+    for (auto& m : movers) {
+        m.position = glm::vec3(coord(rng), coord(rng), coord(rng));
+        m.velocity = glm::vec3(unit(rng), unit(rng), unit(rng)) * 2.0f;
+        m.halfSize = glm::vec3(size(rng), size(rng), size(rng)) * 0.5f;
+    }
+
+    AABBTree tree(0.1f);
+    Timer buildTimer;
+    for (int i = 0; i < count; i++) {
+        movers[i].proxy = tree.insert(boundsOf(movers[i]), i);
+    }
+    double buildMs = buildTimer.ms();
+
+    const float dt = 1.0f / 60.0f;
+    const int raysPerFrame = 32;
+    const int boxesPerFrame = 32;
+    double updateMs = 0.0, frustumTreeMs = 0.0, frustumScanMs = 0.0;
+    double rayTreeMs = 0.0, rayScanMs = 0.0, overlapTreeMs = 0.0, overlapScanMs = 0.0;
+    long reinserts = 0, visibleTotal = 0;
+    bool ok = true;
+
+    std::vector<int> treeHits, scanHits;
+    for (int frame = 0; frame < frames; frame++) {
+        Timer updateTimer;
+        for (auto& m : movers) {
+            glm::vec3 displacement = m.velocity * dt;
+            m.position += displacement;
+            for (int axis = 0; axis < 3; axis++) {
+                if (std::abs(m.position[axis]) > worldSize * 0.5f) m.velocity[axis] = -m.velocity[axis];
+            }
+            if (tree.update(m.proxy, boundsOf(m), displacement)) reinserts++;
+        }
+        updateMs += updateTimer.ms();
+
+        // Camera orbits the centre so the visible set changes every frame
+        float angle = frame * 0.05f;
+        glm::vec3 eye(std::cos(angle) * worldSize * 0.25f, 0.0f, std::sin(angle) * worldSize * 0.25f);
+        glm::mat4 view = glm::lookAt(eye, glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+        glm::mat4 projection = glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, worldSize * 0.5f);
+        Frustum frustum(projection * view);
+
+        treeHits.clear();
+        Timer frustumTree;
+        tree.queryFrustum(frustum, treeHits);
+        frustumTreeMs += frustumTree.ms();
+
+        scanHits.clear();
+        Timer frustumScan;
+        for (int i = 0; i < count; i++) {
+            if (frustum.intersects(boundsOf(movers[i]))) scanHits.push_back(i);
+        }
+        frustumScanMs += frustumScan.ms();
+
+        visibleTotal += static_cast<long>(treeHits.size());
+        if (treeHits.size() != scanHits.size()) ok = false;
+
+        for (int r = 0; r < raysPerFrame; r++) {
+            glm::vec3 origin(coord(rng), coord(rng), coord(rng));
+            glm::vec3 direction = glm::normalize(glm::vec3(unit(rng), unit(rng), unit(rng)) + glm::vec3(1e-3f));
+            float maxDistance = worldSize * 0.25f;
+
+            treeHits.clear();
+            Timer rayTree;
+            tree.queryRay(origin, direction, maxDistance, treeHits);
+            rayTreeMs += rayTree.ms();
+
+            scanHits.clear();
+            Timer rayScan;
+            float distance;
+            for (int i = 0; i < count; i++) {
+                if (boundsOf(movers[i]).raycast(origin, direction, maxDistance, distance)) scanHits.push_back(i);
+            }
+            rayScanMs += rayScan.ms();
+
+            if (treeHits.size() != scanHits.size()) ok = false;
+        }
+
+        for (int b = 0; b < boxesPerFrame; b++) {
+            AABB query;
+            query.min = glm::vec3(coord(rng), coord(rng), coord(rng));
+            query.max = query.min + glm::vec3(4.0f);
+
+            treeHits.clear();
+            Timer overlapTree;
+            tree.queryOverlap(query, treeHits);
+            overlapTreeMs += overlapTree.ms();
+
+            scanHits.clear();
+            Timer overlapScan;
+            for (int i = 0; i < count; i++) {
+                if (boundsOf(movers[i]).overlaps(query)) scanHits.push_back(i);
+            }
+            overlapScanMs += overlapScan.ms();
+
+            if (treeHits.size() != scanHits.size()) ok = false;
+        }
+    }
+
+    std::cout << std::setw(8) << count
+              << std::setw(10) << buildMs
+              << std::setw(10) << updateMs / frames
+              << std::setw(10) << reinserts / frames
+              << std::setw(8) << tree.getHeight()
+              << std::setw(10) << visibleTotal / frames
+              << std::setw(10) << frustumTreeMs / frames
+              << std::setw(10) << frustumScanMs / frames
+              << std::setw(10) << 1000.0 * rayTreeMs / (frames * raysPerFrame)
+              << std::setw(10) << 1000.0 * rayScanMs / (frames * raysPerFrame)
+              << std::setw(10) << 1000.0 * overlapTreeMs / (frames * boxesPerFrame)
+              << std::setw(10) << 1000.0 * overlapScanMs / (frames * boxesPerFrame)
+              << (ok ? "" : "  MISMATCH") << std::endl;
+    return ok;
+}
+
+int main(int argc, char* argv[]) {
+    int frames = argc > 1 ? std::atoi(argv[1]) : 60;
+    if (frames <= 0) frames = 60;
+
+    std::mt19937 rng(1234);
+
+    std::cout << "AABB tree benchmark, " << frames << " frames per size, all objects moving" << std::endl;
+    std::cout << "times in ms (build, update, frustum) and us per query (ray, overlap)" << std::endl;
+    std::cout << std::setw(8) << "objects"
+              << std::setw(10) << "build"
+              << std::setw(10) << "update"
+              << std::setw(10) << "reinsert"
+              << std::setw(8) << "height"
+              << std::setw(10) << "visible"
+              << std::setw(10) << "fr.tree"
+              << std::setw(10) << "fr.scan"
+              << std::setw(10) << "ray.tree"
+              << std::setw(10) << "ray.scan"
+              << std::setw(10) << "ovl.tree"
+              << std::setw(10) << "ovl.scan" << std::endl;
+    std::cout << std::fixed << std::setprecision(3);
+
+    bool ok = true;
+    for (int count : {1000, 10000, 100000}) {
+        ok = runBenchmark(count, frames, rng) && ok;
+    }
+
+    if (!ok) {
+        std::cerr << "Tree query results differ from the linear scan" << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,168 @@
+#include "glad/glad.h"
+#include <GLFW/glfw3.h>
+#include <glm/glm.hpp>
+#include <vector>
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <cstring>
+#include <cstdlib>
+#include <chrono>
+#include <filesystem>
+#include <nlohmann/json.hpp>
+#include "domain/TexturedObj.hpp"
+#include "domain/LightClusters.hpp"
+#include "domain/Lightmap.hpp"
+#include "domain/LightmapBaker.hpp"
+#include "domain/Logger.hpp"
+
+using json = nlohmann::json;
+
+// Offline bake of the static objects in a SceneViewer scene file: every object
+// without a trajectory gets lightmaps/<name>.lightmap, which SceneViewer picks
+// up on load. Objects and lights are read exactly as SceneViewer reads them,
+// since a lightmap is only used while both still match.
+
+// Same defaults as SceneViewer
+const float DEFAULT_LIGHT_RADIUS = 50.0f;
+const glm::vec3 DEFAULT_LIGHT_POSITION(2.0f, 4.0f, 6.0f);
+const std::string LIGHTMAP_DIRECTORY = "lightmaps/";
+
+void printUsage(const char* programName) {
+    std::cout << "Usage: " << programName << " [scene_config.json] [options]" << std::endl;
+    std::cout << "  --density N       lightmap texels per world unit (default 8)" << std::endl;
+    std::cout << "  --max-size N      largest atlas side (default 1024)" << std::endl;
+    std::cout << "  --samples N       ambient occlusion rays per texel (default 64)" << std::endl;
+    std::cout << "  --ao-distance D   ambient occlusion ray length (default 2)" << std::endl;
+    std::cout << "  --threads N       worker threads (default: all cores)" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    std::string sceneFile = "scene_config.json";
+    LightmapBaker::Settings settings;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--density" && hasValue) {
+            settings.texelsPerUnit = static_cast<float>(std::atof(argv[++i]));
+        } else if (arg == "--max-size" && hasValue) {
+            settings.maxSize = std::atoi(argv[++i]);
+        } else if (arg == "--samples" && hasValue) {
+            settings.aoSamples = std::atoi(argv[++i]);
+        } else if (arg == "--ao-distance" && hasValue) {
+            settings.aoDistance = static_cast<float>(std::atof(argv[++i]));
+        } else if (arg == "--threads" && hasValue) {
+            settings.threads = std::atoi(argv[++i]);
+        } else if (arg == "--help" || arg[0] == '-') {
+            printUsage(argv[0]);
+            return arg == "--help" ? 0 : -1;
+        } else {
+            sceneFile = arg;
+        }
+    }
+
+    std::ifstream file(sceneFile);
+    if (!file.is_open()) {
+        LOG_ERROR("Could not open scene configuration: " << sceneFile);
+        return -1;
+    }
+    json sceneData;
+    try {
+        file >> sceneData;
+    } catch (const json::exception& e) {
+        LOG_ERROR("JSON parsing error: " << e.what());
+        return -1;
+    }
+
+    // Meshes are loaded through TexturedObj so the vertex order matches what
+    // SceneViewer draws, and that needs a context; the window is never shown
+    glfwInit();
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    GLFWwindow* window = glfwCreateWindow(64, 64, "Lightmap Baker", NULL, NULL);
+    if (window == NULL) {
+        LOG_ERROR("Failed to create GLFW window");
+        glfwTerminate();
+        return -1;
+    }
+    glfwMakeContextCurrent(window);
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+        LOG_ERROR("Failed to initialize GLAD");
+        return -1;
+    }
+
+    // The enabled lights in file order, or SceneViewer's fallback light
+    std::vector<LightClusters::PointLight> lights;
+    if (sceneData.contains("lights")) {
+        for (const auto& lightData : sceneData["lights"]) {
+            if (!lightData.value("enabled", true)) continue;
+            glm::vec3 position(lightData["position"][0], lightData["position"][1], lightData["position"][2]);
+            glm::vec3 color(lightData["color"][0], lightData["color"][1], lightData["color"][2]);
+            float intensity = lightData["intensity"];
+            lights.push_back({position, lightData.value("radius", DEFAULT_LIGHT_RADIUS), color * intensity});
+        }
+    }
+    if (lights.empty()) {
+        lights.push_back({DEFAULT_LIGHT_POSITION, DEFAULT_LIGHT_RADIUS, glm::vec3(1.0f)});
+    }
+
+    LightmapBaker baker(settings);
+    baker.setLights(lights);
+
+    std::vector<std::string> names;
+    std::vector<TexturedObj*> objects;
+    if (sceneData.contains("objects")) {
+        for (const auto& objData : sceneData["objects"]) {
+            // Anything on a trajectory or recorded path moves, so it is lit at runtime
+            if (objData.contains("trajectory") || objData.contains("keyframes")) continue;
+
+            std::string objName = objData["name"];
+            TexturedObj* obj = new TexturedObj(objData["file"]);
+            if (objData.contains("position")) {
+                obj->translate(glm::vec3(objData["position"][0], objData["position"][1], objData["position"][2]));
+            }
+            if (objData.contains("rotation")) {
+                obj->setRotation(glm::vec3(objData["rotation"][0], objData["rotation"][1], objData["rotation"][2]));
+            }
+            if (objData.contains("scale")) {
+                obj->setScale(glm::vec3(objData["scale"][0], objData["scale"][1], objData["scale"][2]));
+            }
+
+            if (obj->getVertices().empty()) {
+                LOG_ERROR("Skipping " << objName << ": no textured mesh to attach lightmap UVs to");
+                delete obj;
+                continue;
+            }
+            baker.addMesh(obj->getVertices(), obj->getModelMatrix());
+            names.push_back(objName);
+            objects.push_back(obj);
+        }
+    }
+
+    if (objects.empty()) {
+        LOG_INFO("No static objects to bake");
+    } else {
+        auto start = std::chrono::steady_clock::now();
+        std::vector<Lightmap> lightmaps;
+        baker.bake(lightmaps);
+
+        std::filesystem::create_directories(LIGHTMAP_DIRECTORY);
+        for (size_t i = 0; i < lightmaps.size(); i++) {
+            if (lightmaps[i].width == 0) continue;
+            std::string path = LIGHTMAP_DIRECTORY + names[i] + ".lightmap";
+            if (lightmaps[i].save(path)) {
+                LOG_INFO("Wrote " << path);
+            }
+        }
+        LOG_INFO("Baked " << objects.size() << " static objects in "
+                 << std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() << " s");
+    }
+
+    for (TexturedObj* obj : objects) {
+        delete obj;
+    }
+    glfwTerminate();
+    return 0;
+}
@@ -3,10 +3,13 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
-#include <iostream>
 #include <vector>
+#include <string>
 #include "domain/Camera.hpp"
+#include "domain/CullingTitle.hpp"
 #include "domain/Shader.hpp"
+#include "domain/GLState.hpp"
+#include "domain/Logger.hpp"
 
 const unsigned int SCR_WIDTH = 1280;
 const unsigned int SCR_HEIGHT = 720;
@@ -84,7 +87,7 @@ int main()
 {
     if (!glfwInit())
     {
-        std::cerr << "Failed to initialize GLFW" << std::endl;
+        LOG_ERROR("Failed to initialize GLFW");
         return -1;
     }
 
@@ -95,7 +98,7 @@ int main()
     GLFWwindow *window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "Camera Demo", NULL, NULL);
     if (window == NULL)
     {
-        std::cerr << "Failed to create GLFW window" << std::endl;
+        LOG_ERROR("Failed to create GLFW window");
         glfwTerminate();
         return -1;
     }
@@ -108,11 +111,11 @@ int main()
 
     if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
     {
-        std::cerr << "Failed to initialize GLAD" << std::endl;
+        LOG_ERROR("Failed to initialize GLAD");
         return -1;
     }
 
-    glEnable(GL_DEPTH_TEST);
+    GLState::setDepthTest(true);
 
     Shader shader("src/shaders/camera.vert", "src/shaders/camera.frag");
 
@@ -120,7 +123,7 @@ int main()
     glGenVertexArrays(1, &VAO);
     glGenBuffers(1, &VBO);
 
-    glBindVertexArray(VAO);
+    GLState::bindVertexArray(VAO);
     glBindBuffer(GL_ARRAY_BUFFER, VBO);
     glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
 
@@ -130,6 +133,10 @@ int main()
     glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void *)(3 * sizeof(float)));
     glEnableVertexAttribArray(1);
 
+    AABB cubeBounds;
+    cubeBounds.min = glm::vec3(-0.5f);
+    cubeBounds.max = glm::vec3(0.5f);
+
     while (!glfwWindowShouldClose(window))
     {
         float currentFrame = glfwGetTime();
@@ -148,22 +155,34 @@ int main()
         shader.setMat4("projection", projection);
         shader.setMat4("view", view);
 
-        glBindVertexArray(VAO);
+        Frustum frustum = camera.GetFrustum(projection);
+        int visibleCount = 0;
+
+        GLState::bindVertexArray(VAO);
         for (unsigned int i = 0; i < 10; i++)
         {
             glm::mat4 model = glm::mat4(1.0f);
             model = glm::translate(model, cubePositions[i]);
             float angle = 20.0f * i;
             model = glm::rotate(model, glm::radians(angle), glm::vec3(1.0f, 0.3f, 0.5f));
+
+            if (!frustum.intersects(cubeBounds.transformed(model)))
+            {
+                continue;
+            }
+            visibleCount++;
+
             shader.setMat4("model", model);
             glDrawArrays(GL_TRIANGLES, 0, 36);
         }
 
+        updateCullingTitle(window, "Camera Demo", visibleCount, 10);
+
         glfwSwapBuffers(window);
         glfwPollEvents();
     }
 
-    glDeleteVertexArrays(1, &VAO);
+    GLState::deleteVertexArray(VAO);
     glDeleteBuffers(1, &VBO);
 
     glfwTerminate();
@@ -5,8 +5,13 @@
 #include <glm/gtc/type_ptr.hpp>
 #include <vector>
 #include <iostream>
+#include <string>
 #include "domain/Shader.hpp"
+#include "domain/GLState.hpp"
+#include "domain/Frustum.hpp"
+#include "domain/CullingTitle.hpp"
 #include "domain/Obj.hpp"
+#include "domain/Logger.hpp"
 
 const unsigned int SCR_WIDTH = 1280;
 const unsigned int SCR_HEIGHT = 720;
@@ -42,7 +47,7 @@ void processInput(GLFWwindow *window) {
     if (glfwGetKey(window, GLFW_KEY_TAB) == GLFW_PRESS) {
         if (!tabPressed && !objects.empty()) {
             selectedObject = (selectedObject + 1) % objects.size();
-            std::cout << "Selected object: " << selectedObject << std::endl;
+            LOG_INFO("Selected object: " << selectedObject);
             tabPressed = true;
         }
     } else {
@@ -130,7 +135,7 @@ int main(int argc, char* argv[]) {
 
     GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "Model Viewer", NULL, NULL);
     if (window == NULL) {
-        std::cout << "Failed to create GLFW window" << std::endl;
+        LOG_ERROR("Failed to create GLFW window");
         glfwTerminate();
         return -1;
     }
@@ -138,11 +143,11 @@ int main(int argc, char* argv[]) {
     glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
 
     if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
-        std::cout << "Failed to initialize GLAD" << std::endl;
+        LOG_ERROR("Failed to initialize GLAD");
         return -1;
     }
 
-    glEnable(GL_DEPTH_TEST);
+    GLState::setDepthTest(true);
 
     Shader shader("src/shaders/shader.vert", "src/shaders/shader.frag");
 
@@ -153,14 +158,14 @@ int main(int argc, char* argv[]) {
             obj->translate(glm::vec3(xOffset, 0.0f, 0.0f));
             objects.push_back(obj);
             xOffset += 2.0f;
-            std::cout << "Loaded model: " << argv[i] << std::endl;
+            LOG_INFO("Loaded model: " << argv[i]);
         } catch (const std::exception& e) {
-            std::cerr << "Failed to load model " << argv[i] << ": " << e.what() << std::endl;
+            LOG_ERROR("Failed to load model " << argv[i] << ": " << e.what());
         }
     }
 
     if (objects.empty()) {
-        std::cerr << "No valid models were loaded. Exiting.\n";
+        LOG_ERROR("No valid models were loaded. Exiting.");
         glfwTerminate();
         return -1;
     }
@@ -184,7 +189,16 @@ int main(int argc, char* argv[]) {
             (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
         shader.setMat4("projection", projection);
 
+        shader.setBool("wireframe", wireframeMode);
+        shader.setFloat("wireframeWidth", 1.0f);
+
+        Frustum frustum(projection * view);
+        int visibleCount = 0;
         for (size_t i = 0; i < objects.size(); i++) {
+            if (!frustum.intersects(objects[i]->getWorldBounds()))
+                continue;
+            visibleCount++;
+
             shader.setMat4("model", objects[i]->getModelMatrix());
             
             if (i == selectedObject)
@@ -192,17 +206,11 @@ int main(int argc, char* argv[]) {
             else
                 shader.setVec3("objectColor", glm::vec3(0.8f, 0.8f, 0.8f));
 
-            shader.setBool("wireframe", false);
             objects[i]->draw();
-
-            if (wireframeMode) {
-                glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-                shader.setBool("wireframe", true);
-                objects[i]->draw();
-                glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-            }
         }
 
+        updateCullingTitle(window, "Model Viewer", visibleCount, int(objects.size()));
+
         glfwSwapBuffers(window);
         glfwPollEvents();
     }
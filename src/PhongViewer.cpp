@@ -5,8 +5,13 @@
 #include <glm/gtc/type_ptr.hpp>
 #include <vector>
 #include <iostream>
+#include <string>
 #include "domain/Shader.hpp"
+#include "domain/GLState.hpp"
+#include "domain/Frustum.hpp"
+#include "domain/CullingTitle.hpp"
 #include "domain/TexturedObj.hpp"
+#include "domain/Logger.hpp"
 
 const unsigned int SCR_WIDTH = 1280;
 const unsigned int SCR_HEIGHT = 720;
@@ -54,7 +59,7 @@ void processInput(GLFWwindow *window)
         if (!tabPressed && !objects.empty())
         {
             selectedObject = (selectedObject + 1) % objects.size();
-            std::cout << "Selected object: " << selectedObject << std::endl;
+            LOG_INFO("Selected object: " << selectedObject);
             tabPressed = true;
         }
     }
@@ -190,7 +195,7 @@ int main(int argc, char *argv[])
     GLFWwindow *window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "Phong Viewer - Complete Lighting Model", NULL, NULL);
     if (window == NULL)
     {
-        std::cout << "Failed to create GLFW window" << std::endl;
+        LOG_ERROR("Failed to create GLFW window");
         glfwTerminate();
         return -1;
     }
@@ -199,11 +204,11 @@ int main(int argc, char *argv[])
 
     if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
     {
-        std::cout << "Failed to initialize GLAD" << std::endl;
+        LOG_ERROR("Failed to initialize GLAD");
         return -1;
     }
 
-    glEnable(GL_DEPTH_TEST);
+    GLState::setDepthTest(true);
 
     Shader phongShader("src/shaders/phong.vert", "src/shaders/phong.frag");
 
@@ -216,17 +221,17 @@ int main(int argc, char *argv[])
             obj->translate(glm::vec3(xOffset, 0.0f, 0.0f));
             objects.push_back(obj);
             xOffset += 3.0f;
-            std::cout << "Loaded model: " << argv[i] << std::endl;
+            LOG_INFO("Loaded model: " << argv[i]);
         }
         catch (const std::exception &e)
         {
-            std::cerr << "Failed to load model " << argv[i] << ": " << e.what() << std::endl;
+            LOG_ERROR("Failed to load model " << argv[i] << ": " << e.what());
         }
     }
 
     if (objects.empty())
     {
-        std::cerr << "No valid models were loaded. Exiting.\n";
+        LOG_ERROR("No valid models were loaded. Exiting.");
         glfwTerminate();
         return -1;
     }
@@ -255,8 +260,20 @@ int main(int argc, char *argv[])
         phongShader.setVec3("lightColor", lightColor);
         phongShader.setVec3("viewPos", cameraPos);
 
+        phongShader.setBool("wireframe", wireframeMode);
+        phongShader.setVec3("wireframeColor", glm::vec3(1.0f));
+        phongShader.setFloat("wireframeWidth", 1.0f);
+
+        Frustum frustum(projection * view);
+        int visibleCount = 0;
         for (size_t i = 0; i < objects.size(); i++)
         {
+            if (!frustum.intersects(objects[i]->getWorldBounds()))
+            {
+                continue;
+            }
+            visibleCount++;
+
             phongShader.setMat4("model", objects[i]->getModelMatrix());
 
             bool isSelected = (i == selectedObject);
@@ -292,17 +309,10 @@ int main(int argc, char *argv[])
 
                 objects[i]->drawWithTextures();
             }
-
-            if (wireframeMode)
-            {
-                glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-                phongShader.setBool("useTexture", false);
-                phongShader.setFloat("kd", 1.0f);
-                objects[i]->drawWithTextures();
-                glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-            }
         }
 
+        updateCullingTitle(window, "Phong Viewer - Complete Lighting Model", visibleCount, int(objects.size()));
+
         glfwSwapBuffers(window);
         glfwPollEvents();
     }
@@ -5,15 +5,41 @@
 #include <glm/gtc/type_ptr.hpp>
 #include <vector>
 #include <iostream>
+#include <iomanip>
 #include <fstream>
 #include <sstream>
 #include <string>
+#include <cstring>
 #include <map>
+#include <algorithm>
+#include <cmath>
+#include <thread>
+#include <random>
+#include <filesystem>
 #include <nlohmann/json.hpp>
 #include "domain/Shader.hpp"
+#include "domain/GLState.hpp"
 #include "domain/TexturedObj.hpp"
 #include "domain/Trajectory.hpp"
+#include "domain/TrajectorySystem.hpp"
+#include "domain/KeyframeTrack.hpp"
 #include "domain/Camera.hpp"
+#include "domain/RingBuffer.hpp"
+#include "domain/AABBTree.hpp"
+#include "domain/OcclusionCuller.hpp"
+#include "domain/LODSelector.hpp"
+#include "domain/ImpostorRenderer.hpp"
+#include "domain/GPUDrivenRenderer.hpp"
+#include "domain/LightClusters.hpp"
+#include "domain/DeferredRenderer.hpp"
+#include "domain/ShadowCache.hpp"
+#include "domain/Lightmap.hpp"
+#include "domain/CrowdRenderer.hpp"
+#include "domain/CurveRenderer.hpp"
+#include "domain/SimulationClock.hpp"
+#include "domain/Logger.hpp"
+#include "domain/InputRecorder.hpp"
+#include "domain/FrameTimings.hpp"
 
 using json = nlohmann::json;
 
@@ -30,11 +56,35 @@ struct Light {
     glm::vec3 color;
     float intensity;
     bool enabled;
+    float radius;
 };
 
+const glm::vec3 WIREFRAME_COLOR(0.9f);
+
+// Used when a light in the scene file has no "radius"
+const float DEFAULT_LIGHT_RADIUS = 50.0f;
+
+// Written by BakeLightmaps as <object name>.lightmap
+const std::string LIGHTMAP_DIRECTORY = "lightmaps/";
+const std::string KEYFRAME_DIRECTORY = "keyframes/";
+const float KEYFRAME_RATE = 120.0f;
+const int LIGHTMAP_UNIT = 4;
+
+// Crowd instances are scattered this far to either side of their path
+const float CROWD_SPREAD = 3.0f;
+
+const glm::vec4 CURVE_COLOR(1.0f, 0.8f, 0.2f, 1.0f);
+const glm::vec4 CURVE_MARKER_COLOR(1.0f, 0.3f, 0.2f, 1.0f);
+
 std::vector<Light> lights;
 int selectedLight = 0;
 
+struct ObjectTransform {
+    glm::vec3 position = glm::vec3(0.0f);
+    glm::vec3 rotation = glm::vec3(0.0f);
+    glm::vec3 scale = glm::vec3(1.0f);
+};
+
 struct SceneObject {
     TexturedObj* obj;
     Trajectory trajectory;
@@ -44,13 +94,130 @@ struct SceneObject {
     glm::vec3 initialPosition;
     glm::vec3 initialRotation;
     glm::vec3 initialScale;
+
+    // Proxy in objectTree and the transform it was last synced with
+    int treeProxy = AABBTree::NULL_NODE;
+    unsigned int treeVersion = 0;
+    glm::vec3 treeCenter = glm::vec3(0.0f);
+
+    // Shared with every object loaded from the same file
+    const ImpostorRenderer::Atlas* impostor = nullptr;
+
+    // Slot in the GPU-driven renderer and the state last uploaded to it
+    int gpuObject = -1;
+    unsigned int gpuVersion = ~0u;
+    bool gpuSelected = false;
+
+    // Baked lighting of a static object; texels and UVs are dropped once uploaded
+    Lightmap lightmap;
+    GLuint lightmapTexture = 0;
+
+    // Mover in trajectorySystem while moving, and how far along its path it is
+    int mover = -1;
+    float trajectoryDistance = 0.0f;
+
+    // Recorded path played back instead of the trajectory, and the playhead
+    KeyframeTrack* keyframes = nullptr;
+    std::string keyframeFile;
+    float keyframeTime = 0.0f;
+
+    // Transform after the previous and the latest simulation step; obj holds a
+    // blend of the two, stamped with the transform version it had then
+    ObjectTransform previousTransform;
+    ObjectTransform currentTransform;
+    unsigned int blendVersion = ~0u;
 };
 
 std::vector<SceneObject> sceneObjects;
 int selectedObject = 0;
 
+// The moving objects' trajectories, compiled. Rebuilt whenever a trajectory
+// or the set of moving objects changes.
+TrajectorySystem trajectorySystem;
+bool trajectoriesDirty = true;
+
+// Trajectories and held-key transforms advance in fixed steps of this clock
+SimulationClock simulationClock;
+
+// Keys are indices into sceneObjects
+AABBTree objectTree;
+
 bool wireframeMode = false;
 
+struct RenderSettings {
+    bool depthPrepass = false;
+    GLenum prepassDepthFunc = GL_LEQUAL;
+    bool showOverdraw = false;
+    bool frustumCulling = true;
+    bool occlusionCulling = false;
+    bool levelOfDetail = true;
+    bool impostors = true;
+    float impostorDistance = 40.0f;
+    bool gpuDriven = false;
+    bool deferredShading = false;
+    bool shadows = true;
+    bool lightmaps = true;
+    bool crowd = false;
+    int crowdSize = 100000;
+    bool curves = false;
+    float curveTolerance = CurveRenderer::DEFAULT_TOLERANCE;
+};
+RenderSettings renderSettings;
+
+// Mirrors the std140 ObjectData block in scene.vert and the std430 array in scene_indirect.vert
+struct ObjectUniforms {
+    glm::mat4 model;
+    glm::vec4 material;
+    int flags[4];
+    glm::vec4 params;
+};
+
+const GLuint OBJECT_BLOCK_BINDING = 0;
+
+struct FrameStats {
+    float elapsed = 0.0f;
+    int frames = 0;
+    unsigned int ringStalls = 0;
+    unsigned long glCallsIssued = 0;
+    unsigned long glCallsElided = 0;
+    unsigned long visibleObjects = 0;
+    unsigned long culledObjects = 0;
+    unsigned long occludedObjects = 0;
+    unsigned long occlusionQueries = 0;
+    unsigned long pendingQueries = 0;
+    unsigned long trianglesDrawn = 0;
+    unsigned long impostorsDrawn = 0;
+    unsigned long lightVolumes = 0;
+    unsigned long shadowInvalidations = 0;
+    unsigned long shadowPasses = 0;
+    unsigned long lightmappedObjects = 0;
+    unsigned long simulationSteps = 0;
+};
+FrameStats frameStats;
+
+OcclusionCuller* occlusionCuller = nullptr;
+LODSelector lodSelector;
+ImpostorRenderer* impostorRenderer = nullptr;
+GPUDrivenRenderer* gpuRenderer = nullptr;
+LightClusters* lightClusters = nullptr;
+DeferredRenderer* deferredRenderer = nullptr;
+ShadowCache* shadowCache = nullptr;
+CrowdRenderer* crowdRenderer = nullptr;
+CurveRenderer* curveRenderer = nullptr;
+bool crowdDirty = true;
+float crowdTime = 0.0f;
+std::vector<LightClusters::PointLight> clusterLights;
+std::vector<int> shadowKeys;
+std::vector<TexturedObj*> shadowCasters;
+
+// The setting survives in the JSON even when the context is older than 4.3
+bool gpuDrivenActive() {
+    return renderSettings.gpuDriven && gpuRenderer != nullptr;
+}
+
+// Mesh and impostor are dithered together over this fraction of impostorDistance
+const float IMPOSTOR_FADE_BAND = 0.2f;
+
 enum TransformMode {
     TRANSLATE,
     ROTATE,
@@ -65,12 +232,21 @@ bool firstMouse = true;
 float deltaTime = 0.0f;
 float lastFrame = 0.0f;
 
+// Keys, mouse motion and deltaTime of the current frame, live or replayed
+InputRecorder input;
+FrameTimings* frameTimings = nullptr;
+
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
 void processInput(GLFWwindow* window);
+void simulateInput(float step);
 void printUsage(const char* programName);
 bool loadSceneConfig(const std::string& filename);
 void saveSceneConfig(const std::string& filename);
+void updateWindowTitle(GLFWwindow* window);
+void syncObjectTree();
+void pickObjectAtCrosshair();
+void loadLightmap(SceneObject& obj);
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height) {
     glViewport(0, 0, width, height);
@@ -90,57 +266,71 @@ void mouse_callback(GLFWwindow* window, double xpos, double ypos) {
     lastX = xpos;
     lastY = ypos;
 
-    camera.Rotate(xoffset, yoffset);
+    input.moveCursor(xoffset, yoffset);
 }
 
 void processInput(GLFWwindow* window) {
-    if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+    glm::vec2 look = input.getCursorOffset();
+    if (look.x != 0.0f || look.y != 0.0f)
+        camera.Rotate(look.x, look.y);
+
+    if (input.getKey(GLFW_KEY_ESCAPE) == GLFW_PRESS)
         glfwSetWindowShouldClose(window, true);
 
-    if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
+    if (input.getKey(GLFW_KEY_W) == GLFW_PRESS)
         camera.MoveForward(deltaTime);
-    if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
+    if (input.getKey(GLFW_KEY_S) == GLFW_PRESS)
         camera.MoveBackward(deltaTime);
-    if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
+    if (input.getKey(GLFW_KEY_A) == GLFW_PRESS)
         camera.MoveLeft(deltaTime);
-    if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
+    if (input.getKey(GLFW_KEY_D) == GLFW_PRESS)
         camera.MoveRight(deltaTime);
-    if (glfwGetKey(window, GLFW_KEY_SPACE) == GLFW_PRESS)
+    if (input.getKey(GLFW_KEY_SPACE) == GLFW_PRESS)
         camera.MoveUp(deltaTime);
-    if (glfwGetKey(window, GLFW_KEY_LEFT_CONTROL) == GLFW_PRESS)
+    if (input.getKey(GLFW_KEY_LEFT_CONTROL) == GLFW_PRESS)
         camera.MoveDown(deltaTime);
 
     static bool tabPressed = false;
-    if (glfwGetKey(window, GLFW_KEY_TAB) == GLFW_PRESS) {
+    if (input.getKey(GLFW_KEY_TAB) == GLFW_PRESS) {
         if (!tabPressed && !sceneObjects.empty()) {
             selectedObject = (selectedObject + 1) % sceneObjects.size();
-            std::cout << "Selected object: " << sceneObjects[selectedObject].name << std::endl;
+            LOG_INFO("Selected object: " << sceneObjects[selectedObject].name);
             tabPressed = true;
         }
     } else {
         tabPressed = false;
     }
 
+    static bool ePressed = false;
+    if (input.getKey(GLFW_KEY_E) == GLFW_PRESS) {
+        if (!ePressed) {
+            pickObjectAtCrosshair();
+            ePressed = true;
+        }
+    } else {
+        ePressed = false;
+    }
+
     static bool lPressed = false;
-    if (glfwGetKey(window, GLFW_KEY_L) == GLFW_PRESS) {
+    if (input.getKey(GLFW_KEY_L) == GLFW_PRESS) {
         if (!lPressed && !lights.empty()) {
             selectedLight = (selectedLight + 1) % lights.size();
-            std::cout << "Selected light: " << selectedLight << std::endl;
+            LOG_INFO("Selected light: " << selectedLight);
             lPressed = true;
         }
     } else {
         lPressed = false;
     }
 
-    if (glfwGetKey(window, GLFW_KEY_T) == GLFW_PRESS)
+    if (input.getKey(GLFW_KEY_T) == GLFW_PRESS)
         currentMode = TRANSLATE;
-    if (glfwGetKey(window, GLFW_KEY_R) == GLFW_PRESS)
+    if (input.getKey(GLFW_KEY_R) == GLFW_PRESS)
         currentMode = ROTATE;
-    if (glfwGetKey(window, GLFW_KEY_G) == GLFW_PRESS)
+    if (input.getKey(GLFW_KEY_G) == GLFW_PRESS)
         currentMode = SCALE;
 
     static bool fKeyPressed = false;
-    if (glfwGetKey(window, GLFW_KEY_F) == GLFW_PRESS) {
+    if (input.getKey(GLFW_KEY_F) == GLFW_PRESS) {
         if (!fKeyPressed) {
             wireframeMode = !wireframeMode;
             fKeyPressed = true;
@@ -151,14 +341,14 @@ void processInput(GLFWwindow* window) {
 
     if (!sceneObjects.empty() && selectedObject >= 0 && selectedObject < sceneObjects.size()) {
         SceneObject& obj = sceneObjects[selectedObject];
-        float speed = 2.5f * deltaTime;
 
         static bool cPressed = false;
-        if (glfwGetKey(window, GLFW_KEY_C) == GLFW_PRESS) {
+        if (input.getKey(GLFW_KEY_C) == GLFW_PRESS) {
             if (!cPressed) {
                 glm::mat4 modelMatrix = obj.obj->getModelMatrix();
                 glm::vec3 currentPos(modelMatrix[3][0], modelMatrix[3][1], modelMatrix[3][2]);
                 obj.trajectory.addPoint(currentPos);
+                trajectoriesDirty = true;
                 cPressed = true;
             }
         } else {
@@ -166,10 +356,11 @@ void processInput(GLFWwindow* window) {
         }
 
         static bool mPressed = false;
-        if (glfwGetKey(window, GLFW_KEY_M) == GLFW_PRESS) {
+        if (input.getKey(GLFW_KEY_M) == GLFW_PRESS) {
             if (!mPressed) {
                 obj.isMoving = !obj.isMoving;
-                std::cout << "Object " << obj.name << (obj.isMoving ? " started" : " stopped") << " movement" << std::endl;
+                trajectoriesDirty = true;
+                LOG_INFO("Object " << obj.name << (obj.isMoving ? " started" : " stopped") << " movement");
                 mPressed = true;
             }
         } else {
@@ -177,10 +368,12 @@ void processInput(GLFWwindow* window) {
         }
 
         static bool nPressed = false;
-        if (glfwGetKey(window, GLFW_KEY_N) == GLFW_PRESS) {
+        if (input.getKey(GLFW_KEY_N) == GLFW_PRESS) {
             if (!nPressed) {
                 obj.trajectory.clear();
-                std::cout << "Cleared trajectory for " << obj.name << std::endl;
+                obj.trajectoryDistance = 0.0f;
+                trajectoriesDirty = true;
+                LOG_INFO("Cleared trajectory for " << obj.name);
                 nPressed = true;
             }
         } else {
@@ -188,7 +381,7 @@ void processInput(GLFWwindow* window) {
         }
 
         static bool iPressed = false;
-        if (glfwGetKey(window, GLFW_KEY_I) == GLFW_PRESS) {
+        if (input.getKey(GLFW_KEY_I) == GLFW_PRESS) {
             if (!iPressed) {
                 InterpolationType currentType = obj.trajectory.getInterpolationType();
                 InterpolationType newType;
@@ -204,7 +397,8 @@ void processInput(GLFWwindow* window) {
                         break;
                 }
                 obj.trajectory.setInterpolationType(newType);
-                std::cout << "Changed interpolation type for " << obj.name << std::endl;
+                trajectoriesDirty = true;
+                LOG_INFO("Changed interpolation type for " << obj.name);
                 iPressed = true;
             }
         } else {
@@ -212,7 +406,7 @@ void processInput(GLFWwindow* window) {
         }
 
         static bool oPressed = false;
-        if (glfwGetKey(window, GLFW_KEY_O) == GLFW_PRESS) {
+        if (input.getKey(GLFW_KEY_O) == GLFW_PRESS) {
             if (!oPressed) {
                 InterpolationType currentType = obj.trajectory.getInterpolationType();
                 std::string typeName;
@@ -227,8 +421,8 @@ void processInput(GLFWwindow* window) {
                         typeName = "SPLINE";
                         break;
                 }
-                std::cout << "Object " << obj.name << " interpolation type: " << typeName 
-                          << " (Speed: " << obj.trajectory.getSpeed() << ")" << std::endl;
+                LOG_INFO("Object " << obj.name << " interpolation type: " << typeName 
+                         << " (Speed: " << obj.trajectory.getSpeed() << ")");
                 oPressed = true;
             }
         } else {
@@ -236,81 +430,187 @@ void processInput(GLFWwindow* window) {
         }
 
         static bool pPressed = false;
-        if (glfwGetKey(window, GLFW_KEY_P) == GLFW_PRESS) {
+        if (input.getKey(GLFW_KEY_P) == GLFW_PRESS) {
             if (!pPressed) {
                 float currentSpeed = obj.trajectory.getSpeed();
                 float newSpeed = currentSpeed + 0.5f;
                 if (newSpeed > 5.0f) newSpeed = 0.5f;
                 obj.trajectory.setSpeed(newSpeed);
-                std::cout << "Changed trajectory speed for " << obj.name << " to: " << newSpeed << std::endl;
+                trajectoriesDirty = true;
+                LOG_INFO("Changed trajectory speed for " << obj.name << " to: " << newSpeed);
                 pPressed = true;
             }
         } else {
             pPressed = false;
         }
 
-        switch (currentMode) {
-            case TRANSLATE:
-                if (glfwGetKey(window, GLFW_KEY_UP) == GLFW_PRESS)
-                    obj.obj->translate(glm::vec3(0.0f, speed, 0.0f));
-                if (glfwGetKey(window, GLFW_KEY_DOWN) == GLFW_PRESS)
-                    obj.obj->translate(glm::vec3(0.0f, -speed, 0.0f));
-                if (glfwGetKey(window, GLFW_KEY_LEFT) == GLFW_PRESS)
-                    obj.obj->translate(glm::vec3(-speed, 0.0f, 0.0f));
-                if (glfwGetKey(window, GLFW_KEY_RIGHT) == GLFW_PRESS)
-                    obj.obj->translate(glm::vec3(speed, 0.0f, 0.0f));
-                if (glfwGetKey(window, GLFW_KEY_PAGE_UP) == GLFW_PRESS)
-                    obj.obj->translate(glm::vec3(0.0f, 0.0f, -speed));
-                if (glfwGetKey(window, GLFW_KEY_PAGE_DOWN) == GLFW_PRESS)
-                    obj.obj->translate(glm::vec3(0.0f, 0.0f, speed));
-                break;
-
-            case ROTATE:
-                if (glfwGetKey(window, GLFW_KEY_X) == GLFW_PRESS)
-                    obj.obj->rotate(speed * 50.0f, glm::vec3(1.0f, 0.0f, 0.0f));
-                if (glfwGetKey(window, GLFW_KEY_Y) == GLFW_PRESS)
-                    obj.obj->rotate(speed * 50.0f, glm::vec3(0.0f, 1.0f, 0.0f));
-                if (glfwGetKey(window, GLFW_KEY_Z) == GLFW_PRESS)
-                    obj.obj->rotate(speed * 50.0f, glm::vec3(0.0f, 0.0f, 1.0f));
-                break;
-
-            case SCALE:
-                if (glfwGetKey(window, GLFW_KEY_UP) == GLFW_PRESS)
-                    obj.obj->setScale(obj.obj->scale + glm::vec3(speed * 0.1f));
-                if (glfwGetKey(window, GLFW_KEY_DOWN) == GLFW_PRESS) {
-                    glm::vec3 newScale = obj.obj->scale - glm::vec3(speed * 0.1f);
-                    newScale = glm::max(newScale, glm::vec3(0.01f)); // Minimum scale of 0.01
-                    obj.obj->setScale(newScale);
+        // Records one lap of the trajectory and plays it back from the file from then on
+        static bool jPressed = false;
+        if (input.getKey(GLFW_KEY_J) == GLFW_PRESS) {
+            if (!jPressed) {
+                KeyframeWriter writer(KeyframeTrack::QUANTIZED16_DELTA);
+                writer.addTrajectory(obj.trajectory, KEYFRAME_RATE);
+                std::string path = KEYFRAME_DIRECTORY + obj.name + ".keyframes";
+                std::error_code error;
+                std::filesystem::create_directories(KEYFRAME_DIRECTORY, error);
+                KeyframeTrack* keyframes = new KeyframeTrack();
+                if (writer.getSampleCount() > 0 && writer.save(path) && keyframes->open(path)) {
+                    delete obj.keyframes;
+                    obj.keyframes = keyframes;
+                    obj.keyframeFile = path;
+                    obj.keyframeTime = 0.0f;
+                    trajectoriesDirty = true;
+                    LOG_INFO("Recorded " << writer.getSampleCount() << " keyframes for " << obj.name << " to " << path);
+                } else {
+                    delete keyframes;
+                    LOG_WARNING("No keyframes recorded for " << obj.name << " (it needs a trajectory)");
                 }
-                break;
+                jPressed = true;
+            }
+        } else {
+            jPressed = false;
         }
     }
 
-    if (!lights.empty() && selectedLight >= 0 && selectedLight < lights.size()) {
-        Light& light = lights[selectedLight];
-        float lightSpeed = 3.0f * deltaTime;
+    static bool f3Pressed = false;
+    if (input.getKey(GLFW_KEY_F3) == GLFW_PRESS) {
+        if (!f3Pressed) {
+            renderSettings.depthPrepass = !renderSettings.depthPrepass;
+            LOG_INFO("Depth pre-pass: " << (renderSettings.depthPrepass ? "ON" : "OFF"));
+            f3Pressed = true;
+        }
+    } else {
+        f3Pressed = false;
+    }
 
-        if (glfwGetKey(window, GLFW_KEY_KP_4) == GLFW_PRESS)
-            light.position.x -= lightSpeed;
-        if (glfwGetKey(window, GLFW_KEY_KP_6) == GLFW_PRESS)
-            light.position.x += lightSpeed;
-        if (glfwGetKey(window, GLFW_KEY_KP_2) == GLFW_PRESS)
-            light.position.y -= lightSpeed;
-        if (glfwGetKey(window, GLFW_KEY_KP_8) == GLFW_PRESS)
-            light.position.y += lightSpeed;
-        if (glfwGetKey(window, GLFW_KEY_KP_7) == GLFW_PRESS)
-            light.position.z -= lightSpeed;
-        if (glfwGetKey(window, GLFW_KEY_KP_9) == GLFW_PRESS)
-            light.position.z += lightSpeed;
+    static bool f4Pressed = false;
+    if (input.getKey(GLFW_KEY_F4) == GLFW_PRESS) {
+        if (!f4Pressed) {
+            renderSettings.showOverdraw = !renderSettings.showOverdraw;
+            LOG_INFO("Overdraw view: " << (renderSettings.showOverdraw ? "ON" : "OFF"));
+            f4Pressed = true;
+        }
+    } else {
+        f4Pressed = false;
+    }
+
+    static bool f5Pressed = false;
+    if (input.getKey(GLFW_KEY_F5) == GLFW_PRESS) {
+        if (!f5Pressed) {
+            renderSettings.frustumCulling = !renderSettings.frustumCulling;
+            LOG_INFO("Frustum culling: " << (renderSettings.frustumCulling ? "ON" : "OFF"));
+            f5Pressed = true;
+        }
+    } else {
+        f5Pressed = false;
+    }
 
-        if (glfwGetKey(window, GLFW_KEY_KP_ADD) == GLFW_PRESS)
-            light.intensity += 0.1f;
-        if (glfwGetKey(window, GLFW_KEY_KP_SUBTRACT) == GLFW_PRESS)
-            light.intensity = std::max(0.0f, light.intensity - 0.1f);
+    static bool f6Pressed = false;
+    if (input.getKey(GLFW_KEY_F6) == GLFW_PRESS) {
+        if (!f6Pressed) {
+            renderSettings.occlusionCulling = !renderSettings.occlusionCulling;
+            LOG_INFO("Occlusion culling: " << (renderSettings.occlusionCulling ? "ON" : "OFF"));
+            f6Pressed = true;
+        }
+    } else {
+        f6Pressed = false;
+    }
+
+    static bool f7Pressed = false;
+    if (input.getKey(GLFW_KEY_F7) == GLFW_PRESS) {
+        if (!f7Pressed) {
+            renderSettings.levelOfDetail = !renderSettings.levelOfDetail;
+            LOG_INFO("Level of detail: " << (renderSettings.levelOfDetail ? "ON" : "OFF"));
+            f7Pressed = true;
+        }
+    } else {
+        f7Pressed = false;
+    }
+
+    static bool f8Pressed = false;
+    if (input.getKey(GLFW_KEY_F8) == GLFW_PRESS) {
+        if (!f8Pressed) {
+            renderSettings.impostors = !renderSettings.impostors;
+            LOG_INFO("Impostors: " << (renderSettings.impostors ? "ON" : "OFF"));
+            f8Pressed = true;
+        }
+    } else {
+        f8Pressed = false;
+    }
+
+    static bool f9Pressed = false;
+    if (input.getKey(GLFW_KEY_F9) == GLFW_PRESS) {
+        if (!f9Pressed) {
+            if (gpuRenderer != nullptr) {
+                renderSettings.gpuDriven = !renderSettings.gpuDriven;
+                LOG_INFO("GPU-driven rendering: " << (renderSettings.gpuDriven ? "ON" : "OFF"));
+            } else {
+                LOG_INFO("GPU-driven rendering needs OpenGL 4.3");
+            }
+            f9Pressed = true;
+        }
+    } else {
+        f9Pressed = false;
+    }
+
+    static bool f10Pressed = false;
+    if (input.getKey(GLFW_KEY_F10) == GLFW_PRESS) {
+        if (!f10Pressed) {
+            renderSettings.deferredShading = !renderSettings.deferredShading;
+            LOG_INFO("Deferred shading: " << (renderSettings.deferredShading ? "ON" : "OFF"));
+            f10Pressed = true;
+        }
+    } else {
+        f10Pressed = false;
+    }
+
+    static bool f11Pressed = false;
+    if (input.getKey(GLFW_KEY_F11) == GLFW_PRESS) {
+        if (!f11Pressed) {
+            renderSettings.shadows = !renderSettings.shadows;
+            LOG_INFO("Shadows: " << (renderSettings.shadows ? "ON" : "OFF"));
+            f11Pressed = true;
+        }
+    } else {
+        f11Pressed = false;
+    }
+
+    static bool f12Pressed = false;
+    if (input.getKey(GLFW_KEY_F12) == GLFW_PRESS) {
+        if (!f12Pressed) {
+            renderSettings.lightmaps = !renderSettings.lightmaps;
+            LOG_INFO("Baked lightmaps: " << (renderSettings.lightmaps ? "ON" : "OFF"));
+            f12Pressed = true;
+        }
+    } else {
+        f12Pressed = false;
+    }
+
+    static bool kPressed = false;
+    if (input.getKey(GLFW_KEY_K) == GLFW_PRESS) {
+        if (!kPressed) {
+            renderSettings.crowd = !renderSettings.crowd;
+            crowdDirty = true;
+            LOG_INFO("GPU crowd: " << (renderSettings.crowd ? "ON" : "OFF"));
+            kPressed = true;
+        }
+    } else {
+        kPressed = false;
+    }
+
+    static bool vPressed = false;
+    if (input.getKey(GLFW_KEY_V) == GLFW_PRESS) {
+        if (!vPressed) {
+            renderSettings.curves = !renderSettings.curves;
+            LOG_INFO("Trajectory curves: " << (renderSettings.curves ? "ON" : "OFF"));
+            vPressed = true;
+        }
+    } else {
+        vPressed = false;
     }
 
     static bool f1Pressed = false;
-    if (glfwGetKey(window, GLFW_KEY_F1) == GLFW_PRESS) {
+    if (input.getKey(GLFW_KEY_F1) == GLFW_PRESS) {
         if (!f1Pressed) {
             saveSceneConfig("scene_config.json");
             f1Pressed = true;
@@ -320,7 +620,7 @@ void processInput(GLFWwindow* window) {
     }
 
     static bool f2Pressed = false;
-    if (glfwGetKey(window, GLFW_KEY_F2) == GLFW_PRESS) {
+    if (input.getKey(GLFW_KEY_F2) == GLFW_PRESS) {
         if (!f2Pressed) {
             loadSceneConfig("scene_config.json");
             f2Pressed = true;
@@ -330,9 +630,76 @@ void processInput(GLFWwindow* window) {
     }
 }
 
+// Held keys that transform the selected object; run once per simulation step
+void simulateInput(float step) {
+    if (!lights.empty() && selectedLight >= 0 && selectedLight < lights.size()) {
+        Light& light = lights[selectedLight];
+        float lightSpeed = 3.0f * step;
+
+        if (input.getKey(GLFW_KEY_KP_4) == GLFW_PRESS)
+            light.position.x -= lightSpeed;
+        if (input.getKey(GLFW_KEY_KP_6) == GLFW_PRESS)
+            light.position.x += lightSpeed;
+        if (input.getKey(GLFW_KEY_KP_2) == GLFW_PRESS)
+            light.position.y -= lightSpeed;
+        if (input.getKey(GLFW_KEY_KP_8) == GLFW_PRESS)
+            light.position.y += lightSpeed;
+        if (input.getKey(GLFW_KEY_KP_7) == GLFW_PRESS)
+            light.position.z -= lightSpeed;
+        if (input.getKey(GLFW_KEY_KP_9) == GLFW_PRESS)
+            light.position.z += lightSpeed;
+
+        if (input.getKey(GLFW_KEY_KP_ADD) == GLFW_PRESS)
+            light.intensity += 6.0f * step;
+        if (input.getKey(GLFW_KEY_KP_SUBTRACT) == GLFW_PRESS)
+            light.intensity = std::max(0.0f, light.intensity - 6.0f * step);
+    }
+
+    if (sceneObjects.empty() || selectedObject < 0 || selectedObject >= sceneObjects.size()) return;
+
+    SceneObject& obj = sceneObjects[selectedObject];
+    float speed = 2.5f * step;
+
+    switch (currentMode) {
+        case TRANSLATE:
+            if (input.getKey(GLFW_KEY_UP) == GLFW_PRESS)
+                obj.obj->translate(glm::vec3(0.0f, speed, 0.0f));
+            if (input.getKey(GLFW_KEY_DOWN) == GLFW_PRESS)
+                obj.obj->translate(glm::vec3(0.0f, -speed, 0.0f));
+            if (input.getKey(GLFW_KEY_LEFT) == GLFW_PRESS)
+                obj.obj->translate(glm::vec3(-speed, 0.0f, 0.0f));
+            if (input.getKey(GLFW_KEY_RIGHT) == GLFW_PRESS)
+                obj.obj->translate(glm::vec3(speed, 0.0f, 0.0f));
+            if (input.getKey(GLFW_KEY_PAGE_UP) == GLFW_PRESS)
+                obj.obj->translate(glm::vec3(0.0f, 0.0f, -speed));
+            if (input.getKey(GLFW_KEY_PAGE_DOWN) == GLFW_PRESS)
+                obj.obj->translate(glm::vec3(0.0f, 0.0f, speed));
+            break;
+
+        case ROTATE:
+            if (input.getKey(GLFW_KEY_X) == GLFW_PRESS)
+                obj.obj->rotate(speed * 50.0f, glm::vec3(1.0f, 0.0f, 0.0f));
+            if (input.getKey(GLFW_KEY_Y) == GLFW_PRESS)
+                obj.obj->rotate(speed * 50.0f, glm::vec3(0.0f, 1.0f, 0.0f));
+            if (input.getKey(GLFW_KEY_Z) == GLFW_PRESS)
+                obj.obj->rotate(speed * 50.0f, glm::vec3(0.0f, 0.0f, 1.0f));
+            break;
+
+        case SCALE:
+            if (input.getKey(GLFW_KEY_UP) == GLFW_PRESS)
+                obj.obj->setScale(obj.obj->scale + glm::vec3(speed * 0.1f));
+            if (input.getKey(GLFW_KEY_DOWN) == GLFW_PRESS) {
+                glm::vec3 newScale = obj.obj->scale - glm::vec3(speed * 0.1f);
+                newScale = glm::max(newScale, glm::vec3(0.01f)); // Minimum scale of 0.01
+                obj.obj->setScale(newScale);
+            }
+            break;
+    }
+}
+
 void printUsage(const char* programName) {
     std::cout << "=== SCENE VIEWER - Complete 3D Scene Visualization ===" << std::endl;
-    std::cout << "Usage: " << programName << " [scene_config.json]" << std::endl;
+    std::cout << "Usage: " << programName << " [scene_config.json] [--record file | --replay file] [--timings file.csv] [--headless]" << std::endl;
     std::cout << "Features: Multiple OBJ loading, Phong lighting, parametric curves, JSON scene config" << std::endl;
     std::cout << std::endl;
     std::cout << "Camera Controls:" << std::endl;
@@ -342,6 +709,7 @@ void printUsage(const char* programName) {
     std::cout << std::endl;
     std::cout << "Object Controls:" << std::endl;
     std::cout << "- TAB: Switch between objects" << std::endl;
+    std::cout << "- E: Select object under the crosshair" << std::endl;
     std::cout << "- T/R/G: Translation/Rotation/Scale mode" << std::endl;
     std::cout << "- Z/X/Y: Rotate selected object" << std::endl;
     std::cout << "- Arrow keys: Transform selected object" << std::endl;
@@ -351,7 +719,8 @@ void printUsage(const char* programName) {
     std::cout << "- N: Clear trajectory" << std::endl;
     std::cout << "- I: Change interpolation type (Linear -> Bezier -> Spline)" << std::endl;
     std::cout << "- O: Display current interpolation type and speed" << std::endl;
-    std::cout << "- P: Cycle trajectory speed (0.5 -> 1.0 -> 1.5 -> ... -> 5.0)" << std::endl;
+    std::cout << "- P: Cycle trajectory speed in units/s (0.5 -> 1.0 -> 1.5 -> ... -> 5.0)" << std::endl;
+    std::cout << "- J: Record the trajectory to a keyframe file and play it back from there" << std::endl;
     std::cout << std::endl;
     std::cout << "Parametric Curves:" << std::endl;
     std::cout << "- Linear: Straight lines between control points" << std::endl;
@@ -370,18 +739,36 @@ void printUsage(const char* programName) {
     std::cout << std::endl;
     std::cout << "Display Controls:" << std::endl;
     std::cout << "- F: Toggle wireframe mode" << std::endl;
+    std::cout << "- F3: Toggle depth pre-pass" << std::endl;
+    std::cout << "- F4: Toggle overdraw visualization" << std::endl;
+    std::cout << "- F5: Toggle frustum culling" << std::endl;
+    std::cout << "- F6: Toggle occlusion culling" << std::endl;
+    std::cout << "- F7: Toggle level of detail" << std::endl;
+    std::cout << "- F8: Toggle impostors for distant objects" << std::endl;
+    std::cout << "- F9: Toggle GPU-driven culling and drawing (OpenGL 4.3+)" << std::endl;
+    std::cout << "- F10: Toggle deferred shading" << std::endl;
+    std::cout << "- F11: Toggle point light shadows" << std::endl;
+    std::cout << "- F12: Toggle baked lightmaps on static objects" << std::endl;
+    std::cout << "- K: Toggle a GPU-animated crowd of the selected object on every trajectory" << std::endl;
+    std::cout << "- V: Toggle drawing every trajectory and its control points" << std::endl;
     std::cout << std::endl;
     std::cout << "Viewer Operations:" << std::endl;
     std::cout << "- F1: Save scene configuration (JSON)" << std::endl;
     std::cout << "- F2: Load scene configuration (JSON)" << std::endl;
     std::cout << "- ESC: Exit" << std::endl;
+    std::cout << std::endl;
+    std::cout << "Performance Runs:" << std::endl;
+    std::cout << "- --record file: Save every frame's keys, mouse motion and frame time" << std::endl;
+    std::cout << "- --replay file: Drive the viewer from a recording instead of the keyboard and mouse" << std::endl;
+    std::cout << "- --timings file.csv: Write CPU and GPU time and draw counts for every frame" << std::endl;
+    std::cout << "- --headless: With --replay, run hidden and without vsync until the recording ends" << std::endl;
     std::cout << "==================================================" << std::endl;
 }
 
 bool loadSceneConfig(const std::string& filename) {
     std::ifstream file(filename);
     if (!file.is_open()) {
-        std::cout << "No scene config found, scene not loaded" << std::endl;
+        LOG_INFO("No scene config found, scene not loaded");
         return false;
     }
 
@@ -390,12 +777,29 @@ bool loadSceneConfig(const std::string& filename) {
         file >> sceneData;
         file.close();
 
-        std::cout << "Loading scene configuration from: " << filename << std::endl;
+        LOG_INFO("Loading scene configuration from: " << filename);
         
         for (auto& obj : sceneObjects) {
             delete obj.obj;
+            delete obj.keyframes;
+            GLState::deleteTexture(obj.lightmapTexture);
         }
         sceneObjects.clear();
+        objectTree.clear();
+        if (curveRenderer != nullptr) {
+            curveRenderer->clear();
+        }
+        trajectorySystem.clear();
+        trajectoriesDirty = true;
+        if (occlusionCuller != nullptr) {
+            occlusionCuller->reset();
+        }
+        if (gpuRenderer != nullptr) {
+            gpuRenderer->clearObjects();
+        }
+        if (shadowCache != nullptr) {
+            shadowCache->invalidateAll();
+        }
         lights.clear();
 
         if (sceneData.contains("camera")) {
@@ -404,7 +808,37 @@ bool loadSceneConfig(const std::string& filename) {
             float yaw = cam.value("yaw", -90.0f);
             float pitch = cam.value("pitch", 0.0f);
             camera = Camera(pos, glm::vec3(0.0f, 1.0f, 0.0f), yaw, pitch);
-            std::cout << "Set camera position to (" << pos.x << ", " << pos.y << ", " << pos.z << ") with yaw=" << yaw << ", pitch=" << pitch << std::endl;
+            LOG_INFO("Set camera position to (" << pos.x << ", " << pos.y << ", " << pos.z << ") with yaw=" << yaw << ", pitch=" << pitch);
+        }
+
+        if (sceneData.contains("render")) {
+            auto render = sceneData["render"];
+            renderSettings.depthPrepass = render.value("depthPrepass", false);
+            renderSettings.prepassDepthFunc = render.value("depthFunc", std::string("LEQUAL")) == "EQUAL" ? GL_EQUAL : GL_LEQUAL;
+            renderSettings.frustumCulling = render.value("frustumCulling", true);
+            renderSettings.occlusionCulling = render.value("occlusionCulling", false);
+            renderSettings.levelOfDetail = render.value("levelOfDetail", true);
+            renderSettings.impostors = render.value("impostors", true);
+            renderSettings.impostorDistance = render.value("impostorDistance", 40.0f);
+            renderSettings.gpuDriven = render.value("gpuDriven", false);
+            renderSettings.deferredShading = render.value("deferredShading", false);
+            renderSettings.shadows = render.value("shadows", true);
+            renderSettings.lightmaps = render.value("lightmaps", true);
+            renderSettings.crowd = render.value("crowd", false);
+            renderSettings.crowdSize = render.value("crowdSize", 100000);
+            renderSettings.curves = render.value("curves", false);
+            renderSettings.curveTolerance = render.value("curveTolerance", CurveRenderer::DEFAULT_TOLERANCE);
+        }
+
+        LogLevel logLevel;
+        if (sceneData.contains("logLevel") && Logger::parseLevel(sceneData["logLevel"].get<std::string>(), logLevel)) {
+            Logger::setLevel(logLevel);
+        }
+
+        if (sceneData.contains("simulation")) {
+            auto simulation = sceneData["simulation"];
+            simulationClock.setRate(simulation.value("rate", SimulationClock::DEFAULT_RATE));
+            simulationClock.setMaxSteps(simulation.value("maxSteps", SimulationClock::DEFAULT_MAX_STEPS));
         }
 
         if (sceneData.contains("lights")) {
@@ -414,8 +848,9 @@ bool loadSceneConfig(const std::string& filename) {
                 light.color = glm::vec3(lightData["color"][0], lightData["color"][1], lightData["color"][2]);
                 light.intensity = lightData["intensity"];
                 light.enabled = lightData.value("enabled", true);
+                light.radius = lightData.value("radius", DEFAULT_LIGHT_RADIUS);
                 lights.push_back(light);
-                std::cout << "Added light at (" << light.position.x << ", " << light.position.y << ", " << light.position.z << ")" << std::endl;
+                LOG_INFO("Added light at (" << light.position.x << ", " << light.position.y << ", " << light.position.z << ")");
             }
         }
 
@@ -434,9 +869,9 @@ bool loadSceneConfig(const std::string& filename) {
                     
                     if (objData.contains("rotation")) {
                         glm::vec3 rot(objData["rotation"][0], objData["rotation"][1], objData["rotation"][2]);
-                        std::cout << "Applying rotation to " << objName << ": (" << rot.x << ", " << rot.y << ", " << rot.z << ")" << std::endl;
+                        LOG_INFO("Applying rotation to " << objName << ": (" << rot.x << ", " << rot.y << ", " << rot.z << ")");
                         obj->setRotation(rot);
-                        std::cout << "  Set rotation to: (" << rot.x << ", " << rot.y << ", " << rot.z << ") degrees" << std::endl;
+                        LOG_INFO("  Set rotation to: (" << rot.x << ", " << rot.y << ", " << rot.z << ") degrees");
                     }
                     
                     if (objData.contains("scale")) {
@@ -452,14 +887,21 @@ bool loadSceneConfig(const std::string& filename) {
                         glm::vec3(objData["scale"][0], objData["scale"][1], objData["scale"][2]) : glm::vec3(1.0f);
 
                     SceneObject sceneObj = {obj, Trajectory(), false, objName, objFile, initialPos, initialRot, initialScale};
+                    if (impostorRenderer != nullptr) {
+                        sceneObj.impostor = impostorRenderer->getAtlas(objFile, *obj);
+                    }
+                    if (gpuRenderer != nullptr) {
+                        sceneObj.gpuObject = gpuRenderer->addObject(gpuRenderer->addMesh(objFile, *obj));
+                    }
                     
                     if (objData.contains("trajectory")) {
                         auto trajData = objData["trajectory"];
                         if (trajData.contains("points")) {
+                            std::vector<glm::vec3> trajPoints;
                             for (const auto& point : trajData["points"]) {
-                                glm::vec3 trajPoint(point[0], point[1], point[2]);
-                                sceneObj.trajectory.addPoint(trajPoint);
+                                trajPoints.push_back(glm::vec3(point[0], point[1], point[2]));
                             }
+                            sceneObj.trajectory.setPoints(trajPoints);
                         }
                         if (trajData.contains("speed")) {
                             sceneObj.trajectory.setSpeed(trajData["speed"]);
@@ -478,18 +920,41 @@ bool loadSceneConfig(const std::string& filename) {
                             }
                         }
                     }
+
+                    if (objData.contains("keyframes")) {
+                        auto keyframeData = objData["keyframes"];
+                        sceneObj.keyframeFile = keyframeData["file"];
+                        sceneObj.keyframes = new KeyframeTrack();
+                        if (sceneObj.keyframes->open(sceneObj.keyframeFile)) {
+                            sceneObj.isMoving = keyframeData.value("autoStart", false);
+                            LOG_INFO("Loaded " << sceneObj.keyframes->getSampleCount() << " keyframes for " << objName
+                                     << " (" << sceneObj.keyframes->getDuration() << " s)");
+                        } else {
+                            delete sceneObj.keyframes;
+                            sceneObj.keyframes = nullptr;
+                        }
+                    }
+
+                    if (!objData.contains("trajectory") && !objData.contains("keyframes")) {
+                        loadLightmap(sceneObj);
+                    }
                     
+                    const AABB& bounds = obj->getWorldBounds();
+                    sceneObj.treeProxy = objectTree.insert(bounds, static_cast<int>(sceneObjects.size()));
+                    sceneObj.treeVersion = obj->getTransformVersion();
+                    sceneObj.treeCenter = bounds.center();
+
                     sceneObjects.push_back(sceneObj);
-                    std::cout << "Loaded object: " << objName << " from " << objFile << std::endl;
+                    LOG_INFO("Loaded object: " << objName << " from " << objFile);
                 } catch (const std::exception& e) {
-                    std::cerr << "Failed to load object " << objFile << ": " << e.what() << std::endl;
+                    LOG_ERROR("Failed to load object " << objFile << ": " << e.what());
                 }
             }
         }
 
         return true;
     } catch (const json::exception& e) {
-        std::cerr << "JSON parsing error: " << e.what() << std::endl;
+        LOG_ERROR("JSON parsing error: " << e.what());
         return false;
     }
 }
@@ -503,6 +968,25 @@ void saveSceneConfig(const std::string& filename) {
         sceneData["camera"]["yaw"] = camera.GetYaw();
         sceneData["camera"]["pitch"] = camera.GetPitch();
 
+        sceneData["render"]["depthPrepass"] = renderSettings.depthPrepass;
+        sceneData["render"]["depthFunc"] = renderSettings.prepassDepthFunc == GL_EQUAL ? "EQUAL" : "LEQUAL";
+        sceneData["render"]["frustumCulling"] = renderSettings.frustumCulling;
+        sceneData["render"]["occlusionCulling"] = renderSettings.occlusionCulling;
+        sceneData["render"]["levelOfDetail"] = renderSettings.levelOfDetail;
+        sceneData["render"]["impostors"] = renderSettings.impostors;
+        sceneData["render"]["impostorDistance"] = renderSettings.impostorDistance;
+        sceneData["render"]["gpuDriven"] = renderSettings.gpuDriven;
+        sceneData["render"]["deferredShading"] = renderSettings.deferredShading;
+        sceneData["render"]["shadows"] = renderSettings.shadows;
+        sceneData["render"]["lightmaps"] = renderSettings.lightmaps;
+        sceneData["render"]["crowd"] = renderSettings.crowd;
+        sceneData["render"]["crowdSize"] = renderSettings.crowdSize;
+        sceneData["render"]["curves"] = renderSettings.curves;
+        sceneData["render"]["curveTolerance"] = renderSettings.curveTolerance;
+        sceneData["logLevel"] = Logger::getLevelName(Logger::getLevel());
+        sceneData["simulation"]["rate"] = simulationClock.getRate();
+        sceneData["simulation"]["maxSteps"] = simulationClock.getMaxSteps();
+
         sceneData["lights"] = json::array();
         for (const auto& light : lights) {
             json lightData;
@@ -510,6 +994,7 @@ void saveSceneConfig(const std::string& filename) {
             lightData["color"] = {light.color.x, light.color.y, light.color.z};
             lightData["intensity"] = light.intensity;
             lightData["enabled"] = light.enabled;
+            lightData["radius"] = light.radius;
             sceneData["lights"].push_back(lightData);
         }
 
@@ -541,35 +1026,353 @@ void saveSceneConfig(const std::string& filename) {
                 objData["trajectory"] = trajData;
             }
 
+            if (!obj.keyframeFile.empty()) {
+                objData["keyframes"]["file"] = obj.keyframeFile;
+                objData["keyframes"]["autoStart"] = obj.isMoving;
+            }
+
             sceneData["objects"].push_back(objData);
         }
 
         std::ofstream file(filename);
         if (!file.is_open()) {
-            std::cerr << "Failed to save scene configuration" << std::endl;
+            LOG_ERROR("Failed to save scene configuration");
             return;
         }
 
         file << sceneData.dump(2);
         file.close();
         
-        std::cout << "Scene configuration saved successfully to: " << filename << std::endl;
+        LOG_INFO("Scene configuration saved successfully to: " << filename);
     } catch (const json::exception& e) {
-        std::cerr << "JSON error while saving: " << e.what() << std::endl;
+        LOG_ERROR("JSON error while saving: " << e.what());
+    }
+}
+
+void updateWindowTitle(GLFWwindow* window) {
+    frameStats.elapsed += deltaTime;
+    frameStats.frames++;
+
+    if (frameStats.elapsed < 1.0f) return;
+
+    std::ostringstream title;
+    title << "Scene Viewer - " << std::fixed << std::setprecision(2)
+          << (1000.0f * frameStats.elapsed / frameStats.frames) << " ms/frame"
+          << " | ring stalls: " << frameStats.ringStalls
+          << " | GL calls/frame: " << frameStats.glCallsIssued / frameStats.frames
+          << " issued, " << frameStats.glCallsElided / frameStats.frames << " elided"
+          << " | lights: " << lightClusters->getLightCount() << " ("
+          << lightClusters->getAverageLightsPerCluster() << " avg, "
+          << lightClusters->getMaxLightsPerCluster() << " max per cluster)";
+    if (renderSettings.lightmaps && frameStats.lightmappedObjects > 0) {
+        title << " | lightmapped: " << frameStats.lightmappedObjects / frameStats.frames;
+    }
+    title << " | simulation: " << simulationClock.getRate() << " Hz, "
+          << static_cast<float>(frameStats.simulationSteps) / frameStats.frames << " steps/frame";
+    if (renderSettings.crowd) {
+        title << " | crowd: " << crowdRenderer->getInstanceCount() << " instances";
+    }
+    if (renderSettings.curves) {
+        title << " | curves: " << curveRenderer->getDrawnCount() << "/" << curveRenderer->getPathCount()
+              << " drawn, " << curveRenderer->getVertexCount() << " vertices";
+    }
+    if (renderSettings.shadows) {
+        title << " | shadows: " << static_cast<float>(frameStats.shadowInvalidations) / frameStats.frames
+              << " invalidated, " << static_cast<float>(frameStats.shadowPasses) / frameStats.frames
+              << " rendered per frame";
+    }
+    if (gpuDrivenActive()) {
+        title << " | GPU-driven: " << gpuRenderer->getObjectCount() << " objects in "
+              << gpuRenderer->getMeshCount() << " multi-draws";
+    } else {
+        title << " | visible/culled: " << frameStats.visibleObjects / frameStats.frames
+              << "/" << frameStats.culledObjects / frameStats.frames
+              << " | triangles: " << frameStats.trianglesDrawn / frameStats.frames
+              << " | impostors: " << frameStats.impostorsDrawn / frameStats.frames;
+        if (frameStats.lightVolumes > 0) {
+            title << " | deferred: " << frameStats.lightVolumes / frameStats.frames << " light volumes";
+        }
+        if (renderSettings.occlusionCulling) {
+            title << " | occluded: " << frameStats.occludedObjects / frameStats.frames
+                  << " (" << frameStats.occlusionQueries / frameStats.frames << " queries, "
+                  << frameStats.pendingQueries / frameStats.frames << " pending)";
+        }
+    }
+    glfwSetWindowTitle(window, title.str().c_str());
+
+    frameStats = FrameStats();
+}
+
+// Static objects pick up what BakeLightmaps wrote for them, if anything
+void loadLightmap(SceneObject& obj) {
+    Lightmap lightmap;
+    if (!lightmap.load(LIGHTMAP_DIRECTORY + obj.name + ".lightmap")) return;
+
+    if (lightmap.uvs.size() != obj.obj->getVertices().size()) {
+        LOG_ERROR("Lightmap for " << obj.name << " was baked from a different mesh, ignoring it");
+        return;
+    }
+
+    obj.obj->setLightmapUVs(lightmap.uvs);
+    obj.lightmapTexture = lightmap.createTexture();
+    LOG_INFO("Loaded lightmap for " << obj.name << " (" << lightmap.width << "x" << lightmap.height << ")");
+
+    lightmap.uvs = std::vector<glm::vec2>();
+    lightmap.texels = std::vector<glm::vec4>();
+    obj.lightmap = lightmap;
+}
+
+void rebuildTrajectorySystem() {
+    for (auto& obj : sceneObjects) {
+        if (obj.mover >= 0) {
+            obj.trajectoryDistance = trajectorySystem.getDistance(obj.mover);
+        }
     }
+
+    trajectorySystem.clear();
+    for (auto& obj : sceneObjects) {
+        obj.mover = -1;
+        if (!obj.isMoving || obj.keyframes != nullptr) continue;
+        int path = trajectorySystem.addPath(obj.trajectory);
+        if (path >= 0) {
+            obj.mover = trajectorySystem.addMover(path, obj.trajectory.getSpeed(), obj.trajectoryDistance);
+        }
+    }
+    trajectoriesDirty = false;
+}
+
+ObjectTransform readTransform(const Obj& obj) {
+    return {obj.getPosition(), obj.getRotation(), obj.scale};
+}
+
+// Only what differs is set, so objects at rest keep their transform version
+void applyTransform(Obj& obj, const ObjectTransform& transform) {
+    if (obj.getPosition() != transform.position) obj.setPosition(transform.position);
+    if (obj.getRotation() != transform.rotation) obj.setRotation(transform.rotation);
+    if (obj.scale != transform.scale) obj.setScale(transform.scale);
+}
+
+// mix() of two equal values can be an ulp off, which would count as a move
+ObjectTransform blendTransforms(const ObjectTransform& from, const ObjectTransform& to, float alpha) {
+    ObjectTransform blend = to;
+    if (from.position != to.position) blend.position = glm::mix(from.position, to.position, alpha);
+    if (from.rotation != to.rotation) blend.rotation = glm::mix(from.rotation, to.rotation, alpha);
+    if (from.scale != to.scale) blend.scale = glm::mix(from.scale, to.scale, alpha);
+    return blend;
+}
+
+// Runs the fixed steps due this frame, then leaves every object drawn at the
+// clock's alpha between its last two simulated transforms
+void advanceSimulation() {
+    int steps = simulationClock.advance(deltaTime);
+    float step = simulationClock.getStep();
+    frameStats.simulationSteps += steps;
+
+    // Step on from the simulated transform, not the blend, unless something
+    // outside the simulation (a key, a reload) has moved the object since
+    for (auto& obj : sceneObjects) {
+        if (obj.obj->getTransformVersion() != obj.blendVersion) {
+            obj.currentTransform = readTransform(*obj.obj);
+            obj.previousTransform = obj.currentTransform;
+        } else if (steps > 0) {
+            applyTransform(*obj.obj, obj.currentTransform);
+        }
+    }
+
+    int threads = static_cast<int>(std::thread::hardware_concurrency());
+    for (int i = 0; i < steps; i++) {
+        simulateInput(step);
+        trajectorySystem.update(step, threads);
+
+        for (auto& obj : sceneObjects) {
+            obj.previousTransform = obj.currentTransform;
+            if (obj.mover >= 0) {
+                obj.obj->setPosition(trajectorySystem.getPosition(obj.mover));
+
+                // Wrapping from the end of the path back to its start is a jump, not motion to blend
+                float distance = trajectorySystem.getDistance(obj.mover);
+                if (distance < obj.trajectoryDistance) {
+                    obj.previousTransform.position = obj.obj->getPosition();
+                }
+                obj.trajectoryDistance = distance;
+            } else if (obj.keyframes != nullptr && obj.isMoving) {
+                obj.keyframeTime += step;
+                bool looped = obj.keyframeTime >= obj.keyframes->getDuration();
+                if (looped) {
+                    obj.keyframeTime = std::fmod(obj.keyframeTime, std::max(obj.keyframes->getDuration(), step));
+                }
+                obj.obj->setPosition(obj.keyframes->sample(obj.keyframes->getStartTime() + obj.keyframeTime));
+                if (looped) {
+                    obj.previousTransform.position = obj.obj->getPosition();
+                }
+            }
+            obj.currentTransform = readTransform(*obj.obj);
+        }
+    }
+
+    float alpha = simulationClock.getAlpha();
+    for (auto& obj : sceneObjects) {
+        applyTransform(*obj.obj, blendTransforms(obj.previousTransform, obj.currentTransform, alpha));
+        obj.blendVersion = obj.obj->getTransformVersion();
+    }
+}
+
+// Baked light is only right while the object and the lights are where they were
+// at bake time, and only the full-detail mesh carries the lightmap UVs
+bool usesLightmap(const SceneObject& obj) {
+    return renderSettings.lightmaps && obj.lightmapTexture != 0 && obj.obj->getLOD() == 0 &&
+           obj.lightmap.matches(obj.obj->getModelMatrix()) && obj.lightmap.matches(clusterLights);
+}
+
+// Only objects whose transform changed since the last sync touch the tree
+void syncObjectTree() {
+    for (auto& obj : sceneObjects) {
+        unsigned int version = obj.obj->getTransformVersion();
+        if (version == obj.treeVersion) continue;
+
+        const AABB& bounds = obj.obj->getWorldBounds();
+        glm::vec3 center = bounds.center();
+        objectTree.update(obj.treeProxy, bounds, center - obj.treeCenter);
+        obj.treeVersion = version;
+        obj.treeCenter = center;
+    }
+}
+
+void pickObjectAtCrosshair() {
+    syncObjectTree();
+
+    float distance = 0.0f;
+    int hit = objectTree.raycastClosest(camera.GetPosition(), camera.GetFront(), 100.0f, distance);
+    if (hit < 0) {
+        LOG_INFO("No object under the crosshair");
+        return;
+    }
+
+    selectedObject = hit;
+    LOG_INFO("Selected object: " << sceneObjects[hit].name << " (" << distance << " units away)");
+}
+
+ObjectUniforms makeObjectUniforms(const SceneObject& obj, bool selected, float fade) {
+    ObjectUniforms uniforms;
+    uniforms.model = obj.obj->getModelMatrix();
+    uniforms.params = glm::vec4(fade, 0.0f, 0.0f, 0.0f);
+    uniforms.flags[0] = selected ? 1 : 0;
+    uniforms.flags[1] = 0;
+    uniforms.flags[2] = 0;
+    uniforms.flags[3] = 0;
+
+    if (obj.obj->hasMaterials()) {
+        Material material = obj.obj->getMaterial();
+        uniforms.material = glm::vec4(material.ambient.x, material.diffuse.x, material.specular.x, material.shininess);
+        uniforms.flags[1] = obj.obj->hasTextures() ? 1 : 0;
+    } else {
+        uniforms.material = glm::vec4(0.1f, 0.5f, 0.5f, 10.0f);
+    }
+    return uniforms;
+}
+
+// Instances of the selected object spread over every trajectory in the scene
+void buildCrowd() {
+    crowdDirty = false;
+    crowdRenderer->clear();
+    if (!renderSettings.crowd || sceneObjects.empty()) return;
+
+    TrajectorySystem paths;
+    std::vector<float> speeds;
+    for (const auto& obj : sceneObjects) {
+        if (paths.addPath(obj.trajectory) >= 0) {
+            speeds.push_back(obj.trajectory.getSpeed());
+        }
+    }
+    if (paths.getPathCount() == 0) {
+        LOG_INFO("Crowd: no trajectory in the scene to follow");
+        return;
+    }
+
+    const SceneObject& source = sceneObjects[selectedObject];
+    ObjectUniforms uniforms = makeObjectUniforms(source, false, 0.0f);
+    if (!crowdRenderer->setMesh(*source.obj, uniforms.model, uniforms.material)) {
+        LOG_INFO("Crowd: " << source.name << " has no mesh to instance");
+        return;
+    }
+    crowdRenderer->setPaths(paths);
+
+    // Fixed seed, so a scene always spawns the same crowd
+    std::mt19937 rng(1);
+    std::uniform_int_distribution<int> pick(0, static_cast<int>(paths.getPathCount()) - 1);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    std::uniform_real_distribution<float> spread(-CROWD_SPREAD, CROWD_SPREAD);
+    std::vector<CrowdRenderer::Instance> instances(std::max(renderSettings.crowdSize, 0));
+    for (auto& instance : instances) {
+        instance.path = pick(rng);
+        instance.phase = unit(rng) * paths.getPathLength(instance.path);
+        instance.speed = speeds[instance.path] * (0.75f + 0.5f * unit(rng));
+        instance.offset = glm::vec3(spread(rng), 0.0f, spread(rng));
+    }
+    crowdRenderer->setInstances(instances);
+    LOG_INFO("Crowd: " << instances.size() << " x " << source.name << " on "
+             << paths.getPathCount() << " trajectories");
+}
+
+// Only objects that moved or changed selection are re-sent to the GPU
+void syncGPUObjects() {
+    for (size_t i = 0; i < sceneObjects.size(); i++) {
+        SceneObject& obj = sceneObjects[i];
+        bool selected = static_cast<int>(i) == selectedObject;
+        if (obj.gpuObject < 0) continue;
+        if (obj.gpuVersion == obj.obj->getTransformVersion() && obj.gpuSelected == selected) continue;
+
+        ObjectUniforms uniforms = makeObjectUniforms(obj, selected, 0.0f);
+        gpuRenderer->setObject(obj.gpuObject, uniforms.model, uniforms.material, selected);
+        obj.gpuVersion = obj.obj->getTransformVersion();
+        obj.gpuSelected = selected;
+    }
+}
+
+void setSceneUniforms(Shader& shader, const glm::mat4& view, const glm::mat4& projection,
+                      const glm::vec3& lightPos, const glm::vec3& lightColor) {
+    shader.setMat4("view", view);
+    shader.setMat4("projection", projection);
+    shader.setVec3("viewPos", camera.GetPosition());
+    shader.setBool("wireframe", wireframeMode);
+    shader.setVec3("wireframeColor", WIREFRAME_COLOR);
+    shader.setFloat("wireframeWidth", 1.0f);
+    shader.setVec3("lightPos", lightPos);
+    shader.setVec3("lightColor", lightColor);
+    lightClusters->bind(shader);
+    shadowCache->bind(shader);
+    shader.setInt("lightmap", LIGHTMAP_UNIT);
 }
 
 int main(int argc, char* argv[]) {
     printUsage(argv[0]);
 
+    InputRecorder::Options options = InputRecorder::Options::parse(argc, argv);
+    if (options.headless && options.replayPath.empty()) {
+        LOG_ERROR("--headless needs --replay: a hidden window takes no input");
+        return -1;
+    }
+    if (!input.start(options)) {
+        return -1;
+    }
+
     glfwInit();
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    if (options.headless) {
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    }
 
+    // 4.3 enables the GPU-driven path; everything else only needs 3.3
     GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "Scene Viewer - Complete 3D Visualization", NULL, NULL);
     if (window == NULL) {
-        std::cout << "Failed to create GLFW window" << std::endl;
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+        window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "Scene Viewer - Complete 3D Visualization", NULL, NULL);
+    }
+    if (window == NULL) {
+        LOG_ERROR("Failed to create GLFW window");
         glfwTerminate();
         return -1;
     }
@@ -577,40 +1380,88 @@ int main(int argc, char* argv[]) {
     glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
     glfwSetCursorPosCallback(window, mouse_callback);
     glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+    if (options.headless) {
+        glfwSwapInterval(0);
+    }
 
     if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
-        std::cout << "Failed to initialize GLAD" << std::endl;
+        LOG_ERROR("Failed to initialize GLAD");
         return -1;
     }
 
-    glEnable(GL_DEPTH_TEST);
-
-    Shader phongShader("src/shaders/phong.vert", "src/shaders/phong.frag");
+    GLState::setDepthTest(true);
+
+    Shader sceneShader("src/shaders/scene.vert", "src/shaders/scene.frag");
+    sceneShader.bindUniformBlock("ObjectData", OBJECT_BLOCK_BINDING);
+    Shader depthShader("src/shaders/scene_depth.vert", "src/shaders/depth.frag");
+    depthShader.bindUniformBlock("ObjectData", OBJECT_BLOCK_BINDING);
+    Shader overdrawShader("src/shaders/scene.vert", "src/shaders/overdraw.frag");
+    overdrawShader.bindUniformBlock("ObjectData", OBJECT_BLOCK_BINDING);
+    Shader gbufferShader("src/shaders/scene.vert", "src/shaders/scene_gbuffer.frag");
+    gbufferShader.bindUniformBlock("ObjectData", OBJECT_BLOCK_BINDING);
+    Shader crowdShader("src/shaders/crowd.vert", "src/shaders/scene.frag");
+    Shader crowdGBufferShader("src/shaders/crowd.vert", "src/shaders/scene_gbuffer.frag");
+    Shader crowdOverdrawShader("src/shaders/crowd.vert", "src/shaders/overdraw.frag");
+
+    GLint uboAlignment = 256;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uboAlignment);
+    GLsizeiptr objectStride = (sizeof(ObjectUniforms) + uboAlignment - 1) / uboAlignment * uboAlignment;
+
+    RingBuffer* objectRing = new RingBuffer(GL_UNIFORM_BUFFER, objectStride * 64);
+    LOG_INFO("Object ring buffer: " << (objectRing->isPersistent() ? "persistent mapped" : "per-frame mapped"));
+    // Plain buffer written with glBufferSubData when the ring can't be mapped
+    GLuint fallbackObjectBuffer = 0;
+    GLsizeiptr fallbackObjectSize = 0;
+    bool fallbackLogged = false;
+
+    occlusionCuller = new OcclusionCuller();
+    impostorRenderer = new ImpostorRenderer();
+    lightClusters = new LightClusters();
+    deferredRenderer = new DeferredRenderer();
+    shadowCache = new ShadowCache();
+    crowdRenderer = new CrowdRenderer();
+    curveRenderer = new CurveRenderer();
+
+    Shader* indirectShader = nullptr;
+    Shader* indirectOverdrawShader = nullptr;
+    if (GPUDrivenRenderer::isSupported()) {
+        gpuRenderer = new GPUDrivenRenderer();
+        indirectShader = new Shader("src/shaders/scene_indirect.vert", "src/shaders/scene.frag");
+        indirectOverdrawShader = new Shader("src/shaders/scene_indirect.vert", "src/shaders/overdraw.frag");
+    }
 
     bool configLoaded = false;
-    if (argc > 1) {
-        configLoaded = loadSceneConfig(argv[1]);
+    if (!options.arguments.empty()) {
+        configLoaded = loadSceneConfig(options.arguments[0]);
     }
     if (!configLoaded) {
         configLoaded = loadSceneConfig("scene_config.json");
     }
 
     if (!configLoaded) {
-        std::cerr << "ERROR: No scene configuration found!" << std::endl;
-        std::cerr << "Please provide a scene configuration file:" << std::endl;
-        std::cerr << "  " << argv[0] << " scene_config.json" << std::endl;
-        std::cerr << "Or create a scene_config.json file in the current directory." << std::endl;
+        LOG_ERROR("ERROR: No scene configuration found!");
+        LOG_ERROR("Please provide a scene configuration file:");
+        LOG_ERROR("  " << argv[0] << " scene_config.json");
+        LOG_ERROR("Or create a scene_config.json file in the current directory.");
         glfwTerminate();
         return -1;
     }
 
     if (sceneObjects.empty()) {
-        std::cerr << "ERROR: No objects found in scene configuration!" << std::endl;
-        std::cerr << "Please add objects to your scene_config.json file." << std::endl;
+        LOG_ERROR("ERROR: No objects found in scene configuration!");
+        LOG_ERROR("Please add objects to your scene_config.json file.");
         glfwTerminate();
         return -1;
     } else {
-        std::cout << "Scene loaded with " << sceneObjects.size() << " objects and " << lights.size() << " lights." << std::endl;
+        LOG_INFO("Scene loaded with " << sceneObjects.size() << " objects and " << lights.size() << " lights.");
+    }
+
+    if (!options.timingsPath.empty()) {
+        frameTimings = new FrameTimings();
+        if (!frameTimings->open(options.timingsPath, {"simulation_steps", "visible_objects", "triangles", "gl_calls"})) {
+            delete frameTimings;
+            frameTimings = nullptr;
+        }
     }
 
     while (!glfwWindowShouldClose(window)) {
@@ -618,95 +1469,395 @@ int main(int argc, char* argv[]) {
         deltaTime = currentFrame - lastFrame;
         lastFrame = currentFrame;
 
+        // A replay also supplies the recorded deltaTime, so it simulates exactly what was recorded
+        if (!input.beginFrame(window, deltaTime)) break;
+        deltaTime = input.getDeltaTime();
+        if (frameTimings != nullptr) {
+            frameTimings->beginFrame();
+        }
+        FrameStats frameStart = frameStats;
+
         processInput(window);
+        GLState::beginFrame();
 
-        glClearColor(0.1f, 0.1f, 0.15f, 1.0f);
+        GLState::setDepthMask(true);
+        if (renderSettings.showOverdraw) {
+            glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+        } else {
+            glClearColor(0.1f, 0.1f, 0.15f, 1.0f);
+        }
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-        phongShader.use();
-
         glm::mat4 view = camera.GetViewMatrix();
         glm::mat4 projection = glm::perspective(glm::radians(45.0f),
             (float)windowWidth / (float)windowHeight, 0.1f, 100.0f);
 
-        phongShader.setMat4("view", view);
-        phongShader.setMat4("projection", projection);
-        phongShader.setVec3("viewPos", camera.GetPosition());
+        // Every enabled light goes into the clusters. lightPos/lightColor are
+        // what single-light shaders (impostors) and the ambient term still use:
+        // the first enabled light's position and the sum of all colours.
+        clusterLights.clear();
+        shadowKeys.clear();
+        glm::vec3 lightPos(2.0f, 4.0f, 6.0f);
+        glm::vec3 lightColor(0.0f);
+        for (size_t i = 0; i < lights.size(); i++) {
+            const Light& light = lights[i];
+            if (!light.enabled) continue;
+            if (clusterLights.empty()) lightPos = light.position;
+            lightColor += light.color * light.intensity;
+            clusterLights.push_back({light.position, light.radius, light.color * light.intensity});
+            shadowKeys.push_back(static_cast<int>(i));
+        }
+        if (clusterLights.empty()) {
+            lightColor = glm::vec3(1.0f);
+            clusterLights.push_back({lightPos, DEFAULT_LIGHT_RADIUS, lightColor});
+            shadowKeys.push_back(-1);
+        }
 
-        if (!lights.empty()) {
-            phongShader.setVec3("lightPos", lights[0].position);
-            phongShader.setVec3("lightColor", lights[0].color * lights[0].intensity);
-            
-            if (lights.size() > 1) {
-                glm::vec3 totalLightColor = lights[0].color * lights[0].intensity;
-                for (size_t i = 1; i < lights.size(); i++) {
-                    if (lights[i].enabled) {
-                        totalLightColor += lights[i].color * lights[i].intensity;
-                    }
-                }
-                phongShader.setVec3("lightColor", totalLightColor);
+        if (trajectoriesDirty) {
+            rebuildTrajectorySystem();
+            crowdDirty = true;
+        }
+        if (crowdDirty) {
+            buildCrowd();
+        }
+        advanceSimulation();
+        crowdTime = static_cast<float>(simulationClock.getRenderTime());
+
+        syncObjectTree();
+
+        // Before the clusters are filled, since that packs each light's shadow map slot
+        if (renderSettings.shadows) {
+            shadowCasters.resize(sceneObjects.size());
+            for (size_t i = 0; i < sceneObjects.size(); i++) {
+                shadowCasters[i] = sceneObjects[i].obj;
+            }
+            shadowCache->update(clusterLights, shadowKeys, shadowCasters, objectTree);
+            frameStats.shadowInvalidations += shadowCache->getStats().invalidations;
+            frameStats.shadowPasses += shadowCache->getStats().passes;
+        }
+
+        // Overdraw view stays forward so it keeps counting shaded fragments
+        bool deferred = renderSettings.deferredShading && !renderSettings.showOverdraw && !gpuDrivenActive();
+        if (!deferred) {
+            lightClusters->update(clusterLights, view, projection, 0.1f, 100.0f, windowWidth, windowHeight);
+        }
+        sceneShader.use();
+        setSceneUniforms(sceneShader, view, projection, lightPos, lightColor);
+
+        // The crowd moves in its vertex shader; all the CPU sets is the time
+        auto drawCrowd = [&](bool deferredPass) {
+            if (!renderSettings.crowd || crowdRenderer->getInstanceCount() == 0) return;
+
+            Shader& shader = renderSettings.showOverdraw ? crowdOverdrawShader
+                           : deferredPass ? crowdGBufferShader : crowdShader;
+            shader.use();
+            setSceneUniforms(shader, view, projection, lightPos, lightColor);
+            crowdRenderer->bind(shader, crowdTime);
+            GLState::setBlend(renderSettings.showOverdraw);
+            GLState::setBlendFunc(GL_ONE, GL_ONE);
+            GLState::setDepthMask(true);
+            GLState::setDepthFunc(GL_LESS);
+            crowdRenderer->draw();
+            frameStats.trianglesDrawn += crowdRenderer->getTriangleCount();
+        };
+
+        // Keys are indices into sceneObjects; unchanged trajectories keep their tessellation
+        auto drawCurves = [&]() {
+            if (!renderSettings.curves || renderSettings.showOverdraw) return;
+
+            curveRenderer->setTolerance(renderSettings.curveTolerance);
+            for (size_t i = 0; i < sceneObjects.size(); i++) {
+                curveRenderer->update(static_cast<int>(i), sceneObjects[i].trajectory);
+            }
+            curveRenderer->draw(view, projection, CURVE_COLOR, CURVE_MARKER_COLOR);
+        };
+
+        auto finishFrame = [&]() {
+            frameStats.glCallsIssued += GLState::getFrameStats().issued;
+            frameStats.glCallsElided += GLState::getFrameStats().elided;
+
+            // Taken before updateWindowTitle() may start a new second of stats
+            std::vector<unsigned long> counters;
+            if (frameTimings != nullptr) {
+                counters = {frameStats.simulationSteps - frameStart.simulationSteps,
+                            frameStats.visibleObjects - frameStart.visibleObjects,
+                            frameStats.trianglesDrawn - frameStart.trianglesDrawn,
+                            frameStats.glCallsIssued - frameStart.glCallsIssued};
             }
+            updateWindowTitle(window);
+
+            glfwSwapBuffers(window);
+            glfwPollEvents();
+            if (frameTimings != nullptr) {
+                frameTimings->endFrame(deltaTime, counters);
+            }
+        };
+
+        // Culling and command generation happen in a compute shader; the CPU
+        // only uploads objects that changed and issues one draw per mesh
+        if (gpuDrivenActive()) {
+            syncGPUObjects();
+            gpuRenderer->cull(camera.GetFrustum(projection), renderSettings.frustumCulling);
+
+            Shader& shader = renderSettings.showOverdraw ? *indirectOverdrawShader : *indirectShader;
+            shader.use();
+            setSceneUniforms(shader, view, projection, lightPos, lightColor);
+            GLState::setBlend(renderSettings.showOverdraw);
+            GLState::setBlendFunc(GL_ONE, GL_ONE);
+            GLState::setDepthMask(true);
+            GLState::setDepthFunc(GL_LESS);
+            gpuRenderer->draw();
+            drawCrowd(false);
+            drawCurves();
+
+            finishFrame();
+            continue;
+        }
+
+        std::vector<size_t> visible;
+        visible.reserve(sceneObjects.size());
+        if (renderSettings.frustumCulling) {
+            std::vector<int> hits;
+            objectTree.queryFrustum(camera.GetFrustum(projection), hits);
+            std::sort(hits.begin(), hits.end());
+            visible.assign(hits.begin(), hits.end());
         } else {
-            phongShader.setVec3("lightPos", glm::vec3(2.0f, 4.0f, 6.0f));
-            phongShader.setVec3("lightColor", glm::vec3(1.0f));
+            for (size_t i = 0; i < sceneObjects.size(); i++) {
+                visible.push_back(i);
+            }
         }
+        frameStats.visibleObjects += visible.size();
+        frameStats.culledObjects += sceneObjects.size() - visible.size();
+
+        // The chosen level is kept on the object so the hysteresis has
+        // something to compare against next frame. Past impostorDistance the
+        // mesh is dithered out against its impostor, then dropped entirely.
+        std::vector<float> impostorFade(sceneObjects.size(), 0.0f);
+        std::vector<size_t> meshVisible;
+        std::vector<size_t> fadingList;
+        meshVisible.reserve(visible.size());
+        for (size_t i : visible) {
+            TexturedObj* obj = sceneObjects[i].obj;
+            const BoundingSphere& sphere = obj->getWorldSphere();
+
+            if (renderSettings.impostors && sceneObjects[i].impostor != nullptr) {
+                float distance = glm::length(sphere.center - camera.GetPosition());
+                float band = renderSettings.impostorDistance * IMPOSTOR_FADE_BAND;
+                impostorFade[i] = glm::clamp((distance - renderSettings.impostorDistance) / band, 0.0f, 1.0f);
+            }
+            if (impostorFade[i] > 0.0f) {
+                ObjectUniforms uniforms = makeObjectUniforms(sceneObjects[i], i == selectedObject, 0.0f);
+                impostorRenderer->add(sceneObjects[i].impostor, uniforms.model, uniforms.material,
+                                      impostorFade[i], i == selectedObject);
+                frameStats.impostorsDrawn++;
+                if (impostorFade[i] >= 1.0f) continue;
+                fadingList.push_back(i);
+            } else {
+                meshVisible.push_back(i);
+            }
 
-        for (auto& obj : sceneObjects) {
-            if (obj.isMoving) {
-                glm::vec3 newPos = obj.trajectory.getNextPosition(deltaTime);
-                glm::mat4 modelMatrix = obj.obj->getModelMatrix();
-                glm::vec3 currentPos(modelMatrix[3][0], modelMatrix[3][1], modelMatrix[3][2]);
-                glm::vec3 translation = newPos - currentPos;
-                obj.obj->translate(translation);
+            int level = 0;
+            if (renderSettings.levelOfDetail) {
+                float coverage = LODSelector::screenCoverage(sphere, camera.GetPosition(), glm::radians(45.0f));
+                level = lodSelector.select(obj->getLOD(), coverage, obj->getLODCount());
             }
+            obj->setLOD(level);
+            frameStats.trianglesDrawn += obj->getTriangleCount(obj->getLOD());
         }
 
-        for (size_t i = 0; i < sceneObjects.size(); i++) {
-            const auto& obj = sceneObjects[i];
-            
-            glm::mat4 modelMatrix = obj.obj->getModelMatrix();
-            phongShader.setMat4("model", modelMatrix);
-            phongShader.setBool("isSelected", (i == selectedObject));
-
-            if (obj.obj->hasMaterials()) {
-                Material material = obj.obj->getMaterial();
-                phongShader.setFloat("ka", material.ambient.x);
-                phongShader.setFloat("kd", material.diffuse.x);
-                phongShader.setFloat("ks", material.specular.x);
-                phongShader.setFloat("q", material.shininess);
-
-                if (obj.obj->hasTextures()) {
-                    phongShader.setBool("useTexture", true);
-                    obj.obj->drawTextured(phongShader.ID);
+        // Write every visible object's block straight into the mapped segment, then draw
+        objectRing->reserve(objectStride * sceneObjects.size());
+        objectRing->beginFrame();
+
+        std::vector<GLintptr> objectOffsets(sceneObjects.size());
+        std::vector<GLuint> objectBuffers(sceneObjects.size(), objectRing->getBuffer());
+        for (size_t i : visible) {
+            if (impostorFade[i] >= 1.0f) continue;
+            ObjectUniforms uniforms = makeObjectUniforms(sceneObjects[i], i == selectedObject, impostorFade[i]);
+            if (!deferred && usesLightmap(sceneObjects[i])) {
+                uniforms.flags[2] = 1;
+                frameStats.lightmappedObjects++;
+            }
+
+            RingBuffer::Allocation block = objectRing->allocate(sizeof(ObjectUniforms), uboAlignment);
+            if (block.data != nullptr) {
+                std::memcpy(block.data, &uniforms, sizeof(ObjectUniforms));
+                objectOffsets[i] = block.offset;
+                continue;
+            }
+
+            if (!fallbackLogged) {
+                LOG_WARNING("Object ring buffer unavailable, falling back to glBufferSubData");
+                fallbackLogged = true;
+            }
+            GLsizeiptr needed = objectStride * sceneObjects.size();
+            if (fallbackObjectBuffer == 0) {
+                glGenBuffers(1, &fallbackObjectBuffer);
+            }
+            glBindBuffer(GL_UNIFORM_BUFFER, fallbackObjectBuffer);
+            if (fallbackObjectSize < needed) {
+                glBufferData(GL_UNIFORM_BUFFER, needed, nullptr, GL_DYNAMIC_DRAW);
+                fallbackObjectSize = needed;
+            }
+            objectOffsets[i] = objectStride * i;
+            objectBuffers[i] = fallbackObjectBuffer;
+            glBufferSubData(GL_UNIFORM_BUFFER, objectOffsets[i], sizeof(ObjectUniforms), &uniforms);
+            glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        }
+        objectRing->flush();
+
+        // With occlusion culling on, only objects that passed their last query
+        // are drawn up front; they fill the depth buffer the boxes are tested against
+        std::vector<size_t> drawList;
+        std::vector<size_t> deferredList;
+        if (renderSettings.occlusionCulling) {
+            occlusionCuller->resize(sceneObjects.size());
+            occlusionCuller->collectResults();
+            for (size_t i : meshVisible) {
+                if (occlusionCuller->wasVisible(i)) {
+                    drawList.push_back(i);
                 } else {
-                    phongShader.setBool("useTexture", false);
-                    obj.obj->drawWithTextures();
+                    deferredList.push_back(i);
                 }
+            }
+        } else {
+            drawList = meshVisible;
+        }
+
+        // In deferred mode every mesh pass below lands in the G-buffer instead
+        if (deferred) {
+            deferredRenderer->beginGeometry(windowWidth, windowHeight);
+        }
+
+        // Lay down depth with a position-only stream so the lighting shader
+        // below only runs for the fragments that end up visible
+        if (renderSettings.depthPrepass) {
+            depthShader.use();
+            depthShader.setMat4("view", view);
+            depthShader.setMat4("projection", projection);
+
+            GLState::setColorMask(false);
+            GLState::setDepthFunc(GL_LESS);
+            for (size_t i : drawList) {
+                glBindBufferRange(GL_UNIFORM_BUFFER, OBJECT_BLOCK_BINDING, objectBuffers[i],
+                                  objectOffsets[i], sizeof(ObjectUniforms));
+                sceneObjects[i].obj->drawDepth();
+            }
+            GLState::setColorMask(true);
+            GLState::setDepthMask(false);
+            GLState::setDepthFunc(renderSettings.prepassDepthFunc);
+        } else {
+            GLState::setDepthFunc(GL_LESS);
+        }
+
+        Shader& shadingShader = renderSettings.showOverdraw ? overdrawShader
+                              : deferred ? gbufferShader : sceneShader;
+        if (renderSettings.showOverdraw) {
+            overdrawShader.use();
+            overdrawShader.setMat4("view", view);
+            overdrawShader.setMat4("projection", projection);
+            GLState::setBlend(true);
+            GLState::setBlendFunc(GL_ONE, GL_ONE);
+        } else {
+            shadingShader.use();
+            if (deferred) {
+                setSceneUniforms(gbufferShader, view, projection, lightPos, lightColor);
+            }
+            GLState::setBlend(false);
+        }
+
+        auto drawShaded = [&](size_t i) {
+            const auto& obj = sceneObjects[i];
+
+            glBindBufferRange(GL_UNIFORM_BUFFER, OBJECT_BLOCK_BINDING, objectBuffers[i],
+                              objectOffsets[i], sizeof(ObjectUniforms));
+            if (obj.lightmapTexture != 0) {
+                GLState::bindTexture(LIGHTMAP_UNIT, GL_TEXTURE_2D, obj.lightmapTexture);
+            }
+
+            if (obj.obj->hasTextures()) {
+                obj.obj->drawTextured(shadingShader.ID);
             } else {
-                phongShader.setFloat("ka", 0.1f);
-                phongShader.setFloat("kd", 0.5f);
-                phongShader.setFloat("ks", 0.5f);
-                phongShader.setFloat("q", 10.0f);
-                phongShader.setBool("useTexture", false);
                 obj.obj->drawWithTextures();
             }
+        };
 
-            if (wireframeMode) {
-                glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-                phongShader.setBool("useTexture", false);
-                phongShader.setFloat("kd", 1.0f);
-                obj.obj->drawWithTextures();
-                glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+        for (size_t i : drawList) {
+            drawShaded(i);
+        }
+
+        if (renderSettings.occlusionCulling) {
+            occlusionCuller->beginQueries(projection * view, camera.GetPosition());
+            for (size_t i : meshVisible) {
+                occlusionCuller->issueQuery(i, sceneObjects[i].obj->getWorldBounds());
             }
+            occlusionCuller->endQueries();
+
+            // Objects hidden last frame had no pre-pass, so they write their own depth.
+            // The GPU skips them if this frame's box query found no samples.
+            shadingShader.use();
+            GLState::setBlend(renderSettings.showOverdraw);
+            GLState::setDepthMask(true);
+            GLState::setDepthFunc(GL_LESS);
+            for (size_t i : deferredList) {
+                bool conditional = occlusionCuller->beginConditional(i);
+                drawShaded(i);
+                if (conditional) {
+                    occlusionCuller->endConditional();
+                }
+            }
+
+            frameStats.occludedObjects += deferredList.size();
+            frameStats.occlusionQueries += occlusionCuller->getStats().issued;
+            frameStats.pendingQueries += occlusionCuller->getStats().pending;
+        }
+
+        // Dithered meshes punch holes the pre-pass can't know about, so they
+        // and the impostors write their own depth after everything else
+        shadingShader.use();
+        GLState::setBlend(renderSettings.showOverdraw);
+        GLState::setDepthMask(true);
+        GLState::setDepthFunc(GL_LESS);
+        for (size_t i : fadingList) {
+            drawShaded(i);
         }
+        drawCrowd(deferred);
 
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+        if (deferred) {
+            deferredRenderer->resolve(view, projection, camera.GetPosition(), lightColor, WIREFRAME_COLOR, clusterLights,
+                                     *shadowCache);
+            frameStats.lightVolumes += deferredRenderer->getLightVolumeCount();
+        }
+
+        impostorRenderer->flush(view, projection, camera.GetPosition(), lightPos, lightColor, renderSettings.showOverdraw);
+        drawCurves();
+
+        objectRing->endFrame();
+        if (objectRing->stalledThisFrame()) {
+            frameStats.ringStalls++;
+        }
+        finishFrame();
     }
 
     for (auto& obj : sceneObjects) {
         delete obj.obj;
+        delete obj.keyframes;
+        GLState::deleteTexture(obj.lightmapTexture);
     }
+    delete objectRing;
+    glDeleteBuffers(1, &fallbackObjectBuffer);
+    delete occlusionCuller;
+    delete impostorRenderer;
+    delete lightClusters;
+    delete deferredRenderer;
+    delete shadowCache;
+    delete crowdRenderer;
+    delete curveRenderer;
+    delete gpuRenderer;
+    delete indirectShader;
+    delete indirectOverdrawShader;
+    delete frameTimings;
+    input.stop();
 
     glfwTerminate();
     return 0;
@@ -5,8 +5,13 @@
 #include <glm/gtc/type_ptr.hpp>
 #include <vector>
 #include <iostream>
+#include <string>
 #include "domain/Shader.hpp"
+#include "domain/GLState.hpp"
+#include "domain/Frustum.hpp"
+#include "domain/CullingTitle.hpp"
 #include "domain/TexturedObj.hpp"
+#include "domain/Logger.hpp"
 
 const unsigned int SCR_WIDTH = 1280;
 const unsigned int SCR_HEIGHT = 720;
@@ -51,7 +56,7 @@ void processInput(GLFWwindow *window)
         if (!tabPressed && !objects.empty())
         {
             selectedObject = (selectedObject + 1) % objects.size();
-            std::cout << "Selected object: " << selectedObject << std::endl;
+            LOG_INFO("Selected object: " << selectedObject);
             tabPressed = true;
         }
     }
@@ -156,7 +161,7 @@ int main(int argc, char *argv[])
     GLFWwindow *window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "Textured Viewer (Domain)", NULL, NULL);
     if (window == NULL)
     {
-        std::cout << "Failed to create GLFW window" << std::endl;
+        LOG_ERROR("Failed to create GLFW window");
         glfwTerminate();
         return -1;
     }
@@ -165,11 +170,11 @@ int main(int argc, char *argv[])
 
     if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
     {
-        std::cout << "Failed to initialize GLAD" << std::endl;
+        LOG_ERROR("Failed to initialize GLAD");
         return -1;
     }
 
-    glEnable(GL_DEPTH_TEST);
+    GLState::setDepthTest(true);
 
     Shader texturedShader("src/shaders/textured.vert", "src/shaders/textured.frag");
 
@@ -182,17 +187,17 @@ int main(int argc, char *argv[])
             obj->translate(glm::vec3(xOffset, 0.0f, 0.0f));
             objects.push_back(obj);
             xOffset += 3.0f;
-            std::cout << "Loaded model: " << argv[i] << std::endl;
+            LOG_INFO("Loaded model: " << argv[i]);
         }
         catch (const std::exception &e)
         {
-            std::cerr << "Failed to load model " << argv[i] << ": " << e.what() << std::endl;
+            LOG_ERROR("Failed to load model " << argv[i] << ": " << e.what());
         }
     }
 
     if (objects.empty())
     {
-        std::cerr << "No valid models were loaded. Exiting.\n";
+        LOG_ERROR("No valid models were loaded. Exiting.");
         glfwTerminate();
         return -1;
     }
@@ -221,8 +226,20 @@ int main(int argc, char *argv[])
         texturedShader.setVec3("lightColor", glm::vec3(1.0f));
         texturedShader.setVec3("viewPos", cameraPos);
 
+        texturedShader.setBool("wireframe", wireframeMode);
+        texturedShader.setVec3("wireframeColor", glm::vec3(1.0f, 0.0f, 0.0f));
+        texturedShader.setFloat("wireframeWidth", 1.0f);
+
+        Frustum frustum(projection * view);
+        int visibleCount = 0;
         for (size_t i = 0; i < objects.size(); i++)
         {
+            if (!frustum.intersects(objects[i]->getWorldBounds()))
+            {
+                continue;
+            }
+            visibleCount++;
+
             texturedShader.setMat4("model", objects[i]->getModelMatrix());
 
             if (i == selectedObject)
@@ -255,17 +272,10 @@ int main(int argc, char *argv[])
 
                 objects[i]->drawWithTextures();
             }
-
-            if (wireframeMode)
-            {
-                glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-                texturedShader.setBool("useTexture", false);
-                texturedShader.setVec3("objectColor", glm::vec3(1.0f, 0.0f, 0.0f));
-                objects[i]->drawWithTextures();
-                glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-            }
         }
 
+        updateCullingTitle(window, "Textured Viewer (Domain)", visibleCount, int(objects.size()));
+
         glfwSwapBuffers(window);
         glfwPollEvents();
     }
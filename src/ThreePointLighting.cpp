@@ -5,8 +5,14 @@
 #include <glm/gtc/type_ptr.hpp>
 #include <vector>
 #include <iostream>
+#include <string>
 #include "domain/Shader.hpp"
+#include "domain/GLState.hpp"
+#include "domain/Frustum.hpp"
+#include "domain/CullingTitle.hpp"
 #include "domain/TexturedObj.hpp"
+#include "domain/LightCuller.hpp"
+#include "domain/Logger.hpp"
 
 const unsigned int SCR_WIDTH = 1280;
 const unsigned int SCR_HEIGHT = 720;
@@ -84,6 +90,11 @@ struct ThreePointLights
 };
 
 ThreePointLights lights;
+LightCuller lightCuller;
+std::vector<int> objectLights;
+
+// MAX_LIGHTS in three_point.frag
+const size_t MAX_OBJECT_LIGHTS = 4;
 std::vector<TexturedObj *> objects;
 int selectedObject = 0;
 
@@ -97,6 +108,8 @@ TransformMode currentMode = TRANSLATE;
 
 bool wireframeMode = false;
 bool showLightPositions = false;
+bool depthPrepass = false;
+bool showOverdraw = false;
 
 void framebuffer_size_callback(GLFWwindow *window, int width, int height);
 void processInput(GLFWwindow *window);
@@ -119,7 +132,7 @@ void processInput(GLFWwindow *window)
         if (!tabPressed && !objects.empty())
         {
             selectedObject = (selectedObject + 1) % objects.size();
-            std::cout << "Selected object: " << selectedObject << std::endl;
+            LOG_INFO("Selected object: " << selectedObject);
             updateLightPositions();
             tabPressed = true;
         }
@@ -157,7 +170,7 @@ void processInput(GLFWwindow *window)
         if (!key1Pressed)
         {
             lights.keyEnabled = !lights.keyEnabled;
-            std::cout << "Key Light: " << (lights.keyEnabled ? "ON" : "OFF") << std::endl;
+            LOG_INFO("Key Light: " << (lights.keyEnabled ? "ON" : "OFF"));
             key1Pressed = true;
         }
     }
@@ -171,7 +184,7 @@ void processInput(GLFWwindow *window)
         if (!key2Pressed)
         {
             lights.fillEnabled = !lights.fillEnabled;
-            std::cout << "Fill Light: " << (lights.fillEnabled ? "ON" : "OFF") << std::endl;
+            LOG_INFO("Fill Light: " << (lights.fillEnabled ? "ON" : "OFF"));
             key2Pressed = true;
         }
     }
@@ -185,7 +198,7 @@ void processInput(GLFWwindow *window)
         if (!key3Pressed)
         {
             lights.backEnabled = !lights.backEnabled;
-            std::cout << "Back Light: " << (lights.backEnabled ? "ON" : "OFF") << std::endl;
+            LOG_INFO("Back Light: " << (lights.backEnabled ? "ON" : "OFF"));
             key3Pressed = true;
         }
     }
@@ -200,7 +213,7 @@ void processInput(GLFWwindow *window)
         if (!lKeyPressed)
         {
             showLightPositions = !showLightPositions;
-            std::cout << "Light Position Debug: " << (showLightPositions ? "ON" : "OFF") << std::endl;
+            LOG_INFO("Light Position Debug: " << (showLightPositions ? "ON" : "OFF"));
             lKeyPressed = true;
         }
     }
@@ -209,6 +222,36 @@ void processInput(GLFWwindow *window)
         lKeyPressed = false;
     }
 
+    static bool pKeyPressed = false;
+    if (glfwGetKey(window, GLFW_KEY_P) == GLFW_PRESS)
+    {
+        if (!pKeyPressed)
+        {
+            depthPrepass = !depthPrepass;
+            LOG_INFO("Depth Pre-pass: " << (depthPrepass ? "ON" : "OFF"));
+            pKeyPressed = true;
+        }
+    }
+    else
+    {
+        pKeyPressed = false;
+    }
+
+    static bool oKeyPressed = false;
+    if (glfwGetKey(window, GLFW_KEY_O) == GLFW_PRESS)
+    {
+        if (!oKeyPressed)
+        {
+            showOverdraw = !showOverdraw;
+            LOG_INFO("Overdraw View: " << (showOverdraw ? "ON" : "OFF"));
+            oKeyPressed = true;
+        }
+    }
+    else
+    {
+        oKeyPressed = false;
+    }
+
     float speed = 2.5f * deltaTime;
     if (selectedObject >= 0 && selectedObject < objects.size())
     {
@@ -294,14 +337,13 @@ void updateLightPositions()
 
         if (showLightPositions)
         {
-            std::cout << "\n=== Light Positions Update ===" << std::endl;
-            std::cout << "Object position: (" << objectPos.x << ", " << objectPos.y << ", " << objectPos.z << ")" << std::endl;
-            std::cout << "Object max scale: " << maxScale << std::endl;
-            std::cout << "Key Light pos: (" << lights.keyPos.x << ", " << lights.keyPos.y << ", " << lights.keyPos.z << ")" << std::endl;
-            std::cout << "Fill Light pos: (" << lights.fillPos.x << ", " << lights.fillPos.y << ", " << lights.fillPos.z << ")" << std::endl;
-            std::cout << "Back Light pos: (" << lights.backPos.x << ", " << lights.backPos.y << ", " << lights.backPos.z << ")" << std::endl;
-            std::cout << "============================\n"
-                      << std::endl;
+            LOG_INFO("\n=== Light Positions Update ===");
+            LOG_INFO("Object position: (" << objectPos.x << ", " << objectPos.y << ", " << objectPos.z << ")");
+            LOG_INFO("Object max scale: " << maxScale);
+            LOG_INFO("Key Light pos: (" << lights.keyPos.x << ", " << lights.keyPos.y << ", " << lights.keyPos.z << ")");
+            LOG_INFO("Fill Light pos: (" << lights.fillPos.x << ", " << lights.fillPos.y << ", " << lights.fillPos.z << ")");
+            LOG_INFO("Back Light pos: (" << lights.backPos.x << ", " << lights.backPos.y << ", " << lights.backPos.z << ")");
+            LOG_INFO("============================\n");
         }
     }
 }
@@ -323,6 +365,9 @@ void printUsage(const char *programName)
     std::cout << "- 2: Toggle Fill Light (shadow softener)" << std::endl;
     std::cout << "- 3: Toggle Back Light (background separator)" << std::endl;
     std::cout << "- L: Toggle Light Position Debug" << std::endl;
+    std::cout << "Rendering:" << std::endl;
+    std::cout << "- P: Toggle depth pre-pass" << std::endl;
+    std::cout << "- O: Toggle overdraw visualization" << std::endl;
     std::cout << "- ESC: Exit" << std::endl;
     std::cout << "====================================" << std::endl;
 }
@@ -345,7 +390,7 @@ int main(int argc, char *argv[])
     GLFWwindow *window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "Three Point Lighting System", NULL, NULL);
     if (window == NULL)
     {
-        std::cout << "Failed to create GLFW window" << std::endl;
+        LOG_ERROR("Failed to create GLFW window");
         glfwTerminate();
         return -1;
     }
@@ -354,13 +399,15 @@ int main(int argc, char *argv[])
 
     if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
     {
-        std::cout << "Failed to initialize GLAD" << std::endl;
+        LOG_ERROR("Failed to initialize GLAD");
         return -1;
     }
 
-    glEnable(GL_DEPTH_TEST);
+    GLState::setDepthTest(true);
 
     Shader threePointShader("src/shaders/three_point.vert", "src/shaders/three_point.frag");
+    Shader depthShader("src/shaders/depth.vert", "src/shaders/depth.frag");
+    Shader overdrawShader("src/shaders/three_point.vert", "src/shaders/overdraw.frag");
 
     float xOffset = 0.0f;
     for (int i = 1; i < argc; i++)
@@ -371,25 +418,25 @@ int main(int argc, char *argv[])
             obj->translate(glm::vec3(xOffset, 0.0f, 0.0f));
             objects.push_back(obj);
             xOffset += 3.0f;
-            std::cout << "Loaded model: " << argv[i] << std::endl;
+            LOG_INFO("Loaded model: " << argv[i]);
         }
         catch (const std::exception &e)
         {
-            std::cerr << "Failed to load model " << argv[i] << ": " << e.what() << std::endl;
+            LOG_ERROR("Failed to load model " << argv[i] << ": " << e.what());
         }
     }
 
     if (objects.empty())
     {
-        std::cerr << "No valid models were loaded. Exiting.\n";
+        LOG_ERROR("No valid models were loaded. Exiting.");
         glfwTerminate();
         return -1;
     }
 
     updateLightPositions();
 
-    std::cout << "\nThree Point Lighting System initialized!" << std::endl;
-    std::cout << "Key Light: ON, Fill Light: ON, Back Light: ON" << std::endl;
+    LOG_INFO("\nThree Point Lighting System initialized!");
+    LOG_INFO("Key Light: ON, Fill Light: ON, Back Light: ON");
 
     while (!glfwWindowShouldClose(window))
     {
@@ -399,82 +446,171 @@ int main(int argc, char *argv[])
 
         processInput(window);
 
-        glClearColor(0.05f, 0.05f, 0.1f, 1.0f);
+        GLState::setDepthMask(true);
+        if (showOverdraw)
+        {
+            glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+        }
+        else
+        {
+            glClearColor(0.05f, 0.05f, 0.1f, 1.0f);
+        }
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-        threePointShader.use();
-
         glm::mat4 view = glm::lookAt(cameraPos, cameraPos + cameraFront, cameraUp);
         glm::mat4 projection = glm::perspective(glm::radians(45.0f),
                                                 (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
 
+        Frustum frustum(projection * view);
+        std::vector<size_t> visible;
+        for (size_t i = 0; i < objects.size(); i++)
+        {
+            if (frustum.intersects(objects[i]->getWorldBounds()))
+            {
+                visible.push_back(i);
+            }
+        }
+
+        if (depthPrepass)
+        {
+            depthShader.use();
+            depthShader.setMat4("view", view);
+            depthShader.setMat4("projection", projection);
+
+            GLState::setColorMask(false);
+            GLState::setDepthFunc(GL_LESS);
+            for (size_t i : visible)
+            {
+                depthShader.setMat4("model", objects[i]->getModelMatrix());
+                objects[i]->drawDepth();
+            }
+
+            // Shading only touches fragments whose depth matches what the pre-pass wrote
+            GLState::setColorMask(true);
+            GLState::setDepthMask(false);
+            GLState::setDepthFunc(GL_LEQUAL);
+        }
+        else
+        {
+            GLState::setDepthFunc(GL_LESS);
+        }
+
+        if (showOverdraw)
+        {
+            overdrawShader.use();
+            overdrawShader.setMat4("view", view);
+            overdrawShader.setMat4("projection", projection);
+            GLState::setBlend(true);
+            GLState::setBlendFunc(GL_ONE, GL_ONE);
+        }
+        else
+        {
+            GLState::setBlend(false);
+        }
+
+        Shader &shadingShader = showOverdraw ? overdrawShader : threePointShader;
+        threePointShader.use();
+
         threePointShader.setMat4("view", view);
         threePointShader.setMat4("projection", projection);
         threePointShader.setVec3("viewPos", cameraPos);
 
-        threePointShader.setBool("keyEnabled", lights.keyEnabled);
-        threePointShader.setBool("fillEnabled", lights.fillEnabled);
-        threePointShader.setBool("backEnabled", lights.backEnabled);
-
-        threePointShader.setVec3("keyPos", lights.keyPos);
-        threePointShader.setVec3("keyColor", lights.keyColor);
-        threePointShader.setFloat("keyIntensity", lights.keyIntensity);
-
-        threePointShader.setVec3("fillPos", lights.fillPos);
-        threePointShader.setVec3("fillColor", lights.fillColor);
-        threePointShader.setFloat("fillIntensity", lights.fillIntensity);
+        threePointShader.setBool("wireframe", wireframeMode);
+        threePointShader.setVec3("wireframeColor", glm::vec3(1.0f));
+        threePointShader.setFloat("wireframeWidth", 1.0f);
+
+        lightCuller.clear();
+        if (lights.keyEnabled)
+            lightCuller.add(lights.keyPos, lights.keyColor, lights.keyIntensity);
+        if (lights.fillEnabled)
+            lightCuller.add(lights.fillPos, lights.fillColor, lights.fillIntensity);
+        if (lights.backEnabled)
+            lightCuller.add(lights.backPos, lights.backColor, lights.backIntensity);
+
+        // Ambient isn't attenuated, so every enabled light adds to it whether
+        // or not it reaches a given object; with all lights off a dim fill remains
+        glm::vec3 ambientLight(0.0f);
+        for (const LightCuller::Light &light : lightCuller.getLights())
+        {
+            ambientLight += light.color * light.intensity;
+        }
+        if (lightCuller.getLights().empty())
+        {
+            ambientLight = glm::vec3(0.2f);
+        }
+        threePointShader.setVec3("ambientLight", ambientLight);
 
-        threePointShader.setVec3("backPos", lights.backPos);
-        threePointShader.setVec3("backColor", lights.backColor);
-        threePointShader.setFloat("backIntensity", lights.backIntensity);
+        const LightCuller::Attenuation &attenuation = lightCuller.getAttenuation();
+        threePointShader.setVec3("lightAttenuation", glm::vec3(attenuation.constant, attenuation.linear, attenuation.quadratic));
 
-        for (size_t i = 0; i < objects.size(); i++)
+        int objectLightCount = 0;
+        shadingShader.use();
+        for (size_t i : visible)
         {
-            threePointShader.setMat4("model", objects[i]->getModelMatrix());
+            shadingShader.setMat4("model", objects[i]->getModelMatrix());
 
             bool isSelected = (i == selectedObject);
-            threePointShader.setBool("isSelected", isSelected);
+            shadingShader.setBool("isSelected", isSelected);
+
+            // Only lights whose radius reaches the object's bounds are uploaded
+            if (!showOverdraw)
+            {
+                lightCuller.select(objects[i]->getWorldBounds(), MAX_OBJECT_LIGHTS, objectLights);
+
+                glm::vec3 positions[MAX_OBJECT_LIGHTS];
+                glm::vec3 colors[MAX_OBJECT_LIGHTS];
+                for (size_t k = 0; k < objectLights.size(); k++)
+                {
+                    const LightCuller::Light &light = lightCuller.getLights()[objectLights[k]];
+                    positions[k] = light.position;
+                    colors[k] = light.color * light.intensity;
+                }
+
+                int count = static_cast<int>(objectLights.size());
+                shadingShader.setInt("lightCount", count);
+                if (count > 0)
+                {
+                    shadingShader.setVec3Array("lightPositions", positions, count);
+                    shadingShader.setVec3Array("lightColors", colors, count);
+                }
+                objectLightCount += count;
+            }
 
             if (objects[i]->hasMaterials())
             {
                 Material material = objects[i]->getMaterial();
-                threePointShader.setFloat("ka", material.ambient.x);
-                threePointShader.setFloat("kd", material.diffuse.x);
-                threePointShader.setFloat("ks", material.specular.x);
-                threePointShader.setFloat("q", material.shininess);
+                shadingShader.setFloat("ka", material.ambient.x);
+                shadingShader.setFloat("kd", material.diffuse.x);
+                shadingShader.setFloat("ks", material.specular.x);
+                shadingShader.setFloat("q", material.shininess);
 
                 if (objects[i]->hasTextures())
                 {
-                    threePointShader.setBool("useTexture", true);
-                    objects[i]->drawTextured(threePointShader.ID);
+                    shadingShader.setBool("useTexture", true);
+                    objects[i]->drawTextured(shadingShader.ID);
                 }
                 else
                 {
-                    threePointShader.setBool("useTexture", false);
+                    shadingShader.setBool("useTexture", false);
                     objects[i]->drawWithTextures();
                 }
             }
             else
             {
-                threePointShader.setFloat("ka", 0.1f);
-                threePointShader.setFloat("kd", 0.7f);
-                threePointShader.setFloat("ks", 0.3f);
-                threePointShader.setFloat("q", 32.0f);
-                threePointShader.setBool("useTexture", false);
-
-                objects[i]->drawWithTextures();
-            }
+                shadingShader.setFloat("ka", 0.1f);
+                shadingShader.setFloat("kd", 0.7f);
+                shadingShader.setFloat("ks", 0.3f);
+                shadingShader.setFloat("q", 32.0f);
+                shadingShader.setBool("useTexture", false);
 
-            if (wireframeMode)
-            {
-                glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-                threePointShader.setBool("useTexture", false);
-                threePointShader.setFloat("kd", 1.0f);
                 objects[i]->drawWithTextures();
-                glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
             }
         }
 
+        updateCullingTitle(window, "Three Point Lighting System", (int)visible.size(), (int)objects.size(),
+                           " | lights uploaded: " + std::to_string(objectLightCount) +
+                           " of " + std::to_string(visible.size() * lightCuller.getLights().size()));
+
         glfwSwapBuffers(window);
         glfwPollEvents();
     }
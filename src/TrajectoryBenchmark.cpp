@@ -0,0 +1,325 @@
+#include <glm/glm.hpp>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include "domain/Trajectory.hpp"
+#include "domain/TrajectorySystem.hpp"
+#include "domain/CurveKernels.hpp"
+#include "domain/KeyframeTrack.hpp"
+#include "domain/Logger.hpp"
+
+// Moves 10k to 1M objects along a few shared trajectories and compares
+// TrajectorySystem (single and multithreaded) with querying each object's
+// Trajectory. Positions must agree to within the system's fitting tolerance.
+// Before that, every CurveKernels level this CPU supports is timed and checked
+// bit for bit against the scalar kernels, and at the end about a million
+// recorded samples are read back from text and from every KeyframeTrack encoding.
+
+const int PATH_COUNT = 64;
+const int POINTS_PER_PATH = 6;
+
+struct Timer {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    double ms() const {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+};
+
+std::vector<Trajectory> makePaths(std::mt19937& rng) {
+    std::uniform_real_distribution<float> coord(-20.0f, 20.0f);
+    const InterpolationType types[] = {InterpolationType::LINEAR, InterpolationType::BEZIER, InterpolationType::SPLINE};
+
+    std::vector<Trajectory> paths(PATH_COUNT);
+    for (int i = 0; i < PATH_COUNT; i++) {
+        paths[i].setInterpolationType(types[i % 3]);
+        for (int k = 0; k < POINTS_PER_PATH; k++) {
+            paths[i].addPoint(glm::vec3(coord(rng), coord(rng), coord(rng)));
+        }
+    }
+    return paths;
+}
+
+const size_t KERNEL_SAMPLES = 1000000;
+
+struct Samples {
+    std::vector<float> x, y, z;
+    explicit Samples(size_t count) : x(count), y(count), z(count) {}
+    bool operator==(const Samples& other) const {
+        size_t bytes = x.size() * sizeof(float);
+        return std::memcmp(x.data(), other.x.data(), bytes) == 0 && std::memcmp(y.data(), other.y.data(), bytes) == 0 &&
+               std::memcmp(z.data(), other.z.data(), bytes) == 0;
+    }
+    // Largest difference relative to the magnitude of other
+    float relativeError(const Samples& other) const {
+        float error = 0.0f;
+        for (size_t i = 0; i < x.size(); i++) {
+            glm::vec3 a(x[i], y[i], z[i]);
+            glm::vec3 b(other.x[i], other.y[i], other.z[i]);
+            error = std::max(error, glm::length(a - b) / std::max(1.0f, glm::length(b)));
+        }
+        return error;
+    }
+};
+
+// Kernels match the scalar code bit for bit unless the compiler fused the
+// scalar multiply-adds (e.g. -march=native), which moves the last bit
+const float KERNEL_EPSILON = 1e-5f;
+
+std::vector<CurveKernels::Level> supportedLevels() {
+    std::vector<CurveKernels::Level> levels;
+    for (auto level : {CurveKernels::Level::SCALAR, CurveKernels::Level::SSE, CurveKernels::Level::AVX2}) {
+        if (level <= CurveKernels::getBestLevel()) levels.push_back(level);
+    }
+    return levels;
+}
+
+// Runs evaluate at every level, timing each and comparing it with the scalar result
+template <typename Evaluate>
+bool compareLevels(const char* name, size_t count, double referenceMs, Evaluate evaluate, const Samples* reference = nullptr) {
+    std::cout << "  " << std::left << std::setw(12) << name << std::right;
+    if (referenceMs > 0.0) std::cout << "per point: " << referenceMs << " ms   ";
+
+    Samples scalar(count);
+    bool ok = true;
+    for (auto level : supportedLevels()) {
+        Samples result(count);
+        CurveKernels::setLevel(level);
+        Timer timer;
+        evaluate(result);
+        std::cout << CurveKernels::getLevelName(level) << ": " << timer.ms() << " ms   ";
+        if (level == CurveKernels::Level::SCALAR) {
+            scalar = result;
+        } else if (!(result == scalar)) {
+            float error = result.relativeError(scalar);
+            std::cout << "(off by " << std::scientific << error << std::fixed << ")   ";
+            if (error > KERNEL_EPSILON) ok = false;
+        }
+    }
+    CurveKernels::setLevel(CurveKernels::getBestLevel());
+
+    if (reference != nullptr) {
+        float error = scalar.relativeError(*reference);
+        std::cout << "scalar vs Trajectory: " << std::scientific << error << std::fixed;
+        if (error > KERNEL_EPSILON) ok = false;
+    }
+    std::cout << (ok ? "" : "  MISMATCH") << std::endl;
+    return ok;
+}
+
+bool runKernels(const std::vector<Trajectory>& paths, std::mt19937& rng) {
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    std::vector<float> t(KERNEL_SAMPLES);
+    for (auto& value : t) value = unit(rng);
+
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << "kernels: " << KERNEL_SAMPLES << " samples, best level " << CurveKernels::getLevelName(CurveKernels::getBestLevel())
+              << std::endl;
+
+    bool ok = true;
+    // paths alternate LINEAR, BEZIER, SPLINE
+    for (int index : {0, 2}) {
+        const Trajectory& path = paths[index];
+        Samples reference(KERNEL_SAMPLES);
+        Timer pointTimer;
+        for (size_t i = 0; i < KERNEL_SAMPLES; i++) {
+            glm::vec3 position = path.getPosition(t[i]);
+            reference.x[i] = position.x;
+            reference.y[i] = position.y;
+            reference.z[i] = position.z;
+        }
+        double pointMs = pointTimer.ms();
+        ok = compareLevels(index == 0 ? "linear" : "catmull-rom", KERNEL_SAMPLES, pointMs, [&](Samples& out) {
+            path.samplePositions(t.data(), KERNEL_SAMPLES, out.x.data(), out.y.data(), out.z.data());
+        }, &reference) && ok;
+    }
+
+    // Random cubic segments, as TrajectorySystem evaluates them
+    const int segmentCount = 4096;
+    std::uniform_int_distribution<int> pick(0, segmentCount - 1);
+    std::uniform_real_distribution<float> coefficient(-10.0f, 10.0f);
+    std::vector<float> storage(3 * 4 * segmentCount);
+    for (auto& value : storage) value = coefficient(rng);
+    CurveKernels::Cubics cubics;
+    for (int axis = 0; axis < 3; axis++) {
+        for (int power = 0; power < 4; power++) {
+            cubics.coefficients[axis][power] = storage.data() + (axis * 4 + power) * segmentCount;
+        }
+    }
+    std::vector<int> segments(KERNEL_SAMPLES);
+    for (auto& segment : segments) segment = pick(rng);
+    ok = compareLevels("cubics", KERNEL_SAMPLES, 0.0, [&](Samples& out) {
+        CurveKernels::evaluateCubics(cubics, segments.data(), t.data(), out.x.data(), out.y.data(), out.z.data(),
+                                     KERNEL_SAMPLES);
+    }) && ok;
+    return ok;
+}
+
+bool runBenchmark(const std::vector<Trajectory>& paths, int count, int frames, int threads, std::mt19937& rng) {
+    std::uniform_int_distribution<int> pick(0, PATH_COUNT - 1);
+    std::uniform_real_distribution<float> speed(0.5f, 5.0f);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+    std::vector<int> moverPath(count);
+    std::vector<float> moverSpeed(count), moverDistance(count);
+    for (int i = 0; i < count; i++) {
+        moverPath[i] = pick(rng);
+        moverSpeed[i] = speed(rng);
+        moverDistance[i] = unit(rng) * paths[moverPath[i]].getLength();
+    }
+
+    Timer buildTimer;
+    TrajectorySystem single, multi;
+    std::vector<int> pathIds;
+    for (const auto& path : paths) {
+        pathIds.push_back(single.addPath(path));
+        multi.addPath(path);
+    }
+    for (int i = 0; i < count; i++) {
+        single.addMover(pathIds[moverPath[i]], moverSpeed[i], moverDistance[i]);
+        multi.addMover(pathIds[moverPath[i]], moverSpeed[i], moverDistance[i]);
+    }
+    double buildMs = buildTimer.ms() * 0.5;
+
+    const float dt = 1.0f / 60.0f;
+    double objectMs = 0.0, singleMs = 0.0, multiMs = 0.0;
+    std::vector<glm::vec3> expected(count);
+    float maxError = 0.0f;
+    bool ok = true;
+
+    for (int frame = 0; frame < frames; frame++) {
+        // What SceneViewer did per object: its own trajectory, one query each
+        Timer objectTimer;
+        for (int i = 0; i < count; i++) {
+            const Trajectory& path = paths[moverPath[i]];
+            moverDistance[i] += moverSpeed[i] * dt;
+            if (moverDistance[i] >= path.getLength()) moverDistance[i] = std::fmod(moverDistance[i], path.getLength());
+            expected[i] = path.getPositionAtDistance(moverDistance[i]);
+        }
+        objectMs += objectTimer.ms();
+
+        Timer singleTimer;
+        single.update(dt, 1);
+        singleMs += singleTimer.ms();
+
+        Timer multiTimer;
+        multi.update(dt, threads);
+        multiMs += multiTimer.ms();
+
+        for (int i = 0; i < count; i++) {
+            // Checked at the system's own distance, so only the fit is measured
+            glm::vec3 reference = paths[moverPath[i]].getPositionAtDistance(single.getDistance(i));
+            maxError = std::max(maxError, glm::length(single.getPosition(i) - reference));
+            if (single.getPosition(i) != multi.getPosition(i)) ok = false;
+        }
+    }
+    if (maxError > 2.0f * TrajectorySystem::TOLERANCE) ok = false;
+
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << "movers: " << count << "  paths: " << single.getPathCount() << "  segments: " << single.getSegmentCount()
+              << "  build: " << buildMs << " ms" << std::endl;
+    std::cout << "  per frame  per object: " << objectMs / frames << " ms"
+              << "   system: " << singleMs / frames << " ms"
+              << "   system x" << threads << ": " << multiMs / frames << " ms" << std::endl;
+    std::cout << "  max deviation from Trajectory: " << maxError << (ok ? "" : "  MISMATCH") << std::endl;
+    return ok;
+}
+
+const size_t KEYFRAME_SAMPLES = 1000000;
+const float KEYFRAME_RATE = 120.0f;
+
+bool runKeyframes(const std::vector<Trajectory>& paths) {
+    // Laps of every path one after another, as a long recording would be
+    KeyframeWriter writers[] = {KeyframeWriter(KeyframeTrack::FLOAT32), KeyframeWriter(KeyframeTrack::QUANTIZED16),
+                                KeyframeWriter(KeyframeTrack::QUANTIZED16_DELTA)};
+    while (writers[0].getSampleCount() < KEYFRAME_SAMPLES) {
+        for (size_t p = 0; p < paths.size() && writers[0].getSampleCount() < KEYFRAME_SAMPLES; p++) {
+            for (auto& writer : writers) writer.addTrajectory(paths[p], KEYFRAME_RATE);
+        }
+    }
+
+    std::filesystem::path directory = std::filesystem::temp_directory_path();
+    std::string textPath = (directory / "keyframes.txt").string();
+    std::vector<glm::vec4> expected;
+    {
+        KeyframeTrack track;
+        std::string path = (directory / "keyframes.f32").string();
+        if (!writers[0].save(path) || !track.open(path)) return false;
+        float step = track.getDuration() / static_cast<float>(track.getSampleCount());
+        std::ofstream text(textPath);
+        text << std::setprecision(9);
+        for (uint64_t i = 0; i < track.getSampleCount(); i++) {
+            float time = track.getStartTime() + i * step;
+            glm::vec3 position = track.sample(time);
+            expected.push_back(glm::vec4(position, time));
+            text << time << " " << position.x << " " << position.y << " " << position.z << "\n";
+        }
+    }
+
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << "keyframes: " << writers[0].getSampleCount() << " samples" << std::endl;
+
+    Timer textTimer;
+    std::ifstream text(textPath);
+    std::vector<glm::vec4> parsed;
+    glm::vec4 value;
+    while (text >> value.w >> value.x >> value.y >> value.z) parsed.push_back(value);
+    std::cout << "  text         size: " << std::filesystem::file_size(textPath) / 1024 << " KiB   parse: " << textTimer.ms()
+              << " ms" << std::endl;
+    text.close();
+    std::filesystem::remove(textPath);
+
+    const char* names[] = {"float32", "quantized16", "delta"};
+    const char* extensions[] = {".f32", ".q16", ".d16"};
+    bool ok = parsed.size() == expected.size();
+    for (int e = 0; e < 3; e++) {
+        std::string path = (directory / (std::string("keyframes") + extensions[e])).string();
+        if (e > 0 && !writers[e].save(path)) return false;
+
+        KeyframeTrack track;
+        Timer openTimer;
+        if (!track.open(path)) return false;
+        double openMs = openTimer.ms();
+
+        // The playhead sweeping forward through the whole recording
+        Timer sampleTimer;
+        float error = 0.0f;
+        for (const auto& sample : expected) {
+            error = std::max(error, glm::length(track.sample(sample.w) - glm::vec3(sample)));
+        }
+        double sampleMs = sampleTimer.ms();
+
+        // 16 bits over a block's bounds, which span at most the paths' 40 units
+        float tolerance = e == 0 ? 1e-4f : 2e-3f;
+        if (error > tolerance) ok = false;
+        std::cout << "  " << std::left << std::setw(12) << names[e] << std::right << " size: " << track.getFileSize() / 1024
+                  << " KiB   blocks: " << track.getBlockCount() << "   open: " << openMs << " ms   sample: " << sampleMs
+                  << " ms   max error: " << std::scientific << error << std::fixed << (error > tolerance ? "  MISMATCH" : "")
+                  << std::endl;
+        track.close();
+        std::filesystem::remove(path);
+    }
+    return ok;
+}
+
+int main(int argc, char* argv[]) {
+    Logger::setLevel(LogLevel::INFO);
+    int frames = argc > 1 ? std::max(1, std::atoi(argv[1])) : 60;
+    int threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    std::mt19937 rng(1234);
+    std::vector<Trajectory> paths = makePaths(rng);
+
+    bool ok = runKernels(paths, rng);
+    for (int count : {10000, 100000, 1000000}) {
+        ok = runBenchmark(paths, count, frames, threads, rng) && ok;
+    }
+    ok = runKeyframes(paths) && ok;
+    return ok ? 0 : 1;
+}
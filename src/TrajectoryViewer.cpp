@@ -5,9 +5,18 @@
 #include <glm/gtc/type_ptr.hpp>
 #include <vector>
 #include <iostream>
+#include <string>
 #include "domain/Shader.hpp"
+#include "domain/GLState.hpp"
+#include "domain/Frustum.hpp"
+#include "domain/CullingTitle.hpp"
 #include "domain/TexturedObj.hpp"
 #include "domain/Trajectory.hpp"
+#include "domain/SimulationClock.hpp"
+#include "domain/CurveRenderer.hpp"
+#include "domain/Logger.hpp"
+#include "domain/InputRecorder.hpp"
+#include "domain/FrameTimings.hpp"
 
 const unsigned int SCR_WIDTH = 1280;
 const unsigned int SCR_HEIGHT = 720;
@@ -19,21 +28,34 @@ glm::vec3 cameraUp = glm::vec3(0.0f, 1.0f, 0.0f);
 float deltaTime = 0.0f;
 float lastFrame = 0.0f;
 
+// Keys, mouse motion and deltaTime of the current frame, live or replayed
+InputRecorder input;
+
+// Trajectories advance in fixed steps; objects are drawn between the last two
+SimulationClock simulationClock;
+
 struct ObjectWithTrajectory
 {
     TexturedObj *obj;
     Trajectory trajectory;
     bool isMoving;
+
+    // Positions after the previous and the latest simulation step
+    glm::vec3 previousPosition;
+    glm::vec3 currentPosition;
+    bool stepped;
 };
 
 std::vector<ObjectWithTrajectory> objects;
 int selectedObject = 0;
 
 bool addingControlPoint = false;
+bool showCurves = true;
 
 void framebuffer_size_callback(GLFWwindow *window, int width, int height);
 void processInput(GLFWwindow *window);
 void mouse_callback(GLFWwindow *window, double xpos, double ypos);
+void look(float xoffset, float yoffset);
 void printUsage(const char *programName);
 
 void framebuffer_size_callback(GLFWwindow *window, int width, int height)
@@ -59,6 +81,11 @@ void mouse_callback(GLFWwindow *window, double xpos, double ypos)
     lastX = xpos;
     lastY = ypos;
 
+    input.moveCursor(xoffset, yoffset);
+}
+
+void look(float xoffset, float yoffset)
+{
     float sensitivity = 0.1f;
     xoffset *= sensitivity;
     yoffset *= sensitivity;
@@ -83,26 +110,30 @@ void mouse_callback(GLFWwindow *window, double xpos, double ypos)
 
 void processInput(GLFWwindow *window)
 {
-    if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+    glm::vec2 offset = input.getCursorOffset();
+    if (offset.x != 0.0f || offset.y != 0.0f)
+        look(offset.x, offset.y);
+
+    if (input.getKey(GLFW_KEY_ESCAPE) == GLFW_PRESS)
         glfwSetWindowShouldClose(window, true);
 
     float cameraSpeed = 2.5f * deltaTime;
-    if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
+    if (input.getKey(GLFW_KEY_W) == GLFW_PRESS)
         cameraPos += cameraSpeed * cameraFront;
-    if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
+    if (input.getKey(GLFW_KEY_S) == GLFW_PRESS)
         cameraPos -= cameraSpeed * cameraFront;
-    if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
+    if (input.getKey(GLFW_KEY_A) == GLFW_PRESS)
         cameraPos -= glm::normalize(glm::cross(cameraFront, cameraUp)) * cameraSpeed;
-    if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
+    if (input.getKey(GLFW_KEY_D) == GLFW_PRESS)
         cameraPos += glm::normalize(glm::cross(cameraFront, cameraUp)) * cameraSpeed;
 
     static bool tabPressed = false;
-    if (glfwGetKey(window, GLFW_KEY_TAB) == GLFW_PRESS)
+    if (input.getKey(GLFW_KEY_TAB) == GLFW_PRESS)
     {
         if (!tabPressed && !objects.empty())
         {
             selectedObject = (selectedObject + 1) % objects.size();
-            std::cout << "Selected object: " << selectedObject << std::endl;
+            LOG_INFO("Selected object: " << selectedObject);
             tabPressed = true;
         }
     }
@@ -114,12 +145,12 @@ void processInput(GLFWwindow *window)
     if (!objects.empty() && selectedObject >= 0 && selectedObject < objects.size())
     {
         static bool cPressed = false;
-        if (glfwGetKey(window, GLFW_KEY_C) == GLFW_PRESS)
+        if (input.getKey(GLFW_KEY_C) == GLFW_PRESS)
         {
             if (!cPressed)
             {
                 addingControlPoint = !addingControlPoint;
-                std::cout << (addingControlPoint ? "Adding control points" : "Stopped adding control points") << std::endl;
+                LOG_INFO((addingControlPoint ? "Adding control points" : "Stopped adding control points"));
                 cPressed = true;
             }
         }
@@ -128,13 +159,28 @@ void processInput(GLFWwindow *window)
             cPressed = false;
         }
 
+        static bool vPressed = false;
+        if (input.getKey(GLFW_KEY_V) == GLFW_PRESS)
+        {
+            if (!vPressed)
+            {
+                showCurves = !showCurves;
+                LOG_INFO("Trajectory curves: " << (showCurves ? "ON" : "OFF"));
+                vPressed = true;
+            }
+        }
+        else
+        {
+            vPressed = false;
+        }
+
         static bool xPressed = false;
-        if (glfwGetKey(window, GLFW_KEY_X) == GLFW_PRESS)
+        if (input.getKey(GLFW_KEY_X) == GLFW_PRESS)
         {
             if (!xPressed)
             {
                 objects[selectedObject].trajectory.clear();
-                std::cout << "Cleared trajectory for object " << selectedObject << std::endl;
+                LOG_INFO("Cleared trajectory for object " << selectedObject);
                 xPressed = true;
             }
         }
@@ -144,12 +190,12 @@ void processInput(GLFWwindow *window)
         }
 
         static bool mPressed = false;
-        if (glfwGetKey(window, GLFW_KEY_M) == GLFW_PRESS)
+        if (input.getKey(GLFW_KEY_M) == GLFW_PRESS)
         {
             if (!mPressed)
             {
                 objects[selectedObject].isMoving = !objects[selectedObject].isMoving;
-                std::cout << "Object " << selectedObject << (objects[selectedObject].isMoving ? " started" : " stopped") << " movement" << std::endl;
+                LOG_INFO("Object " << selectedObject << (objects[selectedObject].isMoving ? " started" : " stopped") << " movement");
                 mPressed = true;
             }
         }
@@ -159,7 +205,7 @@ void processInput(GLFWwindow *window)
         }
 
         static bool spacePressed = false;
-        if (addingControlPoint && glfwGetKey(window, GLFW_KEY_SPACE) == GLFW_PRESS)
+        if (addingControlPoint && input.getKey(GLFW_KEY_SPACE) == GLFW_PRESS)
         {
             if (!spacePressed)
             {
@@ -175,7 +221,7 @@ void processInput(GLFWwindow *window)
         }
 
         static bool f1Pressed = false;
-        if (glfwGetKey(window, GLFW_KEY_F1) == GLFW_PRESS)
+        if (input.getKey(GLFW_KEY_F1) == GLFW_PRESS)
         {
             if (!f1Pressed)
             {
@@ -190,7 +236,7 @@ void processInput(GLFWwindow *window)
         }
 
         static bool f2Pressed = false;
-        if (glfwGetKey(window, GLFW_KEY_F2) == GLFW_PRESS)
+        if (input.getKey(GLFW_KEY_F2) == GLFW_PRESS)
         {
             if (!f2Pressed)
             {
@@ -205,14 +251,14 @@ void processInput(GLFWwindow *window)
         }
 
         static bool iPressed = false;
-        if (glfwGetKey(window, GLFW_KEY_I) == GLFW_PRESS)
+        if (input.getKey(GLFW_KEY_I) == GLFW_PRESS)
         {
             if (!iPressed)
             {
-                std::cout << "=== Trajectory Info for Object " << selectedObject << " ===" << std::endl;
+                LOG_INFO("=== Trajectory Info for Object " << selectedObject << " ===");
                 objects[selectedObject].trajectory.printInfo();
-                std::cout << "Movement: " << (objects[selectedObject].isMoving ? "ON" : "OFF") << std::endl;
-                std::cout << "=====================================" << std::endl;
+                LOG_INFO("Movement: " << (objects[selectedObject].isMoving ? "ON" : "OFF"));
+                LOG_INFO("=====================================");
                 iPressed = true;
             }
         }
@@ -222,7 +268,7 @@ void processInput(GLFWwindow *window)
         }
 
         static bool plusPressed = false;
-        if (glfwGetKey(window, GLFW_KEY_EQUAL) == GLFW_PRESS)
+        if (input.getKey(GLFW_KEY_EQUAL) == GLFW_PRESS)
         {
             if (!plusPressed)
             {
@@ -237,7 +283,7 @@ void processInput(GLFWwindow *window)
         }
 
         static bool minusPressed = false;
-        if (glfwGetKey(window, GLFW_KEY_MINUS) == GLFW_PRESS)
+        if (input.getKey(GLFW_KEY_MINUS) == GLFW_PRESS)
         {
             if (!minusPressed)
             {
@@ -252,17 +298,17 @@ void processInput(GLFWwindow *window)
         }
 
         float moveSpeed = 2.0f * deltaTime;
-        if (glfwGetKey(window, GLFW_KEY_UP) == GLFW_PRESS)
+        if (input.getKey(GLFW_KEY_UP) == GLFW_PRESS)
             objects[selectedObject].obj->translate(glm::vec3(0.0f, moveSpeed, 0.0f));
-        if (glfwGetKey(window, GLFW_KEY_DOWN) == GLFW_PRESS)
+        if (input.getKey(GLFW_KEY_DOWN) == GLFW_PRESS)
             objects[selectedObject].obj->translate(glm::vec3(0.0f, -moveSpeed, 0.0f));
-        if (glfwGetKey(window, GLFW_KEY_LEFT) == GLFW_PRESS)
+        if (input.getKey(GLFW_KEY_LEFT) == GLFW_PRESS)
             objects[selectedObject].obj->translate(glm::vec3(-moveSpeed, 0.0f, 0.0f));
-        if (glfwGetKey(window, GLFW_KEY_RIGHT) == GLFW_PRESS)
+        if (input.getKey(GLFW_KEY_RIGHT) == GLFW_PRESS)
             objects[selectedObject].obj->translate(glm::vec3(moveSpeed, 0.0f, 0.0f));
-        if (glfwGetKey(window, GLFW_KEY_PAGE_UP) == GLFW_PRESS)
+        if (input.getKey(GLFW_KEY_PAGE_UP) == GLFW_PRESS)
             objects[selectedObject].obj->translate(glm::vec3(0.0f, 0.0f, -moveSpeed));
-        if (glfwGetKey(window, GLFW_KEY_PAGE_DOWN) == GLFW_PRESS)
+        if (input.getKey(GLFW_KEY_PAGE_DOWN) == GLFW_PRESS)
             objects[selectedObject].obj->translate(glm::vec3(0.0f, 0.0f, moveSpeed));
     }
 }
@@ -271,6 +317,7 @@ void printUsage(const char *programName)
 {
     std::cout << "=== TRAJECTORY VIEWER ===" << std::endl;
     std::cout << "Usage: " << programName << " <model1.obj> [model2.obj] [model3.obj] ..." << std::endl;
+    std::cout << "       [--record file | --replay file] [--timings file.csv] [--headless]" << std::endl;
     std::cout << "Tutorial: Press C, move object, press Space, press C, press M" << std::endl;
     std::cout << "Controls:" << std::endl;
     std::cout << "- WASD: Move camera" << std::endl;
@@ -285,6 +332,7 @@ void printUsage(const char *programName)
     std::cout << "- F1: Save trajectory to file" << std::endl;
     std::cout << "- F2: Load trajectory from file" << std::endl;
     std::cout << "- I: Show trajectory info" << std::endl;
+    std::cout << "- V: Toggle drawing the trajectories and their control points" << std::endl;
     std::cout << "- +/-: Adjust movement speed" << std::endl;
     std::cout << "- ESC: Exit" << std::endl;
     std::cout << "========================" << std::endl;
@@ -292,7 +340,8 @@ void printUsage(const char *programName)
 
 int main(int argc, char *argv[])
 {
-    if (argc < 2)
+    InputRecorder::Options options = InputRecorder::Options::parse(argc, argv);
+    if (options.arguments.empty())
     {
         printUsage(argv[0]);
         return -1;
@@ -300,15 +349,29 @@ int main(int argc, char *argv[])
 
     printUsage(argv[0]);
 
+    if (options.headless && options.replayPath.empty())
+    {
+        LOG_ERROR("--headless needs --replay: a hidden window takes no input");
+        return -1;
+    }
+    if (!input.start(options))
+    {
+        return -1;
+    }
+
     glfwInit();
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    if (options.headless)
+    {
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    }
 
     GLFWwindow *window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "Trajectory Viewer", NULL, NULL);
     if (window == NULL)
     {
-        std::cout << "Failed to create GLFW window" << std::endl;
+        LOG_ERROR("Failed to create GLFW window");
         glfwTerminate();
         return -1;
     }
@@ -316,48 +379,72 @@ int main(int argc, char *argv[])
     glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
     glfwSetCursorPosCallback(window, mouse_callback);
     glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+    if (options.headless)
+    {
+        glfwSwapInterval(0);
+    }
 
     if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
     {
-        std::cout << "Failed to initialize GLAD" << std::endl;
+        LOG_ERROR("Failed to initialize GLAD");
         return -1;
     }
 
-    glEnable(GL_DEPTH_TEST);
+    GLState::setDepthTest(true);
 
     Shader texturedShader("src/shaders/textured.vert", "src/shaders/textured.frag");
+    CurveRenderer *curveRenderer = new CurveRenderer();
 
     float xOffset = 0.0f;
-    for (int i = 1; i < argc; i++)
+    for (const std::string &model : options.arguments)
     {
         try
         {
-            TexturedObj *obj = new TexturedObj(argv[i]);
+            TexturedObj *obj = new TexturedObj(model);
             obj->translate(glm::vec3(xOffset, 0.0f, 0.0f));
-            ObjectWithTrajectory objWithTraj = {obj, Trajectory(), false};
+            ObjectWithTrajectory objWithTraj = {obj, Trajectory(), false, glm::vec3(0.0f), glm::vec3(0.0f), false};
             objects.push_back(objWithTraj);
             xOffset += 3.0f;
-            std::cout << "Loaded model: " << argv[i] << std::endl;
+            LOG_INFO("Loaded model: " << model);
         }
         catch (const std::exception &e)
         {
-            std::cerr << "Failed to load model " << argv[i] << ": " << e.what() << std::endl;
+            LOG_ERROR("Failed to load model " << model << ": " << e.what());
         }
     }
 
     if (objects.empty())
     {
-        std::cerr << "No valid models were loaded. Exiting.\n";
+        LOG_ERROR("No valid models were loaded. Exiting.");
         glfwTerminate();
         return -1;
     }
 
+    FrameTimings *frameTimings = nullptr;
+    if (!options.timingsPath.empty())
+    {
+        frameTimings = new FrameTimings();
+        if (!frameTimings->open(options.timingsPath, {"visible_objects"}))
+        {
+            delete frameTimings;
+            frameTimings = nullptr;
+        }
+    }
+
     while (!glfwWindowShouldClose(window))
     {
         float currentFrame = glfwGetTime();
         deltaTime = currentFrame - lastFrame;
         lastFrame = currentFrame;
 
+        if (!input.beginFrame(window, deltaTime))
+            break;
+        deltaTime = input.getDeltaTime();
+        if (frameTimings != nullptr)
+        {
+            frameTimings->beginFrame();
+        }
+
         processInput(window);
 
         glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
@@ -376,16 +463,41 @@ int main(int argc, char *argv[])
         texturedShader.setVec3("lightColor", glm::vec3(1.0f));
         texturedShader.setVec3("viewPos", cameraPos);
 
+        int steps = simulationClock.advance(deltaTime);
+        float alpha = simulationClock.getAlpha();
+
+        Frustum frustum(projection * view);
+        int visibleCount = 0;
         for (size_t i = 0; i < objects.size(); i++)
         {
-            if (objects[i].isMoving)
+            ObjectWithTrajectory &object = objects[i];
+            if (object.isMoving)
             {
-                glm::vec3 newPos = objects[i].trajectory.getNextPosition(deltaTime);
-                glm::mat4 modelMatrix = objects[i].obj->getModelMatrix();
-                glm::vec3 currentPos(modelMatrix[3][0], modelMatrix[3][1], modelMatrix[3][2]);
-                glm::vec3 translation = newPos - currentPos;
-                objects[i].obj->translate(translation);
+                for (int step = 0; step < steps; step++)
+                {
+                    float distance = object.trajectory.getDistance();
+                    glm::vec3 position = object.trajectory.getNextPosition(simulationClock.getStep());
+                    // Restarting the cycle is a jump, not motion to blend
+                    bool restarted = object.trajectory.getDistance() < distance;
+                    object.previousPosition = object.stepped && !restarted ? object.currentPosition : position;
+                    object.currentPosition = position;
+                    object.stepped = true;
+                }
+                if (object.stepped)
+                {
+                    object.obj->setPosition(glm::mix(object.previousPosition, object.currentPosition, alpha));
+                }
             }
+            else
+            {
+                object.stepped = false;
+            }
+
+            if (!frustum.intersects(objects[i].obj->getWorldBounds()))
+            {
+                continue;
+            }
+            visibleCount++;
 
             texturedShader.setMat4("model", objects[i].obj->getModelMatrix());
 
@@ -421,14 +533,32 @@ int main(int argc, char *argv[])
             }
         }
 
+        if (showCurves)
+        {
+            for (size_t i = 0; i < objects.size(); i++)
+            {
+                curveRenderer->update(static_cast<int>(i), objects[i].trajectory);
+            }
+            curveRenderer->draw(view, projection, glm::vec4(1.0f, 0.8f, 0.2f, 1.0f), glm::vec4(1.0f, 0.3f, 0.2f, 1.0f));
+        }
+
+        updateCullingTitle(window, "Trajectory Viewer", visibleCount, int(objects.size()));
+
         glfwSwapBuffers(window);
         glfwPollEvents();
+        if (frameTimings != nullptr)
+        {
+            frameTimings->endFrame(deltaTime, {static_cast<unsigned long>(visibleCount)});
+        }
     }
 
     for (const auto &obj : objects)
     {
         delete obj.obj;
     }
+    delete curveRenderer;
+    delete frameTimings;
+    input.stop();
     glfwTerminate();
     return 0;
 }
\ No newline at end of file
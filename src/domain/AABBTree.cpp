@@ -0,0 +1,368 @@
+#include "AABBTree.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    // Predicted motion is exaggerated a little so steadily moving objects
+    // don't fall out of their fat box every frame
+    const float DISPLACEMENT_MULTIPLIER = 2.0f;
+
+    AABB fatten(const AABB& box, float margin, const glm::vec3& displacement) {
+        AABB fat;
+        fat.min = box.min - glm::vec3(margin);
+        fat.max = box.max + glm::vec3(margin);
+
+        glm::vec3 d = displacement * DISPLACEMENT_MULTIPLIER;
+        for (int i = 0; i < 3; i++) {
+            if (d[i] < 0.0f) fat.min[i] += d[i];
+            else fat.max[i] += d[i];
+        }
+        return fat;
+    }
+}
+
+AABBTree::AABBTree(float margin)
+    : root(NULL_NODE)
+    , freeList(NULL_NODE)
+    , proxyCount(0)
+    , margin(margin) {
+}
+
+int AABBTree::allocateNode() {
+    if (freeList == NULL_NODE) {
+        nodes.push_back(Node());
+        return static_cast<int>(nodes.size()) - 1;
+    }
+
+    int node = freeList;
+    freeList = nodes[node].parent;
+    nodes[node] = Node();
+    return node;
+}
+
+void AABBTree::freeNode(int node) {
+    nodes[node].height = -1;
+    nodes[node].parent = freeList;
+    freeList = node;
+}
+
+void AABBTree::clear() {
+    nodes.clear();
+    root = NULL_NODE;
+    freeList = NULL_NODE;
+    proxyCount = 0;
+}
+
+int AABBTree::insert(const AABB& box, int key) {
+    int proxy = allocateNode();
+    nodes[proxy].tight = box;
+    nodes[proxy].fat = fatten(box, margin, glm::vec3(0.0f));
+    nodes[proxy].height = 0;
+    nodes[proxy].key = key;
+
+    insertLeaf(proxy);
+    proxyCount++;
+    return proxy;
+}
+
+void AABBTree::remove(int proxy) {
+    removeLeaf(proxy);
+    freeNode(proxy);
+    proxyCount--;
+}
+
+bool AABBTree::update(int proxy, const AABB& box, const glm::vec3& displacement) {
+    nodes[proxy].tight = box;
+    if (nodes[proxy].fat.contains(box)) {
+        return false;
+    }
+
+    removeLeaf(proxy);
+    nodes[proxy].fat = fatten(box, margin, displacement);
+    insertLeaf(proxy);
+    return true;
+}
+
+int AABBTree::getHeight() const {
+    return root == NULL_NODE ? 0 : nodes[root].height;
+}
+
+void AABBTree::insertLeaf(int leaf) {
+    if (root == NULL_NODE) {
+        root = leaf;
+        nodes[root].parent = NULL_NODE;
+        return;
+    }
+
+    // Descend towards the sibling with the lowest surface area heuristic cost
+    AABB leafBox = nodes[leaf].fat;
+    int index = root;
+    while (!nodes[index].isLeaf()) {
+        int child1 = nodes[index].child1;
+        int child2 = nodes[index].child2;
+
+        float area = nodes[index].fat.surfaceArea();
+        float combinedArea = AABB::merge(nodes[index].fat, leafBox).surfaceArea();
+
+        // Cost of pairing the leaf with this node, and the cost pushed down to
+        // every ancestor if we keep descending instead
+        float cost = 2.0f * combinedArea;
+        float inheritanceCost = 2.0f * (combinedArea - area);
+
+        auto descendCost = [&](int child) {
+            float merged = AABB::merge(leafBox, nodes[child].fat).surfaceArea();
+            if (nodes[child].isLeaf()) return merged + inheritanceCost;
+            return merged - nodes[child].fat.surfaceArea() + inheritanceCost;
+        };
+        float cost1 = descendCost(child1);
+        float cost2 = descendCost(child2);
+
+        if (cost < cost1 && cost < cost2) break;
+        index = cost1 < cost2 ? child1 : child2;
+    }
+
+    int sibling = index;
+    int oldParent = nodes[sibling].parent;
+    int newParent = allocateNode();
+    nodes[newParent].parent = oldParent;
+    nodes[newParent].fat = AABB::merge(leafBox, nodes[sibling].fat);
+    nodes[newParent].height = nodes[sibling].height + 1;
+    nodes[newParent].child1 = sibling;
+    nodes[newParent].child2 = leaf;
+    nodes[sibling].parent = newParent;
+    nodes[leaf].parent = newParent;
+
+    if (oldParent != NULL_NODE) {
+        if (nodes[oldParent].child1 == sibling) nodes[oldParent].child1 = newParent;
+        else nodes[oldParent].child2 = newParent;
+    } else {
+        root = newParent;
+    }
+
+    refitAncestors(nodes[leaf].parent);
+}
+
+void AABBTree::removeLeaf(int leaf) {
+    if (leaf == root) {
+        root = NULL_NODE;
+        return;
+    }
+
+    int parent = nodes[leaf].parent;
+    int grandParent = nodes[parent].parent;
+    int sibling = nodes[parent].child1 == leaf ? nodes[parent].child2 : nodes[parent].child1;
+
+    if (grandParent != NULL_NODE) {
+        if (nodes[grandParent].child1 == parent) nodes[grandParent].child1 = sibling;
+        else nodes[grandParent].child2 = sibling;
+        nodes[sibling].parent = grandParent;
+        freeNode(parent);
+        refitAncestors(grandParent);
+    } else {
+        root = sibling;
+        nodes[sibling].parent = NULL_NODE;
+        freeNode(parent);
+    }
+}
+
+void AABBTree::refitAncestors(int index) {
+    while (index != NULL_NODE) {
+        index = balance(index);
+
+        int child1 = nodes[index].child1;
+        int child2 = nodes[index].child2;
+        nodes[index].height = 1 + std::max(nodes[child1].height, nodes[child2].height);
+        nodes[index].fat = AABB::merge(nodes[child1].fat, nodes[child2].fat);
+
+        index = nodes[index].parent;
+    }
+}
+
+// Rotates the taller grandchild up when the subtrees of A differ in height by
+// more than one. Returns the node now sitting where A was.
+int AABBTree::balance(int iA) {
+    Node& A = nodes[iA];
+    if (A.isLeaf() || A.height < 2) {
+        return iA;
+    }
+
+    int iB = A.child1;
+    int iC = A.child2;
+    Node& B = nodes[iB];
+    Node& C = nodes[iC];
+
+    int diff = C.height - B.height;
+
+    if (diff > 1) {
+        int iF = C.child1;
+        int iG = C.child2;
+        Node& F = nodes[iF];
+        Node& G = nodes[iG];
+
+        C.child1 = iA;
+        C.parent = A.parent;
+        A.parent = iC;
+
+        if (C.parent != NULL_NODE) {
+            if (nodes[C.parent].child1 == iA) nodes[C.parent].child1 = iC;
+            else nodes[C.parent].child2 = iC;
+        } else {
+            root = iC;
+        }
+
+        if (F.height > G.height) {
+            C.child2 = iF;
+            A.child2 = iG;
+            G.parent = iA;
+            A.fat = AABB::merge(B.fat, G.fat);
+            C.fat = AABB::merge(A.fat, F.fat);
+            A.height = 1 + std::max(B.height, G.height);
+            C.height = 1 + std::max(A.height, F.height);
+        } else {
+            C.child2 = iG;
+            A.child2 = iF;
+            F.parent = iA;
+            A.fat = AABB::merge(B.fat, F.fat);
+            C.fat = AABB::merge(A.fat, G.fat);
+            A.height = 1 + std::max(B.height, F.height);
+            C.height = 1 + std::max(A.height, G.height);
+        }
+        return iC;
+    }
+
+    if (diff < -1) {
+        int iD = B.child1;
+        int iE = B.child2;
+        Node& D = nodes[iD];
+        Node& E = nodes[iE];
+
+        B.child1 = iA;
+        B.parent = A.parent;
+        A.parent = iB;
+
+        if (B.parent != NULL_NODE) {
+            if (nodes[B.parent].child1 == iA) nodes[B.parent].child1 = iB;
+            else nodes[B.parent].child2 = iB;
+        } else {
+            root = iB;
+        }
+
+        if (D.height > E.height) {
+            B.child2 = iD;
+            A.child1 = iE;
+            E.parent = iA;
+            A.fat = AABB::merge(C.fat, E.fat);
+            B.fat = AABB::merge(A.fat, D.fat);
+            A.height = 1 + std::max(C.height, E.height);
+            B.height = 1 + std::max(A.height, D.height);
+        } else {
+            B.child2 = iE;
+            A.child1 = iD;
+            D.parent = iA;
+            A.fat = AABB::merge(C.fat, D.fat);
+            B.fat = AABB::merge(A.fat, E.fat);
+            A.height = 1 + std::max(C.height, D.height);
+            B.height = 1 + std::max(A.height, E.height);
+        }
+        return iB;
+    }
+
+    return iA;
+}
+
+void AABBTree::queryFrustum(const Frustum& frustum, std::vector<int>& keys) const {
+    if (root == NULL_NODE) return;
+
+    // Each entry carries the planes its parent still straddled
+    std::vector<std::pair<int, unsigned int>> stack;
+    stack.reserve(64);
+    stack.push_back({root, Frustum::ALL_PLANES});
+    while (!stack.empty()) {
+        int index = stack.back().first;
+        unsigned int planeMask = stack.back().second;
+        stack.pop_back();
+        const Node& node = nodes[index];
+
+        const AABB& box = node.isLeaf() ? node.tight : node.fat;
+        if (frustum.classify(box, planeMask) == Frustum::OUTSIDE) continue;
+
+        if (node.isLeaf()) {
+            keys.push_back(node.key);
+            continue;
+        }
+
+        // Under a fully contained node the mask is empty, so the whole
+        // subtree is gathered without another plane test
+        stack.push_back({node.child1, planeMask});
+        stack.push_back({node.child2, planeMask});
+    }
+}
+
+void AABBTree::queryOverlap(const AABB& box, std::vector<int>& keys) const {
+    if (root == NULL_NODE) return;
+
+    std::vector<int> stack;
+    stack.reserve(64);
+    stack.push_back(root);
+    while (!stack.empty()) {
+        const Node& node = nodes[stack.back()];
+        stack.pop_back();
+
+        if (node.isLeaf()) {
+            if (node.tight.overlaps(box)) keys.push_back(node.key);
+        } else if (node.fat.overlaps(box)) {
+            stack.push_back(node.child1);
+            stack.push_back(node.child2);
+        }
+    }
+}
+
+void AABBTree::queryRay(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, std::vector<int>& keys) const {
+    if (root == NULL_NODE) return;
+
+    std::vector<int> stack;
+    stack.reserve(64);
+    stack.push_back(root);
+    while (!stack.empty()) {
+        const Node& node = nodes[stack.back()];
+        stack.pop_back();
+
+        float distance;
+        if (node.isLeaf()) {
+            if (node.tight.raycast(origin, direction, maxDistance, distance)) keys.push_back(node.key);
+        } else if (node.fat.raycast(origin, direction, maxDistance, distance)) {
+            stack.push_back(node.child1);
+            stack.push_back(node.child2);
+        }
+    }
+}
+
+int AABBTree::raycastClosest(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, float& distance) const {
+    int closest = NULL_NODE;
+    if (root == NULL_NODE) return -1;
+
+    // Each hit shortens the ray, which prunes every subtree behind it
+    std::vector<int> stack;
+    stack.reserve(64);
+    stack.push_back(root);
+    while (!stack.empty()) {
+        int index = stack.back();
+        stack.pop_back();
+        const Node& node = nodes[index];
+
+        float t;
+        if (node.isLeaf()) {
+            if (node.tight.raycast(origin, direction, maxDistance, t)) {
+                maxDistance = t;
+                closest = index;
+            }
+        } else if (node.fat.raycast(origin, direction, maxDistance, t)) {
+            stack.push_back(node.child1);
+            stack.push_back(node.child2);
+        }
+    }
+
+    if (closest == NULL_NODE) return -1;
+    distance = maxDistance;
+    return nodes[closest].key;
+}
@@ -0,0 +1,70 @@
+#ifndef AABB_TREE_H
+#define AABB_TREE_H
+
+#include "Bounds.hpp"
+#include "Frustum.hpp"
+#include <glm/glm.hpp>
+#include <vector>
+
+// Dynamic bounding volume hierarchy over scene objects.
+// Leaves store a fattened box so small movements don't touch the tree at all;
+// when an object leaves its fat box it is reinserted and the path back to the
+// root is rebalanced with AVL-style rotations. Each proxy carries an int key
+// (e.g. an index into the scene's object list) which is what queries report.
+class AABBTree {
+public:
+    static const int NULL_NODE = -1;
+
+    explicit AABBTree(float margin = 0.1f);
+
+    int insert(const AABB& box, int key);
+    void remove(int proxy);
+
+    // Returns true if the proxy had to be reinserted. The displacement since
+    // the last update stretches the fat box in the direction of motion.
+    bool update(int proxy, const AABB& box, const glm::vec3& displacement = glm::vec3(0.0f));
+
+    void clear();
+
+    int getKey(int proxy) const { return nodes[proxy].key; }
+    const AABB& getFatBounds(int proxy) const { return nodes[proxy].fat; }
+    int getHeight() const;
+    int getProxyCount() const { return proxyCount; }
+
+    // Queries append the keys of matching proxies; leaves are tested with their
+    // tight box so results match a brute-force scan.
+    void queryFrustum(const Frustum& frustum, std::vector<int>& keys) const;
+    void queryOverlap(const AABB& box, std::vector<int>& keys) const;
+    void queryRay(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, std::vector<int>& keys) const;
+
+    // Nearest proxy whose tight box the ray hits, or -1
+    int raycastClosest(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, float& distance) const;
+
+private:
+    struct Node {
+        AABB fat;
+        AABB tight;
+        int parent = NULL_NODE;  // doubles as the free-list link
+        int child1 = NULL_NODE;
+        int child2 = NULL_NODE;
+        int height = -1;
+        int key = -1;
+
+        bool isLeaf() const { return child1 == NULL_NODE; }
+    };
+
+    std::vector<Node> nodes;
+    int root;
+    int freeList;
+    int proxyCount;
+    float margin;
+
+    int allocateNode();
+    void freeNode(int node);
+    void insertLeaf(int leaf);
+    void removeLeaf(int leaf);
+    void refitAncestors(int node);
+    int balance(int node);
+};
+
+#endif
@@ -0,0 +1,105 @@
+#include "Bounds.hpp"
+#include <algorithm>
+#include <cmath>
+
+AABB AABB::fromPoints(const std::vector<glm::vec3>& points) {
+    AABB box;
+    if (points.empty()) return box;
+
+    box.min = points[0];
+    box.max = points[0];
+    for (const auto& p : points) {
+        box.min = glm::min(box.min, p);
+        box.max = glm::max(box.max, p);
+    }
+    return box;
+}
+
+AABB AABB::merge(const AABB& a, const AABB& b) {
+    AABB box;
+    box.min = glm::min(a.min, b.min);
+    box.max = glm::max(a.max, b.max);
+    return box;
+}
+
+float AABB::surfaceArea() const {
+    glm::vec3 d = max - min;
+    return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+}
+
+bool AABB::contains(const AABB& other) const {
+    return min.x <= other.min.x && min.y <= other.min.y && min.z <= other.min.z &&
+           other.max.x <= max.x && other.max.y <= max.y && other.max.z <= max.z;
+}
+
+bool AABB::overlaps(const AABB& other) const {
+    return min.x <= other.max.x && other.min.x <= max.x &&
+           min.y <= other.max.y && other.min.y <= max.y &&
+           min.z <= other.max.z && other.min.z <= max.z;
+}
+
+bool AABB::raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, float& distance) const {
+    float tMin = 0.0f;
+    float tMax = maxDistance;
+
+    for (int i = 0; i < 3; i++) {
+        if (std::abs(direction[i]) < 1e-8f) {
+            if (origin[i] < min[i] || origin[i] > max[i]) return false;
+            continue;
+        }
+
+        float inv = 1.0f / direction[i];
+        float t0 = (min[i] - origin[i]) * inv;
+        float t1 = (max[i] - origin[i]) * inv;
+        if (t0 > t1) std::swap(t0, t1);
+
+        tMin = std::max(tMin, t0);
+        tMax = std::min(tMax, t1);
+        if (tMin > tMax) return false;
+    }
+
+    distance = tMin;
+    return true;
+}
+
+AABB AABB::transformed(const glm::mat4& m) const {
+    glm::vec3 c = glm::vec3(m * glm::vec4(center(), 1.0f));
+    glm::vec3 e = extents();
+
+    // Project the extents onto each world axis through the absolute rotation/scale part
+    glm::vec3 worldExtents;
+    for (int i = 0; i < 3; i++) {
+        worldExtents[i] = std::abs(m[0][i]) * e.x + std::abs(m[1][i]) * e.y + std::abs(m[2][i]) * e.z;
+    }
+
+    AABB box;
+    box.min = c - worldExtents;
+    box.max = c + worldExtents;
+    return box;
+}
+
+BoundingSphere BoundingSphere::fromPoints(const std::vector<glm::vec3>& points) {
+    BoundingSphere sphere;
+    if (points.empty()) return sphere;
+
+    // Centre on the box midpoint; cheaper than a minimal sphere and close enough for culling
+    sphere.center = AABB::fromPoints(points).center();
+    float radiusSq = 0.0f;
+    for (const auto& p : points) {
+        glm::vec3 d = p - sphere.center;
+        radiusSq = std::max(radiusSq, glm::dot(d, d));
+    }
+    sphere.radius = std::sqrt(radiusSq);
+    return sphere;
+}
+
+BoundingSphere BoundingSphere::transformed(const glm::mat4& m) const {
+    float sx = glm::length(glm::vec3(m[0]));
+    float sy = glm::length(glm::vec3(m[1]));
+    float sz = glm::length(glm::vec3(m[2]));
+
+    BoundingSphere sphere;
+    sphere.center = glm::vec3(m * glm::vec4(center, 1.0f));
+    sphere.radius = radius * std::max(sx, std::max(sy, sz));
+    return sphere;
+}
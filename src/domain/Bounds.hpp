@@ -0,0 +1,39 @@
+#ifndef BOUNDS_H
+#define BOUNDS_H
+
+#include <glm/glm.hpp>
+#include <vector>
+
+struct AABB {
+    glm::vec3 min = glm::vec3(0.0f);
+    glm::vec3 max = glm::vec3(0.0f);
+
+    static AABB fromPoints(const std::vector<glm::vec3>& points);
+
+    static AABB merge(const AABB& a, const AABB& b);
+
+    glm::vec3 center() const { return (min + max) * 0.5f; }
+    glm::vec3 extents() const { return (max - min) * 0.5f; }
+    float surfaceArea() const;
+
+    bool contains(const AABB& other) const;
+    bool overlaps(const AABB& other) const;
+
+    // Slab test; on a hit, distance is the entry point along the (normalized) direction
+    bool raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, float& distance) const;
+
+    // Box enclosing this one after an affine transform
+    AABB transformed(const glm::mat4& m) const;
+};
+
+struct BoundingSphere {
+    glm::vec3 center = glm::vec3(0.0f);
+    float radius = 0.0f;
+
+    static BoundingSphere fromPoints(const std::vector<glm::vec3>& points);
+
+    // Conservative under non-uniform scale: the radius grows by the largest axis scale
+    BoundingSphere transformed(const glm::mat4& m) const;
+};
+
+#endif
@@ -15,6 +15,11 @@ glm::mat4 Camera::GetViewMatrix() const
     return glm::lookAt(position, position + front, up);
 }
 
+Frustum Camera::GetFrustum(const glm::mat4 &projection) const
+{
+    return Frustum(projection * GetViewMatrix());
+}
+
 void Camera::MoveForward(float deltaTime)
 {
     position += front * movementSpeed * deltaTime;
@@ -4,6 +4,7 @@
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
+#include "Frustum.hpp"
 
 class Camera
 {
@@ -14,6 +15,7 @@ public:
            float pitch = 0.0f);
 
     glm::mat4 GetViewMatrix() const;
+    Frustum GetFrustum(const glm::mat4 &projection) const;
 
     void MoveForward(float deltaTime);
     void MoveBackward(float deltaTime);
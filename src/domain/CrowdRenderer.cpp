@@ -0,0 +1,161 @@
+#include "CrowdRenderer.hpp"
+#include "GLState.hpp"
+#include <cstddef>
+
+namespace {
+    const GLuint PATH_ATTRIBUTE = 4;
+    const GLuint OFFSET_ATTRIBUTE = 5;
+
+    // Instance layout in the vertex buffer; the path id travels as a float,
+    // which is exact far beyond any path count
+    struct InstanceData {
+        float path;
+        float phase;
+        float speed;
+        glm::vec3 offset;
+    };
+}
+
+CrowdRenderer::CrowdRenderer()
+    : vao(0)
+    , vertexBuffer(0)
+    , instanceBuffer(0)
+    , vertexCount(0)
+    , instanceCount(0)
+    , diffuseTexture(0)
+    , model(1.0f)
+    , material(0.0f) {
+    glGenBuffers(1, &vertexBuffer);
+    glGenBuffers(1, &instanceBuffer);
+    glGenBuffers(2, buffers);
+    glGenTextures(2, textures);
+
+    glGenVertexArrays(1, &vao);
+    GLState::bindVertexArray(vao);
+
+    glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(TextureVertex), (void*)0);
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(TextureVertex), (void*)offsetof(TextureVertex, normal));
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(TextureVertex), (void*)offsetof(TextureVertex, texCoord));
+
+    glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+    glEnableVertexAttribArray(PATH_ATTRIBUTE);
+    glVertexAttribPointer(PATH_ATTRIBUTE, 3, GL_FLOAT, GL_FALSE, sizeof(InstanceData), (void*)0);
+    glVertexAttribDivisor(PATH_ATTRIBUTE, 1);
+    glEnableVertexAttribArray(OFFSET_ATTRIBUTE);
+    glVertexAttribPointer(OFFSET_ATTRIBUTE, 3, GL_FLOAT, GL_FALSE, sizeof(InstanceData),
+                          (void*)offsetof(InstanceData, offset));
+    glVertexAttribDivisor(OFFSET_ATTRIBUTE, 1);
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    GLState::bindVertexArray(0);
+}
+
+CrowdRenderer::~CrowdRenderer() {
+    GLState::deleteVertexArray(vao);
+    GLuint vertexBuffers[] = {vertexBuffer, instanceBuffer};
+    glDeleteBuffers(2, vertexBuffers);
+    glDeleteBuffers(2, buffers);
+    for (GLuint texture : textures) {
+        GLState::deleteTexture(texture);
+    }
+}
+
+void CrowdRenderer::setPaths(const TrajectorySystem& paths) {
+    // 4 texels per segment: (c0, start), (c1, scale), (c2, 0), (c3, 0)
+    std::vector<glm::vec4> segmentData;
+    segmentData.reserve(paths.getSegmentCount() * 4);
+    for (size_t s = 0; s < paths.getSegmentCount(); s++) {
+        int segment = static_cast<int>(s);
+        segmentData.push_back(glm::vec4(paths.getSegmentCoefficient(segment, 0), paths.getSegmentStart(segment)));
+        segmentData.push_back(glm::vec4(paths.getSegmentCoefficient(segment, 1), paths.getSegmentScale(segment)));
+        segmentData.push_back(glm::vec4(paths.getSegmentCoefficient(segment, 2), 0.0f));
+        segmentData.push_back(glm::vec4(paths.getSegmentCoefficient(segment, 3), 0.0f));
+    }
+
+    // Per path: first segment, segment count, length
+    std::vector<glm::vec4> pathData;
+    for (size_t p = 0; p < paths.getPathCount(); p++) {
+        int path = static_cast<int>(p);
+        pathData.push_back(glm::vec4(static_cast<float>(paths.getPathFirstSegment(path)),
+                                     static_cast<float>(paths.getPathSegmentCount(path)),
+                                     paths.getPathLength(path), 0.0f));
+    }
+
+    // A texture buffer needs storage even when nothing will read it
+    if (segmentData.empty()) segmentData.push_back(glm::vec4(0.0f));
+    if (pathData.empty()) pathData.push_back(glm::vec4(0.0f));
+
+    const std::vector<glm::vec4>* data[2] = {&segmentData, &pathData};
+    for (int slot = 0; slot < 2; slot++) {
+        glBindBuffer(GL_TEXTURE_BUFFER, buffers[slot]);
+        glBufferData(GL_TEXTURE_BUFFER, data[slot]->size() * sizeof(glm::vec4), data[slot]->data(), GL_STATIC_DRAW);
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+        GLState::bindTexture(SEGMENT_UNIT + slot, GL_TEXTURE_BUFFER, textures[slot]);
+        glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, buffers[slot]);
+    }
+}
+
+bool CrowdRenderer::setMesh(const TexturedObj& mesh, const glm::mat4& meshModel, const glm::vec4& meshMaterial) {
+    const std::vector<TextureVertex>& vertices = mesh.getVertices();
+    if (vertices.empty()) {
+        return false;
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(TextureVertex), vertices.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    vertexCount = static_cast<GLsizei>(vertices.size());
+    diffuseTexture = mesh.getDiffuseTexture();
+    model = meshModel;
+    model[3] = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+    material = meshMaterial;
+    return true;
+}
+
+void CrowdRenderer::setInstances(const std::vector<Instance>& instances) {
+    std::vector<InstanceData> data;
+    data.reserve(instances.size());
+    for (const auto& instance : instances) {
+        data.push_back({static_cast<float>(instance.path), instance.phase, instance.speed, instance.offset});
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+    glBufferData(GL_ARRAY_BUFFER, data.size() * sizeof(InstanceData), data.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    instanceCount = instances.size();
+}
+
+void CrowdRenderer::clear() {
+    instanceCount = 0;
+    vertexCount = 0;
+    diffuseTexture = 0;
+}
+
+void CrowdRenderer::bind(Shader& shader, float time) const {
+    GLState::bindTexture(SEGMENT_UNIT, GL_TEXTURE_BUFFER, textures[0]);
+    GLState::bindTexture(PATH_UNIT, GL_TEXTURE_BUFFER, textures[1]);
+    shader.setInt("crowdSegments", SEGMENT_UNIT);
+    shader.setInt("crowdPaths", PATH_UNIT);
+    shader.setFloat("crowdTime", time);
+    shader.setMat4("crowdModel", model);
+    shader.setVec4("crowdMaterial", material);
+    shader.setInt("crowdUseTexture", diffuseTexture != 0 ? 1 : 0);
+
+    if (diffuseTexture != 0) {
+        GLState::bindTexture(0, GL_TEXTURE_2D, diffuseTexture);
+        shader.setInt("texture_diffuse1", 0);
+    }
+}
+
+void CrowdRenderer::draw() const {
+    if (instanceCount == 0 || vertexCount == 0) return;
+
+    GLState::bindVertexArray(vao);
+    glDrawArraysInstanced(GL_TRIANGLES, 0, vertexCount, static_cast<GLsizei>(instanceCount));
+}
@@ -0,0 +1,67 @@
+#ifndef CROWD_RENDERER_H
+#define CROWD_RENDERER_H
+
+#include "glad/glad.h"
+#include "Shader.hpp"
+#include "TexturedObj.hpp"
+#include "TrajectorySystem.hpp"
+#include <glm/glm.hpp>
+#include <vector>
+
+// Instanced crowds that move along trajectories entirely on the GPU.
+// The cubic segments of paths compiled by a TrajectorySystem are uploaded
+// once into a texture buffer, and every instance only stores its path, its
+// distance along it at time zero, its speed and an offset from the path. The
+// vertex shader (crowd.vert) finds the instance's segment by binary search and
+// evaluates it at the current time, so animating the crowd costs the CPU one
+// uniform per frame however many instances there are. Needs only GL 3.3.
+class CrowdRenderer {
+public:
+    // Texture units used by bind(), after the shadow cube maps
+    static const int SEGMENT_UNIT = 12;
+    static const int PATH_UNIT = 13;
+
+    struct Instance {
+        int path;               // path id in the TrajectorySystem given to setPaths
+        float phase;            // distance along the path at time zero
+        float speed;            // world units per second
+        glm::vec3 offset;       // added to the path position
+    };
+
+    CrowdRenderer();
+    ~CrowdRenderer();
+
+    CrowdRenderer(const CrowdRenderer&) = delete;
+    CrowdRenderer& operator=(const CrowdRenderer&) = delete;
+
+    void setPaths(const TrajectorySystem& paths);
+
+    // Copies the mesh's full-detail vertices; model supplies rotation and scale
+    // (its translation is ignored) and material the scene.frag material
+    bool setMesh(const TexturedObj& mesh, const glm::mat4& model, const glm::vec4& material);
+
+    void setInstances(const std::vector<Instance>& instances);
+    void clear();
+
+    // Binds the buffers and texture and sets the crowd uniforms on an active shader
+    void bind(Shader& shader, float time) const;
+    void draw() const;
+
+    size_t getInstanceCount() const { return instanceCount; }
+    size_t getTriangleCount() const { return instanceCount * (vertexCount / 3); }
+
+private:
+    GLuint vao;
+    GLuint vertexBuffer;
+    GLuint instanceBuffer;
+    GLuint buffers[2];      // segments, paths
+    GLuint textures[2];
+
+    GLsizei vertexCount;
+    size_t instanceCount;
+    GLuint diffuseTexture;
+    glm::mat4 model;
+    glm::vec4 material;
+};
+
+#endif
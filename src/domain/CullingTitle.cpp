@@ -0,0 +1,13 @@
+#include "CullingTitle.hpp"
+
+void updateCullingTitle(GLFWwindow* window, const std::string& baseTitle, int visible, int total,
+                        const std::string& detail) {
+    static std::string lastTitle;
+
+    std::string title = baseTitle + " - visible: " + std::to_string(visible) +
+                        " culled: " + std::to_string(total - visible) + detail;
+    if (title != lastTitle) {
+        glfwSetWindowTitle(window, title.c_str());
+        lastTitle = title;
+    }
+}
@@ -0,0 +1,13 @@
+#ifndef CULLING_TITLE_H
+#define CULLING_TITLE_H
+
+#include <GLFW/glfw3.h>
+#include <string>
+
+// Shows the frustum culling result in the window title:
+// "<baseTitle> - visible: N culled: M<detail>". The title is only handed to
+// GLFW when its text changes, so calling this every frame is cheap.
+void updateCullingTitle(GLFWwindow* window, const std::string& baseTitle, int visible, int total,
+                        const std::string& detail = "");
+
+#endif
@@ -0,0 +1,346 @@
+#include "CurveKernels.hpp"
+#include <algorithm>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define CURVE_KERNELS_X86
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define AVX2_TARGET
+#else
+#define AVX2_TARGET __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace CurveKernels {
+
+namespace {
+    // Segment index and local parameter of t, exactly as Trajectory computes them
+    inline void locate(float t, float segmentTime, int lastSegment, int& segment, float& local) {
+        segment = std::max(std::min(static_cast<int>(t / segmentTime), lastSegment), 0);
+        local = (t - segment * segmentTime) / segmentTime;
+        local = std::min(std::max(local, 0.0f), 1.0f);
+    }
+
+    void cubicsScalar(const Cubics& cubics, const int* segments, const float* u,
+                      float* const out[3], size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            int s = segments[i];
+            for (int axis = 0; axis < 3; axis++) {
+                const float* const* c = cubics.coefficients[axis];
+                out[axis][i] = ((c[3][s] * u[i] + c[2][s]) * u[i] + c[1][s]) * u[i] + c[0][s];
+            }
+        }
+    }
+
+    void linearScalar(const Points& points, const float* t, float* const out[3], size_t begin, size_t end) {
+        const float* p[3] = {points.x, points.y, points.z};
+        float segmentTime = 1.0f / (points.count - 1);
+        for (size_t i = begin; i < end; i++) {
+            int segment;
+            float local;
+            locate(t[i], segmentTime, points.count - 2, segment, local);
+            for (int axis = 0; axis < 3; axis++) {
+                out[axis][i] = p[axis][segment] * (1.0f - local) + p[axis][segment + 1] * local;
+            }
+        }
+    }
+
+    void catmullRomScalar(const Points& points, const float* t, float* const out[3], size_t begin, size_t end) {
+        const float* p[3] = {points.x, points.y, points.z};
+        int n = points.count - 1;
+        float segmentTime = 1.0f / n;
+        for (size_t i = begin; i < end; i++) {
+            int segment;
+            float local;
+            locate(t[i], segmentTime, n - 1, segment, local);
+            int p0 = std::max(0, segment - 1);
+            int p1 = segment;
+            int p2 = segment + 1;
+            int p3 = std::min(n, segment + 2);
+
+            float t2 = local * local;
+            float t3 = t2 * local;
+            float w0 = -0.5f * t3 + t2 - 0.5f * local;
+            float w1 = 1.5f * t3 - 2.5f * t2 + 1.0f;
+            float w2 = -1.5f * t3 + 2.0f * t2 + 0.5f * local;
+            float w3 = 0.5f * t3 - 0.5f * t2;
+            for (int axis = 0; axis < 3; axis++) {
+                out[axis][i] = w0 * p[axis][p0] + w1 * p[axis][p1] + w2 * p[axis][p2] + w3 * p[axis][p3];
+            }
+        }
+    }
+
+#ifdef CURVE_KERNELS_X86
+    // SSE2 is part of x86-64, so this level needs no CPU check. It has no
+    // gather, so coefficients and points are loaded lane by lane.
+
+    inline __m128 load4(const float* base, const int* index) {
+        return _mm_set_ps(base[index[3]], base[index[2]], base[index[1]], base[index[0]]);
+    }
+
+    inline void locate4(__m128 t, __m128 segmentTime, __m128 lastSegment, __m128& segment, __m128& local) {
+        segment = _mm_cvtepi32_ps(_mm_cvttps_epi32(_mm_div_ps(t, segmentTime)));
+        segment = _mm_max_ps(_mm_min_ps(segment, lastSegment), _mm_setzero_ps());
+        local = _mm_div_ps(_mm_sub_ps(t, _mm_mul_ps(segment, segmentTime)), segmentTime);
+        local = _mm_min_ps(_mm_max_ps(local, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+    }
+
+    size_t cubicsSSE(const Cubics& cubics, const int* segments, const float* u, float* const out[3], size_t count) {
+        size_t i = 0;
+        for (; i + 4 <= count; i += 4) {
+            __m128 v = _mm_loadu_ps(u + i);
+            for (int axis = 0; axis < 3; axis++) {
+                const float* const* c = cubics.coefficients[axis];
+                __m128 r = _mm_add_ps(_mm_mul_ps(load4(c[3], segments + i), v), load4(c[2], segments + i));
+                r = _mm_add_ps(_mm_mul_ps(r, v), load4(c[1], segments + i));
+                r = _mm_add_ps(_mm_mul_ps(r, v), load4(c[0], segments + i));
+                _mm_storeu_ps(out[axis] + i, r);
+            }
+        }
+        return i;
+    }
+
+    size_t linearSSE(const Points& points, const float* t, float* const out[3], size_t count) {
+        const float* p[3] = {points.x, points.y, points.z};
+        __m128 segmentTime = _mm_set1_ps(1.0f / (points.count - 1));
+        __m128 lastSegment = _mm_set1_ps(static_cast<float>(points.count - 2));
+        __m128 one = _mm_set1_ps(1.0f);
+        size_t i = 0;
+        for (; i + 4 <= count; i += 4) {
+            __m128 segment, local;
+            locate4(_mm_loadu_ps(t + i), segmentTime, lastSegment, segment, local);
+            alignas(16) int index[4];
+            alignas(16) int next[4];
+            __m128i segmentIndex = _mm_cvttps_epi32(segment);
+            _mm_store_si128(reinterpret_cast<__m128i*>(index), segmentIndex);
+            _mm_store_si128(reinterpret_cast<__m128i*>(next), _mm_add_epi32(segmentIndex, _mm_set1_epi32(1)));
+
+            __m128 inverse = _mm_sub_ps(one, local);
+            for (int axis = 0; axis < 3; axis++) {
+                __m128 r = _mm_add_ps(_mm_mul_ps(load4(p[axis], index), inverse), _mm_mul_ps(load4(p[axis], next), local));
+                _mm_storeu_ps(out[axis] + i, r);
+            }
+        }
+        return i;
+    }
+
+    size_t catmullRomSSE(const Points& points, const float* t, float* const out[3], size_t count) {
+        const float* p[3] = {points.x, points.y, points.z};
+        int n = points.count - 1;
+        __m128 segmentTime = _mm_set1_ps(1.0f / n);
+        __m128 lastSegment = _mm_set1_ps(static_cast<float>(n - 1));
+        size_t i = 0;
+        for (; i + 4 <= count; i += 4) {
+            __m128 segment, local;
+            locate4(_mm_loadu_ps(t + i), segmentTime, lastSegment, segment, local);
+            alignas(16) int index[4][4];
+            _mm_store_si128(reinterpret_cast<__m128i*>(index[1]), _mm_cvttps_epi32(segment));
+            for (int lane = 0; lane < 4; lane++) {
+                index[0][lane] = std::max(0, index[1][lane] - 1);
+                index[2][lane] = index[1][lane] + 1;
+                index[3][lane] = std::min(n, index[1][lane] + 2);
+            }
+
+            __m128 t2 = _mm_mul_ps(local, local);
+            __m128 t3 = _mm_mul_ps(t2, local);
+            __m128 halfLocal = _mm_mul_ps(_mm_set1_ps(0.5f), local);
+            __m128 w0 = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(-0.5f), t3), t2), halfLocal);
+            __m128 w1 = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(_mm_set1_ps(1.5f), t3), _mm_mul_ps(_mm_set1_ps(2.5f), t2)),
+                                   _mm_set1_ps(1.0f));
+            __m128 w2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(-1.5f), t3), _mm_mul_ps(_mm_set1_ps(2.0f), t2)),
+                                   halfLocal);
+            __m128 w3 = _mm_sub_ps(_mm_mul_ps(_mm_set1_ps(0.5f), t3), _mm_mul_ps(_mm_set1_ps(0.5f), t2));
+            for (int axis = 0; axis < 3; axis++) {
+                __m128 r = _mm_add_ps(_mm_mul_ps(w0, load4(p[axis], index[0])), _mm_mul_ps(w1, load4(p[axis], index[1])));
+                r = _mm_add_ps(r, _mm_mul_ps(w2, load4(p[axis], index[2])));
+                r = _mm_add_ps(r, _mm_mul_ps(w3, load4(p[axis], index[3])));
+                _mm_storeu_ps(out[axis] + i, r);
+            }
+        }
+        return i;
+    }
+
+    // AVX2: eight lanes and hardware gathers. Built without FMA so the
+    // rounding matches the other levels.
+
+    AVX2_TARGET inline void locate8(__m256 t, __m256 segmentTime, __m256 lastSegment, __m256& segment, __m256& local) {
+        segment = _mm256_cvtepi32_ps(_mm256_cvttps_epi32(_mm256_div_ps(t, segmentTime)));
+        segment = _mm256_max_ps(_mm256_min_ps(segment, lastSegment), _mm256_setzero_ps());
+        local = _mm256_div_ps(_mm256_sub_ps(t, _mm256_mul_ps(segment, segmentTime)), segmentTime);
+        local = _mm256_min_ps(_mm256_max_ps(local, _mm256_setzero_ps()), _mm256_set1_ps(1.0f));
+    }
+
+    AVX2_TARGET size_t cubicsAVX2(const Cubics& cubics, const int* segments, const float* u, float* const out[3],
+                                  size_t count) {
+        size_t i = 0;
+        for (; i + 8 <= count; i += 8) {
+            __m256i s = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(segments + i));
+            __m256 v = _mm256_loadu_ps(u + i);
+            for (int axis = 0; axis < 3; axis++) {
+                const float* const* c = cubics.coefficients[axis];
+                __m256 r = _mm256_add_ps(_mm256_mul_ps(_mm256_i32gather_ps(c[3], s, 4), v), _mm256_i32gather_ps(c[2], s, 4));
+                r = _mm256_add_ps(_mm256_mul_ps(r, v), _mm256_i32gather_ps(c[1], s, 4));
+                r = _mm256_add_ps(_mm256_mul_ps(r, v), _mm256_i32gather_ps(c[0], s, 4));
+                _mm256_storeu_ps(out[axis] + i, r);
+            }
+        }
+        return i;
+    }
+
+    AVX2_TARGET size_t linearAVX2(const Points& points, const float* t, float* const out[3], size_t count) {
+        const float* p[3] = {points.x, points.y, points.z};
+        __m256 segmentTime = _mm256_set1_ps(1.0f / (points.count - 1));
+        __m256 lastSegment = _mm256_set1_ps(static_cast<float>(points.count - 2));
+        __m256 one = _mm256_set1_ps(1.0f);
+        size_t i = 0;
+        for (; i + 8 <= count; i += 8) {
+            __m256 segment, local;
+            locate8(_mm256_loadu_ps(t + i), segmentTime, lastSegment, segment, local);
+            __m256i index = _mm256_cvttps_epi32(segment);
+            __m256i next = _mm256_add_epi32(index, _mm256_set1_epi32(1));
+
+            __m256 inverse = _mm256_sub_ps(one, local);
+            for (int axis = 0; axis < 3; axis++) {
+                __m256 r = _mm256_add_ps(_mm256_mul_ps(_mm256_i32gather_ps(p[axis], index, 4), inverse),
+                                         _mm256_mul_ps(_mm256_i32gather_ps(p[axis], next, 4), local));
+                _mm256_storeu_ps(out[axis] + i, r);
+            }
+        }
+        return i;
+    }
+
+    AVX2_TARGET size_t catmullRomAVX2(const Points& points, const float* t, float* const out[3], size_t count) {
+        const float* p[3] = {points.x, points.y, points.z};
+        int n = points.count - 1;
+        __m256 segmentTime = _mm256_set1_ps(1.0f / n);
+        __m256 lastSegment = _mm256_set1_ps(static_cast<float>(n - 1));
+        __m256i oneIndex = _mm256_set1_epi32(1);
+        size_t i = 0;
+        for (; i + 8 <= count; i += 8) {
+            __m256 segment, local;
+            locate8(_mm256_loadu_ps(t + i), segmentTime, lastSegment, segment, local);
+            __m256i i1 = _mm256_cvttps_epi32(segment);
+            __m256i i0 = _mm256_max_epi32(_mm256_sub_epi32(i1, oneIndex), _mm256_setzero_si256());
+            __m256i i2 = _mm256_add_epi32(i1, oneIndex);
+            __m256i i3 = _mm256_min_epi32(_mm256_add_epi32(i2, oneIndex), _mm256_set1_epi32(n));
+
+            __m256 t2 = _mm256_mul_ps(local, local);
+            __m256 t3 = _mm256_mul_ps(t2, local);
+            __m256 halfLocal = _mm256_mul_ps(_mm256_set1_ps(0.5f), local);
+            __m256 w0 = _mm256_sub_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(-0.5f), t3), t2), halfLocal);
+            __m256 w1 = _mm256_add_ps(_mm256_sub_ps(_mm256_mul_ps(_mm256_set1_ps(1.5f), t3),
+                                                    _mm256_mul_ps(_mm256_set1_ps(2.5f), t2)),
+                                      _mm256_set1_ps(1.0f));
+            __m256 w2 = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(-1.5f), t3),
+                                                    _mm256_mul_ps(_mm256_set1_ps(2.0f), t2)),
+                                      halfLocal);
+            __m256 w3 = _mm256_sub_ps(_mm256_mul_ps(_mm256_set1_ps(0.5f), t3), _mm256_mul_ps(_mm256_set1_ps(0.5f), t2));
+            for (int axis = 0; axis < 3; axis++) {
+                __m256 r = _mm256_add_ps(_mm256_mul_ps(w0, _mm256_i32gather_ps(p[axis], i0, 4)),
+                                         _mm256_mul_ps(w1, _mm256_i32gather_ps(p[axis], i1, 4)));
+                r = _mm256_add_ps(r, _mm256_mul_ps(w2, _mm256_i32gather_ps(p[axis], i2, 4)));
+                r = _mm256_add_ps(r, _mm256_mul_ps(w3, _mm256_i32gather_ps(p[axis], i3, 4)));
+                _mm256_storeu_ps(out[axis] + i, r);
+            }
+        }
+        return i;
+    }
+
+    bool cpuHasAVX2() {
+#if defined(_MSC_VER) && !defined(__clang__)
+        int info[4];
+        __cpuid(info, 1);
+        bool osSavesYmm = (info[2] & (1 << 27)) != 0 && (_xgetbv(0) & 0x6) == 0x6;
+        __cpuidex(info, 7, 0);
+        return osSavesYmm && (info[1] & (1 << 5)) != 0;
+#else
+        // Runs from a static initializer, possibly before the runtime has
+        // filled in the CPU model that __builtin_cpu_supports reads
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2");
+#endif
+    }
+#endif
+
+    Level detectBestLevel() {
+#ifdef CURVE_KERNELS_X86
+        return cpuHasAVX2() ? Level::AVX2 : Level::SSE;
+#else
+        return Level::SCALAR;
+#endif
+    }
+
+    const Level bestLevel = detectBestLevel();
+    Level currentLevel = bestLevel;
+}
+
+Level getBestLevel() {
+    return bestLevel;
+}
+
+Level getLevel() {
+    return currentLevel;
+}
+
+void setLevel(Level level) {
+    currentLevel = std::min(level, bestLevel);
+}
+
+const char* getLevelName(Level level) {
+    switch (level) {
+        case Level::AVX2: return "AVX2";
+        case Level::SSE: return "SSE";
+        default: return "scalar";
+    }
+}
+
+// Each level handles whole vectors and reports how far it got; the scalar
+// code finishes the tail
+
+void evaluateCubics(const Cubics& cubics, const int* segments, const float* u,
+                    float* x, float* y, float* z, size_t count) {
+    float* const out[3] = {x, y, z};
+    size_t done = 0;
+#ifdef CURVE_KERNELS_X86
+    if (currentLevel == Level::AVX2) {
+        done = cubicsAVX2(cubics, segments, u, out, count);
+    } else if (currentLevel == Level::SSE) {
+        done = cubicsSSE(cubics, segments, u, out, count);
+    }
+#endif
+    cubicsScalar(cubics, segments, u, out, done, count);
+}
+
+void evaluateLinear(const Points& points, const float* t, float* x, float* y, float* z, size_t count) {
+    float* const out[3] = {x, y, z};
+    size_t done = 0;
+#ifdef CURVE_KERNELS_X86
+    if (currentLevel == Level::AVX2) {
+        done = linearAVX2(points, t, out, count);
+    } else if (currentLevel == Level::SSE) {
+        done = linearSSE(points, t, out, count);
+    }
+#endif
+    linearScalar(points, t, out, done, count);
+}
+
+void evaluateCatmullRom(const Points& points, const float* t, float* x, float* y, float* z, size_t count) {
+    if (points.count < 4) {
+        evaluateLinear(points, t, x, y, z, count);
+        return;
+    }
+
+    float* const out[3] = {x, y, z};
+    size_t done = 0;
+#ifdef CURVE_KERNELS_X86
+    if (currentLevel == Level::AVX2) {
+        done = catmullRomAVX2(points, t, out, count);
+    } else if (currentLevel == Level::SSE) {
+        done = catmullRomSSE(points, t, out, count);
+    }
+#endif
+    catmullRomScalar(points, t, out, done, count);
+}
+
+}
@@ -0,0 +1,47 @@
+#ifndef CURVE_KERNELS_H
+#define CURVE_KERNELS_H
+
+#include <cstddef>
+
+// Batch curve evaluation over structure-of-arrays buffers, in SSE and AVX2
+// with a scalar fallback. The widest level the CPU supports is picked at run
+// time. Every level does the same float operations in the same order as the
+// scalar code, so results match it bit for bit (unless the compiler is told
+// to fuse multiply-adds in the scalar build).
+namespace CurveKernels {
+    enum class Level {
+        SCALAR,
+        SSE,
+        AVX2
+    };
+
+    Level getBestLevel();
+    Level getLevel();
+    // Clamped to what the CPU supports; mainly for validating against SCALAR
+    void setLevel(Level level);
+    const char* getLevelName(Level level);
+
+    // Cubic segments, p(u) = ((c3 u + c2) u + c1) u + c0: coefficients[axis][power][segment]
+    struct Cubics {
+        const float* coefficients[3][4];
+    };
+
+    // Control points of one path, one array per axis
+    struct Points {
+        const float* x;
+        const float* y;
+        const float* z;
+        int count;
+    };
+
+    // Many paths at once: output i is segment segments[i] at u[i]
+    void evaluateCubics(const Cubics& cubics, const int* segments, const float* u,
+                        float* x, float* y, float* z, size_t count);
+
+    // Many t in [0, 1] on one path, as Trajectory's LINEAR and SPLINE
+    // (Catmull-Rom, linear below four points) interpolation. Needs 2+ points.
+    void evaluateLinear(const Points& points, const float* t, float* x, float* y, float* z, size_t count);
+    void evaluateCatmullRom(const Points& points, const float* t, float* x, float* y, float* z, size_t count);
+}
+
+#endif
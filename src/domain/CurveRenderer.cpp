@@ -0,0 +1,163 @@
+#include "CurveRenderer.hpp"
+#include "GLState.hpp"
+#include "Frustum.hpp"
+
+CurveRenderer::CurveRenderer()
+    : shader("src/shaders/curve.vert", "src/shaders/curve.frag")
+    , vao(0)
+    , vbo(0)
+    , tolerance(DEFAULT_TOLERANCE)
+    , uploadPending(false)
+    , vertexCount(0)
+    , drawnCount(0)
+    , tessellations(0) {
+    glGenVertexArrays(1, &vao);
+    glGenBuffers(1, &vbo);
+
+    GLState::bindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    GLState::bindVertexArray(0);
+}
+
+CurveRenderer::~CurveRenderer() {
+    GLState::deleteVertexArray(vao);
+    glDeleteBuffers(1, &vbo);
+    GLState::deleteProgram(shader.ID);
+}
+
+void CurveRenderer::setTolerance(float newTolerance) {
+    if (newTolerance > 0.0f) {
+        tolerance = newTolerance;
+    }
+}
+
+void CurveRenderer::update(int key, const Trajectory& trajectory) {
+    Path& path = paths[key];
+    if (path.tolerance == tolerance && path.type == trajectory.getInterpolationType() &&
+        path.controlPoints == trajectory.getControlPoints()) {
+        return;
+    }
+
+    path.controlPoints = trajectory.getControlPoints();
+    path.type = trajectory.getInterpolationType();
+    path.tolerance = tolerance;
+    tessellate(trajectory, path);
+    tessellations++;
+    uploadPending = true;
+}
+
+void CurveRenderer::remove(int key) {
+    if (paths.erase(key) > 0) {
+        uploadPending = true;
+    }
+}
+
+void CurveRenderer::clear() {
+    paths.clear();
+    uploadPending = true;
+}
+
+void CurveRenderer::tessellate(const Trajectory& trajectory, Path& path) const {
+    path.vertices.clear();
+    size_t pointCount = path.controlPoints.size();
+    if (pointCount < 2) return;
+
+    // Control points are where linear paths bend, so every span starts at one
+    glm::vec3 previous = trajectory.getPosition(0.0f);
+    path.vertices.push_back(previous);
+    for (size_t k = 1; k < pointCount; k++) {
+        float t0 = static_cast<float>(k - 1) / (pointCount - 1);
+        float t1 = static_cast<float>(k) / (pointCount - 1);
+        glm::vec3 next = trajectory.getPosition(t1);
+        subdivide(trajectory, t0, previous, t1, next, 0, path.vertices);
+        previous = next;
+    }
+
+    std::vector<glm::vec3> extent = path.vertices;
+    extent.insert(extent.end(), path.controlPoints.begin(), path.controlPoints.end());
+    path.bounds = AABB::fromPoints(extent);
+}
+
+// Appends the curve from p0 (already emitted) to p1
+void CurveRenderer::subdivide(const Trajectory& trajectory, float t0, const glm::vec3& p0, float t1,
+                              const glm::vec3& p1, int depth, std::vector<glm::vec3>& vertices) const {
+    if (depth < MAX_SUBDIVISIONS) {
+        for (float u : {0.25f, 0.5f, 0.75f}) {
+            glm::vec3 exact = trajectory.getPosition(t0 + u * (t1 - t0));
+            if (glm::length(glm::mix(p0, p1, u) - exact) > tolerance) {
+                float middle = 0.5f * (t0 + t1);
+                glm::vec3 pm = trajectory.getPosition(middle);
+                subdivide(trajectory, t0, p0, middle, pm, depth + 1, vertices);
+                subdivide(trajectory, middle, pm, t1, p1, depth + 1, vertices);
+                return;
+            }
+        }
+    }
+    vertices.push_back(p1);
+}
+
+// Lines of every path first, then every path's markers
+void CurveRenderer::upload() {
+    std::vector<glm::vec3> data;
+    for (auto& entry : paths) {
+        Path& path = entry.second;
+        path.first = static_cast<GLint>(data.size());
+        data.insert(data.end(), path.vertices.begin(), path.vertices.end());
+    }
+    for (auto& entry : paths) {
+        Path& path = entry.second;
+        path.markerFirst = static_cast<GLint>(data.size());
+        if (!path.vertices.empty()) {
+            data.insert(data.end(), path.controlPoints.begin(), path.controlPoints.end());
+        }
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBufferData(GL_ARRAY_BUFFER, data.size() * sizeof(glm::vec3), data.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    vertexCount = data.size();
+    uploadPending = false;
+}
+
+void CurveRenderer::draw(const glm::mat4& view, const glm::mat4& projection, const glm::vec4& lineColor,
+                         const glm::vec4& markerColor) {
+    if (uploadPending) {
+        upload();
+    }
+
+    glm::mat4 viewProjection = projection * view;
+    Frustum frustum(viewProjection);
+    firsts.clear();
+    counts.clear();
+    markerFirsts.clear();
+    markerCounts.clear();
+    for (const auto& entry : paths) {
+        const Path& path = entry.second;
+        if (path.vertices.empty() || !frustum.intersects(path.bounds)) continue;
+        firsts.push_back(path.first);
+        counts.push_back(static_cast<GLsizei>(path.vertices.size()));
+        markerFirsts.push_back(path.markerFirst);
+        markerCounts.push_back(static_cast<GLsizei>(path.controlPoints.size()));
+    }
+    drawnCount = firsts.size();
+    if (firsts.empty()) return;
+
+    shader.use();
+    shader.setMat4("viewProjection", viewProjection);
+    GLState::bindVertexArray(vao);
+    GLState::setBlend(false);
+    GLState::setDepthTest(true);
+    GLState::setDepthMask(true);
+    GLState::setDepthFunc(GL_LEQUAL);
+
+    shader.setVec4("color", lineColor);
+    glMultiDrawArrays(GL_LINE_STRIP, firsts.data(), counts.data(), static_cast<GLsizei>(firsts.size()));
+
+    glPointSize(MARKER_SIZE);
+    shader.setVec4("color", markerColor);
+    glMultiDrawArrays(GL_POINTS, markerFirsts.data(), markerCounts.data(), static_cast<GLsizei>(markerFirsts.size()));
+    glPointSize(1.0f);
+}
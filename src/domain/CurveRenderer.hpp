@@ -0,0 +1,86 @@
+#ifndef CURVE_RENDERER_H
+#define CURVE_RENDERER_H
+
+#include "glad/glad.h"
+#include "Bounds.hpp"
+#include "Shader.hpp"
+#include "Trajectory.hpp"
+#include <glm/glm.hpp>
+#include <map>
+#include <vector>
+
+// Trajectories drawn as polylines, to see the paths objects will follow.
+// Each trajectory is tessellated adaptively: the span between consecutive
+// control points is halved until the curve stays within the tolerance of the
+// line drawn for it. The result is cached and only redone when the control
+// points, the interpolation type or the tolerance change. All paths share one
+// vertex buffer, followed by their control points, and the paths inside the
+// frustum go out as one glMultiDrawArrays of line strips plus one of points
+// for the control point markers.
+class CurveRenderer {
+public:
+    static constexpr float DEFAULT_TOLERANCE = 0.01f;
+
+    CurveRenderer();
+    ~CurveRenderer();
+
+    CurveRenderer(const CurveRenderer&) = delete;
+    CurveRenderer& operator=(const CurveRenderer&) = delete;
+
+    // Largest distance in world units between a drawn path and its curve
+    void setTolerance(float tolerance);
+    float getTolerance() const { return tolerance; }
+
+    // Keys are the caller's; cheap when nothing changed, so it can run every
+    // frame. A trajectory with fewer than two points draws nothing.
+    void update(int key, const Trajectory& trajectory);
+    void remove(int key);
+    void clear();
+
+    void draw(const glm::mat4& view, const glm::mat4& projection, const glm::vec4& lineColor,
+              const glm::vec4& markerColor);
+
+    size_t getPathCount() const { return paths.size(); }
+    size_t getVertexCount() const { return vertexCount; }
+    size_t getDrawnCount() const { return drawnCount; }
+    unsigned long getTessellationCount() const { return tessellations; }
+
+private:
+    static const int MAX_SUBDIVISIONS = 10;
+    static constexpr float MARKER_SIZE = 6.0f;
+
+    struct Path {
+        // What the tessellation was made from
+        std::vector<glm::vec3> controlPoints;
+        InterpolationType type = InterpolationType::LINEAR;
+        float tolerance = 0.0f;
+
+        std::vector<glm::vec3> vertices;
+        AABB bounds;
+        GLint first = 0;            // in the vertex buffer, after upload
+        GLint markerFirst = 0;
+    };
+
+    Shader shader;
+    GLuint vao;
+    GLuint vbo;
+
+    float tolerance;
+    std::map<int, Path> paths;
+    bool uploadPending;
+    size_t vertexCount;
+    size_t drawnCount;
+    unsigned long tessellations;
+
+    std::vector<GLint> firsts;
+    std::vector<GLsizei> counts;
+    std::vector<GLint> markerFirsts;
+    std::vector<GLsizei> markerCounts;
+
+    void tessellate(const Trajectory& trajectory, Path& path) const;
+    void subdivide(const Trajectory& trajectory, float t0, const glm::vec3& p0, float t1, const glm::vec3& p1,
+                   int depth, std::vector<glm::vec3>& vertices) const;
+    void upload();
+};
+
+#endif
@@ -0,0 +1,249 @@
+#include "DeferredRenderer.hpp"
+#include "GLState.hpp"
+#include "Logger.hpp"
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+namespace {
+    // Icosahedron subdivided twice; 320 faces is plenty for a light volume
+    std::vector<glm::vec3> buildSphere(int subdivisions) {
+        const float t = (1.0f + std::sqrt(5.0f)) / 2.0f;
+        const glm::vec3 corners[12] = {
+            {-1, t, 0}, {1, t, 0}, {-1, -t, 0}, {1, -t, 0},
+            {0, -1, t}, {0, 1, t}, {0, -1, -t}, {0, 1, -t},
+            {t, 0, -1}, {t, 0, 1}, {-t, 0, -1}, {-t, 0, 1},
+        };
+        const int faces[20][3] = {
+            {0, 11, 5}, {0, 5, 1}, {0, 1, 7}, {0, 7, 10}, {0, 10, 11},
+            {1, 5, 9}, {5, 11, 4}, {11, 10, 2}, {10, 7, 6}, {7, 1, 8},
+            {3, 9, 4}, {3, 4, 2}, {3, 2, 6}, {3, 6, 8}, {3, 8, 9},
+            {4, 9, 5}, {2, 4, 11}, {6, 2, 10}, {8, 6, 7}, {9, 8, 1},
+        };
+
+        std::vector<glm::vec3> triangles;
+        for (const auto& face : faces) {
+            for (int corner : face) {
+                triangles.push_back(glm::normalize(corners[corner]));
+            }
+        }
+
+        for (int level = 0; level < subdivisions; level++) {
+            std::vector<glm::vec3> finer;
+            for (size_t i = 0; i < triangles.size(); i += 3) {
+                glm::vec3 a = triangles[i], b = triangles[i + 1], c = triangles[i + 2];
+                glm::vec3 ab = glm::normalize(a + b), bc = glm::normalize(b + c), ca = glm::normalize(c + a);
+                for (const glm::vec3& v : {a, ab, ca, ab, b, bc, ca, bc, c, ab, bc, ca}) {
+                    finer.push_back(v);
+                }
+            }
+            triangles.swap(finer);
+        }
+
+        // Vertices sit on the unit sphere, so the flat faces cut inside it.
+        // Push them out until the closest face plane touches the sphere.
+        float inradius = 1.0f;
+        for (size_t i = 0; i < triangles.size(); i += 3) {
+            glm::vec3 n = glm::normalize(glm::cross(triangles[i + 1] - triangles[i], triangles[i + 2] - triangles[i]));
+            inradius = std::min(inradius, std::abs(glm::dot(n, triangles[i])));
+        }
+        for (glm::vec3& v : triangles) {
+            v /= inradius;
+        }
+        return triangles;
+    }
+}
+
+DeferredRenderer::DeferredRenderer()
+    : width(0)
+    , height(0)
+    , framebuffer(0)
+    , albedo(0)
+    , normal(0)
+    , material(0)
+    , depth(0)
+    , ambientShader("src/shaders/deferred_ambient.vert", "src/shaders/deferred_ambient.frag")
+    , lightShader("src/shaders/deferred_light.vert", "src/shaders/deferred_light.frag")
+    , emptyVAO(0)
+    , sphereVAO(0)
+    , sphereVBO(0)
+    , instanceVBO(0)
+    , sphereVertexCount(0)
+    , lightVolumes(0) {
+    glGenVertexArrays(1, &emptyVAO);
+    createSphere();
+}
+
+DeferredRenderer::~DeferredRenderer() {
+    destroyTargets();
+    GLState::deleteVertexArray(emptyVAO);
+    GLState::deleteVertexArray(sphereVAO);
+    if (sphereVBO != 0) glDeleteBuffers(1, &sphereVBO);
+    if (instanceVBO != 0) glDeleteBuffers(1, &instanceVBO);
+    GLState::deleteProgram(ambientShader.ID);
+    GLState::deleteProgram(lightShader.ID);
+}
+
+void DeferredRenderer::createSphere() {
+    std::vector<glm::vec3> vertices = buildSphere(2);
+    sphereVertexCount = static_cast<GLsizei>(vertices.size());
+
+    glGenVertexArrays(1, &sphereVAO);
+    GLState::bindVertexArray(sphereVAO);
+
+    glGenBuffers(1, &sphereVBO);
+    glBindBuffer(GL_ARRAY_BUFFER, sphereVBO);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(glm::vec3), vertices.data(), GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)0);
+    glEnableVertexAttribArray(0);
+
+    glGenBuffers(1, &instanceVBO);
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(LightInstance), (void*)offsetof(LightInstance, positionRadius));
+    glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(LightInstance), (void*)offsetof(LightInstance, colorShadow));
+    for (GLuint location = 1; location <= 2; location++) {
+        glEnableVertexAttribArray(location);
+        glVertexAttribDivisor(location, 1);
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    GLState::bindVertexArray(0);
+}
+
+void DeferredRenderer::createTargets() {
+    auto createTarget = [&](GLenum internalFormat, GLenum format, GLenum type) {
+        GLuint texture;
+        glGenTextures(1, &texture);
+        GLState::bindTexture(0, GL_TEXTURE_2D, texture);
+        glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, type, nullptr);
+        // Only ever read with texelFetch, but a mipmapped filter would leave it incomplete
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        return texture;
+    };
+
+    albedo = createTarget(GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE);
+    normal = createTarget(GL_RGBA16F, GL_RGBA, GL_FLOAT);
+    material = createTarget(GL_RGBA16F, GL_RGBA, GL_FLOAT);
+    // Same format as a typical default framebuffer so the depth blit is allowed
+    depth = createTarget(GL_DEPTH24_STENCIL8, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8);
+
+    glGenFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, albedo, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, normal, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT2, GL_TEXTURE_2D, material, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, depth, 0);
+
+    const GLenum drawBuffers[] = {GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2};
+    glDrawBuffers(3, drawBuffers);
+
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        LOG_ERROR("G-buffer framebuffer is incomplete");
+    }
+}
+
+void DeferredRenderer::destroyTargets() {
+    if (framebuffer != 0) glDeleteFramebuffers(1, &framebuffer);
+    GLState::deleteTexture(albedo);
+    GLState::deleteTexture(normal);
+    GLState::deleteTexture(material);
+    GLState::deleteTexture(depth);
+    framebuffer = albedo = normal = material = depth = 0;
+}
+
+void DeferredRenderer::beginGeometry(int newWidth, int newHeight) {
+    if (newWidth != width || newHeight != height) {
+        destroyTargets();
+        width = newWidth;
+        height = newHeight;
+        createTargets();
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    GLState::setColorMask(true);
+    GLState::setDepthMask(true);
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+}
+
+void DeferredRenderer::bindTargets(Shader& shader) {
+    GLState::bindTexture(0, GL_TEXTURE_2D, albedo);
+    GLState::bindTexture(1, GL_TEXTURE_2D, normal);
+    GLState::bindTexture(2, GL_TEXTURE_2D, material);
+    GLState::bindTexture(3, GL_TEXTURE_2D, depth);
+    shader.setInt("gAlbedo", 0);
+    shader.setInt("gNormal", 1);
+    shader.setInt("gMaterial", 2);
+    shader.setInt("gDepth", 3);
+}
+
+void DeferredRenderer::resolve(const glm::mat4& view, const glm::mat4& projection, const glm::vec3& viewPos,
+                               const glm::vec3& ambientColor, const glm::vec3& wireframeColor,
+                               const std::vector<LightClusters::PointLight>& lights, const ShadowCache& shadows) {
+    // Depth goes over first: the light volumes are tested against it
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+    glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    GLState::setPolygonMode(GL_FILL);
+    GLState::setColorMask(true);
+    GLState::setDepthMask(false);
+
+    // Ambient overwrites every covered pixel; the background keeps the clear colour
+    GLState::setDepthTest(false);
+    GLState::setBlend(false);
+    ambientShader.use();
+    bindTargets(ambientShader);
+    ambientShader.setVec3("lightColor", ambientColor);
+    ambientShader.setVec3("wireframeColor", wireframeColor);
+    GLState::bindVertexArray(emptyVAO);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+
+    instances.clear();
+    for (const auto& light : lights) {
+        instances.push_back({glm::vec4(light.position, light.radius),
+                             glm::vec4(light.color, static_cast<float>(light.shadowMap))});
+    }
+    lightVolumes = instances.size();
+
+    if (!instances.empty()) {
+        // Back faces that lie behind the stored depth cover exactly the pixels
+        // whose surface is in front of the sphere's far side. Culling front
+        // faces keeps that working with the camera inside a volume, and depth
+        // clamping keeps far sides beyond the far plane from being clipped.
+        GLState::setDepthTest(true);
+        GLState::setDepthFunc(GL_GEQUAL);
+        GLState::setBlend(true);
+        GLState::setBlendFunc(GL_ONE, GL_ONE);
+        GLState::setCullFace(true);
+        glCullFace(GL_FRONT);
+        GLState::setDepthClamp(true);
+
+        lightShader.use();
+        bindTargets(lightShader);
+        shadows.bind(lightShader);
+        lightShader.setMat4("view", view);
+        lightShader.setMat4("projection", projection);
+        lightShader.setMat4("inverseViewProjection", glm::inverse(projection * view));
+        lightShader.setVec3("viewPos", viewPos);
+
+        glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+        glBufferData(GL_ARRAY_BUFFER, instances.size() * sizeof(LightInstance), instances.data(), GL_STREAM_DRAW);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+        GLState::bindVertexArray(sphereVAO);
+        glDrawArraysInstanced(GL_TRIANGLES, 0, sphereVertexCount, static_cast<GLsizei>(instances.size()));
+
+        GLState::setDepthClamp(false);
+        glCullFace(GL_BACK);
+        GLState::setCullFace(false);
+    }
+
+    GLState::setDepthTest(true);
+    GLState::setDepthFunc(GL_LESS);
+    GLState::setDepthMask(true);
+    GLState::setBlend(false);
+}
@@ -0,0 +1,68 @@
+#ifndef DEFERRED_RENDERER_H
+#define DEFERRED_RENDERER_H
+
+#include "glad/glad.h"
+#include "LightClusters.hpp"
+#include "Shader.hpp"
+#include "ShadowCache.hpp"
+#include <glm/glm.hpp>
+#include <vector>
+
+// Deferred shading for scenes with many lights.
+// Meshes are drawn once into a G-buffer (albedo, normal, material, depth).
+// The default framebuffer then gets a full-screen ambient pass, and every
+// point light is drawn as an instanced sphere covering its radius, adding its
+// contribution only where a surface lies inside that sphere. Depth is copied
+// back afterwards so forward passes (impostors) still test against the scene.
+class DeferredRenderer {
+public:
+    DeferredRenderer();
+    ~DeferredRenderer();
+
+    DeferredRenderer(const DeferredRenderer&) = delete;
+    DeferredRenderer& operator=(const DeferredRenderer&) = delete;
+
+    // Binds the G-buffer, resizing it if needed, and clears it. Meshes are
+    // then drawn with scene_gbuffer.frag as the fragment shader.
+    void beginGeometry(int width, int height);
+
+    // Lights the G-buffer into the default framebuffer and copies its depth over
+    void resolve(const glm::mat4& view, const glm::mat4& projection, const glm::vec3& viewPos,
+                 const glm::vec3& ambientColor, const glm::vec3& wireframeColor,
+                 const std::vector<LightClusters::PointLight>& lights, const ShadowCache& shadows);
+
+    size_t getLightVolumeCount() const { return lightVolumes; }
+
+private:
+    // Per-instance attributes, locations 1-2 in deferred_light.vert
+    struct LightInstance {
+        glm::vec4 positionRadius;
+        glm::vec4 colorShadow;
+    };
+
+    int width;
+    int height;
+    GLuint framebuffer;
+    GLuint albedo;
+    GLuint normal;
+    GLuint material;
+    GLuint depth;
+
+    Shader ambientShader;
+    Shader lightShader;
+    GLuint emptyVAO;
+    GLuint sphereVAO;
+    GLuint sphereVBO;
+    GLuint instanceVBO;
+    GLsizei sphereVertexCount;
+
+    std::vector<LightInstance> instances;
+    size_t lightVolumes;
+
+    void createTargets();
+    void destroyTargets();
+    void createSphere();
+    void bindTargets(Shader& shader);
+};
+
+#endif
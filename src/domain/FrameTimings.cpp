@@ -0,0 +1,129 @@
+#include "FrameTimings.hpp"
+#include "Logger.hpp"
+#include <algorithm>
+#include <iomanip>
+#include <numeric>
+#include <sstream>
+
+namespace {
+    // Value below which the given fraction of sorted times fall
+    double percentile(const std::vector<double>& sorted, double fraction) {
+        size_t index = static_cast<size_t>(fraction * (sorted.size() - 1) + 0.5);
+        return sorted[std::min(index, sorted.size() - 1)];
+    }
+
+    std::string summarize(std::vector<double> times) {
+        std::sort(times.begin(), times.end());
+        double average = std::accumulate(times.begin(), times.end(), 0.0) / times.size();
+        std::ostringstream summary;
+        summary << std::fixed << std::setprecision(3) << "avg " << average << " ms, p50 " << percentile(times, 0.5)
+                << ", p95 " << percentile(times, 0.95) << ", p99 " << percentile(times, 0.99) << ", max "
+                << times.back();
+        return summary.str();
+    }
+}
+
+FrameTimings::FrameTimings()
+    : queries{}
+    , frame(0) {
+}
+
+FrameTimings::~FrameTimings() {
+    close();
+}
+
+bool FrameTimings::open(const std::string& filename, const std::vector<std::string>& counters) {
+    close();
+    file.open(filename);
+    if (!file.is_open()) {
+        LOG_ERROR("Could not write frame timings: " << filename);
+        return false;
+    }
+
+    file << "frame,delta_ms,cpu_ms,gpu_ms";
+    for (const auto& name : counters) {
+        file << "," << name;
+    }
+    file << "\n" << std::fixed << std::setprecision(4);
+
+    glGenQueries(LATENCY, queries);
+    path = filename;
+    frame = 0;
+    cpuTimes.clear();
+    gpuTimes.clear();
+    return true;
+}
+
+void FrameTimings::close() {
+    if (!file.is_open()) return;
+
+    // The last frames' queries are done or close to it
+    while (!pending.empty()) {
+        writeRow(true);
+    }
+    glDeleteQueries(LATENCY, queries);
+    file.close();
+
+    if (!cpuTimes.empty()) {
+        LOG_INFO("Frame timings: " << cpuTimes.size() << " frames written to " << path);
+        LOG_INFO("  CPU " << summarize(cpuTimes));
+    }
+    if (!gpuTimes.empty()) {
+        LOG_INFO("  GPU " << summarize(gpuTimes));
+    }
+}
+
+void FrameTimings::beginFrame() {
+    if (!file.is_open()) return;
+
+    // Only waits when the GPU has fallen LATENCY frames behind
+    if (pending.size() == LATENCY) {
+        writeRow(true);
+    }
+    glBeginQuery(GL_TIME_ELAPSED, queries[frame % LATENCY]);
+    frameStart = std::chrono::steady_clock::now();
+}
+
+void FrameTimings::endFrame(float deltaTime, const std::vector<unsigned long>& counters) {
+    if (!file.is_open()) return;
+
+    glEndQuery(GL_TIME_ELAPSED);
+    double cpuMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - frameStart).count();
+    pending.push_back({frame, deltaTime, cpuMs, counters, queries[frame % LATENCY], frameStart});
+    frame++;
+
+    while (!pending.empty() && writeRow(false)) {
+    }
+}
+
+bool FrameTimings::writeRow(bool wait) {
+    const Row& row = pending.front();
+    if (!wait) {
+        GLuint available = GL_FALSE;
+        glGetQueryObjectuiv(row.query, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (available == GL_FALSE) return false;
+    }
+
+    GLuint64 nanoseconds = 0;
+    glGetQueryObjectui64v(row.query, GL_QUERY_RESULT, &nanoseconds);
+    double gpuMs = nanoseconds * 1e-6;
+
+    // More GPU time than has passed since the frame began is a driver error
+    // (llvmpipe reports a raw timestamp for a context's first drawing), left blank
+    double sinceStart = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - row.start).count();
+    bool valid = gpuMs <= sinceStart;
+
+    file << row.frame << "," << row.deltaTime * 1000.0f << "," << row.cpuMs << ",";
+    if (valid) {
+        file << gpuMs;
+        gpuTimes.push_back(gpuMs);
+    }
+    for (unsigned long value : row.counters) {
+        file << "," << value;
+    }
+    file << "\n";
+
+    cpuTimes.push_back(row.cpuMs);
+    pending.pop_front();
+    return true;
+}
@@ -0,0 +1,60 @@
+#ifndef FRAME_TIMINGS_H
+#define FRAME_TIMINGS_H
+
+#include "glad/glad.h"
+#include <chrono>
+#include <deque>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// Per-frame timings written to a CSV file, for comparing builds on the same
+// input replay. A row holds the frame's deltaTime, its CPU time (beginFrame to
+// endFrame), its GPU time from a GL_TIME_ELAPSED query and whatever counters
+// the viewer adds. Query results are read a few frames late so the CPU never
+// waits on them; rows are written in order as their GPU time comes in, with
+// the GPU column left blank when a driver reports an impossible time.
+// close() logs the average and percentiles of both times.
+class FrameTimings {
+public:
+    FrameTimings();
+    ~FrameTimings();
+
+    FrameTimings(const FrameTimings&) = delete;
+    FrameTimings& operator=(const FrameTimings&) = delete;
+
+    // counters names the extra columns endFrame() fills in
+    bool open(const std::string& filename, const std::vector<std::string>& counters = {});
+    void close();
+    bool isOpen() const { return file.is_open(); }
+
+    void beginFrame();
+    void endFrame(float deltaTime, const std::vector<unsigned long>& counters = {});
+
+private:
+    static const int LATENCY = 4;
+
+    struct Row {
+        unsigned long frame;
+        float deltaTime;
+        double cpuMs;
+        std::vector<unsigned long> counters;
+        GLuint query;
+        std::chrono::steady_clock::time_point start;
+    };
+
+    std::ofstream file;
+    std::string path;
+    GLuint queries[LATENCY];
+    std::deque<Row> pending;
+    unsigned long frame;
+    std::chrono::steady_clock::time_point frameStart;
+
+    std::vector<double> cpuTimes;
+    std::vector<double> gpuTimes;
+
+    // Writes the oldest pending row; without wait, only if its query is done
+    bool writeRow(bool wait);
+};
+
+#endif
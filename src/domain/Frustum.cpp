@@ -0,0 +1,81 @@
+#include "Frustum.hpp"
+
+Frustum::Frustum() {
+    update(glm::mat4(1.0f));
+}
+
+Frustum::Frustum(const glm::mat4& viewProjection) {
+    update(viewProjection);
+}
+
+void Frustum::update(const glm::mat4& m) {
+    // glm is column-major, so row i is (m[0][i], m[1][i], m[2][i], m[3][i])
+    glm::vec4 row0(m[0][0], m[1][0], m[2][0], m[3][0]);
+    glm::vec4 row1(m[0][1], m[1][1], m[2][1], m[3][1]);
+    glm::vec4 row2(m[0][2], m[1][2], m[2][2], m[3][2]);
+    glm::vec4 row3(m[0][3], m[1][3], m[2][3], m[3][3]);
+
+    planes[LEFT] = row3 + row0;
+    planes[RIGHT] = row3 - row0;
+    planes[BOTTOM] = row3 + row1;
+    planes[TOP] = row3 - row1;
+    planes[NEAR_PLANE] = row3 + row2;
+    planes[FAR_PLANE] = row3 - row2;
+
+    for (int i = 0; i < PLANE_COUNT; i++) {
+        float length = glm::length(glm::vec3(planes[i]));
+        if (length > 0.0f) planes[i] /= length;
+        absNormals[i] = glm::abs(glm::vec3(planes[i]));
+    }
+}
+
+// Boxes are tested in centre/extents form: the projected radius of the box onto
+// a plane normal is dot(|n|, extents), so one dot product per side decides it.
+bool Frustum::intersects(const AABB& box) const {
+    glm::vec3 center = box.center();
+    glm::vec3 extents = box.extents();
+    for (int i = 0; i < PLANE_COUNT; i++) {
+        float distance = glm::dot(glm::vec3(planes[i]), center) + planes[i].w;
+        if (distance < -glm::dot(absNormals[i], extents)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+Frustum::Containment Frustum::classify(const AABB& box) const {
+    unsigned int planeMask = ALL_PLANES;
+    return classify(box, planeMask);
+}
+
+Frustum::Containment Frustum::classify(const AABB& box, unsigned int& planeMask) const {
+    if (planeMask == 0) return INSIDE;
+
+    glm::vec3 center = box.center();
+    glm::vec3 extents = box.extents();
+    Containment result = INSIDE;
+    for (int i = 0; i < PLANE_COUNT; i++) {
+        if ((planeMask & (1u << i)) == 0) continue;
+
+        float distance = glm::dot(glm::vec3(planes[i]), center) + planes[i].w;
+        float radius = glm::dot(absNormals[i], extents);
+        if (distance < -radius) {
+            return OUTSIDE;
+        }
+        if (distance < radius) {
+            result = INTERSECTING;
+        } else {
+            planeMask &= ~(1u << i);
+        }
+    }
+    return result;
+}
+
+bool Frustum::intersects(const BoundingSphere& sphere) const {
+    for (const auto& plane : planes) {
+        if (glm::dot(glm::vec3(plane), sphere.center) + plane.w < -sphere.radius) {
+            return false;
+        }
+    }
+    return true;
+}
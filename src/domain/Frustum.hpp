@@ -0,0 +1,37 @@
+#ifndef FRUSTUM_H
+#define FRUSTUM_H
+
+#include "Bounds.hpp"
+#include <glm/glm.hpp>
+
+// Six clip planes pulled out of a view-projection matrix (Gribb/Hartmann).
+// Plane normals point inwards, so a positive distance means inside.
+class Frustum {
+public:
+    Frustum();
+    explicit Frustum(const glm::mat4& viewProjection);
+
+    void update(const glm::mat4& viewProjection);
+
+    enum Containment { OUTSIDE, INTERSECTING, INSIDE };
+
+    bool intersects(const AABB& box) const;
+    Containment classify(const AABB& box) const;
+
+    // Hierarchical variant: only planes set in planeMask are tested, and planes
+    // the box is fully inside of are cleared so children can skip them
+    Containment classify(const AABB& box, unsigned int& planeMask) const;
+
+    static const unsigned int ALL_PLANES = 0x3F;
+    bool intersects(const BoundingSphere& sphere) const;
+
+    // The six normalized planes, e.g. for uploading to a culling shader
+    const glm::vec4* getPlanes() const { return planes; }
+
+private:
+    enum { LEFT, RIGHT, BOTTOM, TOP, NEAR_PLANE, FAR_PLANE, PLANE_COUNT };
+    glm::vec4 planes[PLANE_COUNT];
+    glm::vec3 absNormals[PLANE_COUNT];
+};
+
+#endif
@@ -0,0 +1,191 @@
+#include "GLState.hpp"
+#include <algorithm>
+#include <iterator>
+
+namespace {
+    const GLuint UNKNOWN = ~0u;
+
+    int targetSlot(GLenum target) {
+        switch (target) {
+            case GL_TEXTURE_2D: return 0;
+            case GL_TEXTURE_CUBE_MAP: return 1;
+            case GL_TEXTURE_BUFFER: return 2;
+            default: return -1;
+        }
+    }
+}
+
+GLState::Stats GLState::current;
+GLState::Stats GLState::lastFrame;
+
+GLuint GLState::program = UNKNOWN;
+GLuint GLState::vao = UNKNOWN;
+GLuint GLState::activeUnit = UNKNOWN;
+GLuint GLState::textures[GLState::MAX_TEXTURE_UNITS][3] = {};  // a fresh context has nothing bound
+GLenum GLState::polygonMode = GL_NONE;
+GLenum GLState::depthFunc = GL_NONE;
+GLenum GLState::blendSrc = GL_NONE;
+GLenum GLState::blendDst = GL_NONE;
+int GLState::depthTest = -1;
+int GLState::depthMask = -1;
+int GLState::colorMask = -1;
+int GLState::blend = -1;
+int GLState::cullFace = -1;
+int GLState::depthClamp = -1;
+
+bool GLState::changed(bool differs) {
+    if (differs) {
+        current.issued++;
+        return true;
+    }
+    current.elided++;
+    return false;
+}
+
+void GLState::invalidate() {
+    program = UNKNOWN;
+    vao = UNKNOWN;
+    activeUnit = UNKNOWN;
+    for (auto& unit : textures) {
+        std::fill(std::begin(unit), std::end(unit), UNKNOWN);
+    }
+    polygonMode = GL_NONE;
+    depthFunc = GL_NONE;
+    blendSrc = GL_NONE;
+    blendDst = GL_NONE;
+    depthTest = -1;
+    depthMask = -1;
+    colorMask = -1;
+    blend = -1;
+    cullFace = -1;
+    depthClamp = -1;
+}
+
+void GLState::beginFrame() {
+    lastFrame = current;
+    current = Stats();
+}
+
+void GLState::useProgram(GLuint newProgram) {
+    if (changed(program != newProgram)) {
+        glUseProgram(newProgram);
+        program = newProgram;
+    }
+}
+
+void GLState::bindVertexArray(GLuint newVao) {
+    if (changed(vao != newVao)) {
+        glBindVertexArray(newVao);
+        vao = newVao;
+    }
+}
+
+void GLState::setActiveUnit(GLuint unit) {
+    if (changed(activeUnit != unit)) {
+        glActiveTexture(GL_TEXTURE0 + unit);
+        activeUnit = unit;
+    }
+}
+
+void GLState::bindTexture(GLuint unit, GLenum target, GLuint texture) {
+    int slot = targetSlot(target);
+    if (slot < 0 || unit >= MAX_TEXTURE_UNITS) {
+        setActiveUnit(unit);
+        current.issued++;
+        glBindTexture(target, texture);
+        return;
+    }
+
+    if (textures[unit][slot] == texture) {
+        current.elided++;
+        return;
+    }
+
+    setActiveUnit(unit);
+    current.issued++;
+    glBindTexture(target, texture);
+    textures[unit][slot] = texture;
+}
+
+void GLState::setPolygonMode(GLenum mode) {
+    if (changed(polygonMode != mode)) {
+        glPolygonMode(GL_FRONT_AND_BACK, mode);
+        polygonMode = mode;
+    }
+}
+
+void GLState::setCapability(GLenum cap, bool enabled, int& cached) {
+    if (changed(cached != (enabled ? 1 : 0))) {
+        if (enabled) glEnable(cap);
+        else glDisable(cap);
+        cached = enabled ? 1 : 0;
+    }
+}
+
+void GLState::setDepthTest(bool enabled) {
+    setCapability(GL_DEPTH_TEST, enabled, depthTest);
+}
+
+void GLState::setBlend(bool enabled) {
+    setCapability(GL_BLEND, enabled, blend);
+}
+
+void GLState::setCullFace(bool enabled) {
+    setCapability(GL_CULL_FACE, enabled, cullFace);
+}
+
+void GLState::setDepthClamp(bool enabled) {
+    setCapability(GL_DEPTH_CLAMP, enabled, depthClamp);
+}
+
+void GLState::setDepthFunc(GLenum func) {
+    if (changed(depthFunc != func)) {
+        glDepthFunc(func);
+        depthFunc = func;
+    }
+}
+
+void GLState::setDepthMask(bool enabled) {
+    if (changed(depthMask != (enabled ? 1 : 0))) {
+        glDepthMask(enabled ? GL_TRUE : GL_FALSE);
+        depthMask = enabled ? 1 : 0;
+    }
+}
+
+void GLState::setColorMask(bool enabled) {
+    if (changed(colorMask != (enabled ? 1 : 0))) {
+        GLboolean mask = enabled ? GL_TRUE : GL_FALSE;
+        glColorMask(mask, mask, mask, mask);
+        colorMask = enabled ? 1 : 0;
+    }
+}
+
+void GLState::setBlendFunc(GLenum src, GLenum dst) {
+    if (changed(blendSrc != src || blendDst != dst)) {
+        glBlendFunc(src, dst);
+        blendSrc = src;
+        blendDst = dst;
+    }
+}
+
+void GLState::deleteProgram(GLuint id) {
+    if (id == 0) return;
+    // Unlike VAOs and textures, a deleted program stays bound while it is
+    // current, so unbind it for real before the cache says 0
+    if (program == id) useProgram(0);
+    glDeleteProgram(id);
+}
+
+void GLState::deleteVertexArray(GLuint id) {
+    if (id == 0) return;
+    glDeleteVertexArrays(1, &id);
+    if (vao == id) vao = 0;
+}
+
+void GLState::deleteTexture(GLuint id) {
+    if (id == 0) return;
+    glDeleteTextures(1, &id);
+    for (auto& unit : textures) {
+        std::replace(std::begin(unit), std::end(unit), id, 0u);
+    }
+}
@@ -0,0 +1,68 @@
+#ifndef GL_STATE_H
+#define GL_STATE_H
+
+#include "glad/glad.h"
+
+// Thin shadow of the GL state the domain classes touch. Every setter compares
+// against the cached value and only reaches the driver when something changes.
+// Code that changes this state behind GLState's back must call invalidate().
+class GLState {
+public:
+    struct Stats {
+        unsigned int issued = 0;
+        unsigned int elided = 0;
+    };
+
+    static const int MAX_TEXTURE_UNITS = 16;
+
+    static void useProgram(GLuint program);
+    static void bindVertexArray(GLuint vao);
+    static void bindTexture(GLuint unit, GLenum target, GLuint texture);
+
+    static void setPolygonMode(GLenum mode);
+    static void setDepthTest(bool enabled);
+    static void setDepthFunc(GLenum func);
+    static void setDepthMask(bool enabled);
+    static void setColorMask(bool enabled);
+    static void setBlend(bool enabled);
+    static void setBlendFunc(GLenum src, GLenum dst);
+    static void setCullFace(bool enabled);
+    static void setDepthClamp(bool enabled);
+
+    static void deleteProgram(GLuint program);
+    static void deleteVertexArray(GLuint vao);
+    static void deleteTexture(GLuint texture);
+
+    static void invalidate();
+
+    // Starts a new frame: the running counters become the last frame's stats
+    static void beginFrame();
+    static Stats getFrameStats() { return lastFrame; }
+
+private:
+    static Stats current;
+    static Stats lastFrame;
+
+    // Unknown values use sentinels (~0u for names, GL_NONE for enums, -1 for
+    // flags) so the first request after invalidate() always reaches the driver.
+    static GLuint program;
+    static GLuint vao;
+    static GLuint activeUnit;
+    static GLuint textures[MAX_TEXTURE_UNITS][3];
+    static GLenum polygonMode;
+    static GLenum depthFunc;
+    static GLenum blendSrc;
+    static GLenum blendDst;
+    static int depthTest;
+    static int depthMask;
+    static int colorMask;
+    static int blend;
+    static int cullFace;
+    static int depthClamp;
+
+    static void setActiveUnit(GLuint unit);
+    static void setCapability(GLenum cap, bool enabled, int& cached);
+    static bool changed(bool differs);
+};
+
+#endif
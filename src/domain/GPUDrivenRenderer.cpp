@@ -0,0 +1,261 @@
+#include "GPUDrivenRenderer.hpp"
+#include "GLState.hpp"
+#include "Logger.hpp"
+#include <algorithm>
+
+namespace {
+    const GLuint OBJECT_BINDING = 0;
+    const GLuint MESH_BINDING = 1;
+    const GLuint COMMAND_BINDING = 2;
+    const GLuint COUNT_BINDING = 3;
+
+    const GLuint CULL_GROUP_SIZE = 64;
+}
+
+bool GPUDrivenRenderer::isSupported() {
+    return GLAD_GL_VERSION_4_3 != 0;
+}
+
+GPUDrivenRenderer::GPUDrivenRenderer()
+    : cullShader("src/shaders/cull.comp")
+    , vao(0)
+    , vertexBuffer(0)
+    , idBuffer(0)
+    , objectBuffer(0)
+    , meshBuffer(0)
+    , commandBuffer(0)
+    , countBuffer(0)
+    , dirtyBegin(0)
+    , dirtyEnd(0)
+    , verticesDirty(false)
+    , layoutDirty(false)
+    , objectCapacity(0)
+    , countBufferDraws(GLAD_GL_VERSION_4_6 != 0) {
+    glGenBuffers(1, &vertexBuffer);
+    glGenBuffers(1, &idBuffer);
+    glGenBuffers(1, &objectBuffer);
+    glGenBuffers(1, &meshBuffer);
+    glGenBuffers(1, &commandBuffer);
+    glGenBuffers(1, &countBuffer);
+
+    glGenVertexArrays(1, &vao);
+    GLState::bindVertexArray(vao);
+
+    glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(TextureVertex), (void*)0);
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(TextureVertex), (void*)offsetof(TextureVertex, normal));
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(TextureVertex), (void*)offsetof(TextureVertex, texCoord));
+
+    glBindBuffer(GL_ARRAY_BUFFER, idBuffer);
+    glEnableVertexAttribArray(3);
+    glVertexAttribIPointer(3, 1, GL_UNSIGNED_INT, sizeof(GLuint), (void*)0);
+    glVertexAttribDivisor(3, 1);
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    GLState::bindVertexArray(0);
+
+    LOG_INFO("GPU-driven renderer: draw count "
+             << (countBufferDraws ? "read from the GPU (GL 4.6)" : "bounded by zeroed commands"));
+}
+
+GPUDrivenRenderer::~GPUDrivenRenderer() {
+    GLState::deleteVertexArray(vao);
+    GLuint buffers[] = {vertexBuffer, idBuffer, objectBuffer, meshBuffer, commandBuffer, countBuffer};
+    glDeleteBuffers(6, buffers);
+    GLState::deleteProgram(cullShader.ID);
+}
+
+int GPUDrivenRenderer::addMesh(const std::string& key, const TexturedObj& mesh) {
+    auto found = meshIds.find(key);
+    if (found != meshIds.end()) {
+        return found->second;
+    }
+
+    const std::vector<TextureVertex>& meshVertices = mesh.getVertices();
+    if (meshVertices.empty()) {
+        return -1;
+    }
+
+    MeshInfo info;
+    info.boundsMin = glm::vec4(mesh.getLocalBounds().min, 1.0f);
+    info.boundsMax = glm::vec4(mesh.getLocalBounds().max, 1.0f);
+    info.first = static_cast<GLuint>(vertices.size());
+    info.count = static_cast<GLuint>(meshVertices.size());
+    info.commandOffset = 0;
+    info.padding = 0;
+
+    vertices.insert(vertices.end(), meshVertices.begin(), meshVertices.end());
+    meshes.push_back(info);
+    meshTextures.push_back(mesh.getDiffuseTexture());
+    meshObjectCounts.push_back(0);
+
+    int id = static_cast<int>(meshes.size()) - 1;
+    meshIds[key] = id;
+    verticesDirty = true;
+    layoutDirty = true;
+    return id;
+}
+
+int GPUDrivenRenderer::addObject(int mesh) {
+    if (mesh < 0) {
+        return -1;
+    }
+
+    ObjectData data;
+    data.model = glm::mat4(1.0f);
+    data.material = glm::vec4(0.0f);
+    data.flags[0] = 0;
+    data.flags[1] = meshTextures[mesh] != 0 ? 1 : 0;
+    data.flags[2] = 0;
+    data.flags[3] = mesh;
+    data.params = glm::vec4(0.0f);
+    objects.push_back(data);
+
+    meshObjectCounts[mesh]++;
+    layoutDirty = true;
+    return static_cast<int>(objects.size()) - 1;
+}
+
+void GPUDrivenRenderer::setObject(int object, const glm::mat4& model, const glm::vec4& material, bool selected) {
+    ObjectData& data = objects[object];
+    data.model = model;
+    data.material = material;
+    data.flags[0] = selected ? 1 : 0;
+
+    size_t index = static_cast<size_t>(object);
+    if (dirtyBegin == dirtyEnd) {
+        dirtyBegin = index;
+        dirtyEnd = index + 1;
+    } else {
+        dirtyBegin = std::min(dirtyBegin, index);
+        dirtyEnd = std::max(dirtyEnd, index + 1);
+    }
+}
+
+void GPUDrivenRenderer::clearObjects() {
+    objects.clear();
+    std::fill(meshObjectCounts.begin(), meshObjectCounts.end(), 0u);
+    dirtyBegin = dirtyEnd = 0;
+    layoutDirty = true;
+}
+
+void GPUDrivenRenderer::uploadVertices() {
+    glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(TextureVertex), vertices.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    verticesDirty = false;
+}
+
+// Each mesh owns a run of command slots, one per object that uses it
+void GPUDrivenRenderer::uploadLayout() {
+    GLuint offset = 0;
+    for (size_t m = 0; m < meshes.size(); m++) {
+        meshes[m].commandOffset = offset;
+        offset += meshObjectCounts[m];
+    }
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, meshBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, meshes.size() * sizeof(MeshInfo), meshes.data(), GL_STATIC_DRAW);
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, countBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, std::max<size_t>(meshes.size(), 1) * sizeof(GLuint), nullptr, GL_DYNAMIC_DRAW);
+
+    if (objects.size() > objectCapacity || objectCapacity == 0) {
+        objectCapacity = std::max<size_t>(objectCapacity * 2, std::max<size_t>(objects.size(), 64));
+
+        std::vector<GLuint> ids(objectCapacity);
+        for (size_t i = 0; i < ids.size(); i++) {
+            ids[i] = static_cast<GLuint>(i);
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, idBuffer);
+        glBufferData(GL_ARRAY_BUFFER, ids.size() * sizeof(GLuint), ids.data(), GL_STATIC_DRAW);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, objectBuffer);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, objectCapacity * sizeof(ObjectData), nullptr, GL_DYNAMIC_DRAW);
+
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+        glBufferData(GL_DRAW_INDIRECT_BUFFER, objectCapacity * sizeof(DrawCommand), nullptr, GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    }
+
+    // Object slots may have moved between meshes, so resend them all
+    dirtyBegin = 0;
+    dirtyEnd = objects.size();
+    layoutDirty = false;
+}
+
+void GPUDrivenRenderer::uploadObjects() {
+    if (dirtyBegin == dirtyEnd) return;
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, objectBuffer);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, dirtyBegin * sizeof(ObjectData),
+                    (dirtyEnd - dirtyBegin) * sizeof(ObjectData), &objects[dirtyBegin]);
+    dirtyBegin = dirtyEnd = 0;
+}
+
+void GPUDrivenRenderer::cull(const Frustum& frustum, bool frustumCulling) {
+    if (verticesDirty) uploadVertices();
+    if (layoutDirty) uploadLayout();
+    uploadObjects();
+
+    if (objects.empty()) return;
+
+    const GLuint zero = 0;
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, countBuffer);
+    glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, &zero);
+
+    // Without a GPU-side draw count every slot up to the mesh's object count
+    // is drawn, so the ones the shader doesn't fill must be empty commands
+    if (!countBufferDraws) {
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, commandBuffer);
+        glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, &zero);
+    }
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, OBJECT_BINDING, objectBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, MESH_BINDING, meshBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, COMMAND_BINDING, commandBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, COUNT_BINDING, countBuffer);
+
+    cullShader.use();
+    glUniform4fv(glGetUniformLocation(cullShader.ID, "planes"), 6, &frustum.getPlanes()[0][0]);
+    glUniform1ui(glGetUniformLocation(cullShader.ID, "objectCount"), static_cast<GLuint>(objects.size()));
+    cullShader.setBool("frustumCulling", frustumCulling);
+
+    GLuint groups = (static_cast<GLuint>(objects.size()) + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE;
+    glDispatchCompute(groups, 1, 1);
+    glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+}
+
+void GPUDrivenRenderer::draw() {
+    if (objects.empty()) return;
+
+    GLState::bindVertexArray(vao);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, OBJECT_BINDING, objectBuffer);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+    if (countBufferDraws) {
+        glBindBuffer(GL_PARAMETER_BUFFER, countBuffer);
+    }
+
+    for (size_t m = 0; m < meshes.size(); m++) {
+        if (meshObjectCounts[m] == 0) continue;
+
+        GLState::bindTexture(0, GL_TEXTURE_2D, meshTextures[m]);
+        const void* commands = (const void*)(meshes[m].commandOffset * sizeof(DrawCommand));
+        GLsizei maxDraws = static_cast<GLsizei>(meshObjectCounts[m]);
+        if (countBufferDraws) {
+            glMultiDrawArraysIndirectCount(GL_TRIANGLES, commands, m * sizeof(GLuint), maxDraws, 0);
+        } else {
+            glMultiDrawArraysIndirect(GL_TRIANGLES, commands, maxDraws, 0);
+        }
+    }
+
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    if (countBufferDraws) {
+        glBindBuffer(GL_PARAMETER_BUFFER, 0);
+    }
+}
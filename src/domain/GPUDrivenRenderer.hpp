@@ -0,0 +1,105 @@
+#ifndef GPU_DRIVEN_RENDERER_H
+#define GPU_DRIVEN_RENDERER_H
+
+#include "glad/glad.h"
+#include "Frustum.hpp"
+#include "Shader.hpp"
+#include "TexturedObj.hpp"
+#include <glm/glm.hpp>
+#include <map>
+#include <string>
+#include <vector>
+
+// GPU-driven culling and draw submission (GL 4.3+).
+// Every registered mesh is copied once into a shared vertex buffer, and
+// every object's transform and material live in a shader storage buffer that
+// is only touched when the object changes. Each frame a compute shader tests
+// all objects against the frustum and appends one indirect draw command per
+// survivor into its mesh's range; then each mesh is drawn with a single
+// glMultiDrawArraysIndirect. The CPU work per frame depends on the number of
+// meshes, not the number of objects.
+class GPUDrivenRenderer {
+public:
+    static bool isSupported();
+
+    GPUDrivenRenderer();
+    ~GPUDrivenRenderer();
+
+    GPUDrivenRenderer(const GPUDrivenRenderer&) = delete;
+    GPUDrivenRenderer& operator=(const GPUDrivenRenderer&) = delete;
+
+    // Uploads the mesh's full-detail vertices the first time a key is seen.
+    // Returns -1 for meshes without vertex data.
+    int addMesh(const std::string& key, const TexturedObj& mesh);
+
+    int addObject(int mesh);
+    void setObject(int object, const glm::mat4& model, const glm::vec4& material, bool selected);
+
+    // Drops all objects; registered meshes stay for the next scene
+    void clearObjects();
+
+    // Writes this frame's draw commands; with culling off every object is emitted
+    void cull(const Frustum& frustum, bool frustumCulling);
+
+    // Issues one multi-draw per mesh with the given program bound
+    void draw();
+
+    size_t getObjectCount() const { return objects.size(); }
+    size_t getMeshCount() const { return meshes.size(); }
+    bool usesCountBuffer() const { return countBufferDraws; }
+
+private:
+    // std430 mirrors of the structs in cull.comp / scene_indirect.vert
+    struct ObjectData {
+        glm::mat4 model;
+        glm::vec4 material;
+        int flags[4];
+        glm::vec4 params;
+    };
+
+    struct MeshInfo {
+        glm::vec4 boundsMin;
+        glm::vec4 boundsMax;
+        GLuint first;
+        GLuint count;
+        GLuint commandOffset;
+        GLuint padding;
+    };
+
+    struct DrawCommand {
+        GLuint count;
+        GLuint instanceCount;
+        GLuint first;
+        GLuint baseInstance;
+    };
+
+    Shader cullShader;
+    GLuint vao;
+    GLuint vertexBuffer;
+    GLuint idBuffer;
+    GLuint objectBuffer;
+    GLuint meshBuffer;
+    GLuint commandBuffer;
+    GLuint countBuffer;
+
+    std::map<std::string, int> meshIds;
+    std::vector<TextureVertex> vertices;
+    std::vector<MeshInfo> meshes;
+    std::vector<GLuint> meshTextures;
+    std::vector<GLuint> meshObjectCounts;
+
+    std::vector<ObjectData> objects;
+    size_t dirtyBegin;
+    size_t dirtyEnd;
+
+    bool verticesDirty;
+    bool layoutDirty;
+    size_t objectCapacity;
+    bool countBufferDraws;
+
+    void uploadVertices();
+    void uploadLayout();
+    void uploadObjects();
+};
+
+#endif
@@ -0,0 +1,249 @@
+#include "ImpostorRenderer.hpp"
+#include "GLState.hpp"
+#include "Logger.hpp"
+#include <glm/gtc/matrix_transform.hpp>
+#include <cmath>
+
+namespace {
+    const float quadCorners[] = {
+        -1.0f, -1.0f,  1.0f, -1.0f,  -1.0f, 1.0f,  1.0f, 1.0f,
+    };
+
+    float signOf(float v) {
+        return v >= 0.0f ? 1.0f : -1.0f;
+    }
+
+    // Same mapping as octDecode in impostor.vert; e is in [0, 1]^2
+    glm::vec3 octDecode(glm::vec2 e) {
+        e = e * 2.0f - 1.0f;
+        glm::vec3 d(e.x, 1.0f - std::abs(e.x) - std::abs(e.y), e.y);
+        if (d.y < 0.0f) {
+            float x = (1.0f - std::abs(d.z)) * signOf(d.x);
+            float z = (1.0f - std::abs(d.x)) * signOf(d.z);
+            d.x = x;
+            d.z = z;
+        }
+        return glm::normalize(d);
+    }
+}
+
+ImpostorRenderer::ImpostorRenderer(int viewsPerSide, int cellSize)
+    : viewsPerSide(viewsPerSide)
+    , cellSize(cellSize)
+    , bakeShader("src/shaders/impostor_bake.vert", "src/shaders/impostor_bake.frag")
+    , drawShader("src/shaders/impostor.vert", "src/shaders/impostor.frag")
+    , quadVAO(0)
+    , quadVBO(0)
+    , instanceVBO(0) {
+    glGenVertexArrays(1, &quadVAO);
+    GLState::bindVertexArray(quadVAO);
+
+    glGenBuffers(1, &quadVBO);
+    glBindBuffer(GL_ARRAY_BUFFER, quadVBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(quadCorners), quadCorners, GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+
+    // Pointers into this buffer are set per batch in flush()
+    glGenBuffers(1, &instanceVBO);
+    for (GLuint location = 1; location <= 6; location++) {
+        glEnableVertexAttribArray(location);
+        glVertexAttribDivisor(location, 1);
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    GLState::bindVertexArray(0);
+}
+
+ImpostorRenderer::~ImpostorRenderer() {
+    for (auto& pair : atlases) {
+        GLState::deleteTexture(pair.second.albedo);
+        GLState::deleteTexture(pair.second.normal);
+    }
+    GLState::deleteVertexArray(quadVAO);
+    if (quadVBO != 0) glDeleteBuffers(1, &quadVBO);
+    if (instanceVBO != 0) glDeleteBuffers(1, &instanceVBO);
+    GLState::deleteProgram(bakeShader.ID);
+    GLState::deleteProgram(drawShader.ID);
+}
+
+const ImpostorRenderer::Atlas* ImpostorRenderer::getAtlas(const std::string& key, TexturedObj& mesh) {
+    auto found = atlases.find(key);
+    if (found != atlases.end()) {
+        return &found->second;
+    }
+
+    Atlas& atlas = atlases[key];
+    bake(atlas, mesh);
+    LOG_INFO("Baked impostor atlas for " << key << " (" << viewsPerSide * viewsPerSide << " views)");
+    return &atlas;
+}
+
+GLuint ImpostorRenderer::createAtlasTexture(int size) const {
+    GLuint texture;
+    glGenTextures(1, &texture);
+    GLState::bindTexture(0, GL_TEXTURE_2D, texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, size, size, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    // Stop before cells shrink to a few texels and start bleeding into each other
+    int maxLevel = std::max(0, static_cast<int>(std::log2(static_cast<float>(cellSize))) - 3);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, maxLevel);
+    return texture;
+}
+
+void ImpostorRenderer::bake(Atlas& atlas, TexturedObj& mesh) {
+    const AABB& bounds = mesh.getLocalBounds();
+    atlas.center = bounds.center();
+    atlas.radius = std::max(glm::length(bounds.extents()), 1e-4f);
+    atlas.viewsPerSide = viewsPerSide;
+
+    int size = viewsPerSide * cellSize;
+    atlas.albedo = createAtlasTexture(size);
+    atlas.normal = createAtlasTexture(size);
+
+    GLuint depth;
+    glGenRenderbuffers(1, &depth);
+    glBindRenderbuffer(GL_RENDERBUFFER, depth);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, size, size);
+
+    GLuint framebuffer;
+    glGenFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, atlas.albedo, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, atlas.normal, 0);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depth);
+
+    const GLenum drawBuffers[] = {GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1};
+    glDrawBuffers(2, drawBuffers);
+
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        LOG_ERROR("Impostor framebuffer is incomplete");
+    }
+
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+
+    GLState::setColorMask(true);
+    GLState::setDepthMask(true);
+    GLState::setDepthTest(true);
+    GLState::setDepthFunc(GL_LESS);
+    GLState::setBlend(false);
+    GLState::setCullFace(false);
+    GLState::setPolygonMode(GL_FILL);
+
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    int savedLOD = mesh.getLOD();
+    mesh.setLOD(0);
+    bakeShader.use();
+
+    // One orthographic capture per cell, looking at the bounding sphere from
+    // the direction the cell's centre decodes to
+    float r = atlas.radius;
+    glm::mat4 projection = glm::ortho(-r, r, -r, r, r, 3.0f * r);
+    for (int y = 0; y < viewsPerSide; y++) {
+        for (int x = 0; x < viewsPerSide; x++) {
+            glm::vec2 cell((x + 0.5f) / viewsPerSide, (y + 0.5f) / viewsPerSide);
+            glm::vec3 direction = octDecode(cell);
+            glm::vec3 up = std::abs(direction.y) > 0.99f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+            glm::mat4 view = glm::lookAt(atlas.center + direction * 2.0f * r, atlas.center, up);
+
+            glViewport(x * cellSize, y * cellSize, cellSize, cellSize);
+            bakeShader.setMat4("viewProjection", projection * view);
+
+            if (mesh.hasTextures()) {
+                mesh.drawTextured(bakeShader.ID);
+            } else {
+                bakeShader.setBool("useTexture", false);
+                mesh.drawWithTextures();
+            }
+        }
+    }
+
+    mesh.setLOD(savedLOD);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+    glDeleteFramebuffers(1, &framebuffer);
+    glDeleteRenderbuffers(1, &depth);
+
+    GLState::bindTexture(0, GL_TEXTURE_2D, atlas.albedo);
+    glGenerateMipmap(GL_TEXTURE_2D);
+    GLState::bindTexture(0, GL_TEXTURE_2D, atlas.normal);
+    glGenerateMipmap(GL_TEXTURE_2D);
+    GLState::bindTexture(0, GL_TEXTURE_2D, 0);
+}
+
+void ImpostorRenderer::add(const Atlas* atlas, const glm::mat4& model, const glm::vec4& material, float fade, bool selected) {
+    Instance instance;
+    instance.model = model;
+    instance.material = material;
+    instance.params = glm::vec4(fade, selected ? 1.0f : 0.0f, 0.0f, 0.0f);
+    batches[atlas].push_back(instance);
+}
+
+size_t ImpostorRenderer::getPendingCount() const {
+    size_t count = 0;
+    for (const auto& pair : batches) {
+        count += pair.second.size();
+    }
+    return count;
+}
+
+void ImpostorRenderer::flush(const glm::mat4& view, const glm::mat4& projection, const glm::vec3& viewPos,
+                             const glm::vec3& lightPos, const glm::vec3& lightColor, bool overdraw) {
+    uploadBuffer.clear();
+    for (const auto& pair : batches) {
+        uploadBuffer.insert(uploadBuffer.end(), pair.second.begin(), pair.second.end());
+    }
+    if (uploadBuffer.empty()) return;
+
+    drawShader.use();
+    drawShader.setMat4("view", view);
+    drawShader.setMat4("projection", projection);
+    drawShader.setVec3("viewPos", viewPos);
+    drawShader.setVec3("lightPos", lightPos);
+    drawShader.setVec3("lightColor", lightColor);
+    drawShader.setBool("overdraw", overdraw);
+    drawShader.setInt("albedoAtlas", 0);
+    drawShader.setInt("normalAtlas", 1);
+
+    GLState::bindVertexArray(quadVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+    glBufferData(GL_ARRAY_BUFFER, uploadBuffer.size() * sizeof(Instance), uploadBuffer.data(), GL_STREAM_DRAW);
+
+    GLint sphereLocation = glGetUniformLocation(drawShader.ID, "sphere");
+    size_t first = 0;
+    for (auto& pair : batches) {
+        const Atlas* atlas = pair.first;
+        std::vector<Instance>& instances = pair.second;
+        if (instances.empty()) continue;
+
+        // Without base-instance draws (GL 4.2) each batch re-points the
+        // instanced attributes at its slice of the shared buffer
+        size_t base = first * sizeof(Instance);
+        for (int column = 0; column < 4; column++) {
+            glVertexAttribPointer(1 + column, 4, GL_FLOAT, GL_FALSE, sizeof(Instance),
+                                  (void*)(base + offsetof(Instance, model) + column * sizeof(glm::vec4)));
+        }
+        glVertexAttribPointer(5, 4, GL_FLOAT, GL_FALSE, sizeof(Instance), (void*)(base + offsetof(Instance, material)));
+        glVertexAttribPointer(6, 4, GL_FLOAT, GL_FALSE, sizeof(Instance), (void*)(base + offsetof(Instance, params)));
+
+        GLState::bindTexture(0, GL_TEXTURE_2D, atlas->albedo);
+        GLState::bindTexture(1, GL_TEXTURE_2D, atlas->normal);
+        glUniform4f(sphereLocation, atlas->center.x, atlas->center.y, atlas->center.z, atlas->radius);
+        drawShader.setInt("viewsPerSide", atlas->viewsPerSide);
+
+        glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, static_cast<GLsizei>(instances.size()));
+
+        first += instances.size();
+        instances.clear();
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
@@ -0,0 +1,71 @@
+#ifndef IMPOSTOR_RENDERER_H
+#define IMPOSTOR_RENDERER_H
+
+#include "glad/glad.h"
+#include "Shader.hpp"
+#include "TexturedObj.hpp"
+#include <glm/glm.hpp>
+#include <map>
+#include <string>
+#include <vector>
+
+// Octahedral impostors for distant objects.
+// At load time each mesh is rendered from viewsPerSide^2 directions spread
+// over the sphere (octahedral mapping) into one cell each of an albedo and a
+// normal atlas. At draw time every impostor is a single quad that picks the
+// cell closest to the camera direction and is lit like the real mesh. All
+// impostors sharing an atlas go out in one instanced draw.
+class ImpostorRenderer {
+public:
+    struct Atlas {
+        GLuint albedo = 0;
+        GLuint normal = 0;
+        int viewsPerSide = 0;
+        glm::vec3 center = glm::vec3(0.0f);   // object-space capture sphere
+        float radius = 0.0f;
+    };
+
+    explicit ImpostorRenderer(int viewsPerSide = 8, int cellSize = 128);
+    ~ImpostorRenderer();
+
+    ImpostorRenderer(const ImpostorRenderer&) = delete;
+    ImpostorRenderer& operator=(const ImpostorRenderer&) = delete;
+
+    // Bakes on first use; later calls with the same key share the atlas
+    const Atlas* getAtlas(const std::string& key, TexturedObj& mesh);
+
+    // fade is the crossfade weight in (0, 1]; 1 means the impostor alone
+    void add(const Atlas* atlas, const glm::mat4& model, const glm::vec4& material, float fade, bool selected);
+
+    // Draws everything added since the last flush
+    void flush(const glm::mat4& view, const glm::mat4& projection, const glm::vec3& viewPos,
+               const glm::vec3& lightPos, const glm::vec3& lightColor, bool overdraw);
+
+    size_t getPendingCount() const;
+
+private:
+    // Per-instance attributes, locations 1-6 in impostor.vert
+    struct Instance {
+        glm::mat4 model;
+        glm::vec4 material;
+        glm::vec4 params;
+    };
+
+    int viewsPerSide;
+    int cellSize;
+
+    Shader bakeShader;
+    Shader drawShader;
+    GLuint quadVAO;
+    GLuint quadVBO;
+    GLuint instanceVBO;
+
+    std::map<std::string, Atlas> atlases;
+    std::map<const Atlas*, std::vector<Instance>> batches;
+    std::vector<Instance> uploadBuffer;
+
+    void bake(Atlas& atlas, TexturedObj& mesh);
+    GLuint createAtlasTexture(int size) const;
+};
+
+#endif
@@ -0,0 +1,161 @@
+#include "InputRecorder.hpp"
+#include "Logger.hpp"
+#include <cstring>
+
+namespace {
+    const char MAGIC[4] = {'I', 'N', 'P', 'T'};
+    const uint32_t VERSION = 1;
+
+    template <typename T>
+    void write(std::ofstream& file, const T& value) {
+        file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    template <typename T>
+    bool read(std::ifstream& file, T& value) {
+        return static_cast<bool>(file.read(reinterpret_cast<char*>(&value), sizeof(T)));
+    }
+}
+
+InputRecorder::Options InputRecorder::Options::parse(int argc, char* argv[]) {
+    Options options;
+    for (int i = 1; i < argc; i++) {
+        std::string argument = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (argument == "--record" && hasValue) {
+            options.recordPath = argv[++i];
+        } else if (argument == "--replay" && hasValue) {
+            options.replayPath = argv[++i];
+        } else if (argument == "--timings" && hasValue) {
+            options.timingsPath = argv[++i];
+        } else if (argument == "--headless") {
+            options.headless = true;
+        } else {
+            options.arguments.push_back(argument);
+        }
+    }
+    return options;
+}
+
+InputRecorder::InputRecorder()
+    : mode(Mode::LIVE)
+    , cursorOffset(0.0f)
+    , pendingCursor(0.0f)
+    , deltaTime(0.0f)
+    , frame(0) {
+}
+
+bool InputRecorder::record(const std::string& filename) {
+    stop();
+    output.open(filename, std::ios::binary);
+    if (!output.is_open()) {
+        LOG_ERROR("Could not write input recording: " << filename);
+        return false;
+    }
+
+    output.write(MAGIC, sizeof(MAGIC));
+    write(output, VERSION);
+    path = filename;
+    mode = Mode::RECORD;
+    LOG_INFO("Recording input to " << filename);
+    return true;
+}
+
+bool InputRecorder::replay(const std::string& filename) {
+    stop();
+    input.open(filename, std::ios::binary);
+    if (!input.is_open()) {
+        LOG_ERROR("Could not open input recording: " << filename);
+        return false;
+    }
+
+    char magic[4];
+    uint32_t version = 0;
+    if (!input.read(magic, sizeof(magic)) || std::memcmp(magic, MAGIC, sizeof(MAGIC)) != 0 || !read(input, version) ||
+        version != VERSION) {
+        LOG_ERROR("Not an input recording (or an older format): " << filename);
+        input.close();
+        return false;
+    }
+
+    path = filename;
+    mode = Mode::REPLAY;
+    LOG_INFO("Replaying input from " << filename);
+    return true;
+}
+
+bool InputRecorder::start(const Options& options) {
+    if (!options.replayPath.empty()) return replay(options.replayPath);
+    if (!options.recordPath.empty()) return record(options.recordPath);
+    return true;
+}
+
+void InputRecorder::stop() {
+    if (mode == Mode::RECORD) {
+        output.close();
+        LOG_INFO("Recorded " << frame << " frames of input to " << path);
+    } else if (mode == Mode::REPLAY) {
+        input.close();
+        LOG_INFO("Replayed " << frame << " frames of input from " << path);
+    }
+    mode = Mode::LIVE;
+    keys.reset();
+    cursorOffset = glm::vec2(0.0f);
+    pendingCursor = glm::vec2(0.0f);
+    frame = 0;
+}
+
+bool InputRecorder::beginFrame(GLFWwindow* window, float frameTime) {
+    if (mode == Mode::REPLAY) {
+        if (!readFrame()) return false;
+        frame++;
+        return true;
+    }
+
+    changes.clear();
+    for (int key = FIRST_KEY; key < KEY_COUNT; key++) {
+        bool pressed = glfwGetKey(window, key) == GLFW_PRESS;
+        if (pressed != keys[key]) {
+            keys[key] = pressed;
+            changes.push_back(static_cast<uint16_t>(key));
+        }
+    }
+    cursorOffset = pendingCursor;
+    pendingCursor = glm::vec2(0.0f);
+    deltaTime = frameTime;
+
+    if (mode == Mode::RECORD) {
+        writeFrame();
+    }
+    frame++;
+    return true;
+}
+
+int InputRecorder::getKey(int key) const {
+    if (key < FIRST_KEY || key >= KEY_COUNT) return GLFW_RELEASE;
+    return keys[key] ? GLFW_PRESS : GLFW_RELEASE;
+}
+
+void InputRecorder::moveCursor(float xoffset, float yoffset) {
+    if (mode == Mode::REPLAY) return;
+    pendingCursor += glm::vec2(xoffset, yoffset);
+}
+
+void InputRecorder::writeFrame() {
+    write(output, deltaTime);
+    write(output, cursorOffset);
+    write(output, static_cast<uint16_t>(changes.size()));
+    output.write(reinterpret_cast<const char*>(changes.data()), changes.size() * sizeof(uint16_t));
+}
+
+bool InputRecorder::readFrame() {
+    uint16_t count = 0;
+    if (!read(input, deltaTime) || !read(input, cursorOffset) || !read(input, count)) return false;
+
+    changes.resize(count);
+    if (!input.read(reinterpret_cast<char*>(changes.data()), count * sizeof(uint16_t))) return false;
+    for (uint16_t key : changes) {
+        if (key >= FIRST_KEY && key < KEY_COUNT) keys.flip(key);
+    }
+    return true;
+}
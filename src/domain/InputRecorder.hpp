@@ -0,0 +1,87 @@
+#ifndef INPUT_RECORDER_H
+#define INPUT_RECORDER_H
+
+#include <GLFW/glfw3.h>
+#include <glm/glm.hpp>
+#include <bitset>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// Everything a viewer takes from the user in a frame: the keys held, how far
+// the mouse moved and the frame's deltaTime. Viewers ask getKey() instead of
+// glfwGetKey() and hand cursor motion to moveCursor(), so the same session can
+// be written to a file and fed back later frame for frame, deltaTime included,
+// however fast the replaying machine draws it. The scene and window size are
+// not recorded; a replay only matches when they are the same.
+//
+// File: "INPT", version, then per frame deltaTime, the mouse offset, and the
+// keys whose state changed since the frame before (count, then key codes).
+class InputRecorder {
+public:
+    enum class Mode {
+        LIVE,
+        RECORD,
+        REPLAY
+    };
+
+    // Command line flags shared by the viewers; anything else is kept in arguments
+    //   --record <file>  --replay <file>  --timings <file.csv>  --headless
+    struct Options {
+        std::string recordPath;
+        std::string replayPath;
+        std::string timingsPath;
+        bool headless = false;
+        std::vector<std::string> arguments;
+
+        static Options parse(int argc, char* argv[]);
+    };
+
+    InputRecorder();
+
+    InputRecorder(const InputRecorder&) = delete;
+    InputRecorder& operator=(const InputRecorder&) = delete;
+
+    bool record(const std::string& filename);
+    bool replay(const std::string& filename);
+    // Records or replays as the options ask; true if there was nothing to open
+    bool start(const Options& options);
+    // Ends a recording or replay; call it before exit so the frame count is logged
+    void stop();
+
+    // Takes this frame's input from the window, or the next frame from the
+    // replay. Returns false once the replay has run out of frames.
+    bool beginFrame(GLFWwindow* window, float deltaTime);
+
+    int getKey(int key) const;
+    glm::vec2 getCursorOffset() const { return cursorOffset; }
+    float getDeltaTime() const { return deltaTime; }
+
+    // Called from the cursor callback; ignored while replaying
+    void moveCursor(float xoffset, float yoffset);
+
+    Mode getMode() const { return mode; }
+    unsigned long getFrame() const { return frame; }
+
+private:
+    static const int FIRST_KEY = GLFW_KEY_SPACE;
+    static const int KEY_COUNT = GLFW_KEY_LAST + 1;
+
+    Mode mode;
+    std::ofstream output;
+    std::ifstream input;
+    std::string path;
+
+    std::bitset<KEY_COUNT> keys;
+    std::vector<uint16_t> changes;
+    glm::vec2 cursorOffset;
+    glm::vec2 pendingCursor;    // moved since the last beginFrame
+    float deltaTime;
+    unsigned long frame;
+
+    bool readFrame();
+    void writeFrame();
+};
+
+#endif
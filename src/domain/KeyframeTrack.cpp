@@ -0,0 +1,542 @@
+#include "KeyframeTrack.hpp"
+#include "Logger.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#define NOGDI
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+struct KeyframeTrack::Header {
+    char magic[4];
+    uint32_t version;
+    uint32_t encoding;
+    uint32_t blockCount;
+    uint64_t sampleCount;
+    uint64_t indexOffset;
+    float startTime;
+    float endTime;
+    uint32_t reserved[2];
+};
+
+struct KeyframeTrack::BlockEntry {
+    uint64_t offset;            // from the start of the file
+    uint32_t size;              // in bytes
+    uint32_t sampleCount;
+    float startTime;
+    float endTime;
+    float boundsMin[3];         // quantization range of the positions
+    float boundsMax[3];
+};
+
+namespace {
+    const char MAGIC[4] = {'K', 'E', 'Y', 'F'};
+    const uint32_t VERSION = 1;
+    const uint64_t BLOCK_ALIGNMENT = 8;
+    // A delta sample is four varints of at least one byte each
+    const uint64_t MIN_DELTA_SAMPLE_SIZE = 4;
+    const float QUANTIZED_MAX = 65535.0f;
+
+    uint64_t align(uint64_t offset) {
+        return (offset + BLOCK_ALIGNMENT - 1) / BLOCK_ALIGNMENT * BLOCK_ALIGNMENT;
+    }
+
+    uint16_t quantize(float value, float low, float high) {
+        if (high <= low) return 0;
+        float q = std::round((value - low) / (high - low) * QUANTIZED_MAX);
+        return static_cast<uint16_t>(std::clamp(q, 0.0f, QUANTIZED_MAX));
+    }
+
+    float dequantize(uint16_t value, float low, float high) {
+        return low + value * ((high - low) / QUANTIZED_MAX);
+    }
+
+    void writeVarint(std::vector<unsigned char>& out, uint32_t value) {
+        while (value >= 0x80) {
+            out.push_back(static_cast<unsigned char>(value | 0x80));
+            value >>= 7;
+        }
+        out.push_back(static_cast<unsigned char>(value));
+    }
+
+    bool readVarint(const unsigned char*& in, const unsigned char* end, uint32_t& value) {
+        value = 0;
+        for (int shift = 0; shift < 35 && in < end; shift += 7) {
+            unsigned char byte = *in++;
+            value |= static_cast<uint32_t>(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0) return true;
+        }
+        return false;
+    }
+
+    // Small deltas of either sign become small unsigned numbers
+    uint32_t zigzag(int32_t value) {
+        return (static_cast<uint32_t>(value) << 1) ^ static_cast<uint32_t>(value >> 31);
+    }
+
+    int32_t unzigzag(uint32_t value) {
+        return static_cast<int32_t>(value >> 1) ^ -static_cast<int32_t>(value & 1);
+    }
+
+    size_t sampleSize(uint32_t encoding) {
+        return encoding == KeyframeTrack::FLOAT32 ? 4 * sizeof(float) : 4 * sizeof(uint16_t);
+    }
+}
+
+KeyframeTrack::KeyframeTrack()
+    : data(nullptr)
+    , size(0)
+#ifdef _WIN32
+    , fileHandle(nullptr)
+    , mappingHandle(nullptr)
+#endif
+    , header(nullptr)
+    , blocks(nullptr)
+    , currentBlock(-1)
+    , currentSample(0)
+    , decodes(0) {
+}
+
+KeyframeTrack::~KeyframeTrack() {
+    close();
+}
+
+bool KeyframeTrack::open(const std::string& path) {
+    close();
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_FLAG_RANDOM_ACCESS, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        LOG_ERROR("Could not open keyframes: " << path);
+        return false;
+    }
+    LARGE_INTEGER fileSize;
+    HANDLE mapping = nullptr;
+    if (GetFileSizeEx(file, &fileSize) && fileSize.QuadPart > 0) {
+        mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    }
+    void* view = mapping != nullptr ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+    if (view == nullptr) {
+        if (mapping != nullptr) CloseHandle(mapping);
+        CloseHandle(file);
+        LOG_ERROR("Could not map keyframes: " << path);
+        return false;
+    }
+    fileHandle = file;
+    mappingHandle = mapping;
+    size = static_cast<size_t>(fileSize.QuadPart);
+#else
+    int file = ::open(path.c_str(), O_RDONLY);
+    if (file < 0) {
+        LOG_ERROR("Could not open keyframes: " << path);
+        return false;
+    }
+    struct stat status;
+    void* view = MAP_FAILED;
+    if (fstat(file, &status) == 0 && status.st_size > 0) {
+        view = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+    }
+    ::close(file);
+    if (view == MAP_FAILED) {
+        LOG_ERROR("Could not map keyframes: " << path);
+        return false;
+    }
+    size = static_cast<size_t>(status.st_size);
+    // No read-ahead over the whole file; enterBlock asks for what it needs
+    madvise(view, size, MADV_RANDOM);
+#endif
+
+    data = static_cast<const unsigned char*>(view);
+    header = reinterpret_cast<const Header*>(data);
+    if (!validate(path)) {
+        close();
+        return false;
+    }
+    blocks = reinterpret_cast<const BlockEntry*>(data + header->indexOffset);
+    return true;
+}
+
+void KeyframeTrack::close() {
+    if (data != nullptr) {
+#ifdef _WIN32
+        UnmapViewOfFile(data);
+        CloseHandle(mappingHandle);
+        CloseHandle(fileHandle);
+        mappingHandle = nullptr;
+        fileHandle = nullptr;
+#else
+        munmap(const_cast<unsigned char*>(data), size);
+#endif
+    }
+    data = nullptr;
+    size = 0;
+    header = nullptr;
+    blocks = nullptr;
+    currentBlock = -1;
+    currentSample = 0;
+    decoded.clear();
+}
+
+bool KeyframeTrack::validate(const std::string& path) const {
+    if (size < sizeof(Header) || std::memcmp(header->magic, MAGIC, sizeof(MAGIC)) != 0 ||
+        header->version != VERSION) {
+        LOG_ERROR("Not a keyframe file (or an older format): " << path);
+        return false;
+    }
+
+    // Every sum below is formed only once it is known not to pass the end of
+    // the file, so values read from it can't wrap around
+    bool timed = std::isfinite(header->startTime) && std::isfinite(header->endTime) &&
+                 header->startTime <= header->endTime;
+    if (header->encoding > QUANTIZED16_DELTA || header->blockCount == 0 || !timed ||
+        header->indexOffset % BLOCK_ALIGNMENT != 0 || header->indexOffset > size ||
+        header->blockCount > (size - header->indexOffset) / sizeof(BlockEntry)) {
+        LOG_ERROR("Corrupt keyframe header: " << path);
+        return false;
+    }
+    uint64_t indexEnd = header->indexOffset + static_cast<uint64_t>(header->blockCount) * sizeof(BlockEntry);
+
+    const BlockEntry* entries = reinterpret_cast<const BlockEntry*>(data + header->indexOffset);
+    uint64_t sampleTotal = 0;
+    for (uint32_t b = 0; b < header->blockCount; b++) {
+        const BlockEntry& entry = entries[b];
+        bool inside = entry.offset >= indexEnd && entry.offset <= size && entry.size <= size - entry.offset;
+        bool sized = header->encoding == QUANTIZED16_DELTA
+                   ? entry.sampleCount <= entry.size / MIN_DELTA_SAMPLE_SIZE
+                   : entry.size == static_cast<uint64_t>(entry.sampleCount) * sampleSize(header->encoding);
+        bool finite = std::isfinite(entry.startTime) && std::isfinite(entry.endTime);
+        for (int axis = 0; axis < 3; axis++) {
+            finite = finite && std::isfinite(entry.boundsMin[axis]) && std::isfinite(entry.boundsMax[axis]);
+        }
+        bool ordered = entry.startTime <= entry.endTime && (b == 0 || entries[b - 1].endTime <= entry.startTime);
+        if (entry.sampleCount == 0 || !inside || !sized || !finite || !ordered ||
+            entry.offset % BLOCK_ALIGNMENT != 0) {
+            LOG_ERROR("Corrupt keyframe block " << b << ": " << path);
+            return false;
+        }
+        sampleTotal += entry.sampleCount;
+    }
+
+    // Neighbouring blocks share their boundary sample; every block holds at
+    // least one, so this can't go below zero
+    if (sampleTotal - (header->blockCount - 1) != header->sampleCount) {
+        LOG_ERROR("Keyframe sample count doesn't match its blocks: " << path);
+        return false;
+    }
+    return true;
+}
+
+float KeyframeTrack::getStartTime() const {
+    return header != nullptr ? header->startTime : 0.0f;
+}
+
+float KeyframeTrack::getEndTime() const {
+    return header != nullptr ? header->endTime : 0.0f;
+}
+
+KeyframeTrack::Encoding KeyframeTrack::getEncoding() const {
+    return header != nullptr ? static_cast<Encoding>(header->encoding) : FLOAT32;
+}
+
+uint64_t KeyframeTrack::getSampleCount() const {
+    return header != nullptr ? header->sampleCount : 0;
+}
+
+uint32_t KeyframeTrack::getBlockCount() const {
+    return header != nullptr ? header->blockCount : 0;
+}
+
+glm::vec3 KeyframeTrack::sample(float time) {
+    if (!isOpen()) return glm::vec3(0.0f);
+
+    float duration = getDuration();
+    if (duration > 0.0f) {
+        time = std::fmod(time - header->startTime, duration);
+        if (time < 0.0f) time += duration;
+        time += header->startTime;
+    } else {
+        time = header->startTime;
+    }
+
+    int block = findBlock(time);
+    enterBlock(block);
+    uint32_t index = findSample(block, time);
+    currentSample = index;
+
+    glm::vec4 a = readSample(block, index);
+    if (index + 1 >= blocks[block].sampleCount) return glm::vec3(a);
+    glm::vec4 b = readSample(block, index + 1);
+    float f = b.w > a.w ? (time - a.w) / (b.w - a.w) : 0.0f;
+    return glm::mix(glm::vec3(a), glm::vec3(b), std::clamp(f, 0.0f, 1.0f));
+}
+
+// The playhead usually stays in its block or moves on to the next one
+int KeyframeTrack::findBlock(float time) const {
+    int count = static_cast<int>(header->blockCount);
+    for (int candidate : {currentBlock, currentBlock + 1}) {
+        if (candidate >= 0 && candidate < count && time >= blocks[candidate].startTime &&
+            time <= blocks[candidate].endTime) {
+            return candidate;
+        }
+    }
+
+    int low = 0;
+    int high = count - 1;
+    while (low < high) {
+        int middle = (low + high + 1) / 2;
+        if (blocks[middle].startTime <= time) {
+            low = middle;
+        } else {
+            high = middle - 1;
+        }
+    }
+    return low;
+}
+
+// Last sample at or before the time; playback only moves a few samples a call
+uint32_t KeyframeTrack::findSample(int block, float time) const {
+    const uint32_t LOOKAHEAD = 4;
+    uint32_t count = blocks[block].sampleCount;
+    if (currentSample < count && readSample(block, currentSample).w <= time) {
+        uint32_t index = currentSample;
+        for (uint32_t step = 0; step < LOOKAHEAD; step++) {
+            if (index + 1 >= count || readSample(block, index + 1).w > time) return index;
+            index++;
+        }
+    }
+
+    uint32_t low = 0;
+    uint32_t high = count - 1;
+    while (low < high) {
+        uint32_t middle = (low + high + 1) / 2;
+        if (readSample(block, middle).w <= time) {
+            low = middle;
+        } else {
+            high = middle - 1;
+        }
+    }
+    return low;
+}
+
+void KeyframeTrack::enterBlock(int block) {
+    if (block == currentBlock) return;
+
+    int previous = currentBlock;
+    currentBlock = block;
+    currentSample = 0;
+
+    // The neighbours stay resident so the playhead can cross into either of them
+    int count = static_cast<int>(header->blockCount);
+    advise(block, true);
+    if (block + 1 < count) advise(block + 1, true);
+    for (int stale : {block - 2, block + 2}) {
+        if (stale >= 0 && stale < count) advise(stale, false);
+    }
+    if (previous >= 0 && std::abs(previous - block) > 2) advise(previous, false);
+
+    if (header->encoding == QUANTIZED16_DELTA) {
+        decodeBlock(block);
+    }
+}
+
+void KeyframeTrack::advise(int block, bool needed) const {
+#ifndef _WIN32
+    static const uintptr_t PAGE = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+
+    uintptr_t begin = reinterpret_cast<uintptr_t>(data + blocks[block].offset);
+    uintptr_t end = begin + blocks[block].size;
+    if (needed) {
+        begin = begin / PAGE * PAGE;
+        madvise(reinterpret_cast<void*>(begin), end - begin, MADV_WILLNEED);
+    } else {
+        // Only pages entirely inside the block; the ones at its edges are shared with the neighbours
+        begin = (begin + PAGE - 1) / PAGE * PAGE;
+        end = end / PAGE * PAGE;
+        if (begin < end) {
+            madvise(reinterpret_cast<void*>(begin), end - begin, MADV_DONTNEED);
+        }
+    }
+#else
+    (void)block;
+    (void)needed;
+#endif
+}
+
+void KeyframeTrack::decodeBlock(int block) {
+    const BlockEntry& entry = blocks[block];
+    const unsigned char* in = data + entry.offset;
+    const unsigned char* end = in + entry.size;
+
+    decoded.resize(entry.sampleCount);
+    int32_t values[4] = {0, 0, 0, 0};
+    for (uint32_t i = 0; i < entry.sampleCount; i++) {
+        for (int32_t& value : values) {
+            uint32_t delta = 0;
+            // A truncated block repeats its last good sample
+            if (readVarint(in, end, delta)) {
+                value = std::clamp(value + unzigzag(delta), 0, 65535);
+            }
+        }
+        decoded[i] = glm::vec4(dequantize(static_cast<uint16_t>(values[1]), entry.boundsMin[0], entry.boundsMax[0]),
+                               dequantize(static_cast<uint16_t>(values[2]), entry.boundsMin[1], entry.boundsMax[1]),
+                               dequantize(static_cast<uint16_t>(values[3]), entry.boundsMin[2], entry.boundsMax[2]),
+                               dequantize(static_cast<uint16_t>(values[0]), entry.startTime, entry.endTime));
+    }
+    decodes++;
+}
+
+// xyz and time in w
+glm::vec4 KeyframeTrack::readSample(int block, uint32_t index) const {
+    const BlockEntry& entry = blocks[block];
+    const unsigned char* in = data + entry.offset + index * sampleSize(header->encoding);
+
+    switch (header->encoding) {
+        case FLOAT32: {
+            float values[4];
+            std::memcpy(values, in, sizeof(values));
+            return glm::vec4(values[1], values[2], values[3], values[0]);
+        }
+        case QUANTIZED16: {
+            uint16_t values[4];
+            std::memcpy(values, in, sizeof(values));
+            return glm::vec4(dequantize(values[1], entry.boundsMin[0], entry.boundsMax[0]),
+                             dequantize(values[2], entry.boundsMin[1], entry.boundsMax[1]),
+                             dequantize(values[3], entry.boundsMin[2], entry.boundsMax[2]),
+                             dequantize(values[0], entry.startTime, entry.endTime));
+        }
+        default:
+            return decoded[index];
+    }
+}
+
+KeyframeWriter::KeyframeWriter(KeyframeTrack::Encoding encoding, uint32_t samplesPerBlock)
+    : encoding(encoding)
+    , samplesPerBlock(std::max<uint32_t>(samplesPerBlock, 2)) {
+}
+
+void KeyframeWriter::add(float time, const glm::vec3& position) {
+    if (!samples.empty()) {
+        time = std::max(time, samples.back().w);
+    }
+    samples.push_back(glm::vec4(position, time));
+}
+
+void KeyframeWriter::addTrajectory(const Trajectory& trajectory, float rate) {
+    float length = trajectory.getLength();
+    float speed = trajectory.getSpeed();
+    if (length <= 0.0f || speed <= 0.0f || rate <= 0.0f) return;
+
+    float start = samples.empty() ? 0.0f : samples.back().w;
+    float duration = length / speed;
+    size_t count = static_cast<size_t>(std::ceil(duration * rate));
+    for (size_t i = 0; i <= count; i++) {
+        float time = std::min(static_cast<float>(i) / rate, duration);
+        add(start + time, trajectory.getPositionAtDistance(time * speed));
+    }
+}
+
+bool KeyframeWriter::save(const std::string& path) const {
+    if (samples.empty()) {
+        LOG_ERROR("No keyframes to write to " << path);
+        return false;
+    }
+
+    // Block b holds samples [first, last]; the next block starts at last again
+    std::vector<KeyframeTrack::BlockEntry> entries;
+    std::vector<std::vector<unsigned char>> payloads;
+    size_t first = 0;
+    for (;;) {
+        size_t last = std::min(first + samplesPerBlock - 1, samples.size() - 1);
+
+        KeyframeTrack::BlockEntry entry = {};
+        entry.sampleCount = static_cast<uint32_t>(last - first + 1);
+        entry.startTime = samples[first].w;
+        entry.endTime = samples[last].w;
+        glm::vec3 low(samples[first]);
+        glm::vec3 high(samples[first]);
+        for (size_t i = first; i <= last; i++) {
+            low = glm::min(low, glm::vec3(samples[i]));
+            high = glm::max(high, glm::vec3(samples[i]));
+        }
+        for (int axis = 0; axis < 3; axis++) {
+            entry.boundsMin[axis] = low[axis];
+            entry.boundsMax[axis] = high[axis];
+        }
+
+        std::vector<unsigned char> payload;
+        int32_t previous[4] = {0, 0, 0, 0};
+        for (size_t i = first; i <= last; i++) {
+            const glm::vec4& s = samples[i];
+            if (encoding == KeyframeTrack::FLOAT32) {
+                float values[4] = {s.w, s.x, s.y, s.z};
+                const unsigned char* bytes = reinterpret_cast<const unsigned char*>(values);
+                payload.insert(payload.end(), bytes, bytes + sizeof(values));
+                continue;
+            }
+
+            uint16_t values[4] = {quantize(s.w, entry.startTime, entry.endTime), quantize(s.x, low.x, high.x),
+                                  quantize(s.y, low.y, high.y), quantize(s.z, low.z, high.z)};
+            if (encoding == KeyframeTrack::QUANTIZED16) {
+                const unsigned char* bytes = reinterpret_cast<const unsigned char*>(values);
+                payload.insert(payload.end(), bytes, bytes + sizeof(values));
+            } else {
+                for (int c = 0; c < 4; c++) {
+                    writeVarint(payload, zigzag(values[c] - previous[c]));
+                    previous[c] = values[c];
+                }
+            }
+        }
+        entry.size = static_cast<uint32_t>(payload.size());
+
+        entries.push_back(entry);
+        payloads.push_back(std::move(payload));
+        if (last == samples.size() - 1) break;
+        first = last;
+    }
+
+    KeyframeTrack::Header header = {};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.encoding = encoding;
+    header.blockCount = static_cast<uint32_t>(entries.size());
+    header.sampleCount = samples.size();
+    header.indexOffset = align(sizeof(header));
+    header.startTime = samples.front().w;
+    header.endTime = samples.back().w;
+
+    uint64_t offset = header.indexOffset + entries.size() * sizeof(KeyframeTrack::BlockEntry);
+    for (size_t b = 0; b < entries.size(); b++) {
+        offset = align(offset);
+        entries[b].offset = offset;
+        offset += entries[b].size;
+    }
+
+    std::ofstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        LOG_ERROR("Could not write keyframes: " << path);
+        return false;
+    }
+
+    const char padding[BLOCK_ALIGNMENT] = {};
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(padding, header.indexOffset - sizeof(header));
+    file.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(KeyframeTrack::BlockEntry));
+    uint64_t written = header.indexOffset + entries.size() * sizeof(KeyframeTrack::BlockEntry);
+    for (size_t b = 0; b < entries.size(); b++) {
+        file.write(padding, entries[b].offset - written);
+        file.write(reinterpret_cast<const char*>(payloads[b].data()), payloads[b].size());
+        written = entries[b].offset + entries[b].size;
+    }
+    return static_cast<bool>(file);
+}
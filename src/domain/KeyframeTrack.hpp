@@ -0,0 +1,108 @@
+#ifndef KEYFRAME_TRACK_H
+#define KEYFRAME_TRACK_H
+
+#include "Trajectory.hpp"
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Long recorded paths (motion capture, simulation output) as time-stamped
+// position samples in a binary file that is memory-mapped, not read.
+// Samples are grouped in blocks; a small index in front of them holds each
+// block's time range and bounds, so sample() finds the block by binary search
+// and reads it in place. Consecutive blocks share their boundary sample, so any
+// time falls inside a single block. Blocks near the playhead are paged in
+// ahead of time and blocks it has left behind are released, which keeps the
+// resident part of the file small however long the recording is.
+//
+// Encodings, chosen per file:
+//   FLOAT32           time and xyz as floats, 16 bytes a sample
+//   QUANTIZED16       16 bits per value within the block's time range and bounds, 8 bytes
+//   QUANTIZED16_DELTA the same values delta- and varint-coded, decoded a block at a time
+class KeyframeTrack {
+public:
+    enum Encoding : uint32_t {
+        FLOAT32,
+        QUANTIZED16,
+        QUANTIZED16_DELTA
+    };
+
+    KeyframeTrack();
+    ~KeyframeTrack();
+
+    KeyframeTrack(const KeyframeTrack&) = delete;
+    KeyframeTrack& operator=(const KeyframeTrack&) = delete;
+
+    bool open(const std::string& path);
+    void close();
+    bool isOpen() const { return data != nullptr; }
+
+    // Position at a time, interpolated between samples. Loops over the recording.
+    glm::vec3 sample(float time);
+
+    float getStartTime() const;
+    float getEndTime() const;
+    float getDuration() const { return getEndTime() - getStartTime(); }
+    Encoding getEncoding() const;
+    uint64_t getSampleCount() const;
+    uint32_t getBlockCount() const;
+    size_t getFileSize() const { return size; }
+
+    // Compressed blocks decoded so far
+    unsigned long getDecodeCount() const { return decodes; }
+
+private:
+    friend class KeyframeWriter;
+
+    struct Header;
+    struct BlockEntry;
+
+    const unsigned char* data;
+    size_t size;
+#ifdef _WIN32
+    void* fileHandle;
+    void* mappingHandle;
+#endif
+
+    const Header* header;
+    const BlockEntry* blocks;
+
+    int currentBlock;
+    uint32_t currentSample;
+    std::vector<glm::vec4> decoded;     // the current block when compressed
+    unsigned long decodes;
+
+    bool validate(const std::string& path) const;
+    int findBlock(float time) const;
+    uint32_t findSample(int block, float time) const;
+    void enterBlock(int block);
+    void advise(int block, bool needed) const;
+    void decodeBlock(int block);
+    glm::vec4 readSample(int block, uint32_t index) const;
+};
+
+// Builds a keyframe file in memory and writes it out in one go
+class KeyframeWriter {
+public:
+    static const uint32_t DEFAULT_BLOCK_SAMPLES = 4096;
+
+    explicit KeyframeWriter(KeyframeTrack::Encoding encoding = KeyframeTrack::FLOAT32,
+                            uint32_t samplesPerBlock = DEFAULT_BLOCK_SAMPLES);
+
+    // Times must not decrease
+    void add(float time, const glm::vec3& position);
+
+    // One lap of the trajectory at its speed, rate samples per second
+    void addTrajectory(const Trajectory& trajectory, float rate);
+
+    size_t getSampleCount() const { return samples.size(); }
+    bool save(const std::string& path) const;
+
+private:
+    KeyframeTrack::Encoding encoding;
+    uint32_t samplesPerBlock;
+    std::vector<glm::vec4> samples;     // xyz, time in w
+};
+
+#endif
@@ -0,0 +1,28 @@
+#include "LODSelector.hpp"
+#include <algorithm>
+#include <cmath>
+
+LODSelector::LODSelector(const std::vector<float>& thresholds, float hysteresis)
+    : thresholds(thresholds)
+    , hysteresis(hysteresis) {
+}
+
+float LODSelector::screenCoverage(const BoundingSphere& sphere, const glm::vec3& eye, float fovY) {
+    float distance = glm::length(sphere.center - eye);
+    if (distance <= sphere.radius) return 1.0f;
+    return sphere.radius / (distance * std::tan(fovY * 0.5f));
+}
+
+int LODSelector::select(int currentLevel, float coverage, int levelCount) const {
+    int maxLevel = std::min(levelCount, static_cast<int>(thresholds.size()) + 1) - 1;
+    if (maxLevel <= 0) return 0;
+
+    int level = std::max(0, std::min(currentLevel, maxLevel));
+    while (level > 0 && coverage > thresholds[level - 1] * (1.0f + hysteresis)) {
+        level--;
+    }
+    while (level < maxLevel && coverage < thresholds[level] * (1.0f - hysteresis)) {
+        level++;
+    }
+    return level;
+}
@@ -0,0 +1,26 @@
+#ifndef LOD_SELECTOR_H
+#define LOD_SELECTOR_H
+
+#include "Bounds.hpp"
+#include <glm/glm.hpp>
+#include <vector>
+
+// Picks a level of detail from how much of the screen an object's bounding
+// sphere covers. Thresholds are fractions of the half-height of the view; a
+// level changes only once coverage is past a threshold by the hysteresis
+// margin, so objects sitting on a boundary don't flicker between levels.
+class LODSelector {
+public:
+    // thresholds[i] is the coverage below which level i + 1 is used
+    explicit LODSelector(const std::vector<float>& thresholds = {0.25f, 0.12f, 0.05f}, float hysteresis = 0.15f);
+
+    static float screenCoverage(const BoundingSphere& sphere, const glm::vec3& eye, float fovY);
+
+    int select(int currentLevel, float coverage, int levelCount) const;
+
+private:
+    std::vector<float> thresholds;
+    float hysteresis;
+};
+
+#endif
@@ -0,0 +1,195 @@
+#include "LightClusters.hpp"
+#include "GLState.hpp"
+#include <algorithm>
+#include <cmath>
+
+LightClusters::LightClusters(int tilesX, int tilesY, int depthSlices)
+    : tilesX(tilesX)
+    , tilesY(tilesY)
+    , depthSlices(depthSlices)
+    , nearPlane(0.0f)
+    , farPlane(0.0f)
+    , viewportWidth(0)
+    , viewportHeight(0)
+    , projection(0.0f)
+    , lightCount(0)
+    , maxLightsPerCluster(0) {
+    glGenBuffers(3, buffers);
+    glGenTextures(3, textures);
+}
+
+LightClusters::~LightClusters() {
+    glDeleteBuffers(3, buffers);
+    for (GLuint texture : textures) {
+        GLState::deleteTexture(texture);
+    }
+}
+
+int LightClusters::sliceOf(float depth) const {
+    float t = std::log(depth / nearPlane) / std::log(farPlane / nearPlane);
+    int slice = static_cast<int>(std::floor(t * depthSlices));
+    return std::max(0, std::min(depthSlices - 1, slice));
+}
+
+void LightClusters::buildBounds() {
+    bounds.resize(static_cast<size_t>(tilesX) * tilesY * depthSlices);
+
+    for (int z = 0; z < depthSlices; z++) {
+        float dNear = nearPlane * std::pow(farPlane / nearPlane, static_cast<float>(z) / depthSlices);
+        float dFar = nearPlane * std::pow(farPlane / nearPlane, static_cast<float>(z + 1) / depthSlices);
+
+        for (int y = 0; y < tilesY; y++) {
+            float ndcY0 = -1.0f + 2.0f * y / tilesY;
+            float ndcY1 = -1.0f + 2.0f * (y + 1) / tilesY;
+
+            for (int x = 0; x < tilesX; x++) {
+                float ndcX0 = -1.0f + 2.0f * x / tilesX;
+                float ndcX1 = -1.0f + 2.0f * (x + 1) / tilesX;
+
+                // The cluster is a frustum slice; box its eight corners
+                ClusterBounds& box = bounds[clusterIndex(x, y, z)];
+                box.min = glm::vec3(1e30f);
+                box.max = glm::vec3(-1e30f);
+                for (float d : {dNear, dFar}) {
+                    for (float nx : {ndcX0, ndcX1}) {
+                        for (float ny : {ndcY0, ndcY1}) {
+                            glm::vec3 corner(nx * d / projection[0][0], ny * d / projection[1][1], -d);
+                            box.min = glm::min(box.min, corner);
+                            box.max = glm::max(box.max, corner);
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+void LightClusters::update(const std::vector<PointLight>& lights, const glm::mat4& view, const glm::mat4& newProjection,
+                           float newNear, float newFar, int width, int height) {
+    if (newProjection != projection || newNear != nearPlane || newFar != farPlane) {
+        projection = newProjection;
+        nearPlane = newNear;
+        farPlane = newFar;
+        buildBounds();
+    }
+    viewportWidth = width;
+    viewportHeight = height;
+
+    size_t clusterCount = bounds.size();
+    counts.assign(clusterCount, 0);
+    pairs.clear();
+    lightData.clear();
+    lightCount = static_cast<int>(lights.size());
+
+    for (int i = 0; i < lightCount; i++) {
+        const PointLight& light = lights[i];
+        lightData.push_back(glm::vec4(light.position, light.radius));
+        lightData.push_back(glm::vec4(light.color, static_cast<float>(light.shadowMap)));
+
+        glm::vec3 p = glm::vec3(view * glm::vec4(light.position, 1.0f));
+        float r = light.radius;
+        float depth = -p.z;
+        if (depth + r < nearPlane || depth - r > farPlane) continue;
+
+        float zMin = std::max(depth - r, nearPlane);
+        float zMax = std::min(depth + r, farPlane);
+
+        // Screen extent of the sphere's view-space box over the visible depth
+        // range. x / d is monotonic in both, so the corners bound it.
+        glm::vec2 ndcMin(1e30f);
+        glm::vec2 ndcMax(-1e30f);
+        for (float d : {zMin, zMax}) {
+            for (float s : {-r, r}) {
+                glm::vec2 ndc((p.x + s) * projection[0][0] / d, (p.y + s) * projection[1][1] / d);
+                ndcMin = glm::min(ndcMin, ndc);
+                ndcMax = glm::max(ndcMax, ndc);
+            }
+        }
+        if (ndcMax.x < -1.0f || ndcMin.x > 1.0f || ndcMax.y < -1.0f || ndcMin.y > 1.0f) continue;
+
+        auto tileOf = [](float ndc, int tiles) {
+            int tile = static_cast<int>(std::floor((ndc + 1.0f) * 0.5f * tiles));
+            return std::max(0, std::min(tiles - 1, tile));
+        };
+        int x0 = tileOf(ndcMin.x, tilesX), x1 = tileOf(ndcMax.x, tilesX);
+        int y0 = tileOf(ndcMin.y, tilesY), y1 = tileOf(ndcMax.y, tilesY);
+        int z0 = sliceOf(zMin), z1 = sliceOf(zMax);
+
+        for (int z = z0; z <= z1; z++) {
+            for (int y = y0; y <= y1; y++) {
+                for (int x = x0; x <= x1; x++) {
+                    int cluster = clusterIndex(x, y, z);
+                    const ClusterBounds& box = bounds[cluster];
+                    glm::vec3 closest = glm::clamp(p, box.min, box.max);
+                    glm::vec3 offset = closest - p;
+                    if (glm::dot(offset, offset) > r * r) continue;
+
+                    pairs.push_back({cluster, i});
+                    counts[cluster]++;
+                }
+            }
+        }
+    }
+
+    // Counting sort of the (cluster, light) pairs into one index list
+    grid.resize(clusterCount * 2);
+    unsigned int offset = 0;
+    maxLightsPerCluster = 0;
+    for (size_t c = 0; c < clusterCount; c++) {
+        grid[c * 2] = offset;
+        grid[c * 2 + 1] = 0;
+        offset += counts[c];
+        maxLightsPerCluster = std::max(maxLightsPerCluster, static_cast<int>(counts[c]));
+    }
+    indices.resize(std::max<size_t>(pairs.size(), 1));
+    for (const auto& pair : pairs) {
+        unsigned int& count = grid[pair.first * 2 + 1];
+        indices[grid[pair.first * 2] + count] = static_cast<unsigned int>(pair.second);
+        count++;
+    }
+
+    // A zero-sized buffer texture is not allowed to be fetched from, so an
+    // empty light list still uploads one texel that no cluster points to
+    if (lightData.empty()) lightData.push_back(glm::vec4(0.0f));
+
+    upload(0, GL_RGBA32F, lightData.data(), lightData.size() * sizeof(glm::vec4));
+    upload(1, GL_RG32UI, grid.data(), grid.size() * sizeof(unsigned int));
+    upload(2, GL_R32UI, indices.data(), indices.size() * sizeof(unsigned int));
+}
+
+void LightClusters::upload(int slot, GLenum format, const void* data, GLsizeiptr size) {
+    // Orphan and refill; the texture keeps pointing at the same buffer name
+    glBindBuffer(GL_TEXTURE_BUFFER, buffers[slot]);
+    glBufferData(GL_TEXTURE_BUFFER, size, data, GL_STREAM_DRAW);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+    GLState::bindTexture(LIGHT_UNIT + slot, GL_TEXTURE_BUFFER, textures[slot]);
+    glTexBuffer(GL_TEXTURE_BUFFER, format, buffers[slot]);
+}
+
+void LightClusters::bind(Shader& shader) const {
+    GLState::bindTexture(LIGHT_UNIT, GL_TEXTURE_BUFFER, textures[0]);
+    GLState::bindTexture(GRID_UNIT, GL_TEXTURE_BUFFER, textures[1]);
+    GLState::bindTexture(INDEX_UNIT, GL_TEXTURE_BUFFER, textures[2]);
+
+    shader.setInt("lightData", LIGHT_UNIT);
+    shader.setInt("clusterGrid", GRID_UNIT);
+    shader.setInt("clusterLights", INDEX_UNIT);
+
+    glUniform3i(glGetUniformLocation(shader.ID, "clusterDims"), tilesX, tilesY, depthSlices);
+    shader.setVec2("clusterTileSize", glm::vec2(static_cast<float>(viewportWidth) / tilesX,
+                                                static_cast<float>(viewportHeight) / tilesY));
+
+    // slice = log(depth) * scale + bias, matching sliceOf()
+    float scale = depthSlices / std::log(farPlane / nearPlane);
+    shader.setVec2("clusterDepthParams", glm::vec2(scale, -std::log(nearPlane) * scale));
+}
+
+float LightClusters::getAverageLightsPerCluster() const {
+    // Over clusters that hold any light, i.e. what a lit fragment pays
+    size_t occupied = 0;
+    for (unsigned int count : counts) {
+        if (count > 0) occupied++;
+    }
+    return occupied == 0 ? 0.0f : static_cast<float>(pairs.size()) / occupied;
+}
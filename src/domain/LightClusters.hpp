@@ -0,0 +1,83 @@
+#ifndef LIGHT_CLUSTERS_H
+#define LIGHT_CLUSTERS_H
+
+#include "glad/glad.h"
+#include "Shader.hpp"
+#include <glm/glm.hpp>
+#include <vector>
+
+// Clustered forward lighting.
+// The view frustum is split into tilesX x tilesY screen tiles and depthSlices
+// exponentially spaced depth slices. Every frame each point light is binned on
+// the CPU into the clusters its sphere touches, and the result is uploaded as
+// three texture buffers (lights, per-cluster offset/count, light indices) so a
+// GL 3.3 fragment shader can loop over just the lights of its own cluster.
+class LightClusters {
+public:
+    struct PointLight {
+        glm::vec3 position;     // world space
+        float radius;           // contribution is zero beyond this distance
+        glm::vec3 color;        // already scaled by intensity
+        int shadowMap = -1;     // ShadowCache slot, -1 for an unshadowed light
+    };
+
+    // Texture units used by bind(); unit 0 stays free for the diffuse map
+    static const int LIGHT_UNIT = 5;
+    static const int GRID_UNIT = 6;
+    static const int INDEX_UNIT = 7;
+
+    LightClusters(int tilesX = 16, int tilesY = 9, int depthSlices = 24);
+    ~LightClusters();
+
+    LightClusters(const LightClusters&) = delete;
+    LightClusters& operator=(const LightClusters&) = delete;
+
+    // projection must be a symmetric perspective with the given near/far
+    void update(const std::vector<PointLight>& lights, const glm::mat4& view, const glm::mat4& projection,
+                float nearPlane, float farPlane, int viewportWidth, int viewportHeight);
+
+    // Binds the buffers and sets the cluster uniforms on an active shader
+    void bind(Shader& shader) const;
+
+    int getLightCount() const { return lightCount; }
+    float getAverageLightsPerCluster() const;
+    int getMaxLightsPerCluster() const { return maxLightsPerCluster; }
+
+private:
+    struct ClusterBounds {
+        glm::vec3 min;
+        glm::vec3 max;
+    };
+
+    int tilesX;
+    int tilesY;
+    int depthSlices;
+
+    float nearPlane;
+    float farPlane;
+    int viewportWidth;
+    int viewportHeight;
+    glm::mat4 projection;
+
+    // View-space boxes, rebuilt only when the projection or viewport changes
+    std::vector<ClusterBounds> bounds;
+
+    std::vector<glm::vec4> lightData;            // 2 texels per light
+    std::vector<unsigned int> grid;              // offset, count per cluster
+    std::vector<unsigned int> indices;
+    std::vector<std::pair<int, int>> pairs;      // cluster, light
+    std::vector<unsigned int> counts;
+
+    int lightCount;
+    int maxLightsPerCluster;
+
+    GLuint buffers[3];
+    GLuint textures[3];
+
+    int clusterIndex(int x, int y, int z) const { return (z * tilesY + y) * tilesX + x; }
+    int sliceOf(float depth) const;
+    void buildBounds();
+    void upload(int slot, GLenum format, const void* data, GLsizeiptr size);
+};
+
+#endif
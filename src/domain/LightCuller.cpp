@@ -0,0 +1,57 @@
+#include "LightCuller.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    float peakOf(const glm::vec3& color, float intensity) {
+        return intensity * std::max(std::max(color.x, color.y), color.z);
+    }
+}
+
+LightCuller::LightCuller(const Attenuation& attenuation, float threshold)
+    : attenuation(attenuation)
+    , threshold(threshold) {
+}
+
+void LightCuller::clear() {
+    lights.clear();
+}
+
+void LightCuller::add(const glm::vec3& position, const glm::vec3& color, float intensity) {
+    lights.push_back({position, color, intensity, radiusFor(color, intensity)});
+}
+
+float LightCuller::radiusFor(const glm::vec3& color, float intensity) const {
+    float peak = peakOf(color, intensity);
+    if (peak <= 0.0f) return 0.0f;
+
+    // Solve quadratic * d^2 + linear * d + (constant - peak / threshold) = 0
+    float c = attenuation.constant - peak / threshold;
+    if (c >= 0.0f) return 0.0f;
+    if (attenuation.quadratic <= 0.0f) {
+        return attenuation.linear > 0.0f ? -c / attenuation.linear : INFINITY;
+    }
+    float discriminant = attenuation.linear * attenuation.linear - 4.0f * attenuation.quadratic * c;
+    return (-attenuation.linear + std::sqrt(discriminant)) / (2.0f * attenuation.quadratic);
+}
+
+void LightCuller::select(const AABB& box, size_t maxLights, std::vector<int>& result) const {
+    result.clear();
+    candidates.clear();
+
+    for (size_t i = 0; i < lights.size(); i++) {
+        const Light& light = lights[i];
+        glm::vec3 closest = glm::clamp(light.position, box.min, box.max);
+        float distance = glm::length(closest - light.position);
+        if (distance > light.radius) continue;
+
+        candidates.push_back({peakOf(light.color, light.intensity) * attenuation.at(distance), static_cast<int>(i)});
+    }
+
+    size_t count = std::min(maxLights, candidates.size());
+    std::partial_sort(candidates.begin(), candidates.begin() + count, candidates.end(),
+                      [](const std::pair<float, int>& a, const std::pair<float, int>& b) { return a.first > b.first; });
+    for (size_t i = 0; i < count; i++) {
+        result.push_back(candidates[i].second);
+    }
+}
@@ -0,0 +1,57 @@
+#ifndef LIGHT_CULLER_H
+#define LIGHT_CULLER_H
+
+#include "Bounds.hpp"
+#include <glm/glm.hpp>
+#include <vector>
+
+// Per-object light selection for shaders with a small fixed light array.
+// Each light gets the distance at which its attenuated brightness falls under
+// a threshold; an object only receives lights whose sphere touches its
+// bounds, strongest first, up to the shader's cap.
+class LightCuller {
+public:
+    // 1 / (constant + linear * d + quadratic * d^2)
+    struct Attenuation {
+        float constant;
+        float linear;
+        float quadratic;
+
+        Attenuation(float constant = 1.0f, float linear = 0.09f, float quadratic = 0.032f)
+            : constant(constant), linear(linear), quadratic(quadratic) {}
+
+        float at(float distance) const { return 1.0f / (constant + linear * distance + quadratic * distance * distance); }
+    };
+
+    struct Light {
+        glm::vec3 position;
+        glm::vec3 color;
+        float intensity;
+        float radius;
+    };
+
+    // The default threshold of 5/256 is the usual light-volume cut-off: a few
+    // 8-bit steps, too dark to notice next to the ambient term
+    explicit LightCuller(const Attenuation& attenuation = Attenuation(), float threshold = 5.0f / 256.0f);
+
+    void clear();
+    void add(const glm::vec3& position, const glm::vec3& color, float intensity);
+
+    // Distance at which intensity * max(color) * attenuation reaches the threshold
+    float radiusFor(const glm::vec3& color, float intensity) const;
+
+    // Indices of up to maxLights lights reaching the box, by descending
+    // estimated contribution at the box's closest point
+    void select(const AABB& box, size_t maxLights, std::vector<int>& result) const;
+
+    const std::vector<Light>& getLights() const { return lights; }
+    const Attenuation& getAttenuation() const { return attenuation; }
+
+private:
+    Attenuation attenuation;
+    float threshold;
+    std::vector<Light> lights;
+    mutable std::vector<std::pair<float, int>> candidates;
+};
+
+#endif
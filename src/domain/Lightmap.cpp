@@ -0,0 +1,123 @@
+#include "Lightmap.hpp"
+#include "GLState.hpp"
+#include "Logger.hpp"
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+
+namespace {
+    const char MAGIC[4] = {'L', 'M', 'A', 'P'};
+    const uint32_t VERSION = 1;
+
+    // Matrices and light positions round-trip through JSON floats, so allow for
+    // the last few bits differing
+    const float TOLERANCE = 1e-4f;
+
+    template <typename T>
+    void write(std::ofstream& file, const T& value) {
+        file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    template <typename T>
+    bool read(std::ifstream& file, T& value) {
+        return static_cast<bool>(file.read(reinterpret_cast<char*>(&value), sizeof(T)));
+    }
+
+    bool close(const glm::vec3& a, const glm::vec3& b) {
+        glm::vec3 d = glm::abs(a - b);
+        return d.x <= TOLERANCE && d.y <= TOLERANCE && d.z <= TOLERANCE;
+    }
+}
+
+bool Lightmap::save(const std::string& path) const {
+    std::ofstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        LOG_ERROR("Could not write lightmap: " << path);
+        return false;
+    }
+
+    file.write(MAGIC, sizeof(MAGIC));
+    write(file, VERSION);
+    write(file, static_cast<uint32_t>(width));
+    write(file, static_cast<uint32_t>(height));
+    write(file, model);
+
+    write(file, static_cast<uint32_t>(lights.size()));
+    for (const auto& light : lights) {
+        write(file, light.position);
+        write(file, light.radius);
+        write(file, light.color);
+    }
+
+    write(file, static_cast<uint32_t>(uvs.size()));
+    file.write(reinterpret_cast<const char*>(uvs.data()), uvs.size() * sizeof(glm::vec2));
+    file.write(reinterpret_cast<const char*>(texels.data()), texels.size() * sizeof(glm::vec4));
+    return static_cast<bool>(file);
+}
+
+bool Lightmap::load(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) return false;
+
+    char magic[4];
+    uint32_t version = 0;
+    if (!file.read(magic, sizeof(magic)) || std::memcmp(magic, MAGIC, sizeof(MAGIC)) != 0 ||
+        !read(file, version) || version != VERSION) {
+        LOG_ERROR("Not a lightmap (or an older format): " << path);
+        return false;
+    }
+
+    uint32_t w = 0, h = 0, lightCount = 0, uvCount = 0;
+    if (!read(file, w) || !read(file, h) || !read(file, model) || !read(file, lightCount)) return false;
+
+    lights.resize(lightCount);
+    for (auto& light : lights) {
+        if (!read(file, light.position) || !read(file, light.radius) || !read(file, light.color)) return false;
+        light.shadowMap = -1;
+    }
+
+    if (!read(file, uvCount)) return false;
+    width = static_cast<int>(w);
+    height = static_cast<int>(h);
+    uvs.resize(uvCount);
+    texels.resize(static_cast<size_t>(w) * h);
+    file.read(reinterpret_cast<char*>(uvs.data()), uvs.size() * sizeof(glm::vec2));
+    file.read(reinterpret_cast<char*>(texels.data()), texels.size() * sizeof(glm::vec4));
+    if (!file) {
+        LOG_ERROR("Truncated lightmap: " << path);
+        return false;
+    }
+    return true;
+}
+
+GLuint Lightmap::createTexture() const {
+    GLuint texture;
+    glGenTextures(1, &texture);
+    GLState::bindTexture(0, GL_TEXTURE_2D, texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, width, height, 0, GL_RGBA, GL_FLOAT, texels.data());
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    return texture;
+}
+
+bool Lightmap::matches(const std::vector<LightClusters::PointLight>& current) const {
+    if (current.size() != lights.size()) return false;
+    for (size_t i = 0; i < lights.size(); i++) {
+        if (!close(current[i].position, lights[i].position) || !close(current[i].color, lights[i].color) ||
+            std::abs(current[i].radius - lights[i].radius) > TOLERANCE) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Lightmap::matches(const glm::mat4& currentModel) const {
+    for (int column = 0; column < 4; column++) {
+        glm::vec4 d = glm::abs(currentModel[column] - model[column]);
+        if (d.x > TOLERANCE || d.y > TOLERANCE || d.z > TOLERANCE || d.w > TOLERANCE) return false;
+    }
+    return true;
+}
@@ -0,0 +1,36 @@
+#ifndef LIGHTMAP_H
+#define LIGHTMAP_H
+
+#include "glad/glad.h"
+#include "LightClusters.hpp"
+#include <glm/glm.hpp>
+#include <string>
+#include <vector>
+
+// Baked lighting for one static scene object, written by BakeLightmaps and
+// sampled by scene.frag instead of looping over the lights. Besides the texels
+// it keeps what the bake depended on, so the viewer can tell when it no
+// longer matches the scene: the object's model matrix and the lights.
+struct Lightmap {
+    int width = 0;
+    int height = 0;
+    glm::mat4 model = glm::mat4(1.0f);
+    std::vector<LightClusters::PointLight> lights;
+
+    // Second UV set, one per vertex of TexturedObj::getVertices()
+    std::vector<glm::vec2> uvs;
+    // rgb: direct light reaching the surface (before kd and albedo), a: ambient occlusion
+    std::vector<glm::vec4> texels;
+
+    bool save(const std::string& path) const;
+    bool load(const std::string& path);
+
+    // RGBA16F, linearly filtered. The caller owns the texture.
+    GLuint createTexture() const;
+
+    // Whether a light list (e.g. this frame's) still matches the baked one
+    bool matches(const std::vector<LightClusters::PointLight>& current) const;
+    bool matches(const glm::mat4& currentModel) const;
+};
+
+#endif
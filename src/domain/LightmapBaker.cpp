@@ -0,0 +1,409 @@
+#include "LightmapBaker.hpp"
+#include "Logger.hpp"
+#include <glm/gtc/constants.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+
+namespace {
+    // The two axes left after flattening along axis
+    glm::vec2 project(const glm::vec3& p, int axis) {
+        return glm::vec2(p[(axis + 1) % 3], p[(axis + 2) % 3]);
+    }
+
+    // Cheap deterministic per-texel random numbers, so results don't depend
+    // on which thread baked a texel
+    unsigned int hash(unsigned int x) {
+        x ^= x >> 16;
+        x *= 0x7feb352dU;
+        x ^= x >> 15;
+        x *= 0x846ca68bU;
+        x ^= x >> 16;
+        return x;
+    }
+
+    struct Random {
+        unsigned int state;
+
+        explicit Random(unsigned int seed) : state(hash(seed) | 1U) {}
+
+        float next() {
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            return (state >> 8) * (1.0f / 16777216.0f);
+        }
+    };
+}
+
+LightmapBaker::LightmapBaker(const Settings& settings)
+    : settings(settings)
+    , rayOffset(1e-4f) {}
+
+int LightmapBaker::addMesh(const std::vector<TextureVertex>& vertices, const glm::mat4& model) {
+    Mesh mesh;
+    mesh.model = model;
+    glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(model)));
+
+    mesh.positions.reserve(vertices.size());
+    mesh.normals.reserve(vertices.size());
+    for (const TextureVertex& vertex : vertices) {
+        mesh.positions.push_back(glm::vec3(model * glm::vec4(vertex.position, 1.0f)));
+        glm::vec3 normal = normalMatrix * vertex.normal;
+        float length = glm::length(normal);
+        mesh.normals.push_back(length > 0.0f ? normal / length : glm::vec3(0.0f, 1.0f, 0.0f));
+    }
+
+    meshes.push_back(std::move(mesh));
+    return static_cast<int>(meshes.size()) - 1;
+}
+
+void LightmapBaker::setLights(const std::vector<LightClusters::PointLight>& newLights) {
+    lights = newLights;
+    for (auto& light : lights) {
+        light.shadowMap = -1;
+    }
+}
+
+std::vector<LightmapBaker::Chart> LightmapBaker::buildCharts(const Mesh& mesh) const {
+    int triangleCount = static_cast<int>(mesh.positions.size() / 3);
+
+    // The mesh is a triangle soup, so weld corners by quantized position to
+    // find which triangles share an edge
+    AABB bounds = AABB::fromPoints(mesh.positions);
+    float quantum = std::max(glm::length(bounds.max - bounds.min) * 1e-6f, 1e-7f);
+    std::unordered_map<uint64_t, int> ids;
+    std::vector<int> corner(mesh.positions.size());
+    for (size_t i = 0; i < mesh.positions.size(); i++) {
+        glm::vec3 q = glm::floor((mesh.positions[i] - bounds.min) / quantum + 0.5f);
+        uint64_t key = (static_cast<uint64_t>(q.x) & 0x1fffff) | ((static_cast<uint64_t>(q.y) & 0x1fffff) << 21) |
+                       ((static_cast<uint64_t>(q.z) & 0x1fffff) << 42);
+        auto inserted = ids.insert({key, static_cast<int>(ids.size())});
+        corner[i] = inserted.first->second;
+    }
+
+    std::vector<int> axisKey(triangleCount);
+    std::vector<std::pair<uint64_t, int>> edges;
+    edges.reserve(mesh.positions.size());
+    for (int t = 0; t < triangleCount; t++) {
+        const glm::vec3& a = mesh.positions[t * 3];
+        glm::vec3 normal = glm::cross(mesh.positions[t * 3 + 1] - a, mesh.positions[t * 3 + 2] - a);
+        if (glm::dot(normal, normal) == 0.0f) {
+            normal = mesh.normals[t * 3] + mesh.normals[t * 3 + 1] + mesh.normals[t * 3 + 2];
+        }
+        glm::vec3 magnitude = glm::abs(normal);
+        int axis = magnitude.x >= magnitude.y && magnitude.x >= magnitude.z ? 0 : (magnitude.y >= magnitude.z ? 1 : 2);
+        // Opposite facing sides (the two faces of a wall) never share a chart
+        axisKey[t] = axis * 2 + (normal[axis] < 0.0f ? 1 : 0);
+
+        for (int e = 0; e < 3; e++) {
+            uint64_t v0 = static_cast<uint64_t>(corner[t * 3 + e]);
+            uint64_t v1 = static_cast<uint64_t>(corner[t * 3 + (e + 1) % 3]);
+            if (v0 == v1) continue;
+            edges.push_back({std::min(v0, v1) << 32 | std::max(v0, v1), t});
+        }
+    }
+    std::sort(edges.begin(), edges.end());
+
+    std::vector<std::vector<int>> neighbours(triangleCount);
+    for (size_t i = 0; i < edges.size();) {
+        size_t j = i;
+        while (j < edges.size() && edges[j].first == edges[i].first) j++;
+        for (size_t a = i; a < j; a++) {
+            for (size_t b = a + 1; b < j; b++) {
+                neighbours[edges[a].second].push_back(edges[b].second);
+                neighbours[edges[b].second].push_back(edges[a].second);
+            }
+        }
+        i = j;
+    }
+
+    // Flood fill across shared edges within one axis key
+    std::vector<Chart> charts;
+    std::vector<int> chartOf(triangleCount, -1);
+    std::vector<int> stack;
+    for (int seed = 0; seed < triangleCount; seed++) {
+        if (chartOf[seed] >= 0) continue;
+
+        Chart chart;
+        chart.axis = axisKey[seed] / 2;
+        int chartIndex = static_cast<int>(charts.size());
+        chartOf[seed] = chartIndex;
+        stack.push_back(seed);
+        while (!stack.empty()) {
+            int t = stack.back();
+            stack.pop_back();
+            chart.triangles.push_back(t);
+            for (int n : neighbours[t]) {
+                if (chartOf[n] >= 0 || axisKey[n] != axisKey[seed]) continue;
+                chartOf[n] = chartIndex;
+                stack.push_back(n);
+            }
+        }
+
+        chart.min = glm::vec2(1e30f);
+        chart.max = glm::vec2(-1e30f);
+        for (int t : chart.triangles) {
+            for (int c = 0; c < 3; c++) {
+                glm::vec2 p = project(mesh.positions[t * 3 + c], chart.axis);
+                chart.min = glm::min(chart.min, p);
+                chart.max = glm::max(chart.max, p);
+            }
+        }
+        charts.push_back(std::move(chart));
+    }
+    return charts;
+}
+
+// Shelf packing, tallest charts first. Fails if the charts don't fit in size x size.
+bool LightmapBaker::pack(std::vector<Chart>& charts, float density, int size) const {
+    std::vector<int> order(charts.size());
+    for (size_t i = 0; i < charts.size(); i++) {
+        Chart& chart = charts[i];
+        glm::vec2 extent = (chart.max - chart.min) * density;
+        // +1 so the texel centres at both ends of the chart stay inside it
+        chart.size = glm::ivec2(static_cast<int>(std::ceil(extent.x)) + 1 + 2 * settings.padding,
+                                static_cast<int>(std::ceil(extent.y)) + 1 + 2 * settings.padding);
+        order[i] = static_cast<int>(i);
+    }
+    std::sort(order.begin(), order.end(), [&](int a, int b) {
+        return charts[a].size.y > charts[b].size.y;
+    });
+
+    int x = 0, y = 0, shelfHeight = 0;
+    for (int index : order) {
+        Chart& chart = charts[index];
+        if (chart.size.x > size) return false;
+        if (x + chart.size.x > size) {
+            x = 0;
+            y += shelfHeight;
+            shelfHeight = 0;
+        }
+        if (y + chart.size.y > size) return false;
+
+        chart.origin = glm::ivec2(x, y);
+        x += chart.size.x;
+        shelfHeight = std::max(shelfHeight, chart.size.y);
+    }
+    return true;
+}
+
+bool LightmapBaker::unwrap(const Mesh& mesh, Lightmap& lightmap, std::vector<Sample>& samples) const {
+    std::vector<Chart> charts = buildCharts(mesh);
+
+    // Smallest power of two atlas at the requested density, then lower density.
+    // The gutters alone can overflow the atlas when there are very many charts.
+    float density = settings.texelsPerUnit;
+    int size = 32;
+    while (!pack(charts, density, size)) {
+        if (size < settings.maxSize) {
+            size *= 2;
+        } else if (density > settings.texelsPerUnit * 1e-3f) {
+            density *= 0.85f;
+        } else {
+            LOG_ERROR("  " << charts.size() << " charts don't fit in " << size << "x" << size);
+            return false;
+        }
+    }
+    if (density < settings.texelsPerUnit) {
+        LOG_INFO("  density lowered to " << density << " texels/unit to fit " << size << "x" << size);
+    }
+
+    lightmap.width = size;
+    lightmap.height = size;
+    lightmap.uvs.assign(mesh.positions.size(), glm::vec2(0.0f));
+    samples.assign(static_cast<size_t>(size) * size, Sample());
+
+    for (const Chart& chart : charts) {
+        glm::vec2 base = glm::vec2(chart.origin) + glm::vec2(settings.padding + 0.5f);
+        for (int t : chart.triangles) {
+            glm::vec2 texel[3];
+            for (int c = 0; c < 3; c++) {
+                texel[c] = base + (project(mesh.positions[t * 3 + c], chart.axis) - chart.min) * density;
+                lightmap.uvs[t * 3 + c] = texel[c] / static_cast<float>(size);
+            }
+
+            const glm::vec3& p0 = mesh.positions[t * 3];
+            glm::vec3 faceNormal = glm::cross(mesh.positions[t * 3 + 1] - p0, mesh.positions[t * 3 + 2] - p0);
+            float faceLength = glm::length(faceNormal);
+            if (faceLength == 0.0f) continue;
+            faceNormal /= faceLength;
+
+            // Texels whose centre falls inside the triangle sample it
+            float area = (texel[1].x - texel[0].x) * (texel[2].y - texel[0].y) -
+                         (texel[2].x - texel[0].x) * (texel[1].y - texel[0].y);
+            if (std::abs(area) < 1e-12f) continue;
+
+            glm::vec2 lo = glm::min(texel[0], glm::min(texel[1], texel[2]));
+            glm::vec2 hi = glm::max(texel[0], glm::max(texel[1], texel[2]));
+            int x0 = std::max(0, static_cast<int>(std::floor(lo.x - 0.5f)));
+            int y0 = std::max(0, static_cast<int>(std::floor(lo.y - 0.5f)));
+            int x1 = std::min(size - 1, static_cast<int>(std::ceil(hi.x - 0.5f)));
+            int y1 = std::min(size - 1, static_cast<int>(std::ceil(hi.y - 0.5f)));
+            for (int y = y0; y <= y1; y++) {
+                for (int x = x0; x <= x1; x++) {
+                    glm::vec2 p(x + 0.5f, y + 0.5f);
+                    float w0 = ((texel[1].x - p.x) * (texel[2].y - p.y) - (texel[2].x - p.x) * (texel[1].y - p.y)) / area;
+                    float w1 = ((texel[2].x - p.x) * (texel[0].y - p.y) - (texel[0].x - p.x) * (texel[2].y - p.y)) / area;
+                    float w2 = 1.0f - w0 - w1;
+                    if (w0 < -1e-4f || w1 < -1e-4f || w2 < -1e-4f) continue;
+
+                    Sample& sample = samples[static_cast<size_t>(y) * size + x];
+                    sample.position = mesh.positions[t * 3] * w0 + mesh.positions[t * 3 + 1] * w1 +
+                                      mesh.positions[t * 3 + 2] * w2;
+                    glm::vec3 normal = mesh.normals[t * 3] * w0 + mesh.normals[t * 3 + 1] * w1 +
+                                       mesh.normals[t * 3 + 2] * w2;
+                    float length = glm::length(normal);
+                    sample.normal = length > 0.0f ? normal / length : faceNormal;
+                    sample.faceNormal = glm::dot(faceNormal, sample.normal) < 0.0f ? -faceNormal : faceNormal;
+                    sample.covered = true;
+                }
+            }
+        }
+    }
+
+    LOG_INFO("  " << charts.size() << " charts in " << size << "x" << size);
+    return true;
+}
+
+glm::vec4 LightmapBaker::shade(const Sample& sample, unsigned int seed) const {
+    // Rays leave from just above the actual face so they don't hit it
+    glm::vec3 origin = sample.position + sample.faceNormal * rayOffset;
+    const glm::vec3& N = sample.normal;
+
+    glm::vec3 direct(0.0f);
+    for (const auto& light : lights) {
+        glm::vec3 toLight = light.position - sample.position;
+        float distance = glm::length(toLight);
+        if (distance >= light.radius || distance <= 0.0f) continue;
+
+        float ratio = distance / light.radius;
+        float window = glm::clamp(1.0f - ratio * ratio * ratio * ratio, 0.0f, 1.0f);
+        window *= window;
+        float diffuse = std::max(glm::dot(N, toLight / distance), 0.0f);
+        if (diffuse * window <= 0.0f) continue;
+
+        glm::vec3 ray = light.position - origin;
+        float rayLength = glm::length(ray);
+        if (bvh.occluded(origin, ray / rayLength, rayLength - rayOffset)) continue;
+        direct += light.color * diffuse * window;
+    }
+
+    // Cosine-weighted hemisphere around the shading normal, stratified in elevation
+    glm::vec3 helper = std::abs(N.x) < 0.9f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+    glm::vec3 tangent = glm::normalize(glm::cross(helper, N));
+    glm::vec3 bitangent = glm::cross(N, tangent);
+
+    Random random(seed);
+    int hits = 0;
+    for (int s = 0; s < settings.aoSamples; s++) {
+        float u = (s + random.next()) / settings.aoSamples;
+        float phi = glm::two_pi<float>() * random.next();
+        float r = std::sqrt(u);
+        glm::vec3 direction = tangent * (r * std::cos(phi)) + bitangent * (r * std::sin(phi)) + N * std::sqrt(1.0f - u);
+        // Directions under the real face would start inside the surface
+        if (glm::dot(direction, sample.faceNormal) <= 0.0f) continue;
+        if (bvh.occluded(origin, direction, settings.aoDistance)) hits++;
+    }
+    float occlusion = settings.aoSamples > 0 ? 1.0f - static_cast<float>(hits) / settings.aoSamples : 1.0f;
+
+    return glm::vec4(direct, occlusion);
+}
+
+// Grows covered texels outwards a ring at a time by averaging their covered neighbours
+void LightmapBaker::dilate(Lightmap& lightmap, std::vector<Sample>& samples) const {
+    int w = lightmap.width;
+    int h = lightmap.height;
+    std::vector<std::pair<int, glm::vec4>> grown;
+
+    for (int ring = 0; ring <= settings.padding; ring++) {
+        grown.clear();
+        for (int y = 0; y < h; y++) {
+            for (int x = 0; x < w; x++) {
+                if (samples[y * w + x].covered) continue;
+
+                glm::vec4 sum(0.0f);
+                int count = 0;
+                for (int dy = -1; dy <= 1; dy++) {
+                    for (int dx = -1; dx <= 1; dx++) {
+                        int nx = x + dx, ny = y + dy;
+                        if (nx < 0 || ny < 0 || nx >= w || ny >= h || !samples[ny * w + nx].covered) continue;
+                        sum += lightmap.texels[ny * w + nx];
+                        count++;
+                    }
+                }
+                if (count > 0) grown.push_back({y * w + x, sum / static_cast<float>(count)});
+            }
+        }
+        for (const auto& texel : grown) {
+            lightmap.texels[texel.first] = texel.second;
+            samples[texel.first].covered = true;
+        }
+    }
+}
+
+void LightmapBaker::bake(std::vector<Lightmap>& results) {
+    std::vector<glm::vec3> scene;
+    for (const Mesh& mesh : meshes) {
+        scene.insert(scene.end(), mesh.positions.begin(), mesh.positions.end());
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    bvh.build(scene);
+    const AABB& bounds = bvh.getBounds();
+    rayOffset = std::max(glm::length(bounds.max - bounds.min) * 1e-4f, 1e-4f);
+    LOG_INFO("BVH: " << bvh.getTriangleCount() << " triangles, " << bvh.getNodeCount() << " nodes in "
+             << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count()
+             << " ms");
+
+    int threadCount = settings.threads > 0 ? settings.threads : static_cast<int>(std::thread::hardware_concurrency());
+    threadCount = std::max(threadCount, 1);
+
+    results.clear();
+    results.resize(meshes.size());
+    for (size_t m = 0; m < meshes.size(); m++) {
+        start = std::chrono::steady_clock::now();
+        LOG_INFO("Mesh " << m << ": " << meshes[m].positions.size() / 3 << " triangles");
+
+        Lightmap& lightmap = results[m];
+        lightmap.model = meshes[m].model;
+        lightmap.lights = lights;
+
+        std::vector<Sample> samples;
+        if (!unwrap(meshes[m], lightmap, samples)) {
+            lightmap = Lightmap();
+            continue;
+        }
+        lightmap.texels.assign(samples.size(), glm::vec4(0.0f));
+
+        // Rows are handed out one at a time so threads finish together
+        std::atomic<int> nextRow(0);
+        auto worker = [&]() {
+            for (int y = nextRow++; y < lightmap.height; y = nextRow++) {
+                for (int x = 0; x < lightmap.width; x++) {
+                    size_t index = static_cast<size_t>(y) * lightmap.width + x;
+                    if (!samples[index].covered) continue;
+                    lightmap.texels[index] = shade(samples[index], static_cast<unsigned int>(index * 9781 + m * 6271));
+                }
+            }
+        };
+        std::vector<std::thread> threads;
+        for (int t = 1; t < threadCount; t++) {
+            threads.emplace_back(worker);
+        }
+        worker();
+        for (auto& thread : threads) {
+            thread.join();
+        }
+
+        dilate(lightmap, samples);
+        LOG_INFO("  baked on " << threadCount << " threads in "
+                 << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count()
+                 << " ms");
+    }
+}
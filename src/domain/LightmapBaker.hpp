@@ -0,0 +1,89 @@
+#ifndef LIGHTMAP_BAKER_H
+#define LIGHTMAP_BAKER_H
+
+#include "LightClusters.hpp"
+#include "Lightmap.hpp"
+#include "TextureVertex.hpp"
+#include "TriangleBVH.hpp"
+#include <glm/glm.hpp>
+#include <vector>
+
+// CPU baker for static lighting.
+// Each mesh gets a second UV set: triangles are grouped into charts of
+// connected faces that share a dominant normal axis, every chart is flattened
+// along that axis at a fixed texel density and the charts are shelf-packed
+// into the mesh's own atlas with a gutter between them. Every covered texel is
+// then ray traced against a BVH of all static meshes on all cores: direct
+// light from each point light with hard shadows, and ambient occlusion from
+// cosine-distributed hemisphere rays. Finally texels are dilated into the
+// gutters so bilinear filtering doesn't pull in black at chart edges.
+class LightmapBaker {
+public:
+    struct Settings {
+        float texelsPerUnit;    // atlas density in world units, lowered if an atlas would exceed maxSize
+        int maxSize;
+        int padding;            // gutter texels around each chart
+        int aoSamples;
+        float aoDistance;       // occluders further than this don't darken
+        int threads;            // 0: one per hardware thread
+
+        Settings()
+            : texelsPerUnit(8.0f)
+            , maxSize(1024)
+            , padding(2)
+            , aoSamples(64)
+            , aoDistance(2.0f)
+            , threads(0) {}
+    };
+
+    explicit LightmapBaker(const Settings& settings = Settings());
+
+    // Static meshes occlude each other and each get a lightmap. vertices is a
+    // non-indexed triangle list in model space (TexturedObj::getVertices()).
+    int addMesh(const std::vector<TextureVertex>& vertices, const glm::mat4& model);
+
+    // Lit exactly like scene.frag: radius window, no falloff beyond it
+    void setLights(const std::vector<LightClusters::PointLight>& lights);
+
+    // One lightmap per added mesh, in order. A mesh that couldn't be unwrapped
+    // gets an empty one (width 0).
+    void bake(std::vector<Lightmap>& results);
+
+private:
+    struct Mesh {
+        glm::mat4 model;
+        std::vector<glm::vec3> positions;   // world space
+        std::vector<glm::vec3> normals;     // world space, per vertex
+    };
+
+    // World-space sample of a texel, or an uncovered texel if !covered
+    struct Sample {
+        glm::vec3 position;
+        glm::vec3 normal;
+        glm::vec3 faceNormal;
+        bool covered = false;
+    };
+
+    struct Chart {
+        std::vector<int> triangles;
+        int axis;                   // dominant normal axis, the one flattened away
+        glm::vec2 min;              // extent in the projected plane, world units
+        glm::vec2 max;
+        glm::ivec2 origin;          // placement in the atlas, texels
+        glm::ivec2 size;
+    };
+
+    Settings settings;
+    std::vector<Mesh> meshes;
+    std::vector<LightClusters::PointLight> lights;
+    TriangleBVH bvh;
+    float rayOffset;
+
+    std::vector<Chart> buildCharts(const Mesh& mesh) const;
+    bool pack(std::vector<Chart>& charts, float density, int size) const;
+    bool unwrap(const Mesh& mesh, Lightmap& lightmap, std::vector<Sample>& samples) const;
+    glm::vec4 shade(const Sample& sample, unsigned int seed) const;
+    void dilate(Lightmap& lightmap, std::vector<Sample>& samples) const;
+};
+
+#endif
@@ -0,0 +1,198 @@
+#include "Logger.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include <string>
+#include <utility>
+
+namespace {
+    const auto IDLE_WAIT = std::chrono::milliseconds(2);
+
+    const std::pair<const char*, LogLevel> LEVEL_NAMES[] = {
+        {"debug", LogLevel::DEBUG},
+        {"info", LogLevel::INFO},
+        {"warning", LogLevel::WARNING},
+        {"error", LogLevel::ERROR},
+        {"off", LogLevel::OFF},
+    };
+
+    // Bounded multi-producer queue: a slot is free for position p when its
+    // sequence is p, and holds the message for p when it is p + 1
+    struct Slot {
+        std::atomic<size_t> sequence;
+        LogLevel level;
+        std::string text;
+    };
+
+    class Queue {
+    public:
+        Queue()
+            : level(static_cast<int>(LogLevel::INFO))
+            , dropped(0)
+            , enqueuePosition(0)
+            , dequeuePosition(0)
+            , running(true) {
+            for (size_t i = 0; i < Logger::CAPACITY; i++) {
+                slots[i].sequence.store(i, std::memory_order_relaxed);
+            }
+
+            LogLevel initial;
+            const char* name = std::getenv("LOG_LEVEL");
+            if (name != nullptr && Logger::parseLevel(name, initial)) {
+                level.store(static_cast<int>(initial), std::memory_order_relaxed);
+            }
+
+            writer = std::thread(&Queue::drainLoop, this);
+        }
+
+        ~Queue() {
+            running.store(false, std::memory_order_release);
+            writer.join();
+        }
+
+        bool push(LogLevel messageLevel, std::string& message) {
+            size_t position = enqueuePosition.load(std::memory_order_relaxed);
+            Slot* slot;
+            for (;;) {
+                slot = &slots[position & (Logger::CAPACITY - 1)];
+                size_t sequence = slot->sequence.load(std::memory_order_acquire);
+                std::intptr_t difference = static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(position);
+                if (difference == 0) {
+                    if (enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                        break;
+                    }
+                } else if (difference < 0) {
+                    dropped.fetch_add(1, std::memory_order_relaxed);
+                    return false;
+                } else {
+                    position = enqueuePosition.load(std::memory_order_relaxed);
+                }
+            }
+
+            slot->level = messageLevel;
+            slot->text.swap(message);
+            slot->sequence.store(position + 1, std::memory_order_release);
+            return true;
+        }
+
+        void flush() {
+            size_t target = enqueuePosition.load(std::memory_order_acquire);
+            while (dequeuePosition.load(std::memory_order_acquire) < target) {
+                std::this_thread::yield();
+            }
+        }
+
+        std::atomic<int> level;
+        std::atomic<unsigned long> dropped;
+
+    private:
+        Slot slots[Logger::CAPACITY];
+        std::atomic<size_t> enqueuePosition;
+        std::atomic<size_t> dequeuePosition;  // only the writer thread advances it
+        std::atomic<bool> running;
+        std::thread writer;
+
+        // Writes out every message that is ready; returns how many there were
+        size_t drain() {
+            size_t position = dequeuePosition.load(std::memory_order_relaxed);
+            size_t count = 0;
+            bool wroteOut = false;
+            bool wroteErr = false;
+            for (;;) {
+                Slot& slot = slots[position & (Logger::CAPACITY - 1)];
+                if (slot.sequence.load(std::memory_order_acquire) != position + 1) break;
+
+                bool error = slot.level >= LogLevel::WARNING;
+                std::ostream& stream = error ? std::cerr : std::cout;
+                stream << slot.text << '\n';
+                wroteOut |= !error;
+                wroteErr |= error;
+
+                // The text is freed here rather than by whichever producer reuses the slot
+                std::string().swap(slot.text);
+                slot.sequence.store(position + Logger::CAPACITY, std::memory_order_release);
+                position++;
+                count++;
+                dequeuePosition.store(position, std::memory_order_release);
+            }
+            if (wroteOut) std::cout.flush();
+            if (wroteErr) std::cerr.flush();
+            return count;
+        }
+
+        void drainLoop() {
+            unsigned long reported = 0;
+            for (;;) {
+                // Read before draining, so messages queued before a stop are still written
+                bool stopping = !running.load(std::memory_order_acquire);
+                size_t count = drain();
+
+                unsigned long lost = dropped.load(std::memory_order_relaxed);
+                if (lost != reported) {
+                    LOG_ERROR("(" << lost - reported << " log messages dropped)");
+                    reported = lost;
+                }
+
+                if (stopping) {
+                    // The drop report above was queued after the last drain
+                    drain();
+                    return;
+                }
+                if (count == 0) std::this_thread::sleep_for(IDLE_WAIT);
+            }
+        }
+    };
+
+    Queue& queue() {
+        static Queue instance;
+        return instance;
+    }
+}
+
+void Logger::setLevel(LogLevel level) {
+    queue().level.store(static_cast<int>(level), std::memory_order_relaxed);
+}
+
+LogLevel Logger::getLevel() {
+    return static_cast<LogLevel>(queue().level.load(std::memory_order_relaxed));
+}
+
+bool Logger::isEnabled(LogLevel level) {
+    return level != LogLevel::OFF && static_cast<int>(level) >= queue().level.load(std::memory_order_relaxed);
+}
+
+bool Logger::parseLevel(const std::string& name, LogLevel& level) {
+    std::string lower = name;
+    std::transform(lower.begin(), lower.end(), lower.begin(), [](unsigned char c) { return std::tolower(c); });
+    for (const auto& entry : LEVEL_NAMES) {
+        if (lower == entry.first) {
+            level = entry.second;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* Logger::getLevelName(LogLevel level) {
+    for (const auto& entry : LEVEL_NAMES) {
+        if (entry.second == level) return entry.first;
+    }
+    return "unknown";
+}
+
+void Logger::write(LogLevel level, std::string message) {
+    queue().push(level, message);
+}
+
+void Logger::flush() {
+    queue().flush();
+}
+
+unsigned long Logger::getDroppedCount() {
+    return queue().dropped.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,60 @@
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <sstream>
+#include <string>
+
+// Messages below this level are compiled out (0 debug, 1 info, 2 warning, 3 error)
+#ifndef LOG_MIN_LEVEL
+#define LOG_MIN_LEVEL 0
+#endif
+
+enum class LogLevel {
+    DEBUG,
+    INFO,
+    WARNING,
+    ERROR,
+    OFF
+};
+
+// Console logging that stays off the caller's thread.
+// The LOG_* macros only format a message when its level is enabled, and
+// write() moves it into a slot of a fixed-size lock-free ring; a background
+// thread drains the ring to stdout (debug, info) or stderr (warning, error).
+// Callers never wait for the console: when the ring is full the message is
+// dropped and counted. Any thread may log, and whatever is queued is written
+// out at exit. The runtime level starts from the LOG_LEVEL environment
+// variable (debug, info, warning, error or off; info by default).
+class Logger {
+public:
+    static const size_t CAPACITY = 1024;        // messages in flight, a power of two
+
+    static void setLevel(LogLevel level);
+    static LogLevel getLevel();
+    static bool isEnabled(LogLevel level);
+    static bool parseLevel(const std::string& name, LogLevel& level);
+    static const char* getLevelName(LogLevel level);
+
+    static void write(LogLevel level, std::string message);
+
+    // Blocks until everything logged so far has reached the console
+    static void flush();
+    static unsigned long getDroppedCount();
+};
+
+// Variadic so that commas inside template arguments survive
+#define LOG_AT(level, ...)                                                      \
+    do {                                                                        \
+        if (static_cast<int>(level) >= LOG_MIN_LEVEL && Logger::isEnabled(level)) { \
+            std::ostringstream logStream;                                       \
+            logStream << __VA_ARGS__;                                           \
+            Logger::write(level, logStream.str());                              \
+        }                                                                       \
+    } while (0)
+
+#define LOG_DEBUG(...) LOG_AT(LogLevel::DEBUG, __VA_ARGS__)
+#define LOG_INFO(...) LOG_AT(LogLevel::INFO, __VA_ARGS__)
+#define LOG_WARNING(...) LOG_AT(LogLevel::WARNING, __VA_ARGS__)
+#define LOG_ERROR(...) LOG_AT(LogLevel::ERROR, __VA_ARGS__)
+
+#endif
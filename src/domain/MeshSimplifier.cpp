@@ -0,0 +1,396 @@
+#include "MeshSimplifier.hpp"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <map>
+#include <set>
+
+namespace {
+    // Open edges (mesh borders and attribute seams) get a perpendicular plane
+    // with this weight so collapses don't pull them inwards
+    const double EDGE_WEIGHT = 10.0;
+
+    long long edgeKey(int a, int b) {
+        return (static_cast<long long>(a) << 32) | static_cast<unsigned int>(b);
+    }
+}
+
+void MeshSimplifier::Quadric::addPlane(const glm::vec3& normal, const glm::vec3& point, double weight) {
+    double x = normal.x, y = normal.y, z = normal.z;
+    double d = -(x * point.x + y * point.y + z * point.z);
+
+    a[0] += weight * x * x; a[1] += weight * x * y; a[2] += weight * x * z; a[3] += weight * x * d;
+    a[4] += weight * y * y; a[5] += weight * y * z; a[6] += weight * y * d;
+    a[7] += weight * z * z; a[8] += weight * z * d;
+    a[9] += weight * d * d;
+}
+
+void MeshSimplifier::Quadric::add(const Quadric& other) {
+    for (int i = 0; i < 10; i++) a[i] += other.a[i];
+}
+
+double MeshSimplifier::Quadric::evaluate(const glm::vec3& p) const {
+    double x = p.x, y = p.y, z = p.z;
+    double error = a[0] * x * x + 2.0 * a[1] * x * y + 2.0 * a[2] * x * z + 2.0 * a[3] * x
+                 + a[4] * y * y + 2.0 * a[5] * y * z + 2.0 * a[6] * y
+                 + a[7] * z * z + 2.0 * a[8] * z
+                 + a[9];
+    return std::max(error, 0.0);
+}
+
+MeshSimplifier::MeshSimplifier(const std::vector<TextureVertex>& triangles)
+    : liveTriangles(0)
+    , maxError(0.0) {
+    weld(triangles);
+    classify();
+    computeQuadrics();
+
+    for (int v = 0; v < static_cast<int>(vertices.size()); v++) {
+        pushCandidates(v);
+    }
+}
+
+void MeshSimplifier::weld(const std::vector<TextureVertex>& triangles) {
+    std::map<std::array<float, 8>, int> vertexIds;
+    std::map<std::array<float, 3>, int> positionIds;
+
+    auto vertexId = [&](const TextureVertex& v) {
+        std::array<float, 8> key = {v.position.x, v.position.y, v.position.z,
+                                    v.normal.x, v.normal.y, v.normal.z,
+                                    v.texCoord.x, v.texCoord.y};
+        auto found = vertexIds.find(key);
+        if (found != vertexIds.end()) return found->second;
+
+        std::array<float, 3> positionKey = {v.position.x, v.position.y, v.position.z};
+        auto position = positionIds.find(positionKey);
+        int positionId;
+        if (position == positionIds.end()) {
+            positionId = static_cast<int>(positions.size());
+            positionIds[positionKey] = positionId;
+            positions.push_back(v.position);
+            wedges.push_back(std::vector<int>());
+        } else {
+            positionId = position->second;
+        }
+
+        int id = static_cast<int>(vertices.size());
+        vertexIds[key] = id;
+        vertices.push_back(v);
+        positionOf.push_back(positionId);
+        wedges[positionId].push_back(id);
+        return id;
+    };
+
+    for (size_t i = 0; i + 2 < triangles.size(); i += 3) {
+        int a = vertexId(triangles[i]);
+        int b = vertexId(triangles[i + 1]);
+        int c = vertexId(triangles[i + 2]);
+
+        if (positionOf[a] == positionOf[b] || positionOf[b] == positionOf[c] || positionOf[a] == positionOf[c]) {
+            continue;
+        }
+        indices.push_back(a);
+        indices.push_back(b);
+        indices.push_back(c);
+    }
+
+    size_t triangleCount = indices.size() / 3;
+    triangleAlive.assign(triangleCount, true);
+    liveTriangles = triangleCount;
+
+    vertexTriangles.resize(vertices.size());
+    for (size_t t = 0; t < triangleCount; t++) {
+        for (int k = 0; k < 3; k++) {
+            vertexTriangles[indices[t * 3 + k]].push_back(static_cast<int>(t));
+        }
+    }
+
+    kinds.assign(vertices.size(), LOCKED);
+    versions.assign(vertices.size(), 0);
+    removed.assign(vertices.size(), false);
+    quadrics.resize(positions.size());
+}
+
+void MeshSimplifier::classify() {
+    std::set<long long> attributeEdges;
+    std::set<long long> positionEdges;
+    for (size_t i = 0; i < indices.size(); i += 3) {
+        for (int k = 0; k < 3; k++) {
+            int u = indices[i + k];
+            int v = indices[i + (k + 1) % 3];
+            attributeEdges.insert(edgeKey(u, v));
+            positionEdges.insert(edgeKey(positionOf[u], positionOf[v]));
+        }
+    }
+
+    std::vector<int> openOut(vertices.size(), 0), openIn(vertices.size(), 0);
+    std::vector<int> borderEdges(vertices.size(), 0), seamEdges(vertices.size(), 0);
+    for (size_t i = 0; i < indices.size(); i += 3) {
+        for (int k = 0; k < 3; k++) {
+            int u = indices[i + k];
+            int v = indices[i + (k + 1) % 3];
+            if (attributeEdges.count(edgeKey(v, u))) continue;
+
+            openOut[u]++;
+            openIn[v]++;
+            if (positionEdges.count(edgeKey(positionOf[v], positionOf[u])) == 0) {
+                borderEdges[u]++;
+                borderEdges[v]++;
+            } else {
+                seamEdges[u]++;
+                seamEdges[v]++;
+            }
+        }
+    }
+
+    for (size_t v = 0; v < vertices.size(); v++) {
+        size_t wedgeCount = wedges[positionOf[v]].size();
+        bool oneOpenEachWay = openOut[v] == 1 && openIn[v] == 1;
+
+        if (openOut[v] == 0 && openIn[v] == 0) {
+            kinds[v] = wedgeCount == 1 ? MANIFOLD : LOCKED;
+        } else if (wedgeCount == 1 && oneOpenEachWay && borderEdges[v] == 2) {
+            kinds[v] = BORDER;
+        } else if (wedgeCount == 2 && oneOpenEachWay && seamEdges[v] == 2) {
+            kinds[v] = SEAM;
+        } else {
+            kinds[v] = LOCKED;
+        }
+    }
+}
+
+void MeshSimplifier::computeQuadrics() {
+    std::set<long long> attributeEdges;
+    for (size_t i = 0; i < indices.size(); i += 3) {
+        for (int k = 0; k < 3; k++) {
+            attributeEdges.insert(edgeKey(indices[i + k], indices[i + (k + 1) % 3]));
+        }
+    }
+
+    for (size_t i = 0; i < indices.size(); i += 3) {
+        const glm::vec3& p0 = positions[positionOf[indices[i]]];
+        const glm::vec3& p1 = positions[positionOf[indices[i + 1]]];
+        const glm::vec3& p2 = positions[positionOf[indices[i + 2]]];
+
+        glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+        float doubleArea = glm::length(normal);
+        if (doubleArea <= 0.0f) continue;
+        normal /= doubleArea;
+
+        for (int k = 0; k < 3; k++) {
+            quadrics[positionOf[indices[i + k]]].addPlane(normal, p0, 0.5 * doubleArea);
+        }
+
+        for (int k = 0; k < 3; k++) {
+            int u = indices[i + k];
+            int v = indices[i + (k + 1) % 3];
+            if (attributeEdges.count(edgeKey(v, u))) continue;
+
+            glm::vec3 edge = positions[positionOf[v]] - positions[positionOf[u]];
+            glm::vec3 edgeNormal = glm::cross(edge, normal);
+            float length = glm::length(edgeNormal);
+            if (length <= 0.0f) continue;
+
+            double weight = EDGE_WEIGHT * glm::dot(edge, edge);
+            quadrics[positionOf[u]].addPlane(edgeNormal / length, positions[positionOf[u]], weight);
+            quadrics[positionOf[v]].addPlane(edgeNormal / length, positions[positionOf[u]], weight);
+        }
+    }
+}
+
+void MeshSimplifier::pushCandidate(int from, int to) {
+    if (kinds[from] == LOCKED || positionOf[from] == positionOf[to]) return;
+
+    Quadric combined = quadrics[positionOf[from]];
+    combined.add(quadrics[positionOf[to]]);
+
+    Collapse collapse;
+    collapse.cost = combined.evaluate(positions[positionOf[to]]);
+    collapse.from = from;
+    collapse.to = to;
+    collapse.fromVersion = versions[from];
+    collapse.toVersion = versions[to];
+
+    heap.push_back(collapse);
+    std::push_heap(heap.begin(), heap.end());
+}
+
+void MeshSimplifier::pushCandidates(int vertex) {
+    for (int t : vertexTriangles[vertex]) {
+        if (!triangleAlive[t]) continue;
+        for (int k = 0; k < 3; k++) {
+            int other = indices[t * 3 + k];
+            if (other == vertex) continue;
+            pushCandidate(vertex, other);
+            pushCandidate(other, vertex);
+        }
+    }
+}
+
+int MeshSimplifier::sharedTriangleCount(int a, int b) const {
+    int count = 0;
+    for (int t : vertexTriangles[a]) {
+        if (!triangleAlive[t]) continue;
+        if (indices[t * 3] == b || indices[t * 3 + 1] == b || indices[t * 3 + 2] == b) count++;
+    }
+    return count;
+}
+
+int MeshSimplifier::findWedgePartner(int from, int toPosition) const {
+    for (int t : vertexTriangles[from]) {
+        if (!triangleAlive[t]) continue;
+        for (int k = 0; k < 3; k++) {
+            int corner = indices[t * 3 + k];
+            if (corner != from && positionOf[corner] == toPosition) return corner;
+        }
+    }
+    return -1;
+}
+
+bool MeshSimplifier::canCollapse(int from, int to, int& pairFrom, int& pairTo) const {
+    pairFrom = -1;
+    pairTo = -1;
+
+    switch (kinds[from]) {
+        case MANIFOLD:
+            break;
+        case BORDER:
+            if (kinds[to] != BORDER && kinds[to] != LOCKED) return false;
+            if (sharedTriangleCount(from, to) != 1) return false;
+            break;
+        case SEAM: {
+            if (kinds[to] != SEAM && kinds[to] != LOCKED) return false;
+            if (sharedTriangleCount(from, to) != 1) return false;
+
+            const std::vector<int>& fromWedges = wedges[positionOf[from]];
+            pairFrom = fromWedges[0] == from ? fromWedges[1] : fromWedges[0];
+            pairTo = findWedgePartner(pairFrom, positionOf[to]);
+            if (pairTo < 0 || sharedTriangleCount(pairFrom, pairTo) != 1) return false;
+            break;
+        }
+        default:
+            return false;
+    }
+
+    // Link condition in position space: the endpoints may only share the
+    // neighbours opposite the collapsing edge, otherwise the mesh folds
+    std::set<int> fromNeighbours, toNeighbours;
+    int edgeTriangles = 0;
+    auto gather = [&](int position, std::set<int>& neighbours, bool countEdge) {
+        for (int wedge : wedges[position]) {
+            if (removed[wedge]) continue;
+            for (int t : vertexTriangles[wedge]) {
+                if (!triangleAlive[t]) continue;
+                bool onEdge = false;
+                for (int k = 0; k < 3; k++) {
+                    int corner = positionOf[indices[t * 3 + k]];
+                    if (corner == positionOf[to]) onEdge = true;
+                    if (corner != position) neighbours.insert(corner);
+                }
+                if (countEdge && onEdge) edgeTriangles++;
+            }
+        }
+    };
+    gather(positionOf[from], fromNeighbours, true);
+    gather(positionOf[to], toNeighbours, false);
+
+    int common = 0;
+    for (int p : fromNeighbours) {
+        if (toNeighbours.count(p)) common++;
+    }
+    if (common > edgeTriangles) return false;
+
+    if (flipsTriangles(from, to)) return false;
+    if (pairFrom >= 0 && flipsTriangles(pairFrom, pairTo)) return false;
+    return true;
+}
+
+bool MeshSimplifier::flipsTriangles(int from, int to) const {
+    const glm::vec3& target = positions[positionOf[to]];
+
+    for (int t : vertexTriangles[from]) {
+        if (!triangleAlive[t]) continue;
+
+        const int* tri = &indices[t * 3];
+        if (tri[0] == to || tri[1] == to || tri[2] == to) continue;
+
+        glm::vec3 before[3], after[3];
+        for (int k = 0; k < 3; k++) {
+            before[k] = positions[positionOf[tri[k]]];
+            after[k] = tri[k] == from ? target : before[k];
+        }
+
+        glm::vec3 oldNormal = glm::cross(before[1] - before[0], before[2] - before[0]);
+        glm::vec3 newNormal = glm::cross(after[1] - after[0], after[2] - after[0]);
+        float oldLength = glm::length(oldNormal);
+        float newLength = glm::length(newNormal);
+        if (newLength <= 1e-12f) return true;
+        if (oldLength > 0.0f && glm::dot(oldNormal, newNormal) <= 0.0f) return true;
+    }
+    return false;
+}
+
+void MeshSimplifier::applyCollapse(int from, int to) {
+    for (int t : vertexTriangles[from]) {
+        if (!triangleAlive[t]) continue;
+
+        int* tri = &indices[t * 3];
+        if (tri[0] == to || tri[1] == to || tri[2] == to) {
+            triangleAlive[t] = false;
+            liveTriangles--;
+            continue;
+        }
+
+        for (int k = 0; k < 3; k++) {
+            if (tri[k] == from) tri[k] = to;
+        }
+        vertexTriangles[to].push_back(t);
+    }
+
+    vertexTriangles[from].clear();
+    removed[from] = true;
+}
+
+size_t MeshSimplifier::simplify(size_t targetTriangles) {
+    while (liveTriangles > targetTriangles && !heap.empty()) {
+        std::pop_heap(heap.begin(), heap.end());
+        Collapse collapse = heap.back();
+        heap.pop_back();
+
+        if (removed[collapse.from] || removed[collapse.to]) continue;
+        if (versions[collapse.from] != collapse.fromVersion || versions[collapse.to] != collapse.toVersion) continue;
+
+        int pairFrom, pairTo;
+        if (!canCollapse(collapse.from, collapse.to, pairFrom, pairTo)) continue;
+
+        int fromPosition = positionOf[collapse.from];
+        int toPosition = positionOf[collapse.to];
+
+        applyCollapse(collapse.from, collapse.to);
+        if (pairFrom >= 0) {
+            applyCollapse(pairFrom, pairTo);
+        }
+        quadrics[toPosition].add(quadrics[fromPosition]);
+        maxError = std::max(maxError, collapse.cost);
+
+        versions[collapse.to]++;
+        pushCandidates(collapse.to);
+        if (pairTo >= 0 && pairTo != collapse.to) {
+            versions[pairTo]++;
+            pushCandidates(pairTo);
+        }
+    }
+    return liveTriangles;
+}
+
+std::vector<TextureVertex> MeshSimplifier::extract() const {
+    std::vector<TextureVertex> result;
+    result.reserve(liveTriangles * 3);
+    for (size_t t = 0; t < triangleAlive.size(); t++) {
+        if (!triangleAlive[t]) continue;
+        for (int k = 0; k < 3; k++) {
+            result.push_back(vertices[indices[t * 3 + k]]);
+        }
+    }
+    return result;
+}
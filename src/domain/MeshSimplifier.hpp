@@ -0,0 +1,85 @@
+#ifndef MESH_SIMPLIFIER_H
+#define MESH_SIMPLIFIER_H
+
+#include "TextureVertex.hpp"
+#include <glm/glm.hpp>
+#include <vector>
+
+// Quadric error metric edge-collapse simplifier (Garland & Heckbert).
+// The input triangle soup is welded on all attributes, so a UV or normal seam
+// shows up as two vertices sharing a position. Vertices are classified once:
+//  - manifold: a single wedge with no open edges, free to collapse anywhere
+//  - border:   on an open mesh boundary, may only slide along that boundary
+//  - seam:     exactly two wedges along one seam; both wedges collapse together
+//              along the seam so the two sides stay stitched
+//  - locked:   anything else (corners, seam junctions), never moves
+// Collapses are half-edge (the survivor keeps its position and attributes), so
+// no attribute interpolation is needed and seams are preserved exactly.
+class MeshSimplifier {
+public:
+    explicit MeshSimplifier(const std::vector<TextureVertex>& triangles);
+
+    // Collapses edges until at most targetTriangles remain or nothing more can
+    // be removed without flipping faces. Targets can be lowered on successive
+    // calls to build a nested LOD chain from a single run.
+    size_t simplify(size_t targetTriangles);
+
+    // Current mesh as a non-indexed triangle list, ready for glDrawArrays
+    std::vector<TextureVertex> extract() const;
+
+    size_t getTriangleCount() const { return liveTriangles; }
+    size_t getVertexCount() const { return vertices.size(); }
+    double getMaxError() const { return maxError; }
+
+private:
+    enum Kind { MANIFOLD, BORDER, SEAM, LOCKED };
+
+    struct Quadric {
+        double a[10] = {};
+
+        void addPlane(const glm::vec3& normal, const glm::vec3& point, double weight);
+        void add(const Quadric& other);
+        double evaluate(const glm::vec3& p) const;
+    };
+
+    struct Collapse {
+        double cost;
+        int from;
+        int to;
+        unsigned int fromVersion;
+        unsigned int toVersion;
+
+        bool operator<(const Collapse& other) const { return cost > other.cost; }
+    };
+
+    std::vector<TextureVertex> vertices;
+    std::vector<int> positionOf;                 // vertex -> welded position
+    std::vector<std::vector<int>> wedges;        // position -> vertices sharing it
+    std::vector<glm::vec3> positions;
+    std::vector<Quadric> quadrics;               // per position
+    std::vector<Kind> kinds;
+    std::vector<unsigned int> versions;
+    std::vector<bool> removed;
+
+    std::vector<int> indices;                    // 3 per triangle
+    std::vector<bool> triangleAlive;
+    std::vector<std::vector<int>> vertexTriangles;
+    size_t liveTriangles;
+
+    std::vector<Collapse> heap;
+    double maxError;
+
+    void weld(const std::vector<TextureVertex>& triangles);
+    void classify();
+    void computeQuadrics();
+    void pushCandidates(int vertex);
+    void pushCandidate(int from, int to);
+
+    int sharedTriangleCount(int a, int b) const;
+    int findWedgePartner(int from, int toPosition) const;
+    bool canCollapse(int from, int to, int& pairFrom, int& pairTo) const;
+    bool flipsTriangles(int from, int to) const;
+    void applyCollapse(int from, int to);
+};
+
+#endif
@@ -1,8 +1,9 @@
 #include "Obj.hpp"
+#include "GLState.hpp"
 #include "glad/glad.h"
+#include "Logger.hpp"
 #include <fstream>
 #include <sstream>
-#include <iostream>
 
 Obj::Obj(const std::string& filename) 
     : position(0.0f)
@@ -10,9 +11,15 @@ Obj::Obj(const std::string& filename)
     , scale(1.0f)
     , VAO(0)
     , VBO(0)
-    , numVertices(0) {
+    , numVertices(0)
+    , depthVAO(0)
+    , depthVBO(0)
+    , modelMatrix(1.0f)
+    , modelDirty(true)
+    , boundsVersion(~0u)
+    , transformVersion(0) {
     if (!loadFromFile(filename)) {
-        std::cerr << "Failed to load model: " << filename << std::endl;
+        LOG_ERROR("Failed to load model: " << filename);
     }
 }
 
@@ -21,8 +28,10 @@ Obj::~Obj() {
 }
 
 void Obj::cleanup() {
-    if (VAO != 0) glDeleteVertexArrays(1, &VAO);
+    GLState::deleteVertexArray(VAO);
     if (VBO != 0) glDeleteBuffers(1, &VBO);
+    GLState::deleteVertexArray(depthVAO);
+    if (depthVBO != 0) glDeleteBuffers(1, &depthVBO);
 }
 
 bool Obj::loadFromFile(const std::string& filename) {
@@ -32,7 +41,7 @@ bool Obj::loadFromFile(const std::string& filename) {
 
     std::ifstream file(filename);
     if (!file.is_open()) {
-        std::cerr << "Could not open file: " << filename << std::endl;
+        LOG_ERROR("Could not open file: " << filename);
         return false;
     }
 
@@ -98,14 +107,14 @@ bool Obj::loadFromFile(const std::string& filename) {
     }
 
     if (vBuffer.empty()) {
-        std::cerr << "Error: No valid faces found in file: " << filename << std::endl;
+        LOG_ERROR("Error: No valid faces found in file: " << filename);
         return false;
     }
 
     numVertices = vBuffer.size() / 6;
 
     glGenVertexArrays(1, &VAO);
-    glBindVertexArray(VAO);
+    GLState::bindVertexArray(VAO);
 
     glGenBuffers(1, &VBO);
     glBindBuffer(GL_ARRAY_BUFFER, VBO);
@@ -117,36 +126,99 @@ bool Obj::loadFromFile(const std::string& filename) {
     glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
     glEnableVertexAttribArray(1);
 
+    std::vector<float> positions;
+    std::vector<glm::vec3> points;
+    positions.reserve(numVertices * 3);
+    points.reserve(numVertices);
+    for (size_t i = 0; i < vBuffer.size(); i += 6) {
+        positions.insert(positions.end(), vBuffer.begin() + i, vBuffer.begin() + i + 3);
+        points.push_back(glm::vec3(vBuffer[i], vBuffer[i + 1], vBuffer[i + 2]));
+    }
+    computeBounds(points);
+
+    glGenVertexArrays(1, &depthVAO);
+    GLState::bindVertexArray(depthVAO);
+
+    glGenBuffers(1, &depthVBO);
+    glBindBuffer(GL_ARRAY_BUFFER, depthVBO);
+    glBufferData(GL_ARRAY_BUFFER, positions.size() * sizeof(float), positions.data(), GL_STATIC_DRAW);
+
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+
     glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
+    GLState::bindVertexArray(0);
 
     return true;
 }
 
+void Obj::computeBounds(const std::vector<glm::vec3>& points) {
+    localAABB = AABB::fromPoints(points);
+    localSphere = BoundingSphere::fromPoints(points);
+    boundsVersion = ~0u;
+}
+
+void Obj::markTransformDirty() {
+    modelDirty = true;
+    transformVersion++;
+}
+
 void Obj::translate(const glm::vec3& translation) {
     position += translation;
+    markTransformDirty();
+}
+
+void Obj::setPosition(const glm::vec3& newPosition) {
+    position = newPosition;
+    markTransformDirty();
 }
 
 void Obj::rotate(float angle, const glm::vec3& axis) {
     rotation += axis * angle;
+    markTransformDirty();
 }
 
 void Obj::setRotation(const glm::vec3& newRotation) {
     rotation = newRotation;
+    markTransformDirty();
 }
 
 void Obj::setScale(const glm::vec3& newScale) {
     scale = newScale;
+    markTransformDirty();
 }
 
 glm::mat4 Obj::getModelMatrix() const {
-    glm::mat4 model = glm::mat4(1.0f);
-    model = glm::translate(model, position);
-    model = glm::rotate(model, glm::radians(rotation.z), glm::vec3(0.0f, 0.0f, 1.0f));
-    model = glm::rotate(model, glm::radians(rotation.y), glm::vec3(0.0f, 1.0f, 0.0f));
-    model = glm::rotate(model, glm::radians(rotation.x), glm::vec3(1.0f, 0.0f, 0.0f));
-    model = glm::scale(model, scale);
-    return model;
+    if (modelDirty) {
+        glm::mat4 model = glm::mat4(1.0f);
+        model = glm::translate(model, position);
+        model = glm::rotate(model, glm::radians(rotation.z), glm::vec3(0.0f, 0.0f, 1.0f));
+        model = glm::rotate(model, glm::radians(rotation.y), glm::vec3(0.0f, 1.0f, 0.0f));
+        model = glm::rotate(model, glm::radians(rotation.x), glm::vec3(1.0f, 0.0f, 0.0f));
+        model = glm::scale(model, scale);
+        modelMatrix = model;
+        modelDirty = false;
+    }
+    return modelMatrix;
+}
+
+const AABB& Obj::getWorldBounds() const {
+    if (boundsVersion != transformVersion) {
+        glm::mat4 model = getModelMatrix();
+        worldAABB = localAABB.transformed(model);
+        worldSphere = localSphere.transformed(model);
+        boundsVersion = transformVersion;
+    }
+    return worldAABB;
+}
+
+const BoundingSphere& Obj::getWorldSphere() const {
+    getWorldBounds();
+    return worldSphere;
+}
+
+glm::vec3 Obj::getPosition() const {
+    return position;
 }
 
 glm::vec3 Obj::getRotation() const {
@@ -154,7 +226,11 @@ glm::vec3 Obj::getRotation() const {
 }
 
 void Obj::draw() const {
-    glBindVertexArray(VAO);
+    GLState::bindVertexArray(VAO);
+    glDrawArrays(GL_TRIANGLES, 0, numVertices);
+}
+
+void Obj::drawDepth() const {
+    GLState::bindVertexArray(depthVAO);
     glDrawArrays(GL_TRIANGLES, 0, numVertices);
-    glBindVertexArray(0);
 } 
\ No newline at end of file
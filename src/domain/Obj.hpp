@@ -2,6 +2,7 @@
 #define OBJ_H
 
 #include "glad/glad.h"
+#include "Bounds.hpp"
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <vector>
@@ -13,26 +14,54 @@ private:
     GLuint VBO;
     int numVertices;
 
+    // Tightly packed positions for depth-only passes
+    GLuint depthVAO;
+    GLuint depthVBO;
+
     glm::vec3 position;
     glm::vec3 rotation;
 
+    // Model matrix and world bounds are rebuilt lazily after a transform change
+    mutable glm::mat4 modelMatrix;
+    mutable bool modelDirty;
+    mutable AABB worldAABB;
+    mutable BoundingSphere worldSphere;
+    mutable unsigned int boundsVersion;
+    unsigned int transformVersion;
+
     bool loadFromFile(const std::string& filename);
     void cleanup();
+    void markTransformDirty();
+
+protected:
+    AABB localAABB;
+    BoundingSphere localSphere;
+
+    void computeBounds(const std::vector<glm::vec3>& points);
 
 public:
     Obj(const std::string& filename);
     ~Obj();
 
+    // Read-only outside the class; go through setScale so the cached matrix is refreshed
     glm::vec3 scale;
 
     void translate(const glm::vec3& translation);
+    void setPosition(const glm::vec3& newPosition);
     void rotate(float angle, const glm::vec3& axis);
     void setRotation(const glm::vec3& newRotation);
     void setScale(const glm::vec3& newScale);
     glm::mat4 getModelMatrix() const;
+    glm::vec3 getPosition() const;
     glm::vec3 getRotation() const;
+    unsigned int getTransformVersion() const { return transformVersion; }
+
+    const AABB& getLocalBounds() const { return localAABB; }
+    const AABB& getWorldBounds() const;
+    const BoundingSphere& getWorldSphere() const;
     
     void draw() const;
+    void drawDepth() const;
 };
 
 #endif
\ No newline at end of file
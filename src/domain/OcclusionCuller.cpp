@@ -0,0 +1,142 @@
+#include "OcclusionCuller.hpp"
+#include "GLState.hpp"
+
+namespace {
+    // Larger than the near plane so a camera sitting just outside a box still
+    // counts as inside it; otherwise the near faces are clipped away and the
+    // query reports the object as hidden
+    const float NEAR_MARGIN = 0.2f;
+
+    const float unitCube[] = {
+        0, 0, 0,  1, 0, 0,  1, 1, 0,   0, 0, 0,  1, 1, 0,  0, 1, 0,
+        0, 0, 1,  1, 1, 1,  1, 0, 1,   0, 0, 1,  0, 1, 1,  1, 1, 1,
+        0, 0, 0,  0, 1, 1,  0, 0, 1,   0, 0, 0,  0, 1, 0,  0, 1, 1,
+        1, 0, 0,  1, 0, 1,  1, 1, 1,   1, 0, 0,  1, 1, 1,  1, 1, 0,
+        0, 0, 0,  0, 0, 1,  1, 0, 1,   0, 0, 0,  1, 0, 1,  1, 0, 0,
+        0, 1, 0,  1, 1, 1,  0, 1, 1,   0, 1, 0,  1, 1, 0,  1, 1, 1,
+    };
+}
+
+OcclusionCuller::OcclusionCuller()
+    : boxShader("src/shaders/occlusion_box.vert", "src/shaders/depth.frag")
+    , boxVAO(0)
+    , boxVBO(0)
+    , eye(0.0f) {
+    glGenVertexArrays(1, &boxVAO);
+    GLState::bindVertexArray(boxVAO);
+
+    glGenBuffers(1, &boxVBO);
+    glBindBuffer(GL_ARRAY_BUFFER, boxVBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(unitCube), unitCube, GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    GLState::bindVertexArray(0);
+}
+
+OcclusionCuller::~OcclusionCuller() {
+    reset();
+    GLState::deleteVertexArray(boxVAO);
+    if (boxVBO != 0) glDeleteBuffers(1, &boxVBO);
+    GLState::deleteProgram(boxShader.ID);
+}
+
+void OcclusionCuller::resize(size_t keyCount) {
+    if (keyCount < slots.size()) {
+        for (size_t i = keyCount; i < slots.size(); i++) {
+            if (slots[i].query != 0) glDeleteQueries(1, &slots[i].query);
+        }
+    }
+    slots.resize(keyCount);
+}
+
+void OcclusionCuller::reset() {
+    for (auto& slot : slots) {
+        if (slot.query != 0) glDeleteQueries(1, &slot.query);
+    }
+    slots.clear();
+}
+
+void OcclusionCuller::collectResults() {
+    stats = Stats();
+
+    for (auto& slot : slots) {
+        if (slot.pending) {
+            GLuint available = 0;
+            glGetQueryObjectuiv(slot.query, GL_QUERY_RESULT_AVAILABLE, &available);
+            if (available) {
+                GLuint samplesPassed = 0;
+                glGetQueryObjectuiv(slot.query, GL_QUERY_RESULT, &samplesPassed);
+                slot.visible = samplesPassed != 0;
+                slot.pending = false;
+            } else {
+                stats.pending++;
+            }
+        }
+    }
+}
+
+bool OcclusionCuller::wasVisible(size_t key) const {
+    return key >= slots.size() || slots[key].visible;
+}
+
+void OcclusionCuller::beginQueries(const glm::mat4& viewProjection, const glm::vec3& eyePosition) {
+    eye = eyePosition;
+
+    boxShader.use();
+    boxShader.setMat4("viewProjection", viewProjection);
+
+    GLState::setColorMask(false);
+    GLState::setDepthMask(false);
+    GLState::setDepthFunc(GL_LEQUAL);
+    GLState::setBlend(false);
+    GLState::bindVertexArray(boxVAO);
+}
+
+void OcclusionCuller::issueQuery(size_t key, const AABB& box) {
+    if (key >= slots.size()) return;
+
+    // Still waiting on the previous answer; keep it rather than restarting
+    Slot& slot = slots[key];
+    if (slot.pending) return;
+
+    AABB expanded;
+    expanded.min = box.min - glm::vec3(NEAR_MARGIN);
+    expanded.max = box.max + glm::vec3(NEAR_MARGIN);
+    AABB eyePoint;
+    eyePoint.min = eye;
+    eyePoint.max = eye;
+    if (expanded.contains(eyePoint)) {
+        slot.visible = true;
+        return;
+    }
+
+    if (slot.query == 0) glGenQueries(1, &slot.query);
+
+    boxShader.setVec3("boxMin", box.min);
+    boxShader.setVec3("boxMax", box.max);
+
+    glBeginQuery(GL_ANY_SAMPLES_PASSED, slot.query);
+    glDrawArrays(GL_TRIANGLES, 0, 36);
+    glEndQuery(GL_ANY_SAMPLES_PASSED);
+
+    slot.pending = true;
+    stats.issued++;
+}
+
+void OcclusionCuller::endQueries() {
+    GLState::setColorMask(true);
+}
+
+bool OcclusionCuller::beginConditional(size_t key) {
+    if (key >= slots.size() || !slots[key].pending) return false;
+
+    // NO_WAIT: if the result isn't back yet the GPU just draws the object
+    glBeginConditionalRender(slots[key].query, GL_QUERY_NO_WAIT);
+    return true;
+}
+
+void OcclusionCuller::endConditional() {
+    glEndConditionalRender();
+}
@@ -0,0 +1,63 @@
+#ifndef OCCLUSION_CULLER_H
+#define OCCLUSION_CULLER_H
+
+#include "glad/glad.h"
+#include "Bounds.hpp"
+#include "Shader.hpp"
+#include <glm/glm.hpp>
+#include <vector>
+
+// Hardware occlusion queries with one frame of latency.
+// Each key (scene object index) owns a GL_ANY_SAMPLES_PASSED query that is
+// issued by rasterizing its bounding box against the depth buffer. Results are
+// only read once the GPU reports them available, so the CPU never waits; until
+// then the last known answer is used, and objects believed hidden are drawn
+// under conditional rendering so the GPU can still drop them.
+class OcclusionCuller {
+public:
+    struct Stats {
+        unsigned int issued = 0;
+        unsigned int pending = 0;
+    };
+
+    OcclusionCuller();
+    ~OcclusionCuller();
+
+    OcclusionCuller(const OcclusionCuller&) = delete;
+    OcclusionCuller& operator=(const OcclusionCuller&) = delete;
+
+    void resize(size_t keyCount);
+    void reset();
+
+    // Polls last frame's queries without blocking and resets the frame stats
+    void collectResults();
+    bool wasVisible(size_t key) const;
+
+    // Bounding boxes are drawn with colour and depth writes off between these
+    void beginQueries(const glm::mat4& viewProjection, const glm::vec3& eye);
+    void issueQuery(size_t key, const AABB& box);
+    void endQueries();
+
+    // Wraps a draw in glBeginConditionalRender when the key has a query in flight
+    bool beginConditional(size_t key);
+    void endConditional();
+
+    const Stats& getStats() const { return stats; }
+
+private:
+    struct Slot {
+        GLuint query = 0;
+        bool visible = true;
+        bool pending = false;
+    };
+
+    std::vector<Slot> slots;
+    Stats stats;
+
+    Shader boxShader;
+    GLuint boxVAO;
+    GLuint boxVBO;
+    glm::vec3 eye;
+};
+
+#endif
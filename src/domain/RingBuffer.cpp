@@ -0,0 +1,153 @@
+#include "RingBuffer.hpp"
+#include "Logger.hpp"
+#include <algorithm>
+#include <iterator>
+#include <chrono>
+
+RingBuffer::RingBuffer(GLenum target, GLsizeiptr segmentSize, int segmentCount)
+    : target(target)
+    , buffer(0)
+    , segmentSize(segmentSize)
+    , segmentCount(std::clamp(segmentCount, 1, 8))
+    , currentSegment(0)
+    , head(0)
+    , persistent(false)
+    , mapped(nullptr)
+    , segmentBase(nullptr)
+    , stallCount(0)
+    , stallSeconds(0.0)
+    , frameStalled(false) {
+    std::fill(std::begin(fences), std::end(fences), nullptr);
+    create();
+}
+
+RingBuffer::~RingBuffer() {
+    destroy();
+}
+
+void RingBuffer::create() {
+    GLsizeiptr totalSize = segmentSize * segmentCount;
+    persistent = GLAD_GL_VERSION_4_4 != 0;
+
+    glGenBuffers(1, &buffer);
+    glBindBuffer(target, buffer);
+
+    if (persistent) {
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(target, totalSize, nullptr, flags);
+        mapped = static_cast<unsigned char*>(glMapBufferRange(target, 0, totalSize, flags));
+        if (mapped == nullptr) {
+            LOG_WARNING("RingBuffer: persistent mapping failed, falling back to per-frame mapping");
+            persistent = false;
+            glDeleteBuffers(1, &buffer);
+            glGenBuffers(1, &buffer);
+            glBindBuffer(target, buffer);
+        }
+    }
+
+    if (!persistent) {
+        glBufferData(target, totalSize, nullptr, GL_STREAM_DRAW);
+    }
+
+    glBindBuffer(target, 0);
+}
+
+void RingBuffer::destroy() {
+    for (int i = 0; i < segmentCount; i++) {
+        if (fences[i] != nullptr) {
+            glClientWaitSync(fences[i], GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+            glDeleteSync(fences[i]);
+            fences[i] = nullptr;
+        }
+    }
+
+    if (buffer != 0) {
+        if (mapped != nullptr || segmentBase != nullptr) {
+            glBindBuffer(target, buffer);
+            glUnmapBuffer(target);
+            glBindBuffer(target, 0);
+        }
+        glDeleteBuffers(1, &buffer);
+    }
+
+    buffer = 0;
+    mapped = nullptr;
+    segmentBase = nullptr;
+}
+
+void RingBuffer::reserve(GLsizeiptr newSegmentSize) {
+    if (newSegmentSize <= segmentSize) return;
+
+    destroy();
+    segmentSize = newSegmentSize;
+    currentSegment = 0;
+    head = 0;
+    create();
+}
+
+void RingBuffer::waitForSegment(int segment) {
+    GLsync fence = fences[segment];
+    if (fence == nullptr) return;
+
+    // A zero-timeout poll tells us whether the GPU is already done with this
+    // segment; anything else means the CPU has caught up and must block.
+    GLenum status = glClientWaitSync(fence, 0, 0);
+    if (status == GL_TIMEOUT_EXPIRED) {
+        frameStalled = true;
+        stallCount++;
+
+        auto start = std::chrono::steady_clock::now();
+        do {
+            status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+        } while (status == GL_TIMEOUT_EXPIRED);
+        stallSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    glDeleteSync(fence);
+    fences[segment] = nullptr;
+}
+
+void RingBuffer::beginFrame() {
+    frameStalled = false;
+    head = 0;
+    waitForSegment(currentSegment);
+
+    GLintptr segmentOffset = segmentSize * currentSegment;
+    if (persistent) {
+        segmentBase = mapped + segmentOffset;
+    } else {
+        // The fence already guarantees the GPU is done with this range.
+        glBindBuffer(target, buffer);
+        segmentBase = static_cast<unsigned char*>(glMapBufferRange(target, segmentOffset, segmentSize,
+            GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT));
+        glBindBuffer(target, 0);
+    }
+}
+
+RingBuffer::Allocation RingBuffer::allocate(GLsizeiptr size, GLsizeiptr alignment) {
+    GLsizeiptr alignedHead = (head + alignment - 1) / alignment * alignment;
+    if (segmentBase == nullptr || alignedHead + size > segmentSize) {
+        return {nullptr, 0, 0};
+    }
+
+    head = alignedHead + size;
+    return {segmentBase + alignedHead, segmentSize * currentSegment + alignedHead, size};
+}
+
+void RingBuffer::flush() {
+    if (!persistent && segmentBase != nullptr) {
+        glBindBuffer(target, buffer);
+        glUnmapBuffer(target);
+        glBindBuffer(target, 0);
+    }
+    if (!persistent) {
+        segmentBase = nullptr;
+    }
+}
+
+void RingBuffer::endFrame() {
+    flush();
+    fences[currentSegment] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    currentSegment = (currentSegment + 1) % segmentCount;
+    segmentBase = nullptr;
+}
@@ -0,0 +1,63 @@
+#ifndef RING_BUFFER_H
+#define RING_BUFFER_H
+
+#include "glad/glad.h"
+
+// Triple-buffered streaming buffer for per-frame dynamic data.
+// On GL 4.4+ the storage is persistently and coherently mapped, so writes land
+// directly in GPU-visible memory; older contexts map each segment unsynchronized
+// for the duration of the frame instead. Every segment is guarded by a fence so
+// the CPU never overwrites data the GPU may still be reading.
+class RingBuffer {
+public:
+    struct Allocation {
+        void* data;
+        GLintptr offset;
+        GLsizeiptr size;
+    };
+
+    RingBuffer(GLenum target, GLsizeiptr segmentSize, int segmentCount = 3);
+    ~RingBuffer();
+
+    RingBuffer(const RingBuffer&) = delete;
+    RingBuffer& operator=(const RingBuffer&) = delete;
+
+    void reserve(GLsizeiptr segmentSize);
+
+    void beginFrame();
+    Allocation allocate(GLsizeiptr size, GLsizeiptr alignment = 16);
+    void flush();
+    void endFrame();
+
+    GLuint getBuffer() const { return buffer; }
+    GLenum getTarget() const { return target; }
+    GLsizeiptr getSegmentSize() const { return segmentSize; }
+    bool isPersistent() const { return persistent; }
+
+    unsigned int getStallCount() const { return stallCount; }
+    double getStallSeconds() const { return stallSeconds; }
+    bool stalledThisFrame() const { return frameStalled; }
+
+private:
+    GLenum target;
+    GLuint buffer;
+    GLsizeiptr segmentSize;
+    int segmentCount;
+    int currentSegment;
+    GLsizeiptr head;
+
+    bool persistent;
+    unsigned char* mapped;
+    unsigned char* segmentBase;
+    GLsync fences[8];
+
+    unsigned int stallCount;
+    double stallSeconds;
+    bool frameStalled;
+
+    void create();
+    void destroy();
+    void waitForSegment(int segment);
+};
+
+#endif
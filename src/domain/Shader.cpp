@@ -1,7 +1,39 @@
 #include "Shader.hpp"
+#include "GLState.hpp"
+#include "Logger.hpp"
 #include <fstream>
 #include <sstream>
-#include <iostream>
+
+namespace {
+    const std::string INCLUDE_DIRECTIVE = "#include \"";
+
+    // GLSL has no #include of its own: each `#include "file"` line is replaced
+    // with that file, looked up next to the shader that includes it
+    std::string resolveIncludes(const std::string& code, const std::string& path) {
+        std::string directory = path.substr(0, path.find_last_of('/') + 1);
+        std::istringstream lines(code);
+        std::ostringstream result;
+        std::string line;
+        while (std::getline(lines, line)) {
+            if (line.compare(0, INCLUDE_DIRECTIVE.size(), INCLUDE_DIRECTIVE) != 0) {
+                result << line << '\n';
+                continue;
+            }
+
+            size_t end = line.find('"', INCLUDE_DIRECTIVE.size());
+            std::string includePath = directory + line.substr(INCLUDE_DIRECTIVE.size(), end - INCLUDE_DIRECTIVE.size());
+            std::ifstream includeFile(includePath);
+            if (!includeFile) {
+                LOG_ERROR("ERROR::SHADER::INCLUDE_NOT_FOUND: " << includePath);
+                continue;
+            }
+            std::stringstream includeStream;
+            includeStream << includeFile.rdbuf();
+            result << resolveIncludes(includeStream.str(), includePath);
+        }
+        return result.str();
+    }
+}
 
 Shader::Shader(const char* vertexPath, const char* fragmentPath) {
     std::string vertexCode;
@@ -23,11 +55,11 @@ Shader::Shader(const char* vertexPath, const char* fragmentPath) {
         vShaderFile.close();
         fShaderFile.close();
         
-        vertexCode = vShaderStream.str();
-        fragmentCode = fShaderStream.str();
+        vertexCode = resolveIncludes(vShaderStream.str(), vertexPath);
+        fragmentCode = resolveIncludes(fShaderStream.str(), fragmentPath);
     }
-    catch(std::ifstream::failure e) {
-        std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ" << std::endl;
+    catch(const std::ifstream::failure&) {
+        LOG_ERROR("ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ");
     }
     
     const char* vShaderCode = vertexCode.c_str();
@@ -55,8 +87,40 @@ Shader::Shader(const char* vertexPath, const char* fragmentPath) {
     glDeleteShader(fragment);
 }
 
+Shader::Shader(const char* computePath) {
+    std::string computeCode;
+    std::ifstream cShaderFile;
+
+    cShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+
+    try {
+        cShaderFile.open(computePath);
+        std::stringstream cShaderStream;
+        cShaderStream << cShaderFile.rdbuf();
+        cShaderFile.close();
+        computeCode = resolveIncludes(cShaderStream.str(), computePath);
+    }
+    catch(const std::ifstream::failure&) {
+        LOG_ERROR("ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ");
+    }
+
+    const char* cShaderCode = computeCode.c_str();
+
+    unsigned int compute = glCreateShader(GL_COMPUTE_SHADER);
+    glShaderSource(compute, 1, &cShaderCode, NULL);
+    glCompileShader(compute);
+    checkCompileErrors(compute, "COMPUTE");
+
+    ID = glCreateProgram();
+    glAttachShader(ID, compute);
+    glLinkProgram(ID);
+    checkCompileErrors(ID, "PROGRAM");
+
+    glDeleteShader(compute);
+}
+
 void Shader::use() {
-    glUseProgram(ID);
+    GLState::useProgram(ID);
 }
 
 void Shader::setBool(const std::string &name, bool value) const {
@@ -71,14 +135,33 @@ void Shader::setFloat(const std::string &name, float value) const {
     glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
 }
 
+void Shader::setVec2(const std::string &name, const glm::vec2 &value) const {
+    glUniform2fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+}
+
 void Shader::setVec3(const std::string &name, const glm::vec3 &value) const {
     glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
 }
 
+void Shader::setVec3Array(const std::string &name, const glm::vec3* values, int count) const {
+    glUniform3fv(glGetUniformLocation(ID, name.c_str()), count, &values[0][0]);
+}
+
+void Shader::setVec4(const std::string &name, const glm::vec4 &value) const {
+    glUniform4fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+}
+
 void Shader::setMat4(const std::string &name, const glm::mat4 &mat) const {
     glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
 }
 
+void Shader::bindUniformBlock(const std::string &name, unsigned int binding) const {
+    unsigned int index = glGetUniformBlockIndex(ID, name.c_str());
+    if (index != GL_INVALID_INDEX) {
+        glUniformBlockBinding(ID, index, binding);
+    }
+}
+
 void Shader::checkCompileErrors(unsigned int shader, std::string type) {
     int success;
     char infoLog[1024];
@@ -86,17 +169,15 @@ void Shader::checkCompileErrors(unsigned int shader, std::string type) {
         glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
         if (!success) {
             glGetShaderInfoLog(shader, 1024, NULL, infoLog);
-            std::cout << "ERROR::SHADER_COMPILATION_ERROR of type: " << type << "\n" 
-                      << infoLog << "\n -- --------------------------------------------------- -- " 
-                      << std::endl;
+            LOG_ERROR("ERROR::SHADER_COMPILATION_ERROR of type: " << type << "\n" 
+                      << infoLog << "\n -- --------------------------------------------------- -- ");
         }
     } else {
         glGetProgramiv(shader, GL_LINK_STATUS, &success);
         if (!success) {
             glGetProgramInfoLog(shader, 1024, NULL, infoLog);
-            std::cout << "ERROR::PROGRAM_LINKING_ERROR of type: " << type << "\n" 
-                      << infoLog << "\n -- --------------------------------------------------- -- " 
-                      << std::endl;
+            LOG_ERROR("ERROR::PROGRAM_LINKING_ERROR of type: " << type << "\n" 
+                      << infoLog << "\n -- --------------------------------------------------- -- ");
         }
     }
 } 
\ No newline at end of file
@@ -8,13 +8,19 @@
 class Shader {
 public:
     Shader(const char* vertexPath, const char* fragmentPath);
+    // Compute-only program (GL 4.3+)
+    explicit Shader(const char* computePath);
     
     void use();
     void setBool(const std::string &name, bool value) const;
     void setInt(const std::string &name, int value) const;
     void setFloat(const std::string &name, float value) const;
+    void setVec2(const std::string &name, const glm::vec2 &value) const;
     void setVec3(const std::string &name, const glm::vec3 &value) const;
+    void setVec3Array(const std::string &name, const glm::vec3* values, int count) const;
+    void setVec4(const std::string &name, const glm::vec4 &value) const;
     void setMat4(const std::string &name, const glm::mat4 &mat) const;
+    void bindUniformBlock(const std::string &name, unsigned int binding) const;
     
     unsigned int ID;
 
@@ -0,0 +1,178 @@
+#include "ShadowCache.hpp"
+#include "GLState.hpp"
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+
+namespace {
+    const float SHADOW_NEAR = 0.05f;
+
+    struct CubeFace {
+        glm::vec3 direction;
+        glm::vec3 up;
+    };
+
+    // GL cube map face order: +X, -X, +Y, -Y, +Z, -Z
+    const CubeFace cubeFaces[6] = {
+        {{1.0f, 0.0f, 0.0f}, {0.0f, -1.0f, 0.0f}},
+        {{-1.0f, 0.0f, 0.0f}, {0.0f, -1.0f, 0.0f}},
+        {{0.0f, 1.0f, 0.0f}, {0.0f, 0.0f, 1.0f}},
+        {{0.0f, -1.0f, 0.0f}, {0.0f, 0.0f, -1.0f}},
+        {{0.0f, 0.0f, 1.0f}, {0.0f, -1.0f, 0.0f}},
+        {{0.0f, 0.0f, -1.0f}, {0.0f, -1.0f, 0.0f}},
+    };
+}
+
+ShadowCache::ShadowCache(int resolution, int maxPassesPerFrame)
+    : resolution(resolution)
+    , maxPassesPerFrame(maxPassesPerFrame)
+    , framebuffer(0)
+    , depthShader("src/shaders/shadow_cube.vert", "src/shaders/shadow_cube.frag")
+    , pendingInvalidations(0) {
+    for (Entry& entry : entries) {
+        glGenTextures(1, &entry.cubeMap);
+        GLState::bindTexture(FIRST_UNIT, GL_TEXTURE_CUBE_MAP, entry.cubeMap);
+        for (int face = 0; face < 6; face++) {
+            glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, 0, GL_DEPTH_COMPONENT24, resolution, resolution, 0,
+                         GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+        }
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    }
+
+    glGenFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glDrawBuffer(GL_NONE);
+    glReadBuffer(GL_NONE);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+ShadowCache::~ShadowCache() {
+    for (Entry& entry : entries) {
+        GLState::deleteTexture(entry.cubeMap);
+    }
+    if (framebuffer != 0) glDeleteFramebuffers(1, &framebuffer);
+    GLState::deleteProgram(depthShader.ID);
+}
+
+void ShadowCache::invalidateAll() {
+    for (Entry& entry : entries) {
+        if (entry.valid && !entry.dirty) pendingInvalidations++;
+        entry.valid = false;
+        entry.dirty = true;
+        entry.casters.clear();
+    }
+}
+
+void ShadowCache::gatherCasters(const LightClusters::PointLight& light, const std::vector<TexturedObj*>& casters,
+                                const AABBTree& tree) {
+    AABB box;
+    box.min = light.position - glm::vec3(light.radius);
+    box.max = light.position + glm::vec3(light.radius);
+
+    hits.clear();
+    tree.queryOverlap(box, hits);
+
+    current.clear();
+    for (int key : hits) {
+        const AABB& bounds = casters[key]->getWorldBounds();
+        glm::vec3 closest = glm::clamp(light.position, bounds.min, bounds.max);
+        glm::vec3 offset = closest - light.position;
+        if (glm::dot(offset, offset) > light.radius * light.radius) continue;
+        current.push_back({key, casters[key]->getTransformVersion()});
+    }
+    std::sort(current.begin(), current.end());
+}
+
+void ShadowCache::update(std::vector<LightClusters::PointLight>& lights, const std::vector<int>& keys,
+                         const std::vector<TexturedObj*>& casters, const AABBTree& tree) {
+    // invalidateAll() may have counted some since the last frame
+    stats = Stats();
+    stats.invalidations = pendingInvalidations;
+    pendingInvalidations = 0;
+
+    int slots = std::min(static_cast<int>(lights.size()), MAX_SHADOW_MAPS);
+    for (int slot = 0; slot < slots; slot++) {
+        Entry& entry = entries[slot];
+        LightClusters::PointLight& light = lights[slot];
+        light.shadowMap = slot;
+
+        gatherCasters(light, casters, tree);
+        bool stale = !entry.valid
+            || entry.key != keys[slot]
+            || entry.position != light.position
+            || entry.radius != light.radius
+            || entry.casters != current;
+        if (!stale) continue;
+
+        if (!entry.dirty) {
+            entry.dirty = true;
+            stats.invalidations++;
+        }
+        if (static_cast<int>(stats.passes) >= maxPassesPerFrame) {
+            // Out of budget: an old map of the same light beats none, but a
+            // map that was never rendered or belongs to another light is useless
+            if (!entry.valid || entry.key != keys[slot]) light.shadowMap = -1;
+            continue;
+        }
+
+        render(entry, light, casters);
+        entry.valid = true;
+        entry.dirty = false;
+        entry.key = keys[slot];
+        entry.position = light.position;
+        entry.radius = light.radius;
+        entry.casters.swap(current);
+        stats.passes++;
+    }
+
+    // Slots without a light keep their texture but must not be reused as is
+    for (int slot = slots; slot < MAX_SHADOW_MAPS; slot++) {
+        entries[slot].valid = false;
+    }
+}
+
+void ShadowCache::render(Entry& entry, const LightClusters::PointLight& light, const std::vector<TexturedObj*>& casters) {
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glViewport(0, 0, resolution, resolution);
+    GLState::setDepthTest(true);
+    GLState::setDepthMask(true);
+    GLState::setDepthFunc(GL_LESS);
+    GLState::setCullFace(false);
+    GLState::setPolygonMode(GL_FILL);
+
+    depthShader.use();
+    depthShader.setVec3("lightPos", light.position);
+    depthShader.setFloat("farPlane", light.radius);
+
+    glm::mat4 projection = glm::perspective(glm::radians(90.0f), 1.0f, SHADOW_NEAR, light.radius);
+    for (int face = 0; face < 6; face++) {
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_CUBE_MAP_POSITIVE_X + face,
+                               entry.cubeMap, 0);
+        glClear(GL_DEPTH_BUFFER_BIT);
+
+        glm::mat4 view = glm::lookAt(light.position, light.position + cubeFaces[face].direction, cubeFaces[face].up);
+        depthShader.setMat4("lightViewProjection", projection * view);
+        for (const auto& caster : current) {
+            TexturedObj* mesh = casters[caster.first];
+            depthShader.setMat4("model", mesh->getModelMatrix());
+            mesh->drawDepth();
+        }
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+}
+
+void ShadowCache::bind(Shader& shader) const {
+    static const char* names[MAX_SHADOW_MAPS] = {"shadowMap0", "shadowMap1", "shadowMap2", "shadowMap3"};
+    for (int slot = 0; slot < MAX_SHADOW_MAPS; slot++) {
+        GLState::bindTexture(FIRST_UNIT + slot, GL_TEXTURE_CUBE_MAP, entries[slot].cubeMap);
+        shader.setInt(names[slot], FIRST_UNIT + slot);
+    }
+}
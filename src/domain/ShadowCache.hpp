@@ -0,0 +1,79 @@
+#ifndef SHADOW_CACHE_H
+#define SHADOW_CACHE_H
+
+#include "glad/glad.h"
+#include "AABBTree.hpp"
+#include "LightClusters.hpp"
+#include "Shader.hpp"
+#include "TexturedObj.hpp"
+#include <glm/glm.hpp>
+#include <utility>
+#include <vector>
+
+// Omnidirectional shadow maps that are only re-rendered when they go stale.
+// The first MAX_SHADOW_MAPS lights each own a depth cube map storing the
+// distance to the nearest caster divided by the light's radius. A map
+// remembers the light position and radius it was rendered with and the
+// casters (with their transform versions) that were inside the light sphere.
+// When any of that differs, the map is invalidated. Re-renders are capped per
+// frame, so a burst of invalidations is spread out and a stale map is shown
+// meanwhile.
+class ShadowCache {
+public:
+    static const int MAX_SHADOW_MAPS = 4;
+    // Texture units used by bind(), after the light cluster buffers
+    static const int FIRST_UNIT = 8;
+
+    struct Stats {
+        unsigned int invalidations = 0;
+        unsigned int passes = 0;        // cube maps rendered (6 faces each)
+    };
+
+    explicit ShadowCache(int resolution = 512, int maxPassesPerFrame = 2);
+    ~ShadowCache();
+
+    ShadowCache(const ShadowCache&) = delete;
+    ShadowCache& operator=(const ShadowCache&) = delete;
+
+    // keys identify the lights across frames (e.g. their index in the scene).
+    // Sets shadowMap on the lights that got one. casters is indexed by the
+    // keys stored in tree.
+    void update(std::vector<LightClusters::PointLight>& lights, const std::vector<int>& keys,
+                const std::vector<TexturedObj*>& casters, const AABBTree& tree);
+
+    // Scene reloads replace every light and caster
+    void invalidateAll();
+
+    // Binds all cube maps and sets the shadowMap0..3 samplers on an active shader
+    void bind(Shader& shader) const;
+
+    Stats getStats() const { return stats; }
+
+private:
+    struct Entry {
+        GLuint cubeMap = 0;
+        bool valid = false;
+        bool dirty = true;
+        int key = -1;
+        glm::vec3 position = glm::vec3(0.0f);
+        float radius = 0.0f;
+        std::vector<std::pair<int, unsigned int>> casters;   // key, transform version
+    };
+
+    int resolution;
+    int maxPassesPerFrame;
+    Entry entries[MAX_SHADOW_MAPS];
+    GLuint framebuffer;
+    Shader depthShader;
+    Stats stats;
+    unsigned int pendingInvalidations;
+
+    std::vector<int> hits;
+    std::vector<std::pair<int, unsigned int>> current;
+
+    void gatherCasters(const LightClusters::PointLight& light, const std::vector<TexturedObj*>& casters,
+                       const AABBTree& tree);
+    void render(Entry& entry, const LightClusters::PointLight& light, const std::vector<TexturedObj*>& casters);
+};
+
+#endif
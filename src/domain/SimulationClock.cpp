@@ -0,0 +1,55 @@
+#include "SimulationClock.hpp"
+#include <algorithm>
+#include <cmath>
+
+SimulationClock::SimulationClock(float rate, int maxSteps)
+    : rate(DEFAULT_RATE)
+    , step(1.0f / DEFAULT_RATE)
+    , maxSteps(DEFAULT_MAX_STEPS)
+    , accumulator(0.0f)
+    , steps(0)
+    , droppedSteps(0)
+    , offset(0.0) {
+    setRate(rate);
+    setMaxSteps(maxSteps);
+}
+
+void SimulationClock::setRate(float newRate) {
+    if (!(newRate > 0.0f)) return;
+
+    float alpha = getAlpha();
+    offset = getTime();
+    steps = 0;
+    rate = newRate;
+    step = 1.0f / newRate;
+    accumulator = alpha * step;
+}
+
+void SimulationClock::setMaxSteps(int newMaxSteps) {
+    maxSteps = std::max(newMaxSteps, 1);
+}
+
+void SimulationClock::reset() {
+    accumulator = 0.0f;
+    steps = 0;
+    droppedSteps = 0;
+    offset = 0.0;
+}
+
+int SimulationClock::advance(float frameTime) {
+    accumulator += std::max(frameTime, 0.0f);
+
+    double due = std::floor(static_cast<double>(accumulator) / step);
+    accumulator = static_cast<float>(accumulator - due * step);
+    // Rounding can leave a hair over a step, or under zero
+    if (accumulator >= step) {
+        accumulator -= step;
+        due += 1.0;
+    }
+    accumulator = std::max(accumulator, 0.0f);
+
+    int run = static_cast<int>(std::min(due, static_cast<double>(maxSteps)));
+    droppedSteps += static_cast<unsigned long>(due) - run;
+    steps += run;
+    return run;
+}
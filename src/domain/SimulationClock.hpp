@@ -0,0 +1,49 @@
+#ifndef SIMULATION_CLOCK_H
+#define SIMULATION_CLOCK_H
+
+// Fixed-step simulation time, decoupled from the frame rate.
+// Each frame hands its real duration to advance(), which says how many steps
+// of exactly getStep() seconds to simulate (zero on a fast frame, several on a
+// slow one). Whatever is left over is returned by getAlpha() as a fraction of a
+// step: keep the state before and after the last step and draw
+// mix(previous, current, alpha). Steps per frame are capped so that a long
+// stall drops time instead of piling up more steps than a frame can run.
+class SimulationClock {
+public:
+    static constexpr float DEFAULT_RATE = 60.0f;
+    static const int DEFAULT_MAX_STEPS = 8;
+
+    explicit SimulationClock(float rate = DEFAULT_RATE, int maxSteps = DEFAULT_MAX_STEPS);
+
+    // Steps per second; the leftover time is kept as the same fraction of a step
+    void setRate(float rate);
+    void setMaxSteps(int steps);
+    void reset();
+
+    // Returns the number of fixed steps to run for a frame that took frameTime seconds
+    int advance(float frameTime);
+
+    float getRate() const { return rate; }
+    float getStep() const { return step; }
+    int getMaxSteps() const { return maxSteps; }
+    float getAlpha() const { return accumulator / step; }
+
+    // Time at the latest step, and the time to draw at (alpha of the way from the step before)
+    double getTime() const { return steps * static_cast<double>(step) + offset; }
+    double getRenderTime() const { return getTime() - step + accumulator; }
+
+    unsigned long getStepCount() const { return steps; }
+    unsigned long getDroppedSteps() const { return droppedSteps; }
+
+private:
+    float rate;
+    float step;
+    int maxSteps;
+    float accumulator;
+
+    unsigned long steps;
+    unsigned long droppedSteps;
+    double offset;      // time simulated at earlier rates
+};
+
+#endif
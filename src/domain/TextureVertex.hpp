@@ -0,0 +1,13 @@
+#ifndef TEXTURE_VERTEX_H
+#define TEXTURE_VERTEX_H
+
+#include <glm/glm.hpp>
+
+struct TextureVertex
+{
+    glm::vec3 position;
+    glm::vec3 normal;
+    glm::vec2 texCoord;
+};
+
+#endif
@@ -1,41 +1,47 @@
 #include "TexturedObj.hpp"
+#include "GLState.hpp"
+#include "MeshSimplifier.hpp"
+#include "Logger.hpp"
 #include <fstream>
 #include <sstream>
-#include <iostream>
 #include <algorithm>
 
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
 
 TexturedObj::TexturedObj(const std::string &filename)
-    : Obj(filename), texturedVAO(0), texturedVBO(0)
+    : Obj(filename), texturedVAO(0), texturedVBO(0), lightmapVBO(0), currentLOD(0)
 {
-    std::cout << "TexturedObj constructor called with: " << filename << std::endl;
+    LOG_DEBUG("TexturedObj constructor called with: " << filename);
 
     if (loadTexturedOBJ(filename))
     {
         setupTexturedMesh();
-        std::cout << "Loaded textured model: " << filename << std::endl;
+        LOG_INFO("Loaded textured model: " << filename);
     }
     else
     {
-        std::cout << "Using basic model without textures: " << filename << std::endl;
+        LOG_INFO("Using basic model without textures: " << filename);
     }
 }
 
 TexturedObj::~TexturedObj()
 {
-    if (texturedVAO != 0)
-        glDeleteVertexArrays(1, &texturedVAO);
+    GLState::deleteVertexArray(texturedVAO);
     if (texturedVBO != 0)
         glDeleteBuffers(1, &texturedVBO);
+    if (lightmapVBO != 0)
+        glDeleteBuffers(1, &lightmapVBO);
+
+    for (size_t i = 1; i < lods.size(); i++)
+    {
+        GLState::deleteVertexArray(lods[i].VAO);
+        glDeleteBuffers(1, &lods[i].VBO);
+    }
 
     for (auto &pair : materials)
     {
-        if (pair.second.textureID != 0)
-        {
-            glDeleteTextures(1, &pair.second.textureID);
-        }
+        GLState::deleteTexture(pair.second.textureID);
     }
 }
 
@@ -126,10 +132,10 @@ bool TexturedObj::loadTexturedOBJ(const std::string &path)
 
     file.close();
 
-    std::cout << "Loaded OBJ: " << vertices.size() << " vertices, "
+    LOG_DEBUG("Loaded OBJ: " << vertices.size() << " vertices, "
               << texCoords.size() << " texture coords, "
               << normals.size() << " normals, "
-              << faces.size() << " faces" << std::endl;
+              << faces.size() << " faces");
 
     return !vertices.empty() && !faces.empty();
 }
@@ -139,7 +145,7 @@ bool TexturedObj::loadMTL(const std::string &path)
     std::ifstream file(path);
     if (!file.is_open())
     {
-        std::cout << "Warning: Cannot open MTL file: " << path << std::endl;
+        LOG_WARNING("Cannot open MTL file: " << path);
         return false;
     }
 
@@ -205,7 +211,7 @@ GLuint TexturedObj::loadTexture(const std::string &filePath, int &width, int &he
     GLuint texID;
 
     glGenTextures(1, &texID);
-    glBindTexture(GL_TEXTURE_2D, texID);
+    GLState::bindTexture(0, GL_TEXTURE_2D, texID);
 
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
@@ -227,15 +233,15 @@ GLuint TexturedObj::loadTexture(const std::string &filePath, int &width, int &he
             glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
         }
         glGenerateMipmap(GL_TEXTURE_2D);
-        std::cout << "Loaded texture: " << filePath << " (" << width << "x" << height << ", " << nrChannels << " channels)" << std::endl;
+        LOG_INFO("Loaded texture: " << filePath << " (" << width << "x" << height << ", " << nrChannels << " channels)");
     }
     else
     {
-        std::cout << "Failed to load texture: " << filePath << std::endl;
+        LOG_WARNING("Failed to load texture: " << filePath);
     }
 
     stbi_image_free(data);
-    glBindTexture(GL_TEXTURE_2D, 0);
+    GLState::bindTexture(0, GL_TEXTURE_2D, 0);
 
     return texID;
 }
@@ -267,25 +273,112 @@ void TexturedObj::setupTexturedMesh()
 
     if (!processedVertices.empty())
     {
-        glGenVertexArrays(1, &texturedVAO);
-        glGenBuffers(1, &texturedVBO);
+        std::vector<glm::vec3> points;
+        points.reserve(processedVertices.size());
+        for (const TextureVertex &vertex : processedVertices)
+        {
+            points.push_back(vertex.position);
+        }
+        computeBounds(points);
 
-        glBindVertexArray(texturedVAO);
+        texturedVAO = createVertexArray(processedVertices, texturedVBO);
+        buildLODs();
+    }
+}
+
+GLuint TexturedObj::createVertexArray(const std::vector<TextureVertex> &meshVertices, GLuint &vbo) const
+{
+    GLuint vao;
+    glGenVertexArrays(1, &vao);
+    glGenBuffers(1, &vbo);
 
-        glBindBuffer(GL_ARRAY_BUFFER, texturedVBO);
-        glBufferData(GL_ARRAY_BUFFER, processedVertices.size() * sizeof(TextureVertex), &processedVertices[0], GL_STATIC_DRAW);
+    GLState::bindVertexArray(vao);
 
-        glEnableVertexAttribArray(0);
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(TextureVertex), (void *)0);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBufferData(GL_ARRAY_BUFFER, meshVertices.size() * sizeof(TextureVertex), &meshVertices[0], GL_STATIC_DRAW);
 
-        glEnableVertexAttribArray(1);
-        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(TextureVertex), (void *)offsetof(TextureVertex, normal));
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(TextureVertex), (void *)0);
 
-        glEnableVertexAttribArray(2);
-        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(TextureVertex), (void *)offsetof(TextureVertex, texCoord));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(TextureVertex), (void *)offsetof(TextureVertex, normal));
+
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(TextureVertex), (void *)offsetof(TextureVertex, texCoord));
+
+    GLState::bindVertexArray(0);
+    return vao;
+}
 
-        glBindVertexArray(0);
+// Simplifies once down through 50%, 25% and 10% of the triangles, keeping a
+// snapshot at each step. Levels that barely shrink (e.g. flat-shaded meshes
+// where hard normals lock most vertices) are dropped.
+void TexturedObj::buildLODs()
+{
+    const float LOD_RATIOS[] = {0.5f, 0.25f, 0.1f};
+    const float MIN_REDUCTION = 0.8f;
+
+    lods.clear();
+    lods.push_back({texturedVAO, texturedVBO, static_cast<GLsizei>(processedVertices.size())});
+
+    MeshSimplifier simplifier(processedVertices);
+    size_t baseTriangles = simplifier.getTriangleCount();
+    size_t previousTriangles = baseTriangles;
+
+    for (float ratio : LOD_RATIOS)
+    {
+        size_t target = static_cast<size_t>(baseTriangles * ratio);
+        if (target < 4)
+            break;
+
+        size_t triangles = simplifier.simplify(target);
+        if (triangles > previousTriangles * MIN_REDUCTION)
+            continue;
+
+        std::vector<TextureVertex> simplified = simplifier.extract();
+        LODLevel level;
+        level.VAO = createVertexArray(simplified, level.VBO);
+        level.vertexCount = static_cast<GLsizei>(simplified.size());
+        lods.push_back(level);
+        previousTriangles = triangles;
+    }
+
+    std::ostringstream chain;
+    for (const LODLevel &level : lods)
+    {
+        chain << " " << level.vertexCount / 3;
     }
+    LOG_DEBUG("LOD chain:" << chain.str() << " triangles");
+}
+
+int TexturedObj::getLODCount() const
+{
+    return lods.empty() ? 1 : static_cast<int>(lods.size());
+}
+
+void TexturedObj::setLOD(int level)
+{
+    currentLOD = std::max(0, std::min(level, getLODCount() - 1));
+}
+
+size_t TexturedObj::getTriangleCount(int level) const
+{
+    if (level < 0 || level >= static_cast<int>(lods.size()))
+        return 0;
+    return lods[level].vertexCount / 3;
+}
+
+void TexturedObj::drawDepth() const
+{
+    if (currentLOD == 0)
+    {
+        Obj::drawDepth();
+        return;
+    }
+
+    // Coarse levels are drawn from their full vertex stream; the depth shader only reads location 0
+    GLState::bindVertexArray(lods[currentLOD].VAO);
+    glDrawArrays(GL_TRIANGLES, 0, lods[currentLOD].vertexCount);
 }
 
 void TexturedObj::drawTextured(GLuint shaderProgram) const
@@ -298,8 +391,7 @@ void TexturedObj::drawTextured(GLuint shaderProgram) const
     {
         if (pair.second.textureID != 0)
         {
-            glActiveTexture(GL_TEXTURE0);
-            glBindTexture(GL_TEXTURE_2D, pair.second.textureID);
+            GLState::bindTexture(0, GL_TEXTURE_2D, pair.second.textureID);
             glUniform1i(glGetUniformLocation(shaderProgram, "texture_diffuse1"), 0);
             hasTexture = true;
             break;
@@ -308,9 +400,8 @@ void TexturedObj::drawTextured(GLuint shaderProgram) const
 
     glUniform1i(glGetUniformLocation(shaderProgram, "useTexture"), hasTexture);
 
-    glBindVertexArray(texturedVAO);
-    glDrawArrays(GL_TRIANGLES, 0, processedVertices.size());
-    glBindVertexArray(0);
+    GLState::bindVertexArray(lods[currentLOD].VAO);
+    glDrawArrays(GL_TRIANGLES, 0, lods[currentLOD].vertexCount);
 }
 
 bool TexturedObj::hasTextures() const
@@ -327,11 +418,10 @@ bool TexturedObj::hasTextures() const
 
 void TexturedObj::drawWithTextures() const
 {
-    if (hasTextures() && texturedVAO != 0)
+    if (currentLOD > 0 || lightmapVBO != 0 || (hasTextures() && texturedVAO != 0))
     {
-        glBindVertexArray(texturedVAO);
-        glDrawArrays(GL_TRIANGLES, 0, processedVertices.size());
-        glBindVertexArray(0);
+        GLState::bindVertexArray(lods[currentLOD].VAO);
+        glDrawArrays(GL_TRIANGLES, 0, lods[currentLOD].vertexCount);
     }
     else
     {
@@ -339,6 +429,34 @@ void TexturedObj::drawWithTextures() const
     }
 }
 
+GLuint TexturedObj::getDiffuseTexture() const
+{
+    for (const auto &pair : materials)
+    {
+        if (pair.second.textureID != 0)
+        {
+            return pair.second.textureID;
+        }
+    }
+    return 0;
+}
+
+void TexturedObj::setLightmapUVs(const std::vector<glm::vec2> &uvs)
+{
+    if (texturedVAO == 0 || uvs.size() != processedVertices.size())
+        return;
+
+    if (lightmapVBO == 0)
+        glGenBuffers(1, &lightmapVBO);
+
+    GLState::bindVertexArray(texturedVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, lightmapVBO);
+    glBufferData(GL_ARRAY_BUFFER, uvs.size() * sizeof(glm::vec2), uvs.data(), GL_STATIC_DRAW);
+    glEnableVertexAttribArray(3);
+    glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, sizeof(glm::vec2), (void *)0);
+    GLState::bindVertexArray(0);
+}
+
 Material TexturedObj::getMaterial() const
 {
     if (!materials.empty())
@@ -2,6 +2,7 @@
 #define TEXTURED_OBJ_H
 
 #include "Obj.hpp"
+#include "TextureVertex.hpp"
 #include <map>
 #include <string>
 
@@ -16,13 +17,6 @@ struct Material
     GLuint textureID = 0;
 };
 
-struct TextureVertex
-{
-    glm::vec3 position;
-    glm::vec3 normal;
-    glm::vec2 texCoord;
-};
-
 struct Face
 {
     unsigned int v1, v2, v3;
@@ -43,10 +37,25 @@ private:
     GLuint texturedVAO, texturedVBO;
     std::vector<TextureVertex> processedVertices;
 
+    // Second UV set for a baked lightmap, attribute 3 of the full-detail VAO only
+    GLuint lightmapVBO;
+
+    // Level 0 is the full mesh (texturedVAO); coarser levels come from the simplifier
+    struct LODLevel
+    {
+        GLuint VAO;
+        GLuint VBO;
+        GLsizei vertexCount;
+    };
+    std::vector<LODLevel> lods;
+    int currentLOD;
+
     bool loadTexturedOBJ(const std::string &filename);
     bool loadMTL(const std::string &path);
     GLuint loadTexture(const std::string &filePath, int &width, int &height);
     void setupTexturedMesh();
+    void buildLODs();
+    GLuint createVertexArray(const std::vector<TextureVertex> &meshVertices, GLuint &vbo) const;
 
 public:
     TexturedObj(const std::string &filename);
@@ -56,6 +65,21 @@ public:
     bool hasTextures() const;
 
     void drawWithTextures() const;
+    void drawDepth() const;
+
+    int getLODCount() const;
+    int getLOD() const { return currentLOD; }
+    void setLOD(int level);
+    size_t getTriangleCount(int level) const;
+
+    // Full-detail triangle list and the texture drawTextured binds, for
+    // renderers that batch meshes into their own buffers
+    const std::vector<TextureVertex> &getVertices() const { return processedVertices; }
+    GLuint getDiffuseTexture() const;
+
+    // One UV per vertex of getVertices(); only level 0 carries them
+    void setLightmapUVs(const std::vector<glm::vec2> &uvs);
+    bool hasLightmapUVs() const { return lightmapVBO != 0; }
 
     Material getMaterial() const;
     bool hasMaterials() const;
@@ -7,6 +7,9 @@
 #include <fstream>
 #include <iostream>
 #include <cmath>
+#include <algorithm>
+#include "CurveKernels.hpp"
+#include "Logger.hpp"
 
 enum class InterpolationType {
     LINEAR,
@@ -14,25 +17,37 @@ enum class InterpolationType {
     SPLINE
 };
 
+// Objects move along the curve at a constant speed in world units per
+// second. Whenever the curve changes, a table of arc length against curve
+// parameter is built by adaptive subdivision, so every position query is a
+// binary search plus a linear inverse inside one table interval.
 class Trajectory
 {
 public:
-    Trajectory() : currentPoint(0), speed(1.0f), interpolationType(InterpolationType::LINEAR), 
-                   currentTime(0.0f), totalTime(0.0f) {}
+    Trajectory() : speed(1.0f), interpolationType(InterpolationType::LINEAR), currentDistance(0.0f) {}
 
     void addPoint(const glm::vec3 &point)
     {
         controlPoints.push_back(point);
-        std::cout << "Added point " << controlPoints.size() << ": (" 
-                  << point.x << ", " << point.y << ", " << point.z << ")" << std::endl;
-        updateTotalTime();
+        LOG_DEBUG("Added point " << controlPoints.size() << ": (" 
+                  << point.x << ", " << point.y << ", " << point.z << ")");
+        rebuild();
+    }
+
+    // Replaces every control point with one rebuild, for loaders
+    void setPoints(const std::vector<glm::vec3> &points)
+    {
+        controlPoints = points;
+        LOG_DEBUG("Set " << controlPoints.size() << " points");
+        rebuild();
     }
 
     void setInterpolationType(InterpolationType type)
     {
         interpolationType = type;
-        std::cout << "Interpolation type set to: " << (type == InterpolationType::LINEAR ? "LINEAR" : 
-                                                       type == InterpolationType::BEZIER ? "BEZIER" : "SPLINE") << std::endl;
+        rebuild();
+        LOG_DEBUG("Interpolation type set to: " << (type == InterpolationType::LINEAR ? "LINEAR" : 
+                                                       type == InterpolationType::BEZIER ? "BEZIER" : "SPLINE"));
     }
 
     InterpolationType getInterpolationType() const
@@ -47,31 +62,113 @@ public:
             return glm::vec3(0.0f);
         }
 
-        if (controlPoints.size() == 1)
+        if (controlPoints.size() == 1 || getLength() <= 0.0f)
         {
             return controlPoints[0];
         }
 
-        currentTime += speed * deltaTime;
+        currentDistance += speed * deltaTime;
         
-        if (currentTime >= totalTime)
+        if (currentDistance >= getLength())
         {
-            currentTime = 0.0f;
-            std::cout << "Completed trajectory cycle" << std::endl;
+            // Keep the overshoot so the loop point doesn't stall the object
+            currentDistance = std::fmod(currentDistance, getLength());
+            LOG_DEBUG("Completed trajectory cycle");
         }
 
-        float t = currentTime / totalTime;
+        return interpolate(parameterAtDistance(currentDistance));
+    }
+
+    // How far getNextPosition has moved along the curve
+    float getDistance() const
+    {
+        return currentDistance;
+    }
+
+    // Point at curve parameter t in [0, 1]
+    glm::vec3 getPosition(float t) const
+    {
+        if (controlPoints.empty()) return glm::vec3(0.0f);
         return interpolate(t);
     }
 
+    // Length of the whole curve in world units
+    float getLength() const
+    {
+        return arcLengths.empty() ? 0.0f : arcLengths.back();
+    }
+
+    // Curve parameter in [0, 1] of the point the given distance along the curve
+    float parameterAtDistance(float distance) const
+    {
+        if (arcLengths.size() < 2 || getLength() <= 0.0f) return 0.0f;
+        if (distance <= 0.0f) return 0.0f;
+        if (distance >= getLength()) return 1.0f;
+
+        size_t i = std::upper_bound(arcLengths.begin(), arcLengths.end(), distance) - arcLengths.begin();
+        float s0 = arcLengths[i - 1];
+        float s1 = arcLengths[i];
+        float f = s1 > s0 ? (distance - s0) / (s1 - s0) : 0.0f;
+        return arcParams[i - 1] + f * (arcParams[i] - arcParams[i - 1]);
+    }
+
+    // Inverse of parameterAtDistance
+    float distanceAtParameter(float t) const
+    {
+        if (arcParams.size() < 2) return 0.0f;
+        if (t <= 0.0f) return 0.0f;
+        if (t >= 1.0f) return getLength();
+
+        size_t i = std::upper_bound(arcParams.begin(), arcParams.end(), t) - arcParams.begin();
+        float f = (t - arcParams[i - 1]) / (arcParams[i] - arcParams[i - 1]);
+        return arcLengths[i - 1] + f * (arcLengths[i] - arcLengths[i - 1]);
+    }
+
+    // Positions at many curve parameters at once, one output array per axis.
+    // LINEAR and SPLINE paths are evaluated by the SIMD kernels.
+    void samplePositions(const float* t, size_t count, float* x, float* y, float* z) const
+    {
+        if (controlPoints.size() < 2 || interpolationType == InterpolationType::BEZIER)
+        {
+            for (size_t i = 0; i < count; i++)
+            {
+                glm::vec3 position = controlPoints.empty() ? glm::vec3(0.0f) : interpolate(t[i]);
+                x[i] = position.x;
+                y[i] = position.y;
+                z[i] = position.z;
+            }
+            return;
+        }
+
+        CurveKernels::Points points = {pointsX.data(), pointsY.data(), pointsZ.data(),
+                                       static_cast<int>(controlPoints.size())};
+        if (interpolationType == InterpolationType::SPLINE)
+        {
+            CurveKernels::evaluateCatmullRom(points, t, x, y, z, count);
+        }
+        else
+        {
+            CurveKernels::evaluateLinear(points, t, x, y, z, count);
+        }
+    }
+
+    glm::vec3 getPositionAtDistance(float distance) const
+    {
+        if (controlPoints.empty()) return glm::vec3(0.0f);
+        return interpolate(parameterAtDistance(distance));
+    }
+
     void clear()
     {
         controlPoints.clear();
-        currentPoint = 0;
-        currentPosition = glm::vec3(0.0f);
-        currentTime = 0.0f;
-        totalTime = 0.0f;
-        std::cout << "Trajectory cleared" << std::endl;
+        currentDistance = 0.0f;
+        arcLengths.clear();
+        arcParams.clear();
+        bezierPieces.clear();
+        pointsX.clear();
+        pointsY.clear();
+        pointsZ.clear();
+        LOG_DEBUG("Trajectory cleared");
     }
 
     const std::vector<glm::vec3> &getControlPoints() const
@@ -82,7 +179,7 @@ public:
     void setSpeed(float newSpeed)
     {
         speed = newSpeed;
-        std::cout << "Speed set to: " << speed << std::endl;
+        LOG_DEBUG("Speed set to: " << speed << " units/s");
     }
 
     float getSpeed() const
@@ -95,7 +192,7 @@ public:
         std::ofstream file(filename);
         if (!file.is_open())
         {
-            std::cerr << "Failed to open file for writing: " << filename << std::endl;
+            LOG_ERROR("Failed to open file for writing: " << filename);
             return false;
         }
 
@@ -108,7 +205,7 @@ public:
         file << static_cast<int>(interpolationType) << std::endl;
         file << speed << std::endl;
         
-        std::cout << "Trajectory saved to: " << filename << std::endl;
+        LOG_INFO("Trajectory saved to: " << filename);
         return true;
     }
 
@@ -117,7 +214,7 @@ public:
         std::ifstream file(filename);
         if (!file.is_open())
         {
-            std::cerr << "Failed to open file for reading: " << filename << std::endl;
+            LOG_ERROR("Failed to open file for reading: " << filename);
             return false;
         }
 
@@ -137,53 +234,277 @@ public:
         interpolationType = static_cast<InterpolationType>(typeInt);
         
         file >> speed;
-        updateTotalTime();
+        rebuild();
         
-        std::cout << "Trajectory loaded from: " << filename << " (" << numPoints << " points)" << std::endl;
+        LOG_INFO("Trajectory loaded from: " << filename << " (" << numPoints << " points)");
         return true;
     }
 
     void printInfo() const
     {
-        std::cout << "Trajectory has " << controlPoints.size() << " control points:" << std::endl;
-        std::cout << "Interpolation type: " << (interpolationType == InterpolationType::LINEAR ? "LINEAR" : 
-                                               interpolationType == InterpolationType::BEZIER ? "BEZIER" : "SPLINE") << std::endl;
-        std::cout << "Speed: " << speed << std::endl;
+        LOG_INFO("Trajectory has " << controlPoints.size() << " control points:");
+        LOG_INFO("Interpolation type: " << (interpolationType == InterpolationType::LINEAR ? "LINEAR" : 
+                                              interpolationType == InterpolationType::BEZIER ? "BEZIER" : "SPLINE"));
+        LOG_INFO("Speed: " << speed << " units/s");
+        LOG_INFO("Length: " << getLength() << " units (" << arcLengths.size() << " arc length samples)");
+        if (interpolationType == InterpolationType::BEZIER)
+        {
+            LOG_INFO("Bezier: " << bezierPieces.size() << " cubic pieces, max error " << bezierError);
+        }
         for (size_t i = 0; i < controlPoints.size(); i++)
         {
             const auto& point = controlPoints[i];
-            std::cout << "  Point " << (i+1) << ": (" << point.x << ", " << point.y << ", " << point.z << ")" << std::endl;
+            LOG_INFO("  Point " << (i+1) << ": (" << point.x << ", " << point.y << ", " << point.z << ")");
         }
     }
 
 private:
     std::vector<glm::vec3> controlPoints;
-    size_t currentPoint;
-    glm::vec3 currentPosition;
     float speed;
     InterpolationType interpolationType;
-    float currentTime;
-    float totalTime;
+    float currentDistance;
+
+    // Arc length table: arcLengths[i] is the distance along the curve at
+    // parameter arcParams[i]. Both increase, starting at 0.
+    std::vector<float> arcLengths;
+    std::vector<float> arcParams;
+
+    // Table intervals start evenly spaced, a few per segment so that knots
+    // (where linear paths bend) fall on interval ends, and are then split
+    // adaptively
+    static constexpr int INTERVALS_PER_SEGMENT = 8;
+    static constexpr int MAX_SUBDIVISIONS = 10;
+    static constexpr float TOLERANCE = 1e-3f;
+
+    // Degree n Bezier curves are compiled into cubic pieces. Each piece
+    // matches the position and tangent of the exact curve at both ends, and
+    // pieces are split until they stay within BEZIER_TOLERANCE (relative to
+    // the size of the control polygon) of it. Evaluation is then a binary
+    // search and one cubic, whatever the control point count.
+    struct BezierPiece
+    {
+        float t0;
+        float t1;
+        glm::vec3 p0, p1, p2, p3;
+    };
+    std::vector<BezierPiece> bezierPieces;
+    float bezierError = 0.0f;
+
+    static constexpr int MAX_BEZIER_SPLITS = 16;
+    static constexpr float BEZIER_TOLERANCE = 1e-5f;
+
+    // Control points again, one array per axis, for the batch kernels
+    std::vector<float> pointsX;
+    std::vector<float> pointsY;
+    std::vector<float> pointsZ;
+
+    void rebuild()
+    {
+        pointsX.clear();
+        pointsY.clear();
+        pointsZ.clear();
+        for (const auto& point : controlPoints)
+        {
+            pointsX.push_back(point.x);
+            pointsY.push_back(point.y);
+            pointsZ.push_back(point.z);
+        }
+        compileBezier();
+        buildArcLengthTable();
+    }
 
-    void updateTotalTime()
+    struct ExactPoint
     {
+        long double x, y, z;
+    };
+
+    ExactPoint exactPoint(size_t i) const
+    {
+        return {controlPoints[i].x, controlPoints[i].y, controlPoints[i].z};
+    }
+
+    ExactPoint exactDifference(size_t i) const
+    {
+        ExactPoint a = exactPoint(i);
+        ExactPoint b = exactPoint(i + 1);
+        return {b.x - a.x, b.y - a.y, b.z - a.z};
+    }
+
+    // Exact curve point (and tangent, if wanted) in long double, the reference
+    // the cubic pieces are fitted to and checked against
+    glm::vec3 bezierReference(float t, glm::vec3* tangent = nullptr) const
+    {
+        size_t degree = controlPoints.size() - 1;
+        if (tangent)
+        {
+            *tangent = static_cast<float>(degree) *
+                       bernsteinSum(degree - 1, t, [this](size_t i) { return exactDifference(i); });
+        }
+        return bernsteinSum(degree, t, [this](size_t i) { return exactPoint(i); });
+    }
+
+    // Sum of B(degree, i, t) * value(i). The weights are built outwards from
+    // the largest one by their ratios and divided by their total, so none of
+    // them overflows at any degree, and both tails stop once negligible:
+    // O(degree) per sample without allocating.
+    template <typename Value>
+    static glm::vec3 bernsteinSum(size_t degree, float t, Value value)
+    {
+        ExactPoint sum = {0.0L, 0.0L, 0.0L};
+        if (t <= 0.0f)
+        {
+            sum = value(0);
+        }
+        else if (t >= 1.0f)
+        {
+            sum = value(degree);
+        }
+        else
+        {
+            const long double NEGLIGIBLE = 1e-40L;
+            long double ratio = t / (1.0L - t);
+            size_t mode = std::min(static_cast<size_t>((degree + 1) * static_cast<long double>(t)), degree);
+
+            long double total = 0.0L;
+            auto add = [&](size_t i, long double weight)
+            {
+                ExactPoint point = value(i);
+                sum.x += weight * point.x;
+                sum.y += weight * point.y;
+                sum.z += weight * point.z;
+                total += weight;
+            };
+
+            add(mode, 1.0L);
+            long double weight = 1.0L;
+            for (size_t i = mode; i < degree && weight > NEGLIGIBLE; i++)
+            {
+                weight *= ratio * (degree - i) / (i + 1);
+                add(i + 1, weight);
+            }
+            weight = 1.0L;
+            for (size_t i = mode; i > 0 && weight > NEGLIGIBLE; i--)
+            {
+                weight *= i / (ratio * (degree - i + 1));
+                add(i - 1, weight);
+            }
+            sum = {sum.x / total, sum.y / total, sum.z / total};
+        }
+        return glm::vec3(static_cast<float>(sum.x), static_cast<float>(sum.y), static_cast<float>(sum.z));
+    }
+
+    void compileBezier()
+    {
+        bezierPieces.clear();
+        bezierError = 0.0f;
+        if (interpolationType != InterpolationType::BEZIER || controlPoints.size() < 2) return;
+
+        glm::vec3 low = controlPoints[0];
+        glm::vec3 high = controlPoints[0];
+        for (const auto& point : controlPoints)
+        {
+            low = glm::min(low, point);
+            high = glm::max(high, point);
+        }
+        float tolerance = std::max(BEZIER_TOLERANCE * glm::length(high - low), 1e-6f);
+
+        // One piece per degree to begin with; a cubic can't follow more
+        // wiggles than that
+        int intervals = static_cast<int>(controlPoints.size() - 1);
+        glm::vec3 tangent0;
+        glm::vec3 point0 = bezierReference(0.0f, &tangent0);
+        for (int i = 1; i <= intervals; i++)
+        {
+            float t0 = static_cast<float>(i - 1) / intervals;
+            float t1 = static_cast<float>(i) / intervals;
+            glm::vec3 tangent1;
+            glm::vec3 point1 = bezierReference(t1, &tangent1);
+            fitBezierPiece(t0, point0, tangent0, t1, point1, tangent1, tolerance, 0);
+            point0 = point1;
+            tangent0 = tangent1;
+        }
+    }
+
+    void fitBezierPiece(float t0, const glm::vec3& point0, const glm::vec3& tangent0,
+                        float t1, const glm::vec3& point1, const glm::vec3& tangent1,
+                        float tolerance, int depth)
+    {
+        float span = (t1 - t0) / 3.0f;
+        BezierPiece piece = {t0, t1, point0, point0 + tangent0 * span, point1 - tangent1 * span, point1};
+
+        float error = 0.0f;
+        for (float u : {0.25f, 0.5f, 0.75f})
+        {
+            glm::vec3 exact = bezierReference(t0 + u * (t1 - t0));
+            error = std::max(error, glm::length(evaluatePiece(piece, u) - exact));
+        }
+
+        if (error > tolerance && depth < MAX_BEZIER_SPLITS)
+        {
+            float tm = 0.5f * (t0 + t1);
+            glm::vec3 tangentM;
+            glm::vec3 pointM = bezierReference(tm, &tangentM);
+            fitBezierPiece(t0, point0, tangent0, tm, pointM, tangentM, tolerance, depth + 1);
+            fitBezierPiece(tm, pointM, tangentM, t1, point1, tangent1, tolerance, depth + 1);
+            return;
+        }
+        bezierError = std::max(bezierError, error);
+        bezierPieces.push_back(piece);
+    }
+
+    static glm::vec3 evaluatePiece(const BezierPiece& piece, float u)
+    {
+        float v = 1.0f - u;
+        return (v * v * v) * piece.p0 + (3.0f * v * v * u) * piece.p1 +
+               (3.0f * v * u * u) * piece.p2 + (u * u * u) * piece.p3;
+    }
+
+    void buildArcLengthTable()
+    {
+        arcLengths.clear();
+        arcParams.clear();
         if (controlPoints.size() < 2) return;
-        
-        switch (interpolationType)
+
+        int intervals = static_cast<int>(controlPoints.size() - 1) * INTERVALS_PER_SEGMENT;
+        std::vector<float> t(intervals + 1), x(intervals + 1), y(intervals + 1), z(intervals + 1);
+        for (int i = 0; i <= intervals; i++)
         {
-            case InterpolationType::LINEAR:
-                totalTime = controlPoints.size();
-                break;
-            case InterpolationType::BEZIER:
-                totalTime = controlPoints.size() - 1;
-                break;
-            case InterpolationType::SPLINE:
-                totalTime = controlPoints.size() - 1;
-                break;
+            t[i] = static_cast<float>(i) / intervals;
+        }
+        samplePositions(t.data(), t.size(), x.data(), y.data(), z.data());
+
+        arcLengths.push_back(0.0f);
+        arcParams.push_back(0.0f);
+        for (int i = 1; i <= intervals; i++)
+        {
+            subdivide(t[i - 1], glm::vec3(x[i - 1], y[i - 1], z[i - 1]), t[i], glm::vec3(x[i], y[i], z[i]), 0);
+        }
+    }
+
+    void subdivide(float t0, const glm::vec3& p0, float t1, const glm::vec3& p1, int depth)
+    {
+        float tm = 0.5f * (t0 + t1);
+        glm::vec3 pm = interpolate(tm);
+        float first = glm::length(pm - p0);
+        float second = glm::length(p1 - pm);
+        float halves = first + second;
+        float chord = glm::length(p1 - p0);
+
+        // Split while the interval is curved or the curve's speed changes
+        // along it; otherwise the linear inverse in parameterAtDistance would
+        // be off
+        float tolerance = TOLERANCE * std::max(halves, 1e-3f);
+        if (depth < MAX_SUBDIVISIONS && (halves - chord > tolerance || std::abs(first - second) > tolerance))
+        {
+            subdivide(t0, p0, tm, pm, depth + 1);
+            subdivide(tm, pm, t1, p1, depth + 1);
+            return;
         }
+        arcLengths.push_back(arcLengths.back() + halves);
+        arcParams.push_back(t1);
     }
 
-    glm::vec3 interpolate(float t)
+    glm::vec3 interpolate(float t) const
     {
         switch (interpolationType)
         {
@@ -198,7 +519,7 @@ private:
         }
     }
 
-    glm::vec3 linearInterpolation(float t)
+    glm::vec3 linearInterpolation(float t) const
     {
         if (controlPoints.size() < 2) return controlPoints[0];
         
@@ -212,23 +533,18 @@ private:
         return glm::mix(controlPoints[segment], controlPoints[segment + 1], localT);
     }
 
-    glm::vec3 bezierInterpolation(float t)
+    glm::vec3 bezierInterpolation(float t) const
     {
-        if (controlPoints.size() < 2) return controlPoints[0];
-        
-        int n = controlPoints.size() - 1;
-        glm::vec3 result(0.0f);
-        
-        for (int i = 0; i <= n; i++)
-        {
-            float coefficient = binomialCoefficient(n, i) * std::pow(1.0f - t, n - i) * std::pow(t, i);
-            result += coefficient * controlPoints[i];
-        }
-        
-        return result;
+        if (bezierPieces.empty()) return controlPoints[0];
+
+        t = glm::clamp(t, 0.0f, 1.0f);
+        auto it = std::upper_bound(bezierPieces.begin(), bezierPieces.end(), t,
+                                   [](float value, const BezierPiece& piece) { return value < piece.t1; });
+        const BezierPiece& piece = it == bezierPieces.end() ? bezierPieces.back() : *it;
+        return evaluatePiece(piece, (t - piece.t0) / (piece.t1 - piece.t0));
     }
 
-    glm::vec3 splineInterpolation(float t)
+    glm::vec3 splineInterpolation(float t) const
     {
         if (controlPoints.size() < 4) return linearInterpolation(t);
         
@@ -256,18 +572,6 @@ private:
         
         return result;
     }
-
-    int binomialCoefficient(int n, int k)
-    {
-        if (k > n - k) k = n - k;
-        int result = 1;
-        for (int i = 0; i < k; i++)
-        {
-            result *= (n - i);
-            result /= (i + 1);
-        }
-        return result;
-    }
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,217 @@
+#include "TrajectorySystem.hpp"
+#include "CurveKernels.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    glm::vec3 cubic(const glm::vec3& c0, const glm::vec3& c1, const glm::vec3& c2, const glm::vec3& c3, float u) {
+        return ((c3 * u + c2) * u + c1) * u + c0;
+    }
+}
+
+int TrajectorySystem::addPath(const Trajectory& trajectory) {
+    size_t pointCount = trajectory.getControlPoints().size();
+    float length = trajectory.getLength();
+    if (pointCount < 2 || length <= 0.0f) return -1;
+
+    int path = static_cast<int>(pathLength.size());
+    pathFirstSegment.push_back(static_cast<int>(segmentStart.size()));
+    pathLength.push_back(length);
+
+    // Control points are where linear paths bend, so segments never span one
+    float previous = 0.0f;
+    for (size_t k = 1; k < pointCount; k++) {
+        float next = k + 1 == pointCount ? length
+                                         : trajectory.distanceAtParameter(static_cast<float>(k) / (pointCount - 1));
+        if (next > previous) {
+            fitSegment(trajectory, previous, next, 0);
+            previous = next;
+        }
+    }
+    pathSegmentCount.push_back(static_cast<int>(segmentStart.size()) - pathFirstSegment[path]);
+    return path;
+}
+
+void TrajectorySystem::fitSegment(const Trajectory& trajectory, float s0, float s1, int depth) {
+    float length = s1 - s0;
+    float h = 0.01f * length;
+    glm::vec3 p0 = trajectory.getPositionAtDistance(s0);
+    glm::vec3 p1 = trajectory.getPositionAtDistance(s1);
+
+    // One-sided tangents, so a corner at either end isn't rounded off
+    glm::vec3 m0 = (trajectory.getPositionAtDistance(s0 + h) - p0) * (length / h);
+    glm::vec3 m1 = (p1 - trajectory.getPositionAtDistance(s1 - h)) * (length / h);
+
+    glm::vec3 c0 = p0;
+    glm::vec3 c1 = m0;
+    glm::vec3 c2 = 3.0f * (p1 - p0) - 2.0f * m0 - m1;
+    glm::vec3 c3 = 2.0f * (p0 - p1) + m0 + m1;
+
+    if (depth < MAX_SPLITS) {
+        for (float u : {0.25f, 0.5f, 0.75f}) {
+            glm::vec3 exact = trajectory.getPositionAtDistance(s0 + u * length);
+            if (glm::length(cubic(c0, c1, c2, c3, u) - exact) > TOLERANCE) {
+                float middle = 0.5f * (s0 + s1);
+                fitSegment(trajectory, s0, middle, depth + 1);
+                fitSegment(trajectory, middle, s1, depth + 1);
+                return;
+            }
+        }
+    }
+
+    segmentStart.push_back(s0);
+    segmentScale.push_back(1.0f / length);
+    const glm::vec3 c[4] = {c0, c1, c2, c3};
+    for (int axis = 0; axis < 3; axis++) {
+        for (int power = 0; power < 4; power++) {
+            coefficients[axis][power].push_back(c[power][axis]);
+        }
+    }
+}
+
+int TrajectorySystem::addMover(int path, float speed, float distance) {
+    int mover = static_cast<int>(moverPath.size());
+    float length = pathLength[path];
+    distance = std::fmod(std::max(distance, 0.0f), length);
+
+    int first = pathFirstSegment[path];
+    int last = first + pathSegmentCount[path] - 1;
+    int segment = static_cast<int>(std::upper_bound(segmentStart.begin() + first, segmentStart.begin() + last + 1,
+                                                    distance) - segmentStart.begin()) - 1;
+
+    segment = std::max(segment, first);
+
+    moverPath.push_back(path);
+    moverSegment.push_back(segment);
+    moverDistance.push_back(distance);
+    moverSpeed.push_back(speed);
+    moverParameter.push_back((distance - segmentStart[segment]) * segmentScale[segment]);
+    positionX.push_back(0.0f);
+    positionY.push_back(0.0f);
+    positionZ.push_back(0.0f);
+    evaluateRange(mover, mover + 1);
+    return mover;
+}
+
+void TrajectorySystem::clear() {
+    pathFirstSegment.clear();
+    pathSegmentCount.clear();
+    pathLength.clear();
+    segmentStart.clear();
+    segmentScale.clear();
+    for (auto& axis : coefficients) {
+        for (auto& power : axis) {
+            power.clear();
+        }
+    }
+    moverPath.clear();
+    moverSegment.clear();
+    moverDistance.clear();
+    moverSpeed.clear();
+    moverParameter.clear();
+    positionX.clear();
+    positionY.clear();
+    positionZ.clear();
+}
+
+TrajectorySystem::~TrajectorySystem() {
+    {
+        std::lock_guard<std::mutex> lock(workMutex);
+        workStopping = true;
+    }
+    workReady.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+void TrajectorySystem::update(float deltaTime, int threads) {
+    size_t count = moverPath.size();
+    size_t ranges = std::min(static_cast<size_t>(std::max(threads, 1)),
+                             std::max<size_t>(count / MIN_MOVERS_PER_THREAD, 1));
+    if (ranges == 1) {
+        updateRange(0, count, deltaTime);
+        return;
+    }
+
+    size_t chunk = (count + ranges - 1) / ranges;
+    size_t helpers = (count + chunk - 1) / chunk - 1;
+    while (workers.size() < helpers) {
+        workers.emplace_back(&TrajectorySystem::workerLoop, this, workers.size(), workGeneration);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(workMutex);
+        workChunk = chunk;
+        workCount = count;
+        workDeltaTime = deltaTime;
+        workActive = helpers;
+        workPending = helpers;
+        workGeneration++;
+    }
+    workReady.notify_all();
+
+    updateRange(0, chunk, deltaTime);
+
+    std::unique_lock<std::mutex> lock(workMutex);
+    workDone.wait(lock, [this] { return workPending == 0; });
+}
+
+void TrajectorySystem::workerLoop(size_t index, unsigned long generation) {
+    for (;;) {
+        size_t begin, end;
+        float deltaTime;
+        {
+            std::unique_lock<std::mutex> lock(workMutex);
+            workReady.wait(lock, [&] { return workStopping || workGeneration != generation; });
+            if (workStopping) return;
+            generation = workGeneration;
+            if (index >= workActive) continue;
+
+            begin = (index + 1) * workChunk;
+            end = std::min(begin + workChunk, workCount);
+            deltaTime = workDeltaTime;
+        }
+
+        updateRange(begin, end, deltaTime);
+
+        std::lock_guard<std::mutex> lock(workMutex);
+        if (--workPending == 0) {
+            workDone.notify_one();
+        }
+    }
+}
+
+void TrajectorySystem::updateRange(size_t begin, size_t end, float deltaTime) {
+    for (size_t i = begin; i < end; i++) {
+        int path = moverPath[i];
+        float length = pathLength[path];
+        float distance = moverDistance[i] + moverSpeed[i] * deltaTime;
+        int segment = moverSegment[i];
+        if (distance >= length) {
+            distance = std::fmod(distance, length);
+            segment = pathFirstSegment[path];
+        }
+
+        int last = pathFirstSegment[path] + pathSegmentCount[path] - 1;
+        while (segment < last && distance >= segmentStart[segment + 1]) {
+            segment++;
+        }
+        moverDistance[i] = distance;
+        moverSegment[i] = segment;
+        moverParameter[i] = (distance - segmentStart[segment]) * segmentScale[segment];
+    }
+    evaluateRange(begin, end);
+}
+
+void TrajectorySystem::evaluateRange(size_t begin, size_t end) {
+    CurveKernels::Cubics cubics;
+    for (int axis = 0; axis < 3; axis++) {
+        for (int power = 0; power < 4; power++) {
+            cubics.coefficients[axis][power] = coefficients[axis][power].data();
+        }
+    }
+    CurveKernels::evaluateCubics(cubics, moverSegment.data() + begin, moverParameter.data() + begin,
+                                 positionX.data() + begin, positionY.data() + begin, positionZ.data() + begin,
+                                 end - begin);
+}
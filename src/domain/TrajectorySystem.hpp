@@ -0,0 +1,109 @@
+#ifndef TRAJECTORY_SYSTEM_H
+#define TRAJECTORY_SYSTEM_H
+
+#include "Trajectory.hpp"
+#include <glm/glm.hpp>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Advances every moving object in one pass over flat arrays.
+// Each Trajectory is compiled into a path: a run of cubic segments in
+// distance along the curve, fitted (Hermite, split until within tolerance) to
+// the trajectory's constant-speed motion. Segments and movers are stored as
+// structures of arrays; a mover remembers its segment, so a frame only steps
+// it forward instead of searching, and then all movers' cubics are evaluated
+// in one CurveKernels batch.
+// Paths can be shared by any number of movers.
+class TrajectorySystem {
+public:
+    // Largest distance between a segment and the trajectory it was fitted to
+    static constexpr float TOLERANCE = 1e-3f;
+
+    TrajectorySystem() = default;
+    ~TrajectorySystem();
+
+    TrajectorySystem(const TrajectorySystem&) = delete;
+    TrajectorySystem& operator=(const TrajectorySystem&) = delete;
+
+    // Returns the path id, or -1 if the trajectory has no length to move along
+    int addPath(const Trajectory& trajectory);
+    int addMover(int path, float speed, float distance = 0.0f);
+    void clear();
+
+    // Work is split across threads when there is enough of it. The worker
+    // threads are started by the first update that needs them and then sleep
+    // until the next one, so a fixed-step loop can call this many times a frame.
+    void update(float deltaTime, int threads = 1);
+
+    glm::vec3 getPosition(int mover) const {
+        return glm::vec3(positionX[mover], positionY[mover], positionZ[mover]);
+    }
+    float getDistance(int mover) const { return moverDistance[mover]; }
+
+    // Positions after the last update, one array per axis
+    const float* getPositionsX() const { return positionX.data(); }
+    const float* getPositionsY() const { return positionY.data(); }
+    const float* getPositionsZ() const { return positionZ.data(); }
+
+    // Compiled paths, e.g. for uploading them to the GPU (see CrowdRenderer)
+    int getPathFirstSegment(int path) const { return pathFirstSegment[path]; }
+    int getPathSegmentCount(int path) const { return pathSegmentCount[path]; }
+    float getPathLength(int path) const { return pathLength[path]; }
+    float getSegmentStart(int segment) const { return segmentStart[segment]; }
+    float getSegmentScale(int segment) const { return segmentScale[segment]; }
+    glm::vec3 getSegmentCoefficient(int segment, int power) const {
+        return glm::vec3(coefficients[0][power][segment], coefficients[1][power][segment],
+                         coefficients[2][power][segment]);
+    }
+
+    size_t getPathCount() const { return pathLength.size(); }
+    size_t getSegmentCount() const { return segmentStart.size(); }
+    size_t getMoverCount() const { return moverPath.size(); }
+
+private:
+    static const int MAX_SPLITS = 10;
+    static const int MIN_MOVERS_PER_THREAD = 16384;
+
+    // Paths
+    std::vector<int> pathFirstSegment;
+    std::vector<int> pathSegmentCount;
+    std::vector<float> pathLength;
+
+    // Segments: p(u) = ((c3 u + c2) u + c1) u + c0 per axis, with
+    // u = (distance - segmentStart) * segmentScale in [0, 1]
+    std::vector<float> segmentStart;
+    std::vector<float> segmentScale;
+    std::vector<float> coefficients[3][4];
+
+    // Movers
+    std::vector<int> moverPath;
+    std::vector<int> moverSegment;
+    std::vector<float> moverDistance;
+    std::vector<float> moverSpeed;
+    std::vector<float> moverParameter;  // u within the current segment
+    std::vector<float> positionX;
+    std::vector<float> positionY;
+    std::vector<float> positionZ;
+
+    // Worker pool; worker k updates range k + 1, the caller range 0
+    std::vector<std::thread> workers;
+    std::mutex workMutex;
+    std::condition_variable workReady;
+    std::condition_variable workDone;
+    unsigned long workGeneration = 0;
+    size_t workActive = 0;
+    size_t workPending = 0;
+    size_t workChunk = 0;
+    size_t workCount = 0;
+    float workDeltaTime = 0.0f;
+    bool workStopping = false;
+
+    void fitSegment(const Trajectory& trajectory, float s0, float s1, int depth);
+    void evaluateRange(size_t begin, size_t end);
+    void updateRange(size_t begin, size_t end, float deltaTime);
+    void workerLoop(size_t index, unsigned long generation);
+};
+
+#endif
@@ -0,0 +1,196 @@
+#include "TriangleBVH.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    const int BIN_COUNT = 12;
+    const int MIN_LEAF_SIZE = 2;
+    const int MAX_LEAF_SIZE = 16;
+    // Keeps the traversal stack in occluded() bounded
+    const int MAX_DEPTH = 48;
+    // Cost of visiting a node relative to testing one triangle
+    const float TRAVERSAL_COST = 1.0f;
+
+    struct Bin {
+        AABB box;
+        int count = 0;
+        bool empty = true;
+
+        void add(const AABB& other) {
+            box = empty ? other : AABB::merge(box, other);
+            empty = false;
+            count++;
+        }
+    };
+
+    float areaOf(const AABB& box, bool empty) {
+        return empty ? 0.0f : box.surfaceArea();
+    }
+}
+
+void TriangleBVH::build(const std::vector<glm::vec3>& positions) {
+    nodes.clear();
+    triangles.clear();
+
+    size_t triangleCount = positions.size() / 3;
+    if (triangleCount == 0) return;
+
+    std::vector<BuildItem> items(triangleCount);
+    for (size_t i = 0; i < triangleCount; i++) {
+        const glm::vec3& a = positions[i * 3];
+        const glm::vec3& b = positions[i * 3 + 1];
+        const glm::vec3& c = positions[i * 3 + 2];
+        items[i].box.min = glm::min(a, glm::min(b, c));
+        items[i].box.max = glm::max(a, glm::max(b, c));
+        items[i].centroid = (a + b + c) / 3.0f;
+        items[i].triangle = static_cast<int>(i);
+    }
+
+    nodes.reserve(triangleCount * 2);
+    nodes.push_back(Node());
+    subdivide(0, items, 0, static_cast<int>(triangleCount), 0);
+
+    // Leaves index the items in their final order
+    triangles.resize(triangleCount);
+    for (size_t i = 0; i < triangleCount; i++) {
+        size_t source = static_cast<size_t>(items[i].triangle) * 3;
+        triangles[i].v0 = positions[source];
+        triangles[i].e1 = positions[source + 1] - positions[source];
+        triangles[i].e2 = positions[source + 2] - positions[source];
+    }
+}
+
+void TriangleBVH::subdivide(int nodeIndex, std::vector<BuildItem>& items, int begin, int end, int depth) {
+    AABB box = items[begin].box;
+    AABB centroids;
+    centroids.min = centroids.max = items[begin].centroid;
+    for (int i = begin + 1; i < end; i++) {
+        box = AABB::merge(box, items[i].box);
+        centroids.min = glm::min(centroids.min, items[i].centroid);
+        centroids.max = glm::max(centroids.max, items[i].centroid);
+    }
+    nodes[nodeIndex].box = box;
+    nodes[nodeIndex].first = begin;
+    nodes[nodeIndex].count = end - begin;
+
+    int count = end - begin;
+    if (count <= MIN_LEAF_SIZE || depth >= MAX_DEPTH) return;
+
+    // Sweep the bin boundaries of every axis for the cheapest split
+    float bestCost = 1e30f;
+    int bestAxis = -1;
+    int bestSplit = 0;
+    for (int axis = 0; axis < 3; axis++) {
+        float extent = centroids.max[axis] - centroids.min[axis];
+        if (extent <= 1e-12f) continue;
+
+        Bin bins[BIN_COUNT];
+        float scale = BIN_COUNT / extent;
+        for (int i = begin; i < end; i++) {
+            int bin = std::min(BIN_COUNT - 1, static_cast<int>((items[i].centroid[axis] - centroids.min[axis]) * scale));
+            bins[bin].add(items[i].box);
+        }
+
+        float rightArea[BIN_COUNT];
+        int rightCount[BIN_COUNT];
+        Bin right;
+        for (int split = BIN_COUNT - 1; split > 0; split--) {
+            if (!bins[split].empty) {
+                right.box = right.empty ? bins[split].box : AABB::merge(right.box, bins[split].box);
+                right.empty = false;
+            }
+            right.count += bins[split].count;
+            rightArea[split] = areaOf(right.box, right.empty);
+            rightCount[split] = right.count;
+        }
+
+        Bin left;
+        for (int split = 1; split < BIN_COUNT; split++) {
+            const Bin& bin = bins[split - 1];
+            if (!bin.empty) {
+                left.box = left.empty ? bin.box : AABB::merge(left.box, bin.box);
+                left.empty = false;
+            }
+            left.count += bin.count;
+            if (left.count == 0 || rightCount[split] == 0) continue;
+
+            float cost = areaOf(left.box, left.empty) * left.count + rightArea[split] * rightCount[split];
+            if (cost < bestCost) {
+                bestCost = cost;
+                bestAxis = axis;
+                bestSplit = split;
+            }
+        }
+    }
+
+    float area = box.surfaceArea();
+    float leafCost = area * count;
+    float splitCost = TRAVERSAL_COST * area + bestCost;
+    if (bestAxis < 0 || (splitCost >= leafCost && count <= MAX_LEAF_SIZE)) return;
+
+    float scale = BIN_COUNT / (centroids.max[bestAxis] - centroids.min[bestAxis]);
+    float origin = centroids.min[bestAxis];
+    auto middle = std::partition(items.begin() + begin, items.begin() + end, [&](const BuildItem& item) {
+        int bin = std::min(BIN_COUNT - 1, static_cast<int>((item.centroid[bestAxis] - origin) * scale));
+        return bin < bestSplit;
+    });
+    int mid = static_cast<int>(middle - items.begin());
+    if (mid == begin || mid == end) return;
+
+    int leftIndex = static_cast<int>(nodes.size());
+    nodes.push_back(Node());
+    nodes.push_back(Node());
+    nodes[nodeIndex].first = leftIndex;
+    nodes[nodeIndex].count = 0;
+
+    subdivide(leftIndex, items, begin, mid, depth + 1);
+    subdivide(leftIndex + 1, items, mid, end, depth + 1);
+}
+
+bool TriangleBVH::occluded(const glm::vec3& origin, const glm::vec3& direction, float maxDistance) const {
+    if (nodes.empty()) return false;
+
+    glm::vec3 invDirection = 1.0f / direction;
+
+    int stack[MAX_DEPTH + 2];
+    int size = 0;
+    stack[size++] = 0;
+    while (size > 0) {
+        const Node& node = nodes[stack[--size]];
+
+        // Slab test against the node box
+        glm::vec3 t0 = (node.box.min - origin) * invDirection;
+        glm::vec3 t1 = (node.box.max - origin) * invDirection;
+        glm::vec3 tNear = glm::min(t0, t1);
+        glm::vec3 tFar = glm::max(t0, t1);
+        float enter = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.0f));
+        float exit = std::min(std::min(tFar.x, tFar.y), std::min(tFar.z, maxDistance));
+        if (enter > exit) continue;
+
+        if (node.count == 0) {
+            stack[size++] = node.first;
+            stack[size++] = node.first + 1;
+            continue;
+        }
+
+        for (int i = node.first; i < node.first + node.count; i++) {
+            const Triangle& tri = triangles[i];
+            glm::vec3 p = glm::cross(direction, tri.e2);
+            float det = glm::dot(tri.e1, p);
+            if (std::abs(det) < 1e-12f) continue;
+
+            float invDet = 1.0f / det;
+            glm::vec3 s = origin - tri.v0;
+            float u = glm::dot(s, p) * invDet;
+            if (u < 0.0f || u > 1.0f) continue;
+
+            glm::vec3 q = glm::cross(s, tri.e1);
+            float v = glm::dot(direction, q) * invDet;
+            if (v < 0.0f || u + v > 1.0f) continue;
+
+            float t = glm::dot(tri.e2, q) * invDet;
+            if (t > 0.0f && t < maxDistance) return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,54 @@
+#ifndef TRIANGLE_BVH_H
+#define TRIANGLE_BVH_H
+
+#include "Bounds.hpp"
+#include <glm/glm.hpp>
+#include <vector>
+
+// Static bounding volume hierarchy over a world-space triangle soup, for
+// offline ray queries. Built once, top-down, splitting each node where a
+// binned surface area heuristic says rays are cheapest to trace. Queries are
+// const and keep their stack locally, so any number of threads can share one.
+class TriangleBVH {
+public:
+    // Every three positions form a triangle
+    void build(const std::vector<glm::vec3>& positions);
+
+    // True if any triangle lies along the ray closer than maxDistance.
+    // direction must be normalized.
+    bool occluded(const glm::vec3& origin, const glm::vec3& direction, float maxDistance) const;
+
+    size_t getTriangleCount() const { return triangles.size(); }
+    size_t getNodeCount() const { return nodes.size(); }
+    const AABB& getBounds() const { return nodes.empty() ? emptyBounds : nodes[0].box; }
+
+private:
+    // Leaves have count > 0 and own triangles [first, first + count); interior
+    // nodes have count == 0 and children first and first + 1
+    struct Node {
+        AABB box;
+        int first = 0;
+        int count = 0;
+    };
+
+    // Stored as one vertex and two edges, ready for Moller-Trumbore
+    struct Triangle {
+        glm::vec3 v0;
+        glm::vec3 e1;
+        glm::vec3 e2;
+    };
+
+    struct BuildItem {
+        AABB box;
+        glm::vec3 centroid;
+        int triangle;
+    };
+
+    std::vector<Node> nodes;
+    std::vector<Triangle> triangles;
+    AABB emptyBounds;
+
+    void subdivide(int nodeIndex, std::vector<BuildItem>& items, int begin, int end, int depth);
+};
+
+#endif
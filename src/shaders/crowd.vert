@@ -0,0 +1,85 @@
+#version 330 core
+
+layout (location = 0) in vec3 position;
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in vec2 aTexCoord;
+
+// Per instance (see CrowdRenderer.hpp): path id, distance at time zero, speed
+layout (location = 4) in vec3 instancePath;
+layout (location = 5) in vec3 instanceOffset;
+
+// 4 texels per segment: (c0, start), (c1, 1 / length), (c2, 0), (c3, 0)
+uniform samplerBuffer crowdSegments;
+// Per path: first segment, segment count, length
+uniform samplerBuffer crowdPaths;
+uniform float crowdTime;
+
+// Shared by every instance: rotation and scale of the source object, and
+// what scene.vert would take from ObjectData
+uniform mat4 crowdModel;
+uniform vec4 crowdMaterial;
+uniform int crowdUseTexture;
+
+uniform mat4 view;
+uniform mat4 projection;
+
+invariant gl_Position;
+
+out vec2 texCoord;
+out vec2 lightmapCoord;
+out vec3 vNormal;
+out vec4 fragPos;
+noperspective out vec3 barycentric;
+
+flat out vec4 objectMaterial;
+flat out ivec4 objectFlags;
+flat out vec4 objectParams;
+
+vec3 pathPosition(int path, float distance)
+{
+    vec4 info = texelFetch(crowdPaths, path);
+    int first = int(info.x);
+
+    // Last segment starting at or before the distance
+    int low = 0;
+    int high = int(info.y) - 1;
+    while (low < high) {
+        int middle = (low + high + 1) / 2;
+        if (texelFetch(crowdSegments, (first + middle) * 4).w <= distance) {
+            low = middle;
+        } else {
+            high = middle - 1;
+        }
+    }
+
+    int base = (first + low) * 4;
+    vec4 c0 = texelFetch(crowdSegments, base);
+    vec4 c1 = texelFetch(crowdSegments, base + 1);
+    vec3 c2 = texelFetch(crowdSegments, base + 2).xyz;
+    vec3 c3 = texelFetch(crowdSegments, base + 3).xyz;
+    float u = (distance - c0.w) * c1.w;
+    return ((c3 * u + c2) * u + c1.xyz) * u + c0.xyz;
+}
+
+void main()
+{
+    int path = int(instancePath.x);
+    float length = texelFetch(crowdPaths, path).z;
+    float distance = mod(instancePath.y + instancePath.z * crowdTime, length);
+    vec3 origin = pathPosition(path, distance) + instanceOffset;
+
+    vec4 world = crowdModel * vec4(position, 1.0);
+    world.xyz += origin;
+
+    gl_Position = projection * view * world;
+    fragPos = world;
+    texCoord = aTexCoord;
+    lightmapCoord = vec2(0.0);
+    vNormal = aNormal;
+    barycentric = vec3(0.0);
+    barycentric[gl_VertexID % 3] = 1.0;
+
+    objectMaterial = crowdMaterial;
+    objectFlags = ivec4(0, crowdUseTexture, 0, 0);
+    objectParams = vec4(0.0);
+}
@@ -0,0 +1,11 @@
+#version 330 core
+
+// Trajectory polylines and their control point markers, already in world space
+layout (location = 0) in vec3 position;
+
+uniform mat4 viewProjection;
+
+void main()
+{
+    gl_Position = viewProjection * vec4(position, 1.0);
+}
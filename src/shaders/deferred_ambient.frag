@@ -0,0 +1,33 @@
+#version 330 core
+
+uniform sampler2D gAlbedo;
+uniform sampler2D gNormal;
+uniform sampler2D gMaterial;
+uniform sampler2D gDepth;
+
+uniform vec3 lightColor;       // summed light colour, ambient only
+uniform vec3 wireframeColor;
+
+out vec4 FragColor;
+
+// The forward shader finishes with two mixes, (selection tint, then wireframe),
+// both linear in the lit colour. So this pass writes the constant part and the
+// ambient term pre-scaled, and every light volume adds its term scaled the
+// same way; the sum equals the forward result without a separate light buffer.
+void main()
+{
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    if (texelFetch(gDepth, pixel, 0).r >= 1.0) {
+        discard;
+    }
+
+    vec4 albedo = texelFetch(gAlbedo, pixel, 0);
+    float edge = texelFetch(gNormal, pixel, 0).w;
+    float ka = texelFetch(gMaterial, pixel, 0).x;
+
+    float tint = albedo.a;
+    vec3 ambient = ka * lightColor * albedo.rgb;
+    vec3 result = (1.0 - edge) * ((1.0 - tint) * ambient + tint * vec3(1.0, 1.0, 0.0)) + edge * wireframeColor;
+
+    FragColor = vec4(result, 1.0);
+}
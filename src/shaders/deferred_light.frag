@@ -0,0 +1,73 @@
+#version 330 core
+
+flat in vec4 volumeLight;      // position, radius
+flat in vec3 volumeColor;
+flat in int volumeShadow;      // shadow map slot or -1
+
+uniform sampler2D gAlbedo;
+uniform sampler2D gNormal;
+uniform sampler2D gMaterial;
+uniform sampler2D gDepth;
+
+uniform samplerCube shadowMap0;
+uniform samplerCube shadowMap1;
+uniform samplerCube shadowMap2;
+uniform samplerCube shadowMap3;
+
+uniform mat4 inverseViewProjection;
+uniform vec3 viewPos;
+
+out vec4 FragColor;
+
+// Same lookup as scene.frag
+float shadowDistance(int slot, vec3 direction)
+{
+    if (slot == 0) return texture(shadowMap0, direction).r;
+    if (slot == 1) return texture(shadowMap1, direction).r;
+    if (slot == 2) return texture(shadowMap2, direction).r;
+    return texture(shadowMap3, direction).r;
+}
+
+float shadowFactor(int slot, vec3 toLight, float distance, float radius)
+{
+    if (slot < 0) return 1.0;
+    float occluder = shadowDistance(slot, -toLight) * radius;
+    float bias = 0.05 + 0.01 * distance;
+    return distance - bias > occluder ? 0.0 : 1.0;
+}
+
+void main()
+{
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    float depth = texelFetch(gDepth, pixel, 0).r;
+
+    vec2 uv = (vec2(pixel) + 0.5) / vec2(textureSize(gDepth, 0));
+    vec4 world = inverseViewProjection * vec4(vec3(uv, depth) * 2.0 - 1.0, 1.0);
+    vec3 fragPos = world.xyz / world.w;
+
+    vec3 toLight = volumeLight.xyz - fragPos;
+    float distance = length(toLight);
+    // Same window as scene.frag
+    float window = clamp(1.0 - pow(distance / volumeLight.w, 4.0), 0.0, 1.0);
+    window *= window;
+    window *= shadowFactor(volumeShadow, toLight, distance, volumeLight.w);
+    if (window <= 0.0) {
+        discard;
+    }
+
+    vec4 albedo = texelFetch(gAlbedo, pixel, 0);
+    vec4 normalEdge = texelFetch(gNormal, pixel, 0);
+    vec4 material = texelFetch(gMaterial, pixel, 0);
+
+    vec3 N = normalize(normalEdge.xyz);
+    vec3 L = toLight / distance;
+    vec3 V = normalize(viewPos - fragPos);
+    float diff = max(dot(N, L), 0.0);
+    vec3 R = normalize(reflect(-L, N));
+    float spec = pow(max(dot(R, V), 0.0), material.w);
+
+    vec3 lit = (material.y * diff * albedo.rgb + material.z * spec) * volumeColor * window;
+
+    // Scaled like the ambient pass, see deferred_ambient.frag
+    FragColor = vec4((1.0 - normalEdge.w) * (1.0 - albedo.a) * lit, 1.0);
+}
@@ -0,0 +1,21 @@
+#version 330 core
+
+layout (location = 0) in vec3 position;          // unit sphere, circumscribing
+layout (location = 1) in vec4 lightPositionRadius;
+layout (location = 2) in vec4 lightColorShadow;   // color, shadow map slot or -1
+
+uniform mat4 view;
+uniform mat4 projection;
+
+flat out vec4 volumeLight;
+flat out vec3 volumeColor;
+flat out int volumeShadow;
+
+void main()
+{
+    vec3 world = lightPositionRadius.xyz + position * lightPositionRadius.w;
+    gl_Position = projection * view * vec4(world, 1.0);
+    volumeLight = lightPositionRadius;
+    volumeColor = lightColorShadow.rgb;
+    volumeShadow = int(lightColorShadow.w);
+}
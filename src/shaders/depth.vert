@@ -0,0 +1,15 @@
+#version 330 core
+
+layout (location = 0) in vec3 position;
+
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+
+// Must match the shading pass bit for bit so GL_EQUAL can be used there
+invariant gl_Position;
+
+void main()
+{
+    gl_Position = projection * view * model * vec4(position, 1.0);
+}
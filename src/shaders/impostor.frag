@@ -0,0 +1,68 @@
+#version 330 core
+
+in vec2 atlasCoord;
+in vec3 fragPos;
+in mat3 normalMatrix;
+flat in vec4 vMaterial;
+flat in vec4 vParams;
+
+uniform sampler2D albedoAtlas;
+uniform sampler2D normalAtlas;
+
+uniform vec3 lightPos;
+uniform vec3 lightColor;
+uniform vec3 viewPos;
+uniform bool overdraw;
+
+out vec4 FragColor;
+
+// 4x4 ordered dither threshold; must match the one in scene.frag
+float bayer4(vec2 p)
+{
+    int x = int(mod(p.x, 4.0));
+    int y = int(mod(p.y, 4.0));
+    const float m[16] = float[16](0.0, 8.0, 2.0, 10.0,
+                                  12.0, 4.0, 14.0, 6.0,
+                                  3.0, 11.0, 1.0, 9.0,
+                                  15.0, 7.0, 13.0, 5.0);
+    return (m[y * 4 + x] + 0.5) / 16.0;
+}
+
+void main()
+{
+    vec4 albedo = texture(albedoAtlas, atlasCoord);
+    if (albedo.a < 0.5) {
+        discard;
+    }
+
+    // Screen-door crossfade; scene.frag keeps the complementary pixels of the mesh
+    if (bayer4(gl_FragCoord.xy) >= vParams.x) {
+        discard;
+    }
+
+    if (overdraw) {
+        FragColor = vec4(0.12, 0.05, 0.02, 1.0);
+        return;
+    }
+
+    float ka = vMaterial.x;
+    float kd = vMaterial.y;
+    float ks = vMaterial.z;
+    float q = vMaterial.w;
+
+    vec3 N = normalize(normalMatrix * (texture(normalAtlas, atlasCoord).xyz * 2.0 - 1.0));
+    vec3 L = normalize(lightPos - fragPos);
+    vec3 V = normalize(viewPos - fragPos);
+    vec3 R = normalize(reflect(-L, N));
+
+    vec3 ambient = ka * lightColor;
+    vec3 diffuse = kd * max(dot(N, L), 0.0) * lightColor;
+    vec3 specular = ks * pow(max(dot(R, V), 0.0), q) * lightColor;
+
+    vec3 result = (ambient + diffuse) * albedo.rgb + specular;
+    if (vParams.y != 0.0) {
+        result = mix(result, vec3(1.0, 1.0, 0.0), 0.2);
+    }
+
+    FragColor = vec4(result, 1.0);
+}
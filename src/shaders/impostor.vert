@@ -0,0 +1,72 @@
+#version 330 core
+
+// Quad corner in [-1, 1], then one instance per impostor
+layout (location = 0) in vec2 corner;
+layout (location = 1) in mat4 model;
+layout (location = 5) in vec4 material;   // ka, kd, ks, q
+layout (location = 6) in vec4 params;     // crossfade, isSelected
+
+uniform mat4 view;
+uniform mat4 projection;
+uniform vec3 viewPos;
+
+// Object-space bounding sphere the atlas cells were captured around
+uniform vec4 sphere;
+uniform int viewsPerSide;
+
+out vec2 atlasCoord;
+out vec3 fragPos;
+out mat3 normalMatrix;
+flat out vec4 vMaterial;
+flat out vec4 vParams;
+
+vec2 octEncode(vec3 d)
+{
+    d /= abs(d.x) + abs(d.y) + abs(d.z);
+    vec2 e = d.xz;
+    if (d.y < 0.0) {
+        e = (1.0 - abs(d.zx)) * vec2(d.x >= 0.0 ? 1.0 : -1.0, d.z >= 0.0 ? 1.0 : -1.0);
+    }
+    return e * 0.5 + 0.5;
+}
+
+vec3 octDecode(vec2 e)
+{
+    e = e * 2.0 - 1.0;
+    vec3 d = vec3(e.x, 1.0 - abs(e.x) - abs(e.y), e.y);
+    if (d.y < 0.0) {
+        d.xz = (1.0 - abs(d.zx)) * vec2(d.x >= 0.0 ? 1.0 : -1.0, d.z >= 0.0 ? 1.0 : -1.0);
+    }
+    return normalize(d);
+}
+
+void main()
+{
+    // Snap the direction towards the camera to the nearest captured view and
+    // rebuild that capture's basis, so the quad shows exactly what was baked
+    mat4 inverseModel = inverse(model);
+    vec3 localEye = vec3(inverseModel * vec4(viewPos, 1.0));
+    vec3 toEye = localEye - sphere.xyz;
+    if (dot(toEye, toEye) < 1e-8) {
+        toEye = vec3(0.0, 0.0, 1.0);
+    }
+
+    float cells = float(viewsPerSide);
+    vec2 cell = min(floor(octEncode(normalize(toEye)) * cells), vec2(cells - 1.0));
+    vec3 viewDir = octDecode((cell + 0.5) / cells);
+
+    vec3 up = abs(viewDir.y) > 0.99 ? vec3(0.0, 0.0, 1.0) : vec3(0.0, 1.0, 0.0);
+    vec3 right = normalize(cross(up, viewDir));
+    up = cross(viewDir, right);
+
+    vec3 localPos = sphere.xyz + (corner.x * right + corner.y * up) * sphere.w;
+    vec4 worldPos = model * vec4(localPos, 1.0);
+
+    atlasCoord = (cell + corner * 0.5 + 0.5) / cells;
+    fragPos = vec3(worldPos);
+    normalMatrix = transpose(mat3(inverseModel));
+    vMaterial = material;
+    vParams = params;
+
+    gl_Position = projection * view * worldPos;
+}
@@ -0,0 +1,18 @@
+#version 330 core
+
+in vec3 vNormal;
+in vec2 texCoord;
+
+uniform sampler2D texture_diffuse1;
+uniform bool useTexture;
+
+layout (location = 0) out vec4 albedo;
+layout (location = 1) out vec4 normal;
+
+// Stores unlit colour and object-space normals so the impostor can be lit
+// with the scene's lights at draw time
+void main()
+{
+    albedo = vec4(useTexture ? texture(texture_diffuse1, texCoord).rgb : vec3(0.8), 1.0);
+    normal = vec4(normalize(vNormal) * 0.5 + 0.5, 1.0);
+}
@@ -0,0 +1,18 @@
+#version 330 core
+
+layout (location = 0) in vec3 position;
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in vec2 aTexCoord;
+
+// Orthographic camera for one atlas cell, in the mesh's own space
+uniform mat4 viewProjection;
+
+out vec3 vNormal;
+out vec2 texCoord;
+
+void main()
+{
+    vNormal = aNormal;
+    texCoord = aTexCoord;
+    gl_Position = viewProjection * vec4(position, 1.0);
+}
@@ -0,0 +1,10 @@
+#version 330 core
+
+out vec4 FragColor;
+
+// Each shaded fragment adds a fixed amount under additive blending, so the
+// brightness of a pixel shows how many times the lighting shader ran for it.
+void main()
+{
+    FragColor = vec4(0.12, 0.05, 0.02, 1.0);
+}
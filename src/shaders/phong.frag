@@ -3,6 +3,7 @@
 in vec2 texCoord;
 in vec3 vNormal;
 in vec4 fragPos;
+noperspective in vec3 barycentric;
 
 uniform sampler2D texture_diffuse1;
 uniform bool useTexture;
@@ -16,8 +17,14 @@ uniform float kd;
 uniform float ks;
 uniform float q;
 
+uniform bool wireframe;
+uniform vec3 wireframeColor;
+uniform float wireframeWidth;
+
 out vec4 FragColor;
 
+#include "wireframe.glsl"
+
 void main()
 {
     vec3 objectColor;
@@ -46,5 +53,9 @@ void main()
         result = mix(result, vec3(1.0, 1.0, 0.0), 0.2);
     }
 
+    if (wireframe) {
+        result = mix(result, wireframeColor, wireframeEdge());
+    }
+
     FragColor = vec4(result, 1.0);
 } 
\ No newline at end of file
@@ -11,6 +11,7 @@ uniform mat4 projection;
 out vec2 texCoord;
 out vec3 vNormal;
 out vec4 fragPos;
+noperspective out vec3 barycentric;
 
 void main()
 {
@@ -18,4 +19,6 @@ void main()
     fragPos = model * vec4(position, 1.0);
     texCoord = aTexCoord;
     vNormal = aNormal;
+    barycentric = vec3(0.0);
+    barycentric[gl_VertexID % 3] = 1.0;
 } 
\ No newline at end of file
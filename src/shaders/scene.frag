@@ -0,0 +1,147 @@
+#version 330 core
+
+in vec2 texCoord;
+in vec2 lightmapCoord;
+in vec3 vNormal;
+in vec4 fragPos;
+noperspective in vec3 barycentric;
+uniform bool wireframe;
+uniform vec3 wireframeColor;
+uniform float wireframeWidth;
+
+// Per-object data, forwarded by scene.vert or scene_indirect.vert
+flat in vec4 objectMaterial;   // ka, kd, ks, q
+flat in ivec4 objectFlags;     // isSelected, useTexture, useLightmap
+flat in vec4 objectParams;     // x: crossfade towards the impostor
+
+uniform sampler2D texture_diffuse1;
+
+// Baked by BakeLightmaps for static objects: rgb direct light, a ambient occlusion
+uniform sampler2D lightmap;
+
+// Summed colour of the enabled lights, only used for the ambient term
+uniform vec3 lightColor;
+uniform vec3 viewPos;
+uniform mat4 view;
+
+// Clustered point lights, filled by LightClusters on the CPU
+uniform samplerBuffer lightData;      // per light: (position, radius), (color, shadow map or -1)
+uniform usamplerBuffer clusterGrid;   // per cluster: offset, count
+uniform usamplerBuffer clusterLights; // light indices
+uniform ivec3 clusterDims;
+uniform vec2 clusterTileSize;
+uniform vec2 clusterDepthParams;      // slice = log(depth) * x + y
+
+// Cached cube maps from ShadowCache, distance to the nearest caster / radius
+uniform samplerCube shadowMap0;
+uniform samplerCube shadowMap1;
+uniform samplerCube shadowMap2;
+uniform samplerCube shadowMap3;
+
+out vec4 FragColor;
+
+#include "wireframe.glsl"
+
+// 4x4 ordered dither threshold; must match the one in impostor.frag
+float bayer4(vec2 p)
+{
+    int x = int(mod(p.x, 4.0));
+    int y = int(mod(p.y, 4.0));
+    const float m[16] = float[16](0.0, 8.0, 2.0, 10.0,
+                                  12.0, 4.0, 14.0, 6.0,
+                                  3.0, 11.0, 1.0, 9.0,
+                                  15.0, 7.0, 13.0, 5.0);
+    return (m[y * 4 + x] + 0.5) / 16.0;
+}
+
+// GLSL 3.30 can't index a sampler array with a loop variable
+float shadowDistance(int slot, vec3 direction)
+{
+    if (slot == 0) return texture(shadowMap0, direction).r;
+    if (slot == 1) return texture(shadowMap1, direction).r;
+    if (slot == 2) return texture(shadowMap2, direction).r;
+    return texture(shadowMap3, direction).r;
+}
+
+float shadowFactor(int slot, vec3 toLight, float distance, float radius)
+{
+    if (slot < 0) return 1.0;
+    float occluder = shadowDistance(slot, -toLight) * radius;
+    float bias = 0.05 + 0.01 * distance;
+    return distance - bias > occluder ? 0.0 : 1.0;
+}
+
+void main()
+{
+    if (objectParams.x > 0.0 && bayer4(gl_FragCoord.xy) < objectParams.x) {
+        discard;
+    }
+
+    float ka = objectMaterial.x;
+    float kd = objectMaterial.y;
+    float ks = objectMaterial.z;
+    float q = objectMaterial.w;
+
+    vec3 objectColor;
+    if (objectFlags.y != 0) {
+        objectColor = texture(texture_diffuse1, texCoord).rgb;
+    } else {
+        objectColor = vec3(0.8, 0.8, 0.8);
+    }
+
+    vec3 result;
+    if (objectFlags.z != 0) {
+        // Static object whose lights haven't changed since the bake: no light
+        // loop. Baked light is view independent, so there is no specular.
+        vec4 baked = texture(lightmap, lightmapCoord);
+        result = (ka * lightColor * baked.a + kd * baked.rgb) * objectColor;
+    } else {
+        vec3 ambient = ka * lightColor;
+        vec3 diffuse = vec3(0.0);
+        vec3 specular = vec3(0.0);
+
+        vec3 N = normalize(vNormal);
+        vec3 V = normalize(viewPos - vec3(fragPos));
+
+        float depth = -(view * fragPos).z;
+        ivec3 cluster = ivec3(ivec2(gl_FragCoord.xy / clusterTileSize),
+                              int(log(max(depth, 1e-4)) * clusterDepthParams.x + clusterDepthParams.y));
+        cluster = clamp(cluster, ivec3(0), clusterDims - 1);
+        uvec2 range = texelFetch(clusterGrid, (cluster.z * clusterDims.y + cluster.y) * clusterDims.x + cluster.x).xy;
+
+        for (uint i = 0u; i < range.y; i++) {
+            int light = int(texelFetch(clusterLights, int(range.x + i)).r);
+            vec4 positionRadius = texelFetch(lightData, light * 2);
+            vec4 colorShadow = texelFetch(lightData, light * 2 + 1);
+            vec3 color = colorShadow.rgb;
+
+            vec3 toLight = positionRadius.xyz - vec3(fragPos);
+            float distance = length(toLight);
+            // Smooth window so the light reaches exactly zero at its radius
+            float window = clamp(1.0 - pow(distance / positionRadius.w, 4.0), 0.0, 1.0);
+            window *= window;
+            window *= shadowFactor(int(colorShadow.w), toLight, distance, positionRadius.w);
+            if (window <= 0.0) continue;
+
+            vec3 L = toLight / distance;
+            float diff = max(dot(N, L), 0.0);
+            diffuse += kd * diff * color * window;
+
+            vec3 R = normalize(reflect(-L, N));
+            float spec = pow(max(dot(R, V), 0.0), q);
+            specular += ks * spec * color * window;
+        }
+
+        result = (ambient + diffuse) * objectColor + specular;
+    }
+
+    if (objectFlags.x != 0) {
+        result = mix(result, vec3(1.0, 1.0, 0.0), 0.2);
+    }
+
+    if (wireframe) {
+        result = mix(result, wireframeColor, wireframeEdge());
+    }
+
+    FragColor = vec4(result, 1.0);
+}
@@ -0,0 +1,48 @@
+#version 330 core
+
+layout (location = 0) in vec3 position;
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in vec2 aTexCoord;
+// Only bound for objects with a baked lightmap (see Lightmap.hpp)
+layout (location = 3) in vec2 aLightmapCoord;
+
+// Per-object data streamed through the ring buffer (see RingBuffer.hpp)
+layout (std140) uniform ObjectData {
+    mat4 model;
+    vec4 material;   // ka, kd, ks, q
+    ivec4 flags;     // isSelected, useTexture, useLightmap
+    vec4 params;     // x: crossfade towards the impostor
+};
+
+uniform mat4 view;
+uniform mat4 projection;
+
+invariant gl_Position;
+
+out vec2 texCoord;
+out vec2 lightmapCoord;
+out vec3 vNormal;
+out vec4 fragPos;
+
+// Meshes are drawn non-indexed, so every three consecutive vertices form a
+// triangle and the corner index gives the barycentric coordinate for free.
+noperspective out vec3 barycentric;
+
+flat out vec4 objectMaterial;
+flat out ivec4 objectFlags;
+flat out vec4 objectParams;
+
+void main()
+{
+    gl_Position = projection * view * model * vec4(position, 1.0);
+    fragPos = model * vec4(position, 1.0);
+    texCoord = aTexCoord;
+    lightmapCoord = aLightmapCoord;
+    vNormal = aNormal;
+    barycentric = vec3(0.0);
+    barycentric[gl_VertexID % 3] = 1.0;
+
+    objectMaterial = material;
+    objectFlags = flags;
+    objectParams = params;
+}
@@ -0,0 +1,20 @@
+#version 330 core
+
+layout (location = 0) in vec3 position;
+
+layout (std140) uniform ObjectData {
+    mat4 model;
+    vec4 material;
+    ivec4 flags;
+    vec4 params;
+};
+
+uniform mat4 view;
+uniform mat4 projection;
+
+invariant gl_Position;
+
+void main()
+{
+    gl_Position = projection * view * model * vec4(position, 1.0);
+}
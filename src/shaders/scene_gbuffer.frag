@@ -0,0 +1,51 @@
+#version 330 core
+
+in vec2 texCoord;
+in vec3 vNormal;
+in vec4 fragPos;
+noperspective in vec3 barycentric;
+uniform bool wireframe;
+uniform float wireframeWidth;
+
+flat in vec4 objectMaterial;   // ka, kd, ks, q
+flat in ivec4 objectFlags;     // isSelected, useTexture
+flat in vec4 objectParams;     // x: crossfade towards the impostor
+
+uniform sampler2D texture_diffuse1;
+
+// G-buffer layout read back by deferred_ambient.frag and deferred_light.frag
+layout (location = 0) out vec4 gAlbedo;     // rgb: surface colour, a: selection tint weight
+layout (location = 1) out vec4 gNormal;     // xyz: world normal, w: wireframe edge
+layout (location = 2) out vec4 gMaterial;   // ka, kd, ks, q
+
+#include "wireframe.glsl"
+
+// Same threshold matrix as scene.frag and impostor.frag
+float bayer4(vec2 p)
+{
+    int x = int(mod(p.x, 4.0));
+    int y = int(mod(p.y, 4.0));
+    const float m[16] = float[16](0.0, 8.0, 2.0, 10.0,
+                                  12.0, 4.0, 14.0, 6.0,
+                                  3.0, 11.0, 1.0, 9.0,
+                                  15.0, 7.0, 13.0, 5.0);
+    return (m[y * 4 + x] + 0.5) / 16.0;
+}
+
+void main()
+{
+    if (objectParams.x > 0.0 && bayer4(gl_FragCoord.xy) < objectParams.x) {
+        discard;
+    }
+
+    vec3 objectColor;
+    if (objectFlags.y != 0) {
+        objectColor = texture(texture_diffuse1, texCoord).rgb;
+    } else {
+        objectColor = vec3(0.8, 0.8, 0.8);
+    }
+
+    gAlbedo = vec4(objectColor, objectFlags.x != 0 ? 0.2 : 0.0);
+    gNormal = vec4(normalize(vNormal), wireframe ? wireframeEdge() : 0.0);
+    gMaterial = objectMaterial;
+}
@@ -0,0 +1,57 @@
+#version 430 core
+
+layout (location = 0) in vec3 position;
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in vec2 aTexCoord;
+
+// Instanced attribute fed from an identity buffer; each indirect command's
+// baseInstance is the object's index, so this reads back that index
+layout (location = 3) in uint objectId;
+
+// Same fields as the ObjectData uniform block in scene.vert; flags.w is the mesh
+struct ObjectData {
+    mat4 model;
+    vec4 material;
+    ivec4 flags;
+    vec4 params;
+};
+
+layout (std430, binding = 0) readonly buffer Objects {
+    ObjectData objects[];
+};
+
+uniform mat4 view;
+uniform mat4 projection;
+
+invariant gl_Position;
+
+out vec2 texCoord;
+out vec2 lightmapCoord;
+out vec3 vNormal;
+out vec4 fragPos;
+noperspective out vec3 barycentric;
+
+flat out vec4 objectMaterial;
+flat out ivec4 objectFlags;
+flat out vec4 objectParams;
+
+void main()
+{
+    ObjectData object = objects[objectId];
+
+    gl_Position = projection * view * object.model * vec4(position, 1.0);
+    fragPos = object.model * vec4(position, 1.0);
+    texCoord = aTexCoord;
+    // Batched meshes carry no lightmap UVs; flags.z is never set on this path
+    lightmapCoord = vec2(0.0);
+    vNormal = aNormal;
+
+    // Mesh ranges in the shared buffer start on a multiple of three, so the
+    // corner index still lines up with gl_VertexID
+    barycentric = vec3(0.0);
+    barycentric[gl_VertexID % 3] = 1.0;
+
+    objectMaterial = object.material;
+    objectFlags = object.flags;
+    objectParams = object.params;
+}
@@ -9,8 +9,12 @@ uniform mat4 projection;
 out vec3 Normal;
 out vec3 FragPos;
 
+noperspective out vec3 barycentric;
+
 void main() {
     FragPos = vec3(model * vec4(aPos, 1.0));
     Normal = mat3(transpose(inverse(model))) * aNormal;
     gl_Position = projection * view * vec4(FragPos, 1.0);
+    barycentric = vec3(0.0);
+    barycentric[gl_VertexID % 3] = 1.0;
 } 
\ No newline at end of file
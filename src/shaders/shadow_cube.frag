@@ -0,0 +1,13 @@
+#version 330 core
+
+in vec3 worldPos;
+
+uniform vec3 lightPos;
+uniform float farPlane;
+
+// Stores distance to the light rather than projected depth, so a lookup only
+// needs the direction and every face compares in the same units
+void main()
+{
+    gl_FragDepth = length(worldPos - lightPos) / farPlane;
+}
@@ -0,0 +1,15 @@
+#version 330 core
+
+layout (location = 0) in vec3 position;
+
+uniform mat4 model;
+uniform mat4 lightViewProjection;   // one cube face
+
+out vec3 worldPos;
+
+void main()
+{
+    vec4 world = model * vec4(position, 1.0);
+    worldPos = world.xyz;
+    gl_Position = lightViewProjection * world;
+}
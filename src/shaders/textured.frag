@@ -4,6 +4,7 @@ out vec4 FragColor;
 in vec3 FragPos;
 in vec3 Normal;
 in vec2 TexCoord;
+noperspective in vec3 barycentric;
 
 // Material properties structure
 struct Material {
@@ -21,6 +22,12 @@ uniform vec3 viewPos;
 uniform bool useTexture;
 uniform vec3 objectColor;
 
+uniform bool wireframe;
+uniform vec3 wireframeColor;
+uniform float wireframeWidth;
+
+#include "wireframe.glsl"
+
 void main()
 {
     if (useTexture) {
@@ -41,4 +48,8 @@ void main()
         // Fallback for non-textured objects
         FragColor = vec4(objectColor, 1.0);
     }
+
+    if (wireframe) {
+        FragColor.rgb = mix(FragColor.rgb, wireframeColor, wireframeEdge());
+    }
 } 
\ No newline at end of file
@@ -7,6 +7,8 @@ out vec3 FragPos;
 out vec3 Normal;
 out vec2 TexCoord;
 
+noperspective out vec3 barycentric;
+
 uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
@@ -16,6 +18,8 @@ void main()
     FragPos = vec3(model * vec4(aPos, 1.0));
     Normal = mat3(transpose(inverse(model))) * aNormal;
     TexCoord = aTexCoord;
+    barycentric = vec3(0.0);
+    barycentric[gl_VertexID % 3] = 1.0;
     
     gl_Position = projection * view * vec4(FragPos, 1.0);
 } 
\ No newline at end of file
@@ -3,26 +3,24 @@
 in vec2 texCoord;
 in vec3 worldNormal;
 in vec3 worldPos;
+noperspective in vec3 barycentric;
+uniform bool wireframe;
+uniform vec3 wireframeColor;
+uniform float wireframeWidth;
 
 uniform sampler2D texture_diffuse1;
 uniform bool useTexture;
 uniform bool isSelected;
 
-uniform bool keyEnabled;
-uniform bool fillEnabled;
-uniform bool backEnabled;
+// Only the lights that reach this object, chosen per draw by LightCuller
+const int MAX_LIGHTS = 4;
+uniform int lightCount;
+uniform vec3 lightPositions[MAX_LIGHTS];
+uniform vec3 lightColors[MAX_LIGHTS];       // color * intensity
+uniform vec3 lightAttenuation;              // constant, linear, quadratic
 
-uniform vec3 keyPos;
-uniform vec3 keyColor;
-uniform float keyIntensity;
-
-uniform vec3 fillPos;
-uniform vec3 fillColor;
-uniform float fillIntensity;
-
-uniform vec3 backPos;
-uniform vec3 backColor;
-uniform float backIntensity;
+// Unattenuated, so it comes from every enabled light, culled or not
+uniform vec3 ambientLight;
 
 uniform vec3 viewPos;
 uniform float ka;
@@ -33,14 +31,12 @@ uniform float q;
 out vec4 FragColor;
 
 float calculateAttenuation(float distance) {
-    float constant = 1.0;
-    float linear = 0.09;
-    float quadratic = 0.032;
-    
-    return 1.0 / (constant + linear * distance + quadratic * (distance * distance));
+    return 1.0 / (lightAttenuation.x + lightAttenuation.y * distance + lightAttenuation.z * (distance * distance));
 }
 
-vec3 calculatePointLight(vec3 lightPos, vec3 lightColor, float lightIntensity, 
+#include "wireframe.glsl"
+
+vec3 calculatePointLight(vec3 lightPos, vec3 lightColor,
                         vec3 normal, vec3 fragPos, vec3 viewPos, vec3 objectColor) {
     vec3 lightDir = normalize(lightPos - fragPos);
     vec3 viewDir = normalize(viewPos - fragPos);
@@ -49,15 +45,13 @@ vec3 calculatePointLight(vec3 lightPos, vec3 lightColor, float lightIntensity,
     float distance = length(lightPos - fragPos);
     float attenuation = calculateAttenuation(distance);
     
-    vec3 ambient = ka * lightColor * lightIntensity;
-    
     float diff = max(dot(normal, lightDir), 0.0);
-    vec3 diffuse = kd * diff * lightColor * lightIntensity * attenuation;
+    vec3 diffuse = kd * diff * lightColor * attenuation;
     
     float spec = pow(max(dot(viewDir, reflectDir), 0.0), q);
-    vec3 specular = ks * spec * lightColor * lightIntensity * attenuation;
+    vec3 specular = ks * spec * lightColor * attenuation;
     
-    return (ambient + diffuse) * objectColor + specular;
+    return diffuse * objectColor + specular;
 }
 
 void main()
@@ -71,33 +65,20 @@ void main()
     
     vec3 norm = normalize(worldNormal);
     
-    vec3 result = vec3(0.0);
-    
-    if (keyEnabled) {
-        vec3 keyContrib = calculatePointLight(keyPos, keyColor, keyIntensity, 
-                                            norm, worldPos, viewPos, objectColor);
-        result += keyContrib;
-    }
+    vec3 result = ka * ambientLight * objectColor;
     
-    if (fillEnabled) {
-        vec3 fillContrib = calculatePointLight(fillPos, fillColor, fillIntensity, 
-                                             norm, worldPos, viewPos, objectColor);
-        result += fillContrib;
-    }
-    
-    if (backEnabled) {
-        vec3 backContrib = calculatePointLight(backPos, backColor, backIntensity, 
-                                             norm, worldPos, viewPos, objectColor);
-        result += backContrib;
-    }
-    
-    if (!keyEnabled && !fillEnabled && !backEnabled) {
-        result = objectColor * ka * 0.2;
+    for (int i = 0; i < lightCount; i++) {
+        result += calculatePointLight(lightPositions[i], lightColors[i],
+                                      norm, worldPos, viewPos, objectColor);
     }
     
     if (isSelected) {
         result = mix(result, vec3(1.0, 1.0, 0.0), 0.15);
     }
+
+    if (wireframe) {
+        result = mix(result, wireframeColor, wireframeEdge());
+    }
     
     FragColor = vec4(result, 1.0);
 } 
\ No newline at end of file
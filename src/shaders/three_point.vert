@@ -8,10 +8,15 @@ uniform mat4 model;
 uniform mat4 view;       
 uniform mat4 projection; 
 
+invariant gl_Position;
+
 out vec2 texCoord;
 out vec3 worldNormal;
 out vec3 worldPos;
 
+// Barycentric corner of the triangle, used by the wireframe overlay
+noperspective out vec3 barycentric;
+
 void main()
 {
     gl_Position = projection * view * model * vec4(position, 1.0);
@@ -21,4 +26,7 @@ void main()
     worldNormal = mat3(transpose(inverse(model))) * aNormal;
     
     texCoord = aTexCoord;
+
+    barycentric = vec3(0.0);
+    barycentric[gl_VertexID % 3] = 1.0;
 } 
\ No newline at end of file
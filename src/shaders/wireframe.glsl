@@ -0,0 +1,8 @@
+// Shared by every fragment shader that draws the wireframe overlay; the
+// includer declares barycentric and wireframeWidth
+float wireframeEdge()
+{
+    vec3 d = fwidth(barycentric);
+    vec3 a = smoothstep(vec3(0.0), d * wireframeWidth, barycentric);
+    return 1.0 - min(min(a.x, a.y), a.z);
+}